@@ -18,6 +18,7 @@
 #include "db/filename.h"
 #include "db/internal_stats.h"
 #include "db/merge_helper.h"
+#include "db/range_del_aggregator.h"
 #include "db/table_cache.h"
 #include "db/version_edit.h"
 #include "rocksdb/db.h"
@@ -58,7 +59,8 @@ TableBuilder* NewTableBuilder(
 Status BuildTable(
     const std::string& dbname, Env* env, const ImmutableCFOptions& ioptions,
     const EnvOptions& env_options, TableCache* table_cache,
-    InternalIterator* iter, FileMetaData* meta,
+    InternalIterator* iter, std::unique_ptr<InternalIterator> range_del_iter,
+    FileMetaData* meta,
     const InternalKeyComparator& internal_comparator,
     const std::vector<std::unique_ptr<IntTblPropCollectorFactory>>*
         int_tbl_prop_collector_factories,
@@ -68,7 +70,8 @@ Status BuildTable(
     const CompressionType compression,
     const CompressionOptions& compression_opts, bool paranoid_file_checks,
     InternalStats* internal_stats, const Env::IOPriority io_priority,
-    TableProperties* table_properties, int level) {
+    TableProperties* table_properties, int level,
+    VersionStorageInfo* flush_base) {
   assert((column_family_id ==
           TablePropertiesCollectorFactory::Context::kUnknownColumnFamily) ==
          column_family_name.empty());
@@ -77,10 +80,15 @@ Status BuildTable(
   Status s;
   meta->fd.file_size = 0;
   iter->SeekToFirst();
+  RangeDelAggregator range_del_agg(internal_comparator, snapshots);
+  s = range_del_agg.AddTombstones(std::move(range_del_iter));
+  if (!s.ok()) {
+    return s;
+  }
 
   std::string fname = TableFileName(ioptions.db_paths, meta->fd.GetNumber(),
                                     meta->fd.GetPathId());
-  if (iter->Valid()) {
+  if (iter->Valid() || !range_del_agg.IsEmpty()) {
     TableBuilder* builder;
     unique_ptr<WritableFileWriter> file_writer;
     {
@@ -108,7 +116,11 @@ Status BuildTable(
     CompactionIterator c_iter(iter, internal_comparator.user_comparator(),
                               &merge, kMaxSequenceNumber, &snapshots,
                               earliest_write_conflict_snapshot, env,
-                              true /* internal key corruption is not ok */);
+                              true /* internal key corruption is not ok */,
+                              nullptr /* compaction */,
+                              nullptr /* compaction_filter */,
+                              nullptr /* log_buffer */, &range_del_agg,
+                              flush_base);
     c_iter.SeekToFirst();
     for (; c_iter.Valid(); c_iter.Next()) {
       const Slice& key = c_iter.key();
@@ -124,6 +136,9 @@ Status BuildTable(
       }
     }
 
+    range_del_agg.AddToBuilder(builder, nullptr /* lower_bound */,
+                               nullptr /* upper_bound */, meta);
+
     // Finish and check for builder errors
     bool empty = builder->NumEntries() == 0;
     s = c_iter.status();
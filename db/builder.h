@@ -32,6 +32,7 @@ class TableBuilder;
 class WritableFileWriter;
 class InternalStats;
 class InternalIterator;
+class VersionStorageInfo;
 
 // @param column_family_name Name of the column family that is also identified
 //    by column_family_id, or empty string if unknown. It must outlive the
@@ -46,18 +47,23 @@ TableBuilder* NewTableBuilder(
     const CompressionOptions& compression_opts,
     const bool skip_filters = false);
 
-// Build a Table file from the contents of *iter.  The generated file
+// Build a Table file from the contents of *iter and the range deletions of
+// range_del_iter, which may be null.  The generated file
 // will be named according to number specified in meta. On success, the rest of
 // *meta will be filled with metadata about the generated table.
-// If no data is present in *iter, meta->file_size will be set to
-// zero, and no Table file will be produced.
+// If no data is present in *iter and range_del_iter, meta->file_size will be
+// set to zero, and no Table file will be produced.
 //
 // @param column_family_name Name of the column family that is also identified
 //    by column_family_id, or empty string if unknown.
+// @param flush_base If not null, the files that hold all the data older than
+//    *iter, so that the deletions of the keys that are not in them are
+//    dropped.
 extern Status BuildTable(
     const std::string& dbname, Env* env, const ImmutableCFOptions& options,
     const EnvOptions& env_options, TableCache* table_cache,
-    InternalIterator* iter, FileMetaData* meta,
+    InternalIterator* iter, std::unique_ptr<InternalIterator> range_del_iter,
+    FileMetaData* meta,
     const InternalKeyComparator& internal_comparator,
     const std::vector<std::unique_ptr<IntTblPropCollectorFactory>>*
         int_tbl_prop_collector_factories,
@@ -68,6 +74,7 @@ extern Status BuildTable(
     const CompressionOptions& compression_opts, bool paranoid_file_checks,
     InternalStats* internal_stats,
     const Env::IOPriority io_priority = Env::IO_HIGH,
-    TableProperties* table_properties = nullptr, int level = -1);
+    TableProperties* table_properties = nullptr, int level = -1,
+    VersionStorageInfo* flush_base = nullptr);
 
 }  // namespace rocksdb
@@ -2272,6 +2272,11 @@ void rocksdb_fifo_compaction_options_set_max_table_files_size(
   fifo_opts->rep.max_table_files_size = size;
 }
 
+void rocksdb_fifo_compaction_options_set_ttl(
+    rocksdb_fifo_compaction_options_t* fifo_opts, uint64_t ttl) {
+  fifo_opts->rep.ttl = ttl;
+}
+
 void rocksdb_fifo_compaction_options_destroy(
     rocksdb_fifo_compaction_options_t* fifo_opts) {
   delete fifo_opts;
@@ -26,11 +26,12 @@
 #include "db/table_properties_collector.h"
 #include "db/version_set.h"
 #include "db/write_controller.h"
-#include "db/writebuffer.h"
+#include "rocksdb/write_buffer_manager.h"
 #include "memtable/hash_skiplist_rep.h"
 #include "util/autovector.h"
 #include "util/compression.h"
 #include "util/options_helper.h"
+#include "util/statistics.h"
 #include "util/thread_status_util.h"
 #include "util/xfunc.h"
 
@@ -125,10 +126,11 @@ Status CheckCompressionSupported(const ColumnFamilyOptions& cf_options) {
 }
 
 Status CheckConcurrentWritesSupported(const ColumnFamilyOptions& cf_options) {
-  if (cf_options.inplace_update_support) {
+  if (cf_options.inplace_update_support &&
+      cf_options.inplace_callback != nullptr) {
     return Status::InvalidArgument(
-        "In-place memtable updates (inplace_update_support) is not compatible "
-        "with concurrent writes (allow_concurrent_memtable_write)");
+        "In-place memtable update callbacks (inplace_callback) are not "
+        "compatible with concurrent writes (allow_concurrent_memtable_write)");
   }
   if (cf_options.filter_deletes) {
     return Status::InvalidArgument(
@@ -164,6 +166,10 @@ ColumnFamilyOptions SanitizeOptions(const DBOptions& db_options,
   result.min_write_buffer_number_to_merge =
       std::min(result.min_write_buffer_number_to_merge,
                result.max_write_buffer_number - 1);
+#ifdef ROCKSDB_LITE
+  // The merged memtables are backed by a VectorRep
+  result.in_memory_compaction = false;
+#endif  // ROCKSDB_LITE
   if (result.num_levels < 1) {
     result.num_levels = 1;
   }
@@ -329,7 +335,7 @@ void SuperVersionUnrefHandle(void* ptr) {
 
 ColumnFamilyData::ColumnFamilyData(
     uint32_t id, const std::string& name, Version* _dummy_versions,
-    Cache* _table_cache, WriteBuffer* write_buffer,
+    Cache* _table_cache, WriteBufferManager* write_buffer_manager,
     const ColumnFamilyOptions& cf_options, const DBOptions* db_options,
     const EnvOptions& env_options, ColumnFamilySet* column_family_set)
     : id_(id),
@@ -343,10 +349,11 @@ ColumnFamilyData::ColumnFamilyData(
                SanitizeOptions(*db_options, &internal_comparator_, cf_options)),
       ioptions_(options_),
       mutable_cf_options_(options_, ioptions_),
-      write_buffer_(write_buffer),
+      write_buffer_manager_(write_buffer_manager),
       mem_(nullptr),
       imm_(options_.min_write_buffer_number_to_merge,
-           options_.max_write_buffer_number_to_maintain),
+           options_.max_write_buffer_number_to_maintain,
+           options_.in_memory_compaction),
       super_version_(nullptr),
       super_version_number_(0),
       local_sv_(new ThreadLocalPtr(&SuperVersionUnrefHandle)),
@@ -526,6 +533,28 @@ std::unique_ptr<WriteControllerToken> SetupDelay(
   return write_controller->GetDelayToken(write_rate);
 }
 
+// Used instead of SetupDelay() with adaptive_delayed_write_rate. Rather than
+// stepping the rate by kSlowdownRatio on every recalculation, it derives the
+// rate from the measured compaction throughput, scaled by how much headroom
+// is left before writes have to be stopped: 1 when the slowdown condition
+// has just been reached, approaching 0 next to the stop condition.
+std::unique_ptr<WriteControllerToken> SetupAdaptiveDelay(
+    uint64_t max_write_rate, WriteController* write_controller,
+    double headroom) {
+  const uint64_t kMinWriteRate = 1024u;  // Minimum write rate 1KB/s.
+
+  uint64_t base_rate = max_write_rate;
+  uint64_t compaction_throughput = write_controller->compaction_throughput();
+  if (compaction_throughput > 0 && compaction_throughput < base_rate) {
+    base_rate = compaction_throughput;
+  }
+  headroom = std::max(0.0, std::min(1.0, headroom));
+  uint64_t write_rate =
+      static_cast<uint64_t>(static_cast<double>(base_rate) * headroom);
+  write_rate = std::max(write_rate, std::min(kMinWriteRate, max_write_rate));
+  return write_controller->GetAdjustedDelayToken(write_rate);
+}
+
 int GetL0ThresholdSpeedupCompaction(int level0_file_num_compaction_trigger,
                                     int level0_slowdown_writes_trigger) {
   // SanitizeOptions() ensures it.
@@ -549,6 +578,16 @@ void ColumnFamilyData::RecalculateWriteStallConditions(
     auto write_controller = column_family_set_->write_controller_;
     uint64_t compaction_needed_bytes =
         vstorage->estimated_compaction_needed_bytes();
+    auto setup_delay = [&](double headroom) {
+      if (ioptions_.adaptive_delayed_write_rate &&
+          !mutable_cf_options.disable_auto_compactions) {
+        return SetupAdaptiveDelay(ioptions_.delayed_write_rate,
+                                  write_controller, headroom);
+      }
+      return SetupDelay(ioptions_.delayed_write_rate, write_controller,
+                        compaction_needed_bytes, prev_compaction_needed_bytes_,
+                        mutable_cf_options.disable_auto_compactions);
+    };
 
     if (imm()->NumNotFlushed() >= mutable_cf_options.max_write_buffer_number) {
       write_controller_token_ = write_controller->GetStopToken();
@@ -582,10 +621,8 @@ void ColumnFamilyData::RecalculateWriteStallConditions(
     } else if (mutable_cf_options.max_write_buffer_number > 3 &&
                imm()->NumNotFlushed() >=
                    mutable_cf_options.max_write_buffer_number - 1) {
-      write_controller_token_ =
-          SetupDelay(ioptions_.delayed_write_rate, write_controller,
-                     compaction_needed_bytes, prev_compaction_needed_bytes_,
-                     mutable_cf_options.disable_auto_compactions);
+      // One more immutable memtable stops writes
+      write_controller_token_ = setup_delay(0.5);
       internal_stats_->AddCFStats(InternalStats::MEMTABLE_SLOWDOWN, 1);
       Log(InfoLogLevel::WARN_LEVEL, ioptions_.info_log,
           "[%s] Stalling writes because we have %d immutable memtables "
@@ -597,10 +634,12 @@ void ColumnFamilyData::RecalculateWriteStallConditions(
     } else if (mutable_cf_options.level0_slowdown_writes_trigger >= 0 &&
                vstorage->l0_delay_trigger_count() >=
                    mutable_cf_options.level0_slowdown_writes_trigger) {
-      write_controller_token_ =
-          SetupDelay(ioptions_.delayed_write_rate, write_controller,
-                     compaction_needed_bytes, prev_compaction_needed_bytes_,
-                     mutable_cf_options.disable_auto_compactions);
+      write_controller_token_ = setup_delay(
+          static_cast<double>(mutable_cf_options.level0_stop_writes_trigger -
+                              vstorage->l0_delay_trigger_count()) /
+          std::max(mutable_cf_options.level0_stop_writes_trigger -
+                       mutable_cf_options.level0_slowdown_writes_trigger,
+                   1));
       internal_stats_->AddCFStats(InternalStats::LEVEL0_SLOWDOWN_TOTAL, 1);
       if (compaction_picker_->IsLevel0CompactionInProgress()) {
         internal_stats_->AddCFStats(
@@ -614,10 +653,17 @@ void ColumnFamilyData::RecalculateWriteStallConditions(
     } else if (mutable_cf_options.soft_pending_compaction_bytes_limit > 0 &&
                vstorage->estimated_compaction_needed_bytes() >=
                    mutable_cf_options.soft_pending_compaction_bytes_limit) {
-      write_controller_token_ =
-          SetupDelay(ioptions_.delayed_write_rate, write_controller,
-                     compaction_needed_bytes, prev_compaction_needed_bytes_,
-                     mutable_cf_options.disable_auto_compactions);
+      double headroom = 1.0;
+      if (mutable_cf_options.hard_pending_compaction_bytes_limit >
+          mutable_cf_options.soft_pending_compaction_bytes_limit) {
+        headroom =
+            static_cast<double>(
+                mutable_cf_options.hard_pending_compaction_bytes_limit -
+                compaction_needed_bytes) /
+            (mutable_cf_options.hard_pending_compaction_bytes_limit -
+             mutable_cf_options.soft_pending_compaction_bytes_limit);
+      }
+      write_controller_token_ = setup_delay(headroom);
       internal_stats_->AddCFStats(
           InternalStats::SOFT_PENDING_COMPACTION_BYTES_LIMIT, 1);
       Log(InfoLogLevel::WARN_LEVEL, ioptions_.info_log,
@@ -652,6 +698,15 @@ void ColumnFamilyData::RecalculateWriteStallConditions(
       write_controller_token_.reset();
     }
     prev_compaction_needed_bytes_ = compaction_needed_bytes;
+
+    SetTickerCount(ioptions_.statistics, DELAYED_WRITE_RATE,
+                   write_controller->NeedsDelay()
+                       ? write_controller->delayed_write_rate()
+                       : 0);
+    SetTickerCount(ioptions_.statistics, ESTIMATED_PENDING_COMPACTION_BYTES,
+                   compaction_needed_bytes);
+    SetTickerCount(ioptions_.statistics, ESTIMATED_COMPACTION_THROUGHPUT,
+                   write_controller->compaction_throughput());
   }
 }
 
@@ -672,10 +727,11 @@ uint64_t ColumnFamilyData::GetTotalSstFilesSize() const {
 }
 
 MemTable* ColumnFamilyData::ConstructNewMemtable(
-    const MutableCFOptions& mutable_cf_options, SequenceNumber earliest_seq) {
+    const MutableCFOptions& mutable_cf_options, SequenceNumber earliest_seq,
+    MemTableRepFactory* memtable_factory) {
   assert(current_ != nullptr);
   return new MemTable(internal_comparator_, ioptions_, mutable_cf_options,
-                      write_buffer_, earliest_seq);
+                      write_buffer_manager_, earliest_seq, memtable_factory);
 }
 
 void ColumnFamilyData::CreateNewMemtable(
@@ -854,7 +910,7 @@ ColumnFamilySet::ColumnFamilySet(const std::string& dbname,
                                  const DBOptions* db_options,
                                  const EnvOptions& env_options,
                                  Cache* table_cache,
-                                 WriteBuffer* write_buffer,
+                                 WriteBufferManager* write_buffer_manager,
                                  WriteController* write_controller)
     : max_column_family_(0),
       dummy_cfd_(new ColumnFamilyData(0, "", nullptr, nullptr, nullptr,
@@ -865,7 +921,7 @@ ColumnFamilySet::ColumnFamilySet(const std::string& dbname,
       db_options_(db_options),
       env_options_(env_options),
       table_cache_(table_cache),
-      write_buffer_(write_buffer),
+      write_buffer_manager_(write_buffer_manager),
       write_controller_(write_controller) {
   // initialize linked list
   dummy_cfd_->prev_ = dummy_cfd_;
@@ -930,7 +986,7 @@ ColumnFamilyData* ColumnFamilySet::CreateColumnFamily(
   assert(column_families_.find(name) == column_families_.end());
   ColumnFamilyData* new_cfd =
       new ColumnFamilyData(id, name, dummy_versions, table_cache_,
-                           write_buffer_, options, db_options_,
+                           write_buffer_manager_, options, db_options_,
                            env_options_, this);
   column_families_.insert({name, id});
   column_family_data_.insert({id, new_cfd});
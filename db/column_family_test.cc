@@ -1486,8 +1486,10 @@ TEST_F(ColumnFamilyTest, SameCFManualAutomaticCompactionsLevel) {
 
   threads.join();
   WaitForCompaction();
-  // VERIFY compaction "one"
-  AssertFilesPerLevel("0,1", 1);
+  // VERIFY compaction "one". The L0 files added while the manual compaction
+  // was running were merged by an intra-L0 compaction, which leaves a single
+  // L0 file below the trigger.
+  AssertFilesPerLevel("1,1", 1);
 
   // Compare against saved keys
   std::set<std::string>::iterator key_iter = keys_.begin();
@@ -2340,6 +2342,90 @@ TEST_F(ColumnFamilyTest, WriteStallSingleColumnFamily) {
             dbfull()->TEST_write_controler().delayed_write_rate());
 }
 
+TEST_F(ColumnFamilyTest, WriteStallAdaptiveDelayedWriteRate) {
+  const uint64_t kBaseRate = 810000u;
+  db_options_.delayed_write_rate = kBaseRate;
+  db_options_.adaptive_delayed_write_rate = true;
+  db_options_.statistics = rocksdb::CreateDBStatistics();
+
+  Open({"default"});
+  ColumnFamilyData* cfd =
+      static_cast<ColumnFamilyHandleImpl*>(db_->DefaultColumnFamily())->cfd();
+
+  VersionStorageInfo* vstorage = cfd->current()->storage_info();
+
+  MutableCFOptions mutable_cf_options(
+      Options(db_options_, column_family_options_),
+      ImmutableCFOptions(Options(db_options_, column_family_options_)));
+
+  mutable_cf_options.level0_slowdown_writes_trigger = 20;
+  mutable_cf_options.level0_stop_writes_trigger = 30;
+  mutable_cf_options.soft_pending_compaction_bytes_limit = 200;
+  mutable_cf_options.hard_pending_compaction_bytes_limit = 2000;
+
+  WriteController& write_controller = dbfull()->TEST_write_controler();
+  uint64_t value;
+
+  vstorage->TEST_set_estimated_compaction_needed_bytes(50);
+  cfd->RecalculateWriteStallConditions(mutable_cf_options);
+  ASSERT_TRUE(!write_controller.NeedsDelay());
+  ASSERT_TRUE(db_->GetIntProperty("rocksdb.actual-delayed-write-rate", &value));
+  ASSERT_EQ(0U, value);
+
+  // Without compaction throughput samples the rate shrinks linearly from
+  // delayed_write_rate at the soft limit towards zero at the hard limit.
+  vstorage->TEST_set_estimated_compaction_needed_bytes(200);
+  cfd->RecalculateWriteStallConditions(mutable_cf_options);
+  ASSERT_TRUE(write_controller.NeedsDelay());
+  ASSERT_EQ(kBaseRate, write_controller.delayed_write_rate());
+
+  vstorage->TEST_set_estimated_compaction_needed_bytes(1100);
+  cfd->RecalculateWriteStallConditions(mutable_cf_options);
+  ASSERT_EQ(kBaseRate / 2, write_controller.delayed_write_rate());
+  // The rate does not keep dropping while the debt stays the same
+  cfd->RecalculateWriteStallConditions(mutable_cf_options);
+  ASSERT_EQ(kBaseRate / 2, write_controller.delayed_write_rate());
+
+  vstorage->TEST_set_estimated_compaction_needed_bytes(1999);
+  cfd->RecalculateWriteStallConditions(mutable_cf_options);
+  ASSERT_TRUE(!write_controller.IsStopped());
+  ASSERT_EQ(1024U, write_controller.delayed_write_rate());
+
+  vstorage->TEST_set_estimated_compaction_needed_bytes(2000);
+  cfd->RecalculateWriteStallConditions(mutable_cf_options);
+  ASSERT_TRUE(write_controller.IsStopped());
+  ASSERT_TRUE(db_->GetIntProperty("rocksdb.is-write-stopped", &value));
+  ASSERT_EQ(1U, value);
+
+  // Compactions processing 100KB/s lower the base rate
+  write_controller.RecordCompaction(1000000, 10000000, 1);
+  ASSERT_TRUE(
+      db_->GetIntProperty("rocksdb.estimate-compaction-throughput", &value));
+  ASSERT_EQ(100000U, value);
+  vstorage->TEST_set_estimated_compaction_needed_bytes(1100);
+  cfd->RecalculateWriteStallConditions(mutable_cf_options);
+  ASSERT_TRUE(!write_controller.IsStopped());
+  ASSERT_EQ(50000U, write_controller.delayed_write_rate());
+  ASSERT_TRUE(db_->GetIntProperty("rocksdb.actual-delayed-write-rate", &value));
+  ASSERT_EQ(50000U, value);
+  ASSERT_EQ(50000U, db_options_.statistics->getTickerCount(DELAYED_WRITE_RATE));
+  ASSERT_EQ(1100U, db_options_.statistics->getTickerCount(
+                       ESTIMATED_PENDING_COMPACTION_BYTES));
+  ASSERT_EQ(100000U, db_options_.statistics->getTickerCount(
+                         ESTIMATED_COMPACTION_THROUGHPUT));
+
+  // Level-0 files scale the rate by the distance to the stop trigger
+  vstorage->TEST_set_estimated_compaction_needed_bytes(50);
+  vstorage->set_l0_delay_trigger_count(25);
+  cfd->RecalculateWriteStallConditions(mutable_cf_options);
+  ASSERT_EQ(50000U, write_controller.delayed_write_rate());
+
+  vstorage->set_l0_delay_trigger_count(0);
+  cfd->RecalculateWriteStallConditions(mutable_cf_options);
+  ASSERT_TRUE(!write_controller.NeedsDelay());
+  ASSERT_EQ(0U, db_options_.statistics->getTickerCount(DELAYED_WRITE_RATE));
+}
+
 TEST_F(ColumnFamilyTest, CompactionSpeedupSingleColumnFamily) {
   db_options_.base_background_compactions = 2;
   db_options_.max_background_compactions = 6;
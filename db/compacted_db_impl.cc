@@ -6,6 +6,7 @@
 #ifndef ROCKSDB_LITE
 #include "db/compacted_db_impl.h"
 #include "db/db_impl.h"
+#include "db/range_del_aggregator.h"
 #include "db/version_set.h"
 #include "table/get_context.h"
 
@@ -44,12 +45,21 @@ size_t CompactedDBImpl::FindFile(const Slice& key) {
 
 Status CompactedDBImpl::Get(const ReadOptions& options,
      ColumnFamilyHandle*, const Slice& key, std::string* value) {
+  TableReader* table_reader = files_.files[FindFile(key)].fd.table_reader;
+  // The file may still hold range deletions that were kept for snapshots
+  RangeDelAggregator range_del_agg(cfd_->internal_comparator(),
+                                   {kMaxSequenceNumber});
+  std::unique_ptr<InternalIterator> range_del_iter(
+      table_reader->NewRangeTombstoneIterator(options));
+  Status s = range_del_agg.AddTombstones(std::move(range_del_iter));
+  if (!s.ok()) {
+    return s;
+  }
   GetContext get_context(user_comparator_, nullptr, nullptr, nullptr,
                          GetContext::kNotFound, key, value, nullptr, nullptr,
-                         nullptr);
+                         nullptr, nullptr, &range_del_agg);
   LookupKey lkey(key, kMaxSequenceNumber);
-  files_.files[FindFile(key)].fd.table_reader->Get(
-      options, lkey.internal_key(), &get_context);
+  table_reader->Get(options, lkey.internal_key(), &get_context);
   if (get_context.State() == GetContext::kFound) {
     return Status::OK();
   }
@@ -75,9 +85,20 @@ std::vector<Status> CompactedDBImpl::MultiGet(const ReadOptions& options,
   int idx = 0;
   for (auto* r : reader_list) {
     if (r != nullptr) {
+      RangeDelAggregator range_del_agg(cfd_->internal_comparator(),
+                                       {kMaxSequenceNumber});
+      std::unique_ptr<InternalIterator> range_del_iter(
+          r->NewRangeTombstoneIterator(options));
+      Status s = range_del_agg.AddTombstones(std::move(range_del_iter));
+      if (!s.ok()) {
+        statuses[idx] = s;
+        ++idx;
+        continue;
+      }
       GetContext get_context(user_comparator_, nullptr, nullptr, nullptr,
                              GetContext::kNotFound, keys[idx], &(*values)[idx],
-                             nullptr, nullptr, nullptr);
+                             nullptr, nullptr, nullptr, nullptr,
+                             &range_del_agg);
       LookupKey lkey(keys[idx], kMaxSequenceNumber);
       r->Get(options, lkey.internal_key(), &get_context);
       if (get_context.State() == GetContext::kFound) {
@@ -228,6 +228,11 @@ bool Compaction::IsTrivialMove() const {
     return false;
   }
 
+  if (compaction_reason_ == CompactionReason::kPeriodicCompaction) {
+    // The purpose of a periodic compaction is to rewrite the files
+    return false;
+  }
+
   if (is_manual_compaction_ &&
       (cfd_->ioptions()->compaction_filter != nullptr ||
        cfd_->ioptions()->compaction_filter_factory != nullptr)) {
@@ -266,6 +271,12 @@ bool Compaction::KeyNotExistsBeyondOutputLevel(
   if (cfd_->ioptions()->compaction_style == kCompactionStyleUniversal) {
     return bottommost_level_;
   }
+  if (cfd_->ioptions()->compaction_style == kCompactionStyleLevel &&
+      output_level_ == 0) {
+    // An intra-L0 compaction may leave older L0 files behind that are not
+    // checked below, so only trust the bottommost level check.
+    return bottommost_level_;
+  }
   // Maybe use binary search to find right entry instead of linear search?
   const Comparator* user_cmp = cfd_->user_comparator();
   for (int lvl = output_level_ + 1; lvl < number_levels_; lvl++) {
@@ -432,7 +443,7 @@ bool Compaction::ShouldFormSubcompactions() const {
     return false;
   }
   if (cfd_->ioptions()->compaction_style == kCompactionStyleLevel) {
-    return start_level_ == 0 && !IsOutputLevelEmpty();
+    return start_level_ == 0 && output_level_ > 0 && !IsOutputLevelEmpty();
   } else if (cfd_->ioptions()->compaction_style == kCompactionStyleUniversal) {
     return number_levels_ > 1 && output_level_ > 0;
   } else {
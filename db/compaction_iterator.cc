@@ -15,7 +15,8 @@ CompactionIterator::CompactionIterator(
     SequenceNumber last_sequence, std::vector<SequenceNumber>* snapshots,
     SequenceNumber earliest_write_conflict_snapshot, Env* env,
     bool expect_valid_internal_key, const Compaction* compaction,
-    const CompactionFilter* compaction_filter, LogBuffer* log_buffer)
+    const CompactionFilter* compaction_filter, LogBuffer* log_buffer,
+    RangeDelAggregator* range_del_agg, VersionStorageInfo* flush_base)
     : input_(input),
       cmp_(cmp),
       merge_helper_(merge_helper),
@@ -26,7 +27,10 @@ CompactionIterator::CompactionIterator(
       compaction_(compaction),
       compaction_filter_(compaction_filter),
       log_buffer_(log_buffer),
+      range_del_agg_(range_del_agg),
+      flush_base_(flush_base),
       merge_out_iter_(merge_helper_) {
+  assert(flush_base_ == nullptr || compaction_ == nullptr);
   assert(compaction_filter_ == nullptr || compaction_ != nullptr);
   bottommost_level_ =
       compaction_ == nullptr ? false : compaction_->bottommost_level();
@@ -51,6 +55,22 @@ CompactionIterator::CompactionIterator(
   }
 }
 
+bool CompactionIterator::KeyNotExistsBeyondOutput(const Slice& user_key) {
+  if (compaction_ != nullptr) {
+    return compaction_->KeyNotExistsBeyondOutputLevel(user_key, &level_ptrs_);
+  }
+  if (flush_base_ != nullptr) {
+    // The memtables being flushed are newer than all the files
+    for (int level = 0; level < flush_base_->num_levels(); level++) {
+      if (flush_base_->OverlapInLevel(level, &user_key, &user_key)) {
+        return false;
+      }
+    }
+    return true;
+  }
+  return false;
+}
+
 void CompactionIterator::ResetRecordCounts() {
   iter_stats_.num_record_drop_user = 0;
   iter_stats_.num_record_drop_hidden = 0;
@@ -110,6 +130,9 @@ void CompactionIterator::NextFromInput() {
   valid_ = false;
 
   while (!valid_ && input_->Valid()) {
+    // Set if the compaction filter asked to drop all keys up to
+    // compaction_filter_skip_until_
+    bool need_skip = false;
     key_ = input_->key();
     value_ = input_->value();
     iter_stats_.num_input_records++;
@@ -158,28 +181,37 @@ void CompactionIterator::NextFromInput() {
            ignore_snapshots_)) {
         // If the user has specified a compaction filter and the sequence
         // number is greater than any external snapshot, then invoke the
-        // filter. If the return value of the compaction filter is true,
-        // replace the entry with a deletion marker.
-        bool value_changed = false;
-        bool to_delete = false;
+        // filter. If the compaction filter decides to remove the entry,
+        // replace it with a deletion marker.
+        CompactionFilter::Decision filter;
         compaction_filter_value_.clear();
+        compaction_filter_skip_until_.clear();
         {
           StopWatchNano timer(env_, true);
-          to_delete = compaction_filter_->Filter(
-              compaction_->level(), ikey_.user_key, value_,
-              &compaction_filter_value_, &value_changed);
+          filter = compaction_filter_->FilterV2(
+              compaction_->level(), ikey_.user_key,
+              CompactionFilter::ValueType::kValue, value_,
+              &compaction_filter_value_, &compaction_filter_skip_until_);
           iter_stats_.total_filter_time +=
               env_ != nullptr ? timer.ElapsedNanos() : 0;
         }
-        if (to_delete) {
+        if (filter == CompactionFilter::Decision::kRemoveAndSkipUntil &&
+            cmp_->Compare(compaction_filter_skip_until_, ikey_.user_key) <= 0) {
+          // Can't skip backwards, keep the key as documented for FilterV2()
+          filter = CompactionFilter::Decision::kKeep;
+        }
+        if (filter == CompactionFilter::Decision::kRemove) {
           // convert the current key to a delete
           ikey_.type = kTypeDeletion;
           current_key_.UpdateInternalKey(ikey_.sequence, kTypeDeletion);
           // no value associated with delete
           value_.clear();
           iter_stats_.num_record_drop_user++;
-        } else if (value_changed) {
+        } else if (filter == CompactionFilter::Decision::kChangeValue) {
           value_ = compaction_filter_value_;
+        } else if (filter == CompactionFilter::Decision::kRemoveAndSkipUntil) {
+          need_skip = true;
+          iter_stats_.num_record_drop_user++;
         }
       }
     } else {
@@ -205,7 +237,9 @@ void CompactionIterator::NextFromInput() {
         visible_at_tip_ ? visible_at_tip_ : findEarliestVisibleSnapshot(
                                                 ikey_.sequence, &prev_snapshot);
 
-    if (clear_and_output_next_key_) {
+    if (need_skip) {
+      // Handled at the end of the loop
+    } else if (clear_and_output_next_key_) {
       // In the previous iteration we encountered a single delete that we could
       // not compact out.  We will keep this Put, but can drop it's data.
       // (See Optimization 3, below.)
@@ -312,9 +346,8 @@ void CompactionIterator::NextFromInput() {
         // iteration. If the next key is corrupt, we return before the
         // comparison, so the value of has_current_user_key does not matter.
         has_current_user_key_ = false;
-        if (compaction_ != nullptr && ikey_.sequence <= earliest_snapshot_ &&
-            compaction_->KeyNotExistsBeyondOutputLevel(ikey_.user_key,
-                                                       &level_ptrs_)) {
+        if (ikey_.sequence <= earliest_snapshot_ &&
+            KeyNotExistsBeyondOutput(ikey_.user_key)) {
           // Key doesn't exist outside of this range.
           // Can compact out this SingleDelete.
           ++iter_stats_.num_record_drop_obsolete;
@@ -340,14 +373,16 @@ void CompactionIterator::NextFromInput() {
       assert(last_sequence >= current_user_key_sequence_);
       ++iter_stats_.num_record_drop_hidden;  // (A)
       input_->Next();
-    } else if (compaction_ != nullptr && ikey_.type == kTypeDeletion &&
+    } else if (range_del_agg_ != nullptr && ikey_.type != kTypeSingleDeletion &&
+               range_del_agg_->ShouldDelete(ikey_)) {
+      // A newer range deletion that no snapshot sees past deletes this
+      // entry. The range deletion is written to the output, so dropping the
+      // entry does not affect TransactionDB write-conflict checking either.
+      ++iter_stats_.num_record_drop_hidden;
+      input_->Next();
+    } else if (ikey_.type == kTypeDeletion &&
                ikey_.sequence <= earliest_snapshot_ &&
-               compaction_->KeyNotExistsBeyondOutputLevel(ikey_.user_key,
-                                                          &level_ptrs_)) {
-      // TODO(noetzli): This is the only place where we use compaction_
-      // (besides the constructor). We should probably get rid of this
-      // dependency and find a way to do similar filtering during flushes.
-      //
+               KeyNotExistsBeyondOutput(ikey_.user_key)) {
       // For this user key:
       // (1) there is no data in higher levels
       // (2) data in lower levels will have larger sequence numbers
@@ -372,7 +407,8 @@ void CompactionIterator::NextFromInput() {
       // have hit (A)
       // We encapsulate the merge related state machine in a different
       // object to minimize change to the existing flow.
-      merge_helper_->MergeUntil(input_, prev_snapshot, bottommost_level_);
+      merge_helper_->MergeUntil(input_, prev_snapshot, bottommost_level_,
+                                range_del_agg_);
       merge_out_iter_.SeekToFirst();
 
       if (merge_out_iter_.Valid()) {
@@ -395,10 +431,25 @@ void CompactionIterator::NextFromInput() {
         // batch consumed by the merge operator should not shadow any keys
         // coming after the merges
         has_current_user_key_ = false;
+        Slice skip_until;
+        if (merge_helper_->FilteredUntil(&skip_until)) {
+          compaction_filter_skip_until_.assign(skip_until.data(),
+                                               skip_until.size());
+          need_skip = true;
+          iter_stats_.num_record_drop_user++;
+        }
       }
     } else {
       valid_ = true;
     }
+
+    if (need_skip) {
+      // The seek goes through the index blocks, so data blocks holding only
+      // skipped keys are never read
+      skip_until_key_.SetInternalKey(compaction_filter_skip_until_,
+                                     kMaxSequenceNumber, kValueTypeForSeek);
+      input_->Seek(skip_until_key_.GetKey());
+    }
   }
 }
 
@@ -13,6 +13,7 @@
 
 #include "db/compaction.h"
 #include "db/merge_helper.h"
+#include "db/range_del_aggregator.h"
 #include "rocksdb/compaction_filter.h"
 #include "util/log_buffer.h"
 
@@ -44,7 +45,9 @@ class CompactionIterator {
                      bool expect_valid_internal_key,
                      const Compaction* compaction = nullptr,
                      const CompactionFilter* compaction_filter = nullptr,
-                     LogBuffer* log_buffer = nullptr);
+                     LogBuffer* log_buffer = nullptr,
+                     RangeDelAggregator* range_del_agg = nullptr,
+                     VersionStorageInfo* flush_base = nullptr);
 
   void ResetRecordCounts();
 
@@ -85,6 +88,10 @@ class CompactionIterator {
   inline SequenceNumber findEarliestVisibleSnapshot(
       SequenceNumber in, SequenceNumber* prev_snapshot);
 
+  // Returns whether the deletion of the key can be dropped because no older
+  // entry of the key can exist below the output
+  bool KeyNotExistsBeyondOutput(const Slice& user_key);
+
   InternalIterator* input_;
   const Comparator* cmp_;
   MergeHelper* merge_helper_;
@@ -95,6 +102,12 @@ class CompactionIterator {
   const Compaction* compaction_;
   const CompactionFilter* compaction_filter_;
   LogBuffer* log_buffer_;
+  // The range deletions of the input, the entries they delete are dropped
+  RangeDelAggregator* range_del_agg_;
+  // For a flush that includes the oldest unflushed memtable, the files that
+  // hold all the older data, so that the deletions of keys that are not in
+  // them can be dropped
+  VersionStorageInfo* flush_base_;
   bool bottommost_level_;
   bool valid_ = false;
   SequenceNumber visible_at_tip_;
@@ -137,6 +150,9 @@ class CompactionIterator {
 
   MergeOutputIterator merge_out_iter_;
   std::string compaction_filter_value_;
+  // The user key returned with CompactionFilter::Decision::kRemoveAndSkipUntil
+  std::string compaction_filter_skip_until_;
+  IterKey skip_until_key_;
   // "level_ptrs" holds indices that remember which file of an associated
   // level we were last checking during the last call to compaction->
   // KeyNotExistsBeyondOutputLevel(). This allows future calls to the function
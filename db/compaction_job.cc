@@ -16,6 +16,7 @@
 #include <inttypes.h>
 #include <algorithm>
 #include <functional>
+#include <iterator>
 #include <vector>
 #include <memory>
 #include <list>
@@ -24,6 +25,7 @@
 #include <utility>
 
 #include "db/builder.h"
+#include "db/compaction_service.h"
 #include "db/db_iter.h"
 #include "db/dbformat.h"
 #include "db/event_helpers.h"
@@ -37,6 +39,7 @@
 #include "db/version_set.h"
 #include "port/likely.h"
 #include "port/port.h"
+#include "rocksdb/compaction_service.h"
 #include "rocksdb/db.h"
 #include "rocksdb/env.h"
 #include "rocksdb/statistics.h"
@@ -46,6 +49,7 @@
 #include "table/block_based_table_factory.h"
 #include "table/merger.h"
 #include "table/table_builder.h"
+#include "table/table_reader.h"
 #include "util/coding.h"
 #include "util/file_reader_writer.h"
 #include "util/iostats_context_imp.h"
@@ -378,6 +382,18 @@ void CompactionJob::Prepare() {
   }
 }
 
+void CompactionJob::PrepareForCompactionService(const std::string& output_path,
+                                                Slice* begin, Slice* end) {
+  AutoThreadOperationStageUpdater stage_updater(
+      ThreadStatus::STAGE_COMPACTION_PREPARE);
+
+  auto* c = compact_->compaction;
+  assert(c->column_family_data() != nullptr);
+  bottommost_level_ = c->bottommost_level();
+  output_path_ = output_path;
+  compact_->sub_compact_states.emplace_back(c, begin, end);
+}
+
 struct RangeWithSize {
   Range range;
   uint64_t size;
@@ -386,11 +402,78 @@ struct RangeWithSize {
       : range(a, b), size(s) {}
 };
 
+// Samples the index blocks of all input tables for keys that split the
+// compaction into ranges with the size of one or a few data blocks. Returns
+// false if any input table can't provide such keys.
+bool CompactionJob::GenSubcompactionAnchors(std::vector<RangeWithSize>* ranges,
+                                            uint64_t* sum) {
+  auto* c = compact_->compaction;
+  auto* cfd = c->column_family_data();
+  const Comparator* cfd_comparator = cfd->user_comparator();
+
+  std::vector<TableReader::Anchor> anchors;
+  for (size_t lvl_idx = 0; lvl_idx < c->num_input_levels(); lvl_idx++) {
+    for (size_t i = 0; i < c->num_input_files(lvl_idx); i++) {
+      Cache::Handle* handle = nullptr;
+      Status s = cfd->table_cache()->FindTable(
+          env_options_, cfd->internal_comparator(), c->input(lvl_idx, i)->fd,
+          &handle);
+      if (s.ok()) {
+        std::vector<TableReader::Anchor> file_anchors;
+        s = cfd->table_cache()
+                ->GetTableReaderFromHandle(handle)
+                ->ApproximateKeyAnchors(ReadOptions(), &file_anchors);
+        cfd->table_cache()->ReleaseHandle(handle);
+        std::move(file_anchors.begin(), file_anchors.end(),
+                  std::back_inserter(anchors));
+      }
+      if (!s.ok()) {
+        return false;
+      }
+    }
+  }
+
+  if (anchors.empty()) {
+    return false;
+  }
+
+  std::sort(anchors.begin(), anchors.end(),
+    [cfd_comparator] (const TableReader::Anchor& a,
+                      const TableReader::Anchor& b) -> bool {
+      return cfd_comparator->Compare(a.user_key, b.user_key) < 0;
+    });
+
+  // Merge anchors of the same key. Each range then ends at an anchor and
+  // covers the data of all inputs since the previous one.
+  anchor_keys_.clear();
+  anchor_keys_.reserve(anchors.size());
+  std::vector<uint64_t> range_sizes;
+  for (auto& anchor : anchors) {
+    if (!anchor_keys_.empty() &&
+        cfd_comparator->Compare(anchor_keys_.back(), anchor.user_key) == 0) {
+      range_sizes.back() += anchor.range_size;
+    } else {
+      anchor_keys_.push_back(std::move(anchor.user_key));
+      range_sizes.push_back(anchor.range_size);
+    }
+  }
+
+  *sum = 0;
+  for (size_t i = 0; i < anchor_keys_.size(); i++) {
+    ranges->emplace_back(i == 0 ? Slice() : Slice(anchor_keys_[i - 1]),
+                         anchor_keys_[i], range_sizes[i]);
+    *sum += range_sizes[i];
+  }
+  return true;
+}
+
 // Generates a histogram representing potential divisions of key ranges from
-// the input. It adds the starting and/or ending keys of certain input files
-// to the working set and then finds the approximate size of data in between
-// each consecutive pair of slices. Then it divides these ranges into
-// consecutive groups such that each group has a similar size.
+// the input. It prefers keys sampled from the index blocks of the input
+// tables, so that even a compaction of a few large files can be split. If
+// those are not available, it adds the starting and/or ending keys of certain
+// input files to the working set and then finds the approximate size of data
+// in between each consecutive pair of slices. Then it divides these ranges
+// into consecutive groups such that each group has a similar size.
 void CompactionJob::GenSubcompactionBoundaries() {
   auto* c = compact_->compaction;
   auto* cfd = c->column_family_data();
@@ -399,70 +482,76 @@ void CompactionJob::GenSubcompactionBoundaries() {
   int start_lvl = c->start_level();
   int out_lvl = c->output_level();
 
-  // Add the starting and/or ending key of certain input files as a potential
-  // boundary
-  for (size_t lvl_idx = 0; lvl_idx < c->num_input_levels(); lvl_idx++) {
-    int lvl = c->level(lvl_idx);
-    if (lvl >= start_lvl && lvl <= out_lvl) {
-      const LevelFilesBrief* flevel = c->input_levels(lvl_idx);
-      size_t num_files = flevel->num_files;
-
-      if (num_files == 0) {
-        continue;
-      }
-
-      if (lvl == 0) {
-        // For level 0 add the starting and ending key of each file since the
-        // files may have greatly differing key ranges (not range-partitioned)
-        for (size_t i = 0; i < num_files; i++) {
-          bounds.emplace_back(flevel->files[i].smallest_key);
-          bounds.emplace_back(flevel->files[i].largest_key);
+  uint64_t sum = 0;
+  std::vector<RangeWithSize> ranges;
+  if (!GenSubcompactionAnchors(&ranges, &sum)) {
+    // Add the starting and/or ending key of certain input files as a
+    // potential boundary
+    for (size_t lvl_idx = 0; lvl_idx < c->num_input_levels(); lvl_idx++) {
+      int lvl = c->level(lvl_idx);
+      if (lvl >= start_lvl && lvl <= out_lvl) {
+        const LevelFilesBrief* flevel = c->input_levels(lvl_idx);
+        size_t num_files = flevel->num_files;
+
+        if (num_files == 0) {
+          continue;
         }
-      } else {
-        // For all other levels add the smallest/largest key in the level to
-        // encompass the range covered by that level
-        bounds.emplace_back(flevel->files[0].smallest_key);
-        bounds.emplace_back(flevel->files[num_files - 1].largest_key);
-        if (lvl == out_lvl) {
-          // For the last level include the starting keys of all files since
-          // the last level is the largest and probably has the widest key
-          // range. Since it's range partitioned, the ending key of one file
-          // and the starting key of the next are very close (or identical).
-          for (size_t i = 1; i < num_files; i++) {
+
+        if (lvl == 0) {
+          // For level 0 add the starting and ending key of each file since
+          // the files may have greatly differing key ranges (not
+          // range-partitioned)
+          for (size_t i = 0; i < num_files; i++) {
             bounds.emplace_back(flevel->files[i].smallest_key);
+            bounds.emplace_back(flevel->files[i].largest_key);
+          }
+        } else {
+          // For all other levels add the smallest/largest key in the level to
+          // encompass the range covered by that level
+          bounds.emplace_back(flevel->files[0].smallest_key);
+          bounds.emplace_back(flevel->files[num_files - 1].largest_key);
+          if (lvl == out_lvl) {
+            // For the last level include the starting keys of all files since
+            // the last level is the largest and probably has the widest key
+            // range. Since it's range partitioned, the ending key of one file
+            // and the starting key of the next are very close (or identical).
+            for (size_t i = 1; i < num_files; i++) {
+              bounds.emplace_back(flevel->files[i].smallest_key);
+            }
           }
         }
       }
     }
-  }
 
-  std::sort(bounds.begin(), bounds.end(),
-    [cfd_comparator] (const Slice& a, const Slice& b) -> bool {
-      return cfd_comparator->Compare(ExtractUserKey(a), ExtractUserKey(b)) < 0;
-    });
-  // Remove duplicated entries from bounds
-  bounds.erase(std::unique(bounds.begin(), bounds.end(),
-    [cfd_comparator] (const Slice& a, const Slice& b) -> bool {
-      return cfd_comparator->Compare(ExtractUserKey(a), ExtractUserKey(b)) == 0;
-    }), bounds.end());
-
-  // Combine consecutive pairs of boundaries into ranges with an approximate
-  // size of data covered by keys in that range
-  uint64_t sum = 0;
-  std::vector<RangeWithSize> ranges;
-  auto* v = cfd->current();
-  for (auto it = bounds.begin();;) {
-    const Slice a = *it;
-    it++;
+    std::sort(bounds.begin(), bounds.end(),
+      [cfd_comparator] (const Slice& a, const Slice& b) -> bool {
+        return cfd_comparator->Compare(ExtractUserKey(a),
+                                       ExtractUserKey(b)) < 0;
+      });
+    // Remove duplicated entries from bounds
+    bounds.erase(std::unique(bounds.begin(), bounds.end(),
+      [cfd_comparator] (const Slice& a, const Slice& b) -> bool {
+        return cfd_comparator->Compare(ExtractUserKey(a),
+                                       ExtractUserKey(b)) == 0;
+      }), bounds.end());
+
+    // Combine consecutive pairs of boundaries into ranges with an approximate
+    // size of data covered by keys in that range
+    auto* v = cfd->current();
+    for (auto it = bounds.begin();;) {
+      const Slice a = *it;
+      it++;
+
+      if (it == bounds.end()) {
+        break;
+      }
 
-    if (it == bounds.end()) {
-      break;
+      const Slice b = *it;
+      uint64_t size =
+          versions_->ApproximateSize(v, a, b, start_lvl, out_lvl + 1);
+      ranges.emplace_back(ExtractUserKey(a), ExtractUserKey(b), size);
+      sum += size;
     }
-
-    const Slice b = *it;
-    uint64_t size = versions_->ApproximateSize(v, a, b, start_lvl, out_lvl + 1);
-    ranges.emplace_back(a, b, size);
-    sum += size;
   }
 
   // Group the ranges into subcompactions
@@ -489,7 +578,7 @@ void CompactionJob::GenSubcompactionBoundaries() {
         continue;
       }
       if (sum >= mean) {
-        boundaries_.emplace_back(ExtractUserKey(ranges[i].range.limit));
+        boundaries_.emplace_back(ranges[i].range.limit);
         sizes_.emplace_back(sum);
         subcompactions--;
         sum = 0;
@@ -640,10 +729,200 @@ Status CompactionJob::Install(const MutableCFOptions& mutable_cf_options) {
   return status;
 }
 
+Status CompactionJob::RunForCompactionService(CompactionServiceResult* result) {
+  assert(!output_path_.empty());
+  Status status = Run();
+
+  result->status = status;
+  result->output_path = output_path_;
+  for (const auto& state : compact_->sub_compact_states) {
+    for (const auto& output : state.outputs) {
+      CompactionServiceResult::OutputFile file;
+      file.file_number = output.meta.fd.GetNumber();
+      file.file_size = output.meta.fd.GetFileSize();
+      file.smallest_seqno = output.meta.smallest_seqno;
+      file.largest_seqno = output.meta.largest_seqno;
+      file.smallest = output.meta.smallest.Encode().ToString();
+      file.largest = output.meta.largest.Encode().ToString();
+      file.marked_for_compaction = output.meta.marked_for_compaction;
+      result->output_files.push_back(std::move(file));
+    }
+  }
+  result->num_input_records = compact_->num_input_records;
+  result->num_output_records = compact_->num_output_records;
+  result->total_bytes = compact_->total_bytes;
+
+  CleanupCompaction();
+  return status;
+}
+
+#ifndef ROCKSDB_LITE
+Status CompactionJob::ProcessKeyValueCompactionWithCompactionService(
+    SubcompactionState* sub_compact) {
+  Compaction* c = compact_->compaction;
+  ColumnFamilyData* cfd = c->column_family_data();
+
+  CompactionServiceInput input;
+  input.column_family_name = cfd->GetName();
+  input.snapshots = existing_snapshots_;
+  input.earliest_write_conflict_snapshot = earliest_write_conflict_snapshot_;
+  input.last_sequence = versions_->LastSequence();
+  for (size_t i = 0; i < c->num_input_levels(); i++) {
+    CompactionServiceInput::InputLevel input_level;
+    input_level.level = c->level(i);
+    for (size_t j = 0; j < c->num_input_files(i); j++) {
+      input_level.files.push_back(c->input(i, j)->fd.GetNumber());
+    }
+    input.inputs.push_back(std::move(input_level));
+  }
+  input.grandparents.level = c->output_level() + 1;
+  for (const auto* f : c->grandparents()) {
+    input.grandparents.files.push_back(f->fd.GetNumber());
+  }
+  input.output_level = c->output_level();
+  input.output_path_id = c->output_path_id();
+  input.max_output_file_size = c->max_output_file_size();
+  input.max_grandparent_overlap_bytes = c->max_grandparent_overlap_bytes();
+  input.compression = c->output_compression();
+  input.manual_compaction = c->is_manual_compaction();
+  input.compaction_reason = c->compaction_reason();
+  if (sub_compact->start != nullptr) {
+    input.has_begin = true;
+    input.begin = sub_compact->start->ToString();
+  }
+  if (sub_compact->end != nullptr) {
+    input.has_end = true;
+    input.end = sub_compact->end->ToString();
+  }
+
+  std::string input_str;
+  input.EncodeTo(&input_str);
+  std::string result_str;
+  Status s = db_options_.compaction_service->Run(dbname_, job_id_, input_str,
+                                                 &result_str);
+  CompactionServiceResult result;
+  if (s.ok()) {
+    s = result.DecodeFrom(result_str);
+  }
+  if (s.ok()) {
+    s = result.status;
+  }
+
+  // Move the output files into the DB, under new file numbers, and check
+  // that they are usable
+  for (size_t i = 0; s.ok() && i < result.output_files.size(); i++) {
+    const auto& file = result.output_files[i];
+    SubcompactionState::Output out;
+    // no need to lock because VersionSet::next_file_number_ is atomic
+    out.meta.fd = FileDescriptor(versions_->NewFileNumber(),
+                                 c->output_path_id(), file.file_size);
+    out.meta.smallest.DecodeFrom(file.smallest);
+    out.meta.largest.DecodeFrom(file.largest);
+    out.meta.smallest_seqno = file.smallest_seqno;
+    out.meta.largest_seqno = file.largest_seqno;
+    out.meta.marked_for_compaction = file.marked_for_compaction;
+    out.finished = true;
+    const std::string fname =
+        TableFileName(db_options_.db_paths, out.meta.fd.GetNumber(),
+                      out.meta.fd.GetPathId());
+    s = env_->RenameFile(
+        MakeTableFileName(result.output_path, file.file_number), fname);
+    if (!s.ok()) {
+      break;
+    }
+    sub_compact->outputs.push_back(out);
+    auto* meta = &sub_compact->current_output()->meta;
+
+    InternalIterator* iter = cfd->table_cache()->NewIterator(
+        ReadOptions(), env_options_, cfd->internal_comparator(), meta->fd,
+        nullptr, cfd->internal_stats()->GetFileReadHist(c->output_level()),
+        false);
+    s = iter->status();
+    if (s.ok() && paranoid_file_checks_) {
+      for (iter->SeekToFirst(); iter->Valid(); iter->Next()) {}
+      s = iter->status();
+    }
+    delete iter;
+    std::shared_ptr<const TableProperties> tp;
+    if (s.ok()) {
+      s = cfd->table_cache()->GetTableProperties(
+          env_options_, cfd->internal_comparator(), meta->fd, &tp);
+    }
+    if (!s.ok()) {
+      break;
+    }
+    sub_compact->current_output()->table_properties = tp;
+    sub_compact->total_bytes += meta->fd.GetFileSize();
+    meta->creation_time = tp->creation_time;
+
+    TableProperties props = *tp;
+    TableFileCreationInfo info(std::move(props));
+    info.db_name = dbname_;
+    info.cf_name = cfd->GetName();
+    info.file_path = fname;
+    info.file_size = meta->fd.GetFileSize();
+    info.job_id = job_id_;
+    Log(InfoLogLevel::INFO_LEVEL, db_options_.info_log,
+        "[%s] [JOB %d] Generated table #%" PRIu64 ": %" PRIu64
+        " keys, %" PRIu64 " bytes%s by compaction service %s",
+        cfd->GetName().c_str(), job_id_, meta->fd.GetNumber(),
+        tp->num_entries, meta->fd.GetFileSize(),
+        meta->marked_for_compaction ? " (need compaction)" : "",
+        db_options_.compaction_service->Name());
+    EventHelpers::LogAndNotifyTableFileCreation(
+        event_logger_, cfd->ioptions()->listeners, meta->fd, info);
+
+    auto sfm =
+        static_cast<SstFileManagerImpl*>(db_options_.sst_file_manager.get());
+    if (sfm && meta->fd.GetPathId() == 0) {
+      sfm->OnAddFile(fname);
+    }
+  }
+
+  if (s.ok()) {
+    sub_compact->num_input_records = result.num_input_records;
+    sub_compact->num_output_records = result.num_output_records;
+  } else {
+    // Forget the files that were moved in already, the subcompaction will be
+    // redone locally
+    for (const auto& out : sub_compact->outputs) {
+      TableCache::Evict(table_cache_.get(), out.meta.fd.GetNumber());
+      auto fname = TableFileName(db_options_.db_paths, out.meta.fd.GetNumber(),
+                                 out.meta.fd.GetPathId());
+      auto sfm =
+          static_cast<SstFileManagerImpl*>(db_options_.sst_file_manager.get());
+      if (sfm && out.meta.fd.GetPathId() == 0) {
+        sfm->OnDeleteFile(fname);
+      }
+      env_->DeleteFile(fname);
+    }
+    sub_compact->outputs.clear();
+    sub_compact->total_bytes = 0;
+  }
+  return s;
+}
+#endif  // !ROCKSDB_LITE
+
 void CompactionJob::ProcessKeyValueCompaction(SubcompactionState* sub_compact) {
   assert(sub_compact != nullptr);
+#ifndef ROCKSDB_LITE
+  if (db_options_.compaction_service != nullptr) {
+    Status s = ProcessKeyValueCompactionWithCompactionService(sub_compact);
+    if (s.ok()) {
+      return;
+    }
+    Log(InfoLogLevel::WARN_LEVEL, db_options_.info_log,
+        "[%s] [JOB %d] Compaction service %s failed, compacting locally: %s",
+        compact_->compaction->column_family_data()->GetName().c_str(),
+        job_id_, db_options_.compaction_service->Name(),
+        s.ToString().c_str());
+  }
+#endif  // !ROCKSDB_LITE
+  ColumnFamilyData* cfd = sub_compact->compaction->column_family_data();
+  RangeDelAggregator range_del_agg(cfd->internal_comparator(),
+                                   existing_snapshots_);
   std::unique_ptr<InternalIterator> input(
-      versions_->MakeInputIterator(sub_compact->compaction));
+      versions_->MakeInputIterator(sub_compact->compaction, &range_del_agg));
 
   AutoThreadOperationStageUpdater stage_updater(
       ThreadStatus::STAGE_COMPACTION_PROCESS_KV);
@@ -664,7 +943,6 @@ void CompactionJob::ProcessKeyValueCompaction(SubcompactionState* sub_compact) {
     prev_prepare_write_nanos = IOSTATS(prepare_write_nanos);
   }
 
-  ColumnFamilyData* cfd = sub_compact->compaction->column_family_data();
   auto compaction_filter = cfd->ioptions()->compaction_filter;
   std::unique_ptr<CompactionFilter> compaction_filter_from_factory = nullptr;
   if (compaction_filter == nullptr) {
@@ -696,7 +974,8 @@ void CompactionJob::ProcessKeyValueCompaction(SubcompactionState* sub_compact) {
   sub_compact->c_iter.reset(new CompactionIterator(
       input.get(), cfd->user_comparator(), &merge, versions_->LastSequence(),
       &existing_snapshots_, earliest_write_conflict_snapshot_, env_, false,
-      sub_compact->compaction, compaction_filter));
+      sub_compact->compaction, compaction_filter, nullptr /* log_buffer */,
+      &range_del_agg));
   auto c_iter = sub_compact->c_iter.get();
   c_iter->SeekToFirst();
   const auto& c_iter_stats = c_iter->iter_stats();
@@ -715,8 +994,11 @@ void CompactionJob::ProcessKeyValueCompaction(SubcompactionState* sub_compact) {
         cfd->user_comparator()->Compare(c_iter->user_key(), *end) >= 0) {
       break;
     } else if (sub_compact->ShouldStopBefore(key) &&
-               sub_compact->builder != nullptr) {
-      status = FinishCompactionOutputFile(input->status(), sub_compact);
+               sub_compact->builder != nullptr &&
+               !OutputFileContinuesUserKey(sub_compact, c_iter->user_key(),
+                                           range_del_agg)) {
+      status = FinishCompactionOutputFile(input->status(), sub_compact,
+                                          range_del_agg, &key);
       if (!status.ok()) {
         break;
       }
@@ -748,12 +1030,28 @@ void CompactionJob::ProcessKeyValueCompaction(SubcompactionState* sub_compact) {
     // during subcompactions (i.e. if output size, estimated by input size, is
     // going to be 1.2MB and max_output_file_size = 1MB, prefer to have 0.6MB
     // and 0.6MB instead of 1MB and 0.2MB)
-    if (sub_compact->builder->FileSize() >=
-        sub_compact->compaction->max_output_file_size()) {
-      status = FinishCompactionOutputFile(input->status(), sub_compact);
-    }
+    bool output_file_ended = sub_compact->builder->FileSize() >=
+                             sub_compact->compaction->max_output_file_size();
 
     c_iter->Next();
+
+    // The next output file starts at the next key, whose range deletions
+    // it holds
+    if (output_file_ended &&
+        !(c_iter->Valid() &&
+          OutputFileContinuesUserKey(sub_compact, c_iter->user_key(),
+                                     range_del_agg))) {
+      status = FinishCompactionOutputFile(
+          input->status(), sub_compact, range_del_agg,
+          c_iter->Valid() ? &c_iter->key() : nullptr);
+    }
+  }
+
+  if (status.ok() && sub_compact->builder == nullptr &&
+      sub_compact->outputs.empty() && !range_del_agg.IsEmpty()) {
+    // The subcompaction output has no keys, but may still need to hold
+    // range deletions. The file is dropped if it ends up empty.
+    status = OpenCompactionOutputFile(sub_compact);
   }
 
   sub_compact->num_input_records = c_iter_stats.num_input_records;
@@ -777,7 +1075,8 @@ void CompactionJob::ProcessKeyValueCompaction(SubcompactionState* sub_compact) {
         "Database shutdown or Column family drop during compaction");
   }
   if (status.ok() && sub_compact->builder != nullptr) {
-    status = FinishCompactionOutputFile(input->status(), sub_compact);
+    status = FinishCompactionOutputFile(input->status(), sub_compact,
+                                        range_del_agg);
   }
   if (status.ok()) {
     status = input->status();
@@ -827,8 +1126,25 @@ void CompactionJob::RecordDroppedKeys(
   }
 }
 
+// With range deletions, all the entries of a user key are kept in one output
+// file. Otherwise the range deletions covering the key would go into the
+// second file only, past the entries of the first file that they delete.
+bool CompactionJob::OutputFileContinuesUserKey(
+    SubcompactionState* sub_compact, const Slice& next_user_key,
+    const RangeDelAggregator& range_del_agg) {
+  if (range_del_agg.IsEmpty() || sub_compact->current_output() == nullptr ||
+      sub_compact->current_output()->meta.largest.size() == 0) {
+    return false;
+  }
+  ColumnFamilyData* cfd = sub_compact->compaction->column_family_data();
+  return cfd->user_comparator()->Equal(
+      sub_compact->current_output()->meta.largest.user_key(), next_user_key);
+}
+
 Status CompactionJob::FinishCompactionOutputFile(
-    const Status& input_status, SubcompactionState* sub_compact) {
+    const Status& input_status, SubcompactionState* sub_compact,
+    const RangeDelAggregator& range_del_agg,
+    const Slice* next_table_min_key) {
   AutoThreadOperationStageUpdater stage_updater(
       ThreadStatus::STAGE_COMPACTION_SYNC_FILE);
   assert(sub_compact != nullptr);
@@ -843,10 +1159,65 @@ Status CompactionJob::FinishCompactionOutputFile(
   // Check for iterator errors
   Status s = input_status;
   auto meta = &sub_compact->current_output()->meta;
+  if (s.ok() && !range_del_agg.IsEmpty()) {
+    // The first output file of the subcompaction also holds the range
+    // deletions before its first key, the others start where the previous
+    // one ended
+    Slice lower_bound_guard;
+    const Slice* lower_bound = sub_compact->start;
+    if (sub_compact->outputs.size() > 1 && meta->smallest.size() > 0) {
+      lower_bound_guard = meta->smallest.user_key();
+      lower_bound = &lower_bound_guard;
+    }
+    Slice upper_bound_guard;
+    const Slice* upper_bound = sub_compact->end;
+    if (next_table_min_key != nullptr) {
+      upper_bound_guard = ExtractUserKey(*next_table_min_key);
+      if (upper_bound == nullptr ||
+          sub_compact->compaction->column_family_data()
+                  ->user_comparator()
+                  ->Compare(upper_bound_guard, *upper_bound) < 0) {
+        upper_bound = &upper_bound_guard;
+      }
+    }
+    range_del_agg.AddToBuilder(sub_compact->builder.get(), lower_bound,
+                               upper_bound, meta, bottommost_level_);
+  }
   const uint64_t current_entries = sub_compact->builder->NumEntries();
+  if (s.ok() && current_entries == 0) {
+    // Only happens to a file opened for range deletions that all turned out
+    // to be outside the subcompaction or obsolete
+    sub_compact->builder->Abandon();
+    sub_compact->builder.reset();
+    sub_compact->outfile.reset();
+    env_->DeleteFile(
+        output_path_.empty()
+            ? TableFileName(db_options_.db_paths, output_number,
+                            meta->fd.GetPathId())
+            : MakeTableFileName(output_path_, output_number));
+    sub_compact->outputs.pop_back();
+    return s;
+  }
+  const Compaction* c = sub_compact->compaction;
+  if (c->output_level() == 0) {
+    // L0 files are ordered by sequence number. An L0->L0 output must cover
+    // the whole sequence number range of its inputs, even if the newest or
+    // oldest entries were dropped, so that it keeps its place among the L0
+    // files that were not compacted.
+    for (size_t i = 0; i < c->num_input_levels(); i++) {
+      for (size_t j = 0; j < c->num_input_files(i); j++) {
+        const FileMetaData* f = c->input(i, j);
+        meta->smallest_seqno =
+            std::min(meta->smallest_seqno, f->smallest_seqno);
+        meta->largest_seqno = std::max(meta->largest_seqno, f->largest_seqno);
+      }
+    }
+  }
   meta->marked_for_compaction = sub_compact->builder->NeedCompact();
   if (s.ok()) {
     s = sub_compact->builder->Finish();
+    meta->creation_time =
+        sub_compact->builder->GetTableProperties().creation_time;
   } else {
     sub_compact->builder->Abandon();
   }
@@ -865,7 +1236,13 @@ Status CompactionJob::FinishCompactionOutputFile(
   }
   sub_compact->outfile.reset();
 
-  if (s.ok() && current_entries > 0) {
+  if (s.ok() && current_entries > 0 && !output_path_.empty()) {
+    // The output is checked and reported by the DB that requested the
+    // compaction
+    sub_compact->current_output()->table_properties =
+        std::make_shared<TableProperties>(
+            sub_compact->builder->GetTableProperties());
+  } else if (s.ok() && current_entries > 0) {
     // Verify that the table is usable
     ColumnFamilyData* cfd = sub_compact->compaction->column_family_data();
     InternalIterator* iter = cfd->table_cache()->NewIterator(
@@ -907,7 +1284,7 @@ Status CompactionJob::FinishCompactionOutputFile(
   // Report new file to SstFileManagerImpl
   auto sfm =
       static_cast<SstFileManagerImpl*>(db_options_.sst_file_manager.get());
-  if (sfm && meta->fd.GetPathId() == 0) {
+  if (sfm && meta->fd.GetPathId() == 0 && output_path_.empty()) {
     ColumnFamilyData* cfd = sub_compact->compaction->column_family_data();
     auto fn = TableFileName(cfd->ioptions()->db_paths, meta->fd.GetNumber(),
                             meta->fd.GetPathId());
@@ -986,8 +1363,11 @@ Status CompactionJob::OpenCompactionOutputFile(
   uint64_t file_number = versions_->NewFileNumber();
   // Make the output file
   unique_ptr<WritableFile> writable_file;
-  std::string fname = TableFileName(db_options_.db_paths, file_number,
-                                    sub_compact->compaction->output_path_id());
+  std::string fname =
+      output_path_.empty()
+          ? TableFileName(db_options_.db_paths, file_number,
+                          sub_compact->compaction->output_path_id())
+          : MakeTableFileName(output_path_, file_number);
   Status s = NewWritableFile(env_, fname, &writable_file, env_options_);
   if (!s.ok()) {
     Log(InfoLogLevel::ERROR_LEVEL, db_options_.info_log,
@@ -49,6 +49,8 @@ class Version;
 class VersionEdit;
 class VersionSet;
 class Arena;
+struct CompactionServiceResult;
+struct RangeWithSize;
 
 class CompactionJob {
  public:
@@ -80,10 +82,24 @@ class CompactionJob {
   // REQUIRED: mutex held
   Status Install(const MutableCFOptions& mutable_cf_options);
 
+  // Used instead of Prepare(), Run() and Install() to run a compaction on
+  // behalf of another DB through its CompactionService. The compaction is
+  // run as a single subcompaction of the user key range [begin, end), where
+  // nullptr means unbounded, and its output files are written to the
+  // directory output_path. They are described in *result instead of being
+  // installed. begin and end must outlive the job.
+  // REQUIRED: mutex held
+  void PrepareForCompactionService(const std::string& output_path,
+                                   Slice* begin, Slice* end);
+  // REQUIRED: mutex not held
+  Status RunForCompactionService(CompactionServiceResult* result);
+
  private:
   struct SubcompactionState;
 
   void AggregateStatistics();
+  bool GenSubcompactionAnchors(std::vector<RangeWithSize>* ranges,
+                               uint64_t* sum);
   void GenSubcompactionBoundaries();
 
   // update the thread status for starting a compaction.
@@ -92,9 +108,21 @@ class CompactionJob {
   // Call compaction filter. Then iterate through input and compact the
   // kv-pairs
   void ProcessKeyValueCompaction(SubcompactionState* sub_compact);
-
+  // Hands the subcompaction to db_options_.compaction_service and moves the
+  // files it produced into the DB
+  Status ProcessKeyValueCompactionWithCompactionService(
+      SubcompactionState* sub_compact);
+
+  // Also writes the range deletions that fall between the previous output
+  // file of the subcompaction and next_table_min_key, the first key of the
+  // next output file, or the end of the subcompaction if it is null
   Status FinishCompactionOutputFile(const Status& input_status,
-                                    SubcompactionState* sub_compact);
+                                    SubcompactionState* sub_compact,
+                                    const RangeDelAggregator& range_del_agg,
+                                    const Slice* next_table_min_key = nullptr);
+  bool OutputFileContinuesUserKey(SubcompactionState* sub_compact,
+                                  const Slice& next_user_key,
+                                  const RangeDelAggregator& range_del_agg);
   Status InstallCompactionResults(const MutableCFOptions& mutable_cf_options);
   void RecordCompactionIOStats();
   Status OpenCompactionOutputFile(SubcompactionState* sub_compact);
@@ -149,6 +177,11 @@ class CompactionJob {
   bool bottommost_level_;
   bool paranoid_file_checks_;
   bool measure_io_stats_;
+  // The directory for the output files when running on behalf of a
+  // CompactionService. Empty for the paths of the DB.
+  std::string output_path_;
+  // Stores the user keys sampled from the index blocks of the input tables
+  std::vector<std::string> anchor_keys_;
   // Stores the Slices that designate the boundaries for each subcompaction
   std::vector<Slice> boundaries_;
   // Stores the approx size of keys covered in the range of each subcompaction
@@ -22,7 +22,6 @@
 #include "db/column_family.h"
 #include "db/filename.h"
 #include "util/log_buffer.h"
-#include "util/random.h"
 #include "util/statistics.h"
 #include "util/string_util.h"
 #include "util/sync_point.h"
@@ -873,6 +872,11 @@ bool LevelCompactionPicker::NeedsCompaction(const VersionStorageInfo* vstorage)
       return true;
     }
   }
+  for (const auto& level_file : vstorage->FilesMarkedForPeriodicCompaction()) {
+    if (!level_file.second->being_compacted) {
+      return true;
+    }
+  }
   return false;
 }
 
@@ -900,16 +904,8 @@ void LevelCompactionPicker::PickFilesMarkedForCompactionExperimental(
     return ExpandWhileOverlapping(cf_name, vstorage, inputs);
   };
 
-  // take a chance on a random file first
-  Random64 rnd(/* seed */ reinterpret_cast<uint64_t>(vstorage));
-  size_t random_file_index = static_cast<size_t>(rnd.Uniform(
-      static_cast<uint64_t>(vstorage->FilesMarkedForCompaction().size())));
-
-  if (continuation(vstorage->FilesMarkedForCompaction()[random_file_index])) {
-    // found the compaction!
-    return;
-  }
-
+  // The files are ordered by the density of their deletions, so the first
+  // one that can be compacted is the one that slows down the reads the most
   for (auto& level_file : vstorage->FilesMarkedForCompaction()) {
     if (continuation(level_file)) {
       // found the compaction!
@@ -919,6 +915,35 @@ void LevelCompactionPicker::PickFilesMarkedForCompactionExperimental(
   inputs->files.clear();
 }
 
+void LevelCompactionPicker::PickPeriodicCompaction(
+    const std::string& cf_name, VersionStorageInfo* vstorage,
+    CompactionInputFiles* inputs, int* level, int* output_level) {
+  // The last level with data is rewritten in place, so that the files are
+  // not pushed down one level per period
+  const int last_level = vstorage->num_non_empty_levels() - 1;
+  for (auto& level_file : vstorage->FilesMarkedForPeriodicCompaction()) {
+    if (level_file.second->being_compacted) {
+      continue;
+    }
+    *level = level_file.first;
+    if (*level == 0) {
+      if (!level0_compactions_in_progress_.empty()) {
+        continue;
+      }
+      *output_level = vstorage->base_level();
+    } else {
+      *output_level = (*level == last_level) ? *level : *level + 1;
+    }
+    inputs->files = {level_file.second};
+    inputs->level = *level;
+    if (ExpandWhileOverlapping(cf_name, vstorage, inputs)) {
+      // found the compaction!
+      return;
+    }
+  }
+  inputs->files.clear();
+}
+
 Compaction* LevelCompactionPicker::PickCompaction(
     const std::string& cf_name, const MutableCFOptions& mutable_cf_options,
     VersionStorageInfo* vstorage, LogBuffer* log_buffer) {
@@ -961,6 +986,15 @@ Compaction* LevelCompactionPicker::PickCompaction(
         inputs.clear();
         if (level == 0) {
           skipped_l0 = true;
+          // L0->base_level may be blocked by a running L0 compaction or by a
+          // compaction from base_level downwards. To keep the L0 file count,
+          // and with it the chance of a write stall, down, try merging a span
+          // of recently flushed files within L0 instead.
+          if (PickIntraL0Compaction(vstorage, mutable_cf_options, &inputs)) {
+            output_level = 0;
+            compaction_reason = CompactionReason::kLevelL0FilesNum;
+            break;
+          }
         }
       }
     }
@@ -978,14 +1012,25 @@ Compaction* LevelCompactionPicker::PickCompaction(
       compaction_reason = CompactionReason::kFilesMarkedForCompaction;
     }
   }
+  // Files older than periodic_compaction_seconds come last, they are not
+  // worth delaying any other compaction for
+  if (inputs.empty()) {
+    is_manual = false;
+    PickPeriodicCompaction(cf_name, vstorage, &inputs, &level, &output_level);
+    if (!inputs.empty()) {
+      compaction_reason = CompactionReason::kPeriodicCompaction;
+    }
+  }
   if (inputs.empty()) {
     return nullptr;
   }
   assert(level >= 0 && output_level >= 0);
 
   // Two level 0 compaction won't run at the same time, so don't need to worry
-  // about files on level 0 being compacted.
-  if (level == 0) {
+  // about files on level 0 being compacted. The only exception is an intra-L0
+  // compaction, whose inputs were already picked to avoid files being
+  // compacted.
+  if (level == 0 && output_level != 0) {
     assert(level0_compactions_in_progress_.empty());
     InternalKey smallest, largest;
     GetRange(inputs, &smallest, &largest);
@@ -1009,8 +1054,9 @@ Compaction* LevelCompactionPicker::PickCompaction(
   // Setup input files from output level
   CompactionInputFiles output_level_inputs;
   output_level_inputs.level = output_level;
-  if (!SetupOtherInputs(cf_name, mutable_cf_options, vstorage, &inputs,
-                   &output_level_inputs, &parent_index, base_index)) {
+  if (level != output_level &&
+      !SetupOtherInputs(cf_name, mutable_cf_options, vstorage, &inputs,
+                        &output_level_inputs, &parent_index, base_index)) {
     return nullptr;
   }
 
@@ -1019,12 +1065,21 @@ Compaction* LevelCompactionPicker::PickCompaction(
     compaction_inputs.push_back(output_level_inputs);
   }
 
+  // An intra-L0 compaction must produce exactly one file, whose sequence
+  // number range then sits between the older and the newer L0 files. So
+  // neither the file size nor the grandparent overlap may cut its output.
+  uint64_t max_output_file_size = port::kMaxUint64;
+  uint64_t max_grandparent_overlap_bytes = port::kMaxUint64;
   std::vector<FileMetaData*> grandparents;
-  GetGrandparents(vstorage, inputs, output_level_inputs, &grandparents);
+  if (output_level != 0) {
+    max_output_file_size = mutable_cf_options.MaxFileSizeForLevel(output_level);
+    max_grandparent_overlap_bytes =
+        mutable_cf_options.MaxGrandParentOverlapBytes(level);
+    GetGrandparents(vstorage, inputs, output_level_inputs, &grandparents);
+  }
   auto c = new Compaction(
       vstorage, mutable_cf_options, std::move(compaction_inputs), output_level,
-      mutable_cf_options.MaxFileSizeForLevel(output_level),
-      mutable_cf_options.MaxGrandParentOverlapBytes(level),
+      max_output_file_size, max_grandparent_overlap_bytes,
       GetPathId(ioptions_, mutable_cf_options, output_level),
       GetCompressionType(ioptions_, output_level, vstorage->base_level()),
       std::move(grandparents), is_manual, score,
@@ -1150,6 +1205,54 @@ bool LevelCompactionPicker::PickCompactionBySize(VersionStorageInfo* vstorage,
   return inputs->size() > 0;
 }
 
+bool LevelCompactionPicker::PickIntraL0Compaction(
+    VersionStorageInfo* vstorage, const MutableCFOptions& mutable_cf_options,
+    CompactionInputFiles* inputs) {
+  inputs->clear();
+  const std::vector<FileMetaData*>& level_files = vstorage->LevelFiles(0);
+  // If L0 isn't accumulating many files beyond the regular trigger, don't
+  // resort to an L0->L0 compaction yet.
+  if (level_files.size() <
+          static_cast<size_t>(
+              mutable_cf_options.level0_file_num_compaction_trigger + 2) ||
+      level_files[0]->being_compacted) {
+    return false;
+  }
+
+  // Level 0 files are sorted newest first. Only a span starting at the newest
+  // file is picked, so the output file is newer than every L0 file left
+  // behind, including those of a running L0->base_level compaction.
+  const uint64_t max_compaction_bytes =
+      mutable_cf_options.ExpandedCompactionByteSizeLimit(0);
+  uint64_t compact_bytes = level_files[0]->fd.GetFileSize();
+  uint64_t compact_bytes_per_del_file = port::kMaxUint64;
+  // Compaction range will be [0, limit).
+  size_t limit;
+  // Pull in files until the amount of compaction work per deleted file begins
+  // increasing or the maximum total compaction size is reached.
+  for (limit = 1; limit < level_files.size(); ++limit) {
+    if (level_files[limit]->being_compacted) {
+      break;
+    }
+    compact_bytes += level_files[limit]->fd.GetFileSize();
+    uint64_t new_compact_bytes_per_del_file = compact_bytes / limit;
+    if (new_compact_bytes_per_del_file > compact_bytes_per_del_file ||
+        compact_bytes > max_compaction_bytes) {
+      break;
+    }
+    compact_bytes_per_del_file = new_compact_bytes_per_del_file;
+  }
+
+  if (limit < kMinFilesForIntraL0Compaction) {
+    return false;
+  }
+  inputs->level = 0;
+  inputs->files.assign(level_files.begin(), level_files.begin() + limit);
+  TEST_SYNC_POINT_CALLBACK("LevelCompactionPicker::PickIntraL0Compaction",
+                           inputs);
+  return true;
+}
+
 #ifndef ROCKSDB_LITE
 bool UniversalCompactionPicker::NeedsCompaction(
     const VersionStorageInfo* vstorage) const {
@@ -1772,7 +1875,42 @@ Compaction* UniversalCompactionPicker::PickCompactionUniversalSizeAmp(
 bool FIFOCompactionPicker::NeedsCompaction(const VersionStorageInfo* vstorage)
     const {
   const int kLevel0 = 0;
-  return vstorage->CompactionScore(kLevel0) >= 1;
+  if (vstorage->CompactionScore(kLevel0) >= 1) {
+    return true;
+  }
+  for (const auto& level_file : vstorage->FilesMarkedForPeriodicCompaction()) {
+    if (!level_file.second->being_compacted) {
+      return true;
+    }
+  }
+  return false;
+}
+
+Compaction* FIFOCompactionPicker::PickTtlCompaction(
+    const std::string& cf_name, const MutableCFOptions& mutable_cf_options,
+    VersionStorageInfo* vstorage, LogBuffer* log_buffer) {
+  std::vector<CompactionInputFiles> inputs;
+  inputs.emplace_back();
+  inputs[0].level = 0;
+  for (const auto& level_file : vstorage->FilesMarkedForPeriodicCompaction()) {
+    auto f = level_file.second;
+    if (f->being_compacted) {
+      continue;
+    }
+    inputs[0].files.push_back(f);
+    LogToBuffer(log_buffer, "[%s] FIFO compaction: picking file %" PRIu64
+                            " created at %" PRIu64 " for deletion",
+                cf_name.c_str(), f->fd.GetNumber(), f->creation_time);
+  }
+  if (inputs[0].files.empty()) {
+    return nullptr;
+  }
+  Compaction* c = new Compaction(
+      vstorage, mutable_cf_options, std::move(inputs), 0, 0, 0, 0,
+      kNoCompression, {}, /* is manual */ false, vstorage->CompactionScore(0),
+      /* is deletion compaction */ true, CompactionReason::kFIFOTtl);
+  level0_compactions_in_progress_.insert(c);
+  return c;
 }
 
 Compaction* FIFOCompactionPicker::PickCompaction(
@@ -1786,6 +1924,16 @@ Compaction* FIFOCompactionPicker::PickCompaction(
     total_size += file->fd.file_size;
   }
 
+  // The expired files go first, whatever the total size
+  if (!vstorage->FilesMarkedForPeriodicCompaction().empty() &&
+      level0_compactions_in_progress_.empty()) {
+    Compaction* c =
+        PickTtlCompaction(cf_name, mutable_cf_options, vstorage, log_buffer);
+    if (c != nullptr) {
+      return c;
+    }
+  }
+
   if (total_size <= ioptions_.compaction_options_fifo.max_table_files_size ||
       level_files.size() == 0) {
     // total size not exceeded
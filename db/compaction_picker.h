@@ -217,6 +217,24 @@ class LevelCompactionPicker : public CompactionPicker {
                                                 VersionStorageInfo* vstorage,
                                                 CompactionInputFiles* inputs,
                                                 int* level, int* output_level);
+
+  // Put the oldest file that is due for a periodic compaction, and is not
+  // being compacted, into inputs. A file of the last level with data is
+  // rewritten in place, any other one is compacted into the next level.
+  void PickPeriodicCompaction(const std::string& cf_name,
+                             VersionStorageInfo* vstorage,
+                             CompactionInputFiles* inputs, int* level,
+                             int* output_level);
+
+  // Pick a span of the newest L0 files that can be merged into a single,
+  // larger L0 file while L0->base_level compaction is blocked. Returns false
+  // unless L0 holds more than level0_file_num_compaction_trigger + 1 files
+  // and at least kMinFilesForIntraL0Compaction of them can be picked.
+  bool PickIntraL0Compaction(VersionStorageInfo* vstorage,
+                             const MutableCFOptions& mutable_cf_options,
+                             CompactionInputFiles* inputs);
+
+  static const size_t kMinFilesForIntraL0Compaction = 4;
 };
 
 #ifndef ROCKSDB_LITE
@@ -313,6 +331,14 @@ class FIFOCompactionPicker : public CompactionPicker {
 
   virtual bool NeedsCompaction(const VersionStorageInfo* vstorage) const
       override;
+
+ private:
+  // Deletes the files older than CompactionOptionsFIFO::ttl that are not
+  // being compacted. Returns nullptr if there are none.
+  Compaction* PickTtlCompaction(const std::string& cf_name,
+                                const MutableCFOptions& mutable_cf_options,
+                                VersionStorageInfo* vstorage,
+                                LogBuffer* log_buffer);
 };
 
 class NullCompactionPicker : public CompactionPicker {
@@ -760,6 +760,105 @@ TEST_F(CompactionPickerTest, NotScheduleL1IfL0WithHigherPri3) {
   ASSERT_TRUE(compaction.get() != nullptr);
 }
 
+TEST_F(CompactionPickerTest, IntraL0WhenL0ToBaseBlocked) {
+  NewVersionStorage(6, kCompactionStyleLevel);
+  mutable_cf_options_.level0_file_num_compaction_trigger = 2;
+
+  // 5 L0 files of the same size, newest first
+  Add(0, 1U, "100", "150", 1000U, 0, 50, 59);
+  Add(0, 2U, "110", "160", 1000U, 0, 40, 49);
+  Add(0, 3U, "120", "170", 1000U, 0, 30, 39);
+  Add(0, 4U, "130", "180", 1000U, 0, 20, 29);
+  Add(0, 5U, "140", "190", 1000U, 0, 10, 19);
+
+  // L0->L1 is blocked by the overlapping L1 file being compacted
+  Add(1, 6U, "100", "200", 1000U, 0, 0, 0);
+  file_map_[6u].first->being_compacted = true;
+
+  UpdateVersionStorageInfo();
+
+  std::unique_ptr<Compaction> compaction(level_compaction_picker.PickCompaction(
+      cf_name_, mutable_cf_options_, vstorage_.get(), &log_buffer_));
+  ASSERT_TRUE(compaction.get() != nullptr);
+  ASSERT_EQ(0, compaction->output_level());
+  ASSERT_EQ(1U, compaction->num_input_levels());
+  ASSERT_EQ(5U, compaction->num_input_files(0));
+  ASSERT_EQ(1U, compaction->input(0, 0)->fd.GetNumber());
+  ASSERT_EQ(5U, compaction->input(0, 4)->fd.GetNumber());
+  ASSERT_EQ(CompactionReason::kLevelL0FilesNum,
+            compaction->compaction_reason());
+  ASSERT_FALSE(compaction->bottommost_level());
+}
+
+TEST_F(CompactionPickerTest, IntraL0SkipsFilesBeingCompacted) {
+  NewVersionStorage(6, kCompactionStyleLevel);
+  mutable_cf_options_.level0_file_num_compaction_trigger = 2;
+
+  // The two oldest files are part of a running L0->L1 compaction
+  Add(0, 1U, "100", "150", 1000U, 0, 70, 79);
+  Add(0, 2U, "110", "160", 1000U, 0, 60, 69);
+  Add(0, 3U, "120", "170", 1000U, 0, 50, 59);
+  Add(0, 4U, "130", "180", 1000U, 0, 40, 49);
+  Add(0, 5U, "140", "190", 1000U, 0, 30, 39);
+  Add(0, 6U, "100", "200", 1000U, 0, 20, 29);
+  Add(0, 7U, "100", "200", 1000U, 0, 10, 19);
+  file_map_[6u].first->being_compacted = true;
+  file_map_[7u].first->being_compacted = true;
+  Add(1, 8U, "100", "200", 1000U, 0, 0, 0);
+  file_map_[8u].first->being_compacted = true;
+
+  UpdateVersionStorageInfo();
+
+  std::unique_ptr<Compaction> compaction(level_compaction_picker.PickCompaction(
+      cf_name_, mutable_cf_options_, vstorage_.get(), &log_buffer_));
+  ASSERT_TRUE(compaction.get() != nullptr);
+  ASSERT_EQ(0, compaction->output_level());
+  ASSERT_EQ(5U, compaction->num_input_files(0));
+  ASSERT_EQ(1U, compaction->input(0, 0)->fd.GetNumber());
+  ASSERT_EQ(5U, compaction->input(0, 4)->fd.GetNumber());
+}
+
+TEST_F(CompactionPickerTest, IntraL0StopsWhenWorkPerFileIncreases) {
+  NewVersionStorage(6, kCompactionStyleLevel);
+  mutable_cf_options_.level0_file_num_compaction_trigger = 2;
+
+  // Merging the large file would not pay off
+  Add(0, 1U, "100", "150", 1000U, 0, 50, 59);
+  Add(0, 2U, "110", "160", 1000U, 0, 40, 49);
+  Add(0, 3U, "120", "170", 1000U, 0, 30, 39);
+  Add(0, 4U, "130", "180", 1000U, 0, 20, 29);
+  Add(0, 5U, "140", "190", 100000U, 0, 10, 19);
+  Add(1, 6U, "100", "200", 1000U, 0, 0, 0);
+  file_map_[6u].first->being_compacted = true;
+
+  UpdateVersionStorageInfo();
+
+  std::unique_ptr<Compaction> compaction(level_compaction_picker.PickCompaction(
+      cf_name_, mutable_cf_options_, vstorage_.get(), &log_buffer_));
+  ASSERT_TRUE(compaction.get() != nullptr);
+  ASSERT_EQ(0, compaction->output_level());
+  ASSERT_EQ(4U, compaction->num_input_files(0));
+  ASSERT_EQ(4U, compaction->input(0, 3)->fd.GetNumber());
+}
+
+TEST_F(CompactionPickerTest, NoIntraL0WithFewFiles) {
+  NewVersionStorage(6, kCompactionStyleLevel);
+  mutable_cf_options_.level0_file_num_compaction_trigger = 2;
+
+  // Not enough files beyond the trigger for an intra-L0 compaction
+  Add(0, 1U, "100", "150", 1000U, 0, 30, 39);
+  Add(0, 2U, "110", "160", 1000U, 0, 20, 29);
+  Add(0, 3U, "120", "170", 1000U, 0, 10, 19);
+  Add(1, 6U, "100", "200", 1000U, 0, 0, 0);
+  file_map_[6u].first->being_compacted = true;
+
+  UpdateVersionStorageInfo();
+
+  std::unique_ptr<Compaction> compaction(level_compaction_picker.PickCompaction(
+      cf_name_, mutable_cf_options_, vstorage_.get(), &log_buffer_));
+  ASSERT_TRUE(compaction.get() == nullptr);
+}
+
 TEST_F(CompactionPickerTest, EstimateCompactionBytesNeeded1) {
   int num_levels = ioptions_.num_levels;
   ioptions_.level_compaction_dynamic_level_bytes = false;
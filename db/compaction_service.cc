@@ -0,0 +1,275 @@
+//  Copyright (c) 2011-present, Facebook, Inc.  All rights reserved.
+//  This source code is licensed under the BSD-style license found in the
+//  LICENSE file in the root directory of this source tree. An additional grant
+//  of patent rights can be found in the PATENTS file in the same directory.
+
+#include "db/compaction_service.h"
+
+#include <string.h>
+
+#include "util/logging.h"
+#include "util/string_util.h"
+
+namespace rocksdb {
+
+namespace {
+
+void PutNumber(std::string* dst, const char* name, uint64_t value) {
+  dst->append(name);
+  dst->push_back('=');
+  AppendNumberTo(dst, value);
+  dst->push_back('\n');
+}
+
+void PutHex(std::string* dst, const char* name, const Slice& value) {
+  dst->append(name);
+  dst->push_back('=');
+  dst->append(value.ToString(true));
+  dst->push_back('\n');
+}
+
+void AppendNumberList(std::string* dst, const std::vector<uint64_t>& values) {
+  for (size_t i = 0; i < values.size(); i++) {
+    if (i > 0) {
+      dst->push_back(',');
+    }
+    AppendNumberTo(dst, values[i]);
+  }
+}
+
+void PutInputLevel(std::string* dst, const char* name,
+                   const CompactionServiceInput::InputLevel& input_level) {
+  dst->append(name);
+  dst->push_back('=');
+  AppendNumberTo(dst, static_cast<uint64_t>(input_level.level));
+  dst->push_back(':');
+  AppendNumberList(dst, input_level.files);
+  dst->push_back('\n');
+}
+
+bool ParseNumber(Slice in, uint64_t* value) {
+  return ConsumeDecimalNumber(&in, value) && in.empty();
+}
+
+bool ParseNumberList(const Slice& in, std::vector<uint64_t>* values) {
+  values->clear();
+  if (in.empty()) {
+    return true;
+  }
+  for (const auto& item : StringSplit(in.ToString(), ',')) {
+    uint64_t value;
+    if (!ParseNumber(item, &value)) {
+      return false;
+    }
+    values->push_back(value);
+  }
+  return true;
+}
+
+bool ParseInputLevel(const Slice& in,
+                     CompactionServiceInput::InputLevel* input_level) {
+  const char* colon =
+      static_cast<const char*>(memchr(in.data(), ':', in.size()));
+  if (colon == nullptr) {
+    return false;
+  }
+  uint64_t level;
+  if (!ParseNumber(Slice(in.data(), colon - in.data()), &level)) {
+    return false;
+  }
+  input_level->level = static_cast<int>(level);
+  return ParseNumberList(
+      Slice(colon + 1, in.size() - (colon - in.data()) - 1),
+      &input_level->files);
+}
+
+// Calls handler(name, value) for every "name=value" line of `src` and stops
+// at the first line that the handler can't parse.
+template <typename Handler>
+Status ForEachLine(const Slice& src, const char* what, Handler handler) {
+  for (const auto& line : StringSplit(src.ToString(), '\n')) {
+    if (line.empty()) {
+      continue;
+    }
+    size_t pos = line.find('=');
+    if (pos == std::string::npos ||
+        !handler(line.substr(0, pos), line.substr(pos + 1))) {
+      return Status::Corruption(std::string("Bad ") + what + " line", line);
+    }
+  }
+  return Status::OK();
+}
+
+}  // namespace
+
+CompactionServiceInput::CompactionServiceInput()
+    : earliest_write_conflict_snapshot(kMaxSequenceNumber),
+      last_sequence(0),
+      output_level(0),
+      output_path_id(0),
+      max_output_file_size(0),
+      max_grandparent_overlap_bytes(0),
+      compression(kNoCompression),
+      manual_compaction(false),
+      compaction_reason(CompactionReason::kUnknown),
+      has_begin(false),
+      has_end(false) {
+  grandparents.level = 0;
+}
+
+void CompactionServiceInput::EncodeTo(std::string* dst) const {
+  PutHex(dst, "column_family", column_family_name);
+  dst->append("snapshots=");
+  AppendNumberList(dst, snapshots);
+  dst->push_back('\n');
+  PutNumber(dst, "earliest_write_conflict_snapshot",
+            earliest_write_conflict_snapshot);
+  PutNumber(dst, "last_sequence", last_sequence);
+  for (const auto& input_level : inputs) {
+    PutInputLevel(dst, "input", input_level);
+  }
+  PutInputLevel(dst, "grandparents", grandparents);
+  PutNumber(dst, "output_level", output_level);
+  PutNumber(dst, "output_path_id", output_path_id);
+  PutNumber(dst, "max_output_file_size", max_output_file_size);
+  PutNumber(dst, "max_grandparent_overlap_bytes",
+            max_grandparent_overlap_bytes);
+  PutNumber(dst, "compression", static_cast<uint64_t>(compression));
+  PutNumber(dst, "manual_compaction", manual_compaction ? 1 : 0);
+  PutNumber(dst, "compaction_reason",
+            static_cast<uint64_t>(compaction_reason));
+  if (has_begin) {
+    PutHex(dst, "begin", begin);
+  }
+  if (has_end) {
+    PutHex(dst, "end", end);
+  }
+}
+
+Status CompactionServiceInput::DecodeFrom(const Slice& src) {
+  *this = CompactionServiceInput();
+  return ForEachLine(src, "compaction input", [this](const std::string& name,
+                                                     const Slice& value) {
+    uint64_t n = 0;
+    if (name == "column_family") {
+      return value.DecodeHex(&column_family_name);
+    } else if (name == "snapshots") {
+      return ParseNumberList(value, &snapshots);
+    } else if (name == "earliest_write_conflict_snapshot") {
+      return ParseNumber(value, &earliest_write_conflict_snapshot);
+    } else if (name == "last_sequence") {
+      return ParseNumber(value, &last_sequence);
+    } else if (name == "input") {
+      inputs.emplace_back();
+      return ParseInputLevel(value, &inputs.back());
+    } else if (name == "grandparents") {
+      return ParseInputLevel(value, &grandparents);
+    } else if (name == "output_level") {
+      bool ok = ParseNumber(value, &n);
+      output_level = static_cast<int>(n);
+      return ok;
+    } else if (name == "output_path_id") {
+      bool ok = ParseNumber(value, &n);
+      output_path_id = static_cast<uint32_t>(n);
+      return ok;
+    } else if (name == "max_output_file_size") {
+      return ParseNumber(value, &max_output_file_size);
+    } else if (name == "max_grandparent_overlap_bytes") {
+      return ParseNumber(value, &max_grandparent_overlap_bytes);
+    } else if (name == "compression") {
+      bool ok = ParseNumber(value, &n);
+      compression = static_cast<CompressionType>(n);
+      return ok;
+    } else if (name == "manual_compaction") {
+      bool ok = ParseNumber(value, &n);
+      manual_compaction = n != 0;
+      return ok;
+    } else if (name == "compaction_reason") {
+      bool ok = ParseNumber(value, &n);
+      compaction_reason = static_cast<CompactionReason>(n);
+      return ok;
+    } else if (name == "begin") {
+      has_begin = true;
+      return value.DecodeHex(&begin);
+    } else if (name == "end") {
+      has_end = true;
+      return value.DecodeHex(&end);
+    }
+    // Ignore fields added by newer versions
+    return true;
+  });
+}
+
+CompactionServiceResult::CompactionServiceResult()
+    : num_input_records(0), num_output_records(0), total_bytes(0) {}
+
+void CompactionServiceResult::EncodeTo(std::string* dst) const {
+  PutHex(dst, "status", status.ToString());
+  PutHex(dst, "output_path", output_path);
+  for (const auto& file : output_files) {
+    dst->append("output_file=");
+    AppendNumberTo(dst, file.file_number);
+    dst->push_back(',');
+    AppendNumberTo(dst, file.file_size);
+    dst->push_back(',');
+    AppendNumberTo(dst, file.smallest_seqno);
+    dst->push_back(',');
+    AppendNumberTo(dst, file.largest_seqno);
+    dst->push_back(',');
+    dst->append(Slice(file.smallest).ToString(true));
+    dst->push_back(',');
+    dst->append(Slice(file.largest).ToString(true));
+    dst->push_back(',');
+    dst->push_back(file.marked_for_compaction ? '1' : '0');
+    dst->push_back('\n');
+  }
+  PutNumber(dst, "num_input_records", num_input_records);
+  PutNumber(dst, "num_output_records", num_output_records);
+  PutNumber(dst, "total_bytes", total_bytes);
+}
+
+Status CompactionServiceResult::DecodeFrom(const Slice& src) {
+  *this = CompactionServiceResult();
+  return ForEachLine(src, "compaction result", [this](const std::string& name,
+                                                      const Slice& value) {
+    if (name == "status") {
+      std::string message;
+      if (!value.DecodeHex(&message)) {
+        return false;
+      }
+      status = message == Status::OK().ToString()
+                   ? Status::OK()
+                   : Status::Aborted("Remote compaction failed", message);
+      return true;
+    } else if (name == "output_path") {
+      return value.DecodeHex(&output_path);
+    } else if (name == "output_file") {
+      std::vector<std::string> fields = StringSplit(value.ToString(), ',');
+      if (fields.size() != 7) {
+        return false;
+      }
+      uint64_t marked = 0;
+      OutputFile file;
+      bool ok = ParseNumber(fields[0], &file.file_number) &&
+                ParseNumber(fields[1], &file.file_size) &&
+                ParseNumber(fields[2], &file.smallest_seqno) &&
+                ParseNumber(fields[3], &file.largest_seqno) &&
+                Slice(fields[4]).DecodeHex(&file.smallest) &&
+                Slice(fields[5]).DecodeHex(&file.largest) &&
+                ParseNumber(fields[6], &marked);
+      file.marked_for_compaction = marked != 0;
+      output_files.push_back(std::move(file));
+      return ok;
+    } else if (name == "num_input_records") {
+      return ParseNumber(value, &num_input_records);
+    } else if (name == "num_output_records") {
+      return ParseNumber(value, &num_output_records);
+    } else if (name == "total_bytes") {
+      return ParseNumber(value, &total_bytes);
+    }
+    // Ignore fields added by newer versions
+    return true;
+  });
+}
+
+}  // namespace rocksdb
@@ -0,0 +1,90 @@
+//  Copyright (c) 2011-present, Facebook, Inc.  All rights reserved.
+//  This source code is licensed under the BSD-style license found in the
+//  LICENSE file in the root directory of this source tree. An additional grant
+//  of patent rights can be found in the PATENTS file in the same directory.
+//
+// The descriptions of a compaction and of its outputs that are exchanged with
+// a CompactionService. Both are encoded as lines of "name=value", so that
+// they can be passed through files or any other byte-oriented channel and
+// inspected by hand. Keys and names are hex encoded.
+
+#pragma once
+
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+#include "db/dbformat.h"
+#include "rocksdb/listener.h"
+#include "rocksdb/options.h"
+#include "rocksdb/slice.h"
+#include "rocksdb/status.h"
+
+namespace rocksdb {
+
+struct CompactionServiceInput {
+  struct InputLevel {
+    int level;
+    std::vector<uint64_t> files;
+  };
+
+  std::string column_family_name;
+  std::vector<SequenceNumber> snapshots;
+  SequenceNumber earliest_write_conflict_snapshot;
+  SequenceNumber last_sequence;
+
+  // The input files, identified by file number, by level
+  std::vector<InputLevel> inputs;
+  // The files of the level below the output level that overlap the
+  // compaction, used to cut the output files
+  InputLevel grandparents;
+
+  int output_level;
+  uint32_t output_path_id;
+  uint64_t max_output_file_size;
+  uint64_t max_grandparent_overlap_bytes;
+  CompressionType compression;
+  bool manual_compaction;
+  CompactionReason compaction_reason;
+
+  // The user key range of the subcompaction to run. 'begin' is inclusive,
+  // 'end' is exclusive, and an absent bound means unbounded.
+  bool has_begin;
+  std::string begin;
+  bool has_end;
+  std::string end;
+
+  CompactionServiceInput();
+
+  void EncodeTo(std::string* dst) const;
+  Status DecodeFrom(const Slice& src);
+};
+
+struct CompactionServiceResult {
+  struct OutputFile {
+    // The number of the file in 'output_path', see MakeTableFileName()
+    uint64_t file_number;
+    uint64_t file_size;
+    SequenceNumber smallest_seqno;
+    SequenceNumber largest_seqno;
+    // Internal keys
+    std::string smallest;
+    std::string largest;
+    bool marked_for_compaction;
+  };
+
+  Status status;
+  // The directory that holds the output files
+  std::string output_path;
+  std::vector<OutputFile> output_files;
+  uint64_t num_input_records;
+  uint64_t num_output_records;
+  uint64_t total_bytes;
+
+  CompactionServiceResult();
+
+  void EncodeTo(std::string* dst) const;
+  Status DecodeFrom(const Slice& src);
+};
+
+}  // namespace rocksdb
@@ -0,0 +1,326 @@
+//  Copyright (c) 2011-present, Facebook, Inc.  All rights reserved.
+//  This source code is licensed under the BSD-style license found in the
+//  LICENSE file in the root directory of this source tree. An additional grant
+//  of patent rights can be found in the PATENTS file in the same directory.
+
+#if !defined(ROCKSDB_LITE)
+
+#include <atomic>
+#include <thread>
+
+#include "db/compaction_service.h"
+#include "db/db_test_util.h"
+#include "port/stack_trace.h"
+#include "rocksdb/compaction_service.h"
+#include "rocksdb/utilities/shared_dir_compaction_service.h"
+
+namespace rocksdb {
+
+namespace {
+
+// Runs the compactions in the same process, but through the same code as a
+// worker process would
+class InProcessCompactionService : public CompactionService {
+ public:
+  explicit InProcessCompactionService(const std::string& output_root)
+      : output_root_(output_root), fail_(false), num_runs_(0) {}
+
+  virtual const char* Name() const override {
+    return "InProcessCompactionService";
+  }
+
+  virtual Status Run(const std::string& db_name, int job_id,
+                     const std::string& input, std::string* result) override {
+    int run = num_runs_.fetch_add(1);
+    if (fail_) {
+      return Status::IOError("Injected compaction service failure");
+    }
+    return DB::OpenAndCompact(options_, db_name,
+                              output_root_ + "/" + ToString(run), input,
+                              result);
+  }
+
+  Options options_;
+  const std::string output_root_;
+  bool fail_;
+  std::atomic<int> num_runs_;
+};
+
+void DestroyDir(Env* env, const std::string& dir) {
+  std::vector<std::string> children;
+  if (env->GetChildren(dir, &children).ok()) {
+    for (const auto& child : children) {
+      if (child != "." && child != ".." &&
+          !env->DeleteFile(dir + "/" + child).ok()) {
+        DestroyDir(env, dir + "/" + child);
+      }
+    }
+  }
+  env->DeleteDir(dir);
+}
+
+}  // namespace
+
+class CompactionServiceTest : public DBTestBase {
+ public:
+  CompactionServiceTest() : DBTestBase("/compaction_service_test") {
+    service_dir_ = test::TmpDir(env_) + "/compaction_service_test_dir";
+    DestroyDir(env_, service_dir_);
+  }
+
+  ~CompactionServiceTest() { DestroyDir(env_, service_dir_); }
+
+  Options ServiceOptions(std::shared_ptr<CompactionService> service) {
+    Options options = CurrentOptions();
+    options.disable_auto_compactions = true;
+    options.compaction_service = service;
+    return options;
+  }
+
+  // Writes 4 overlapping L0 files, with a snapshot taken after the first
+  void GenerateFiles() {
+    for (int file = 0; file < 4; file++) {
+      for (int i = 0; i < 100; i++) {
+        ASSERT_OK(Put(Key(i), "v" + ToString(file)));
+      }
+      if (file == 0) {
+        snapshot_ = db_->GetSnapshot();
+      }
+      ASSERT_OK(Flush());
+    }
+    ASSERT_OK(Delete(Key(0)));
+    ASSERT_OK(Flush());
+    ASSERT_EQ("5", FilesPerLevel());
+  }
+
+  void VerifyData() {
+    ASSERT_EQ("NOT_FOUND", Get(Key(0)));
+    for (int i = 1; i < 100; i++) {
+      ASSERT_EQ("v3", Get(Key(i)));
+    }
+    if (snapshot_ != nullptr) {
+      for (int i = 0; i < 100; i++) {
+        ASSERT_EQ("v0", Get(Key(i), snapshot_));
+      }
+    }
+  }
+
+  void ReleaseSnapshot() {
+    db_->ReleaseSnapshot(snapshot_);
+    snapshot_ = nullptr;
+  }
+
+  std::string service_dir_;
+  const Snapshot* snapshot_ = nullptr;
+};
+
+TEST_F(CompactionServiceTest, InProcessService) {
+  auto service = std::make_shared<InProcessCompactionService>(service_dir_);
+  Options options = ServiceOptions(service);
+  DestroyAndReopen(options);
+  service->options_ = db_->GetOptions();
+  GenerateFiles();
+
+  ASSERT_OK(db_->CompactRange(CompactRangeOptions(), nullptr, nullptr));
+  ASSERT_GT(service->num_runs_.load(), 0);
+  ASSERT_EQ("0,1", FilesPerLevel());
+  VerifyData();
+
+  // Only the versions visible to the snapshot were kept
+  ASSERT_EQ("[ DEL, v0 ]", AllEntriesFor(Key(0)));
+  ASSERT_EQ("[ v3, v0 ]", AllEntriesFor(Key(1)));
+
+  // The output files were moved into the DB
+  ReleaseSnapshot();
+  Reopen(options);
+  VerifyData();
+}
+
+TEST_F(CompactionServiceTest, FallbackToLocalCompaction) {
+  auto service = std::make_shared<InProcessCompactionService>(service_dir_);
+  service->fail_ = true;
+  DestroyAndReopen(ServiceOptions(service));
+  GenerateFiles();
+
+  ASSERT_OK(db_->CompactRange(CompactRangeOptions(), nullptr, nullptr));
+  ASSERT_GT(service->num_runs_.load(), 0);
+  ASSERT_EQ("0,1", FilesPerLevel());
+  VerifyData();
+  ReleaseSnapshot();
+}
+
+TEST_F(CompactionServiceTest, SharedDirService) {
+  Options options = ServiceOptions(NewSharedDirCompactionService(
+      env_, service_dir_, 60000000 /* timeout_micros */,
+      1000 /* poll_interval_micros */));
+  DestroyAndReopen(options);
+  Options worker_options = db_->GetOptions();
+
+  std::atomic<bool> stop(false);
+  std::atomic<int> num_requests(0);
+  std::thread worker([&]() {
+    while (!stop.load()) {
+      bool found = false;
+      ASSERT_OK(RunSharedDirCompactionRequest(worker_options, service_dir_,
+                                              &found));
+      if (found) {
+        num_requests++;
+      } else {
+        env_->SleepForMicroseconds(1000);
+      }
+    }
+  });
+
+  GenerateFiles();
+  ASSERT_OK(db_->CompactRange(CompactRangeOptions(), nullptr, nullptr));
+  stop = true;
+  worker.join();
+
+  ASSERT_GT(num_requests.load(), 0);
+  ASSERT_EQ("0,1", FilesPerLevel());
+  VerifyData();
+
+  // Only empty output directories may be left behind
+  std::vector<std::string> children;
+  ASSERT_OK(env_->GetChildren(service_dir_, &children));
+  for (const auto& child : children) {
+    if (child == "." || child == "..") {
+      continue;
+    }
+    std::vector<std::string> outputs;
+    ASSERT_OK(env_->GetChildren(service_dir_ + "/" + child, &outputs));
+    for (const auto& output : outputs) {
+      ASSERT_TRUE(output == "." || output == "..");
+    }
+  }
+  ReleaseSnapshot();
+}
+
+TEST_F(CompactionServiceTest, SharedDirServiceWithoutWorker) {
+  DestroyAndReopen(ServiceOptions(NewSharedDirCompactionService(
+      env_, service_dir_, 10000 /* timeout_micros */,
+      1000 /* poll_interval_micros */)));
+  GenerateFiles();
+
+  // Times out and compacts locally
+  ASSERT_OK(db_->CompactRange(CompactRangeOptions(), nullptr, nullptr));
+  ASSERT_EQ("0,1", FilesPerLevel());
+  VerifyData();
+
+  // The request was withdrawn
+  std::vector<std::string> children;
+  ASSERT_OK(env_->GetChildren(service_dir_, &children));
+  for (const auto& child : children) {
+    ASSERT_TRUE(child == "." || child == "..");
+  }
+  ReleaseSnapshot();
+}
+
+TEST_F(CompactionServiceTest, EncodeDecode) {
+  CompactionServiceInput input;
+  input.column_family_name = "cf=1\n";
+  input.snapshots = {10, 20};
+  input.earliest_write_conflict_snapshot = 10;
+  input.last_sequence = 30;
+  input.inputs.resize(2);
+  input.inputs[0].level = 0;
+  input.inputs[0].files = {7, 8};
+  input.inputs[1].level = 1;
+  input.grandparents.level = 2;
+  input.grandparents.files = {3};
+  input.output_level = 1;
+  input.output_path_id = 1;
+  input.max_output_file_size = 1 << 20;
+  input.max_grandparent_overlap_bytes = 10 << 20;
+  input.compression = kSnappyCompression;
+  input.manual_compaction = true;
+  input.compaction_reason = CompactionReason::kManualCompaction;
+  input.has_end = true;
+  input.end = std::string("a\0=\n", 4);
+
+  std::string encoded;
+  input.EncodeTo(&encoded);
+  CompactionServiceInput decoded;
+  ASSERT_OK(decoded.DecodeFrom(encoded));
+  ASSERT_EQ(input.column_family_name, decoded.column_family_name);
+  ASSERT_EQ(input.snapshots, decoded.snapshots);
+  ASSERT_EQ(10U, decoded.earliest_write_conflict_snapshot);
+  ASSERT_EQ(30U, decoded.last_sequence);
+  ASSERT_EQ(2U, decoded.inputs.size());
+  ASSERT_EQ(0, decoded.inputs[0].level);
+  ASSERT_EQ(input.inputs[0].files, decoded.inputs[0].files);
+  ASSERT_EQ(1, decoded.inputs[1].level);
+  ASSERT_TRUE(decoded.inputs[1].files.empty());
+  ASSERT_EQ(2, decoded.grandparents.level);
+  ASSERT_EQ(input.grandparents.files, decoded.grandparents.files);
+  ASSERT_EQ(1, decoded.output_level);
+  ASSERT_EQ(1U, decoded.output_path_id);
+  ASSERT_EQ(input.max_output_file_size, decoded.max_output_file_size);
+  ASSERT_EQ(input.max_grandparent_overlap_bytes,
+            decoded.max_grandparent_overlap_bytes);
+  ASSERT_EQ(kSnappyCompression, decoded.compression);
+  ASSERT_TRUE(decoded.manual_compaction);
+  ASSERT_TRUE(decoded.compaction_reason ==
+              CompactionReason::kManualCompaction);
+  ASSERT_FALSE(decoded.has_begin);
+  ASSERT_TRUE(decoded.has_end);
+  ASSERT_EQ(input.end, decoded.end);
+
+  CompactionServiceResult result;
+  result.status = Status::OK();
+  result.output_path = "/tmp/out";
+  result.output_files.resize(1);
+  result.output_files[0].file_number = 12;
+  result.output_files[0].file_size = 4096;
+  result.output_files[0].smallest_seqno = 1;
+  result.output_files[0].largest_seqno = 9;
+  result.output_files[0].smallest = std::string("\0a", 2);
+  result.output_files[0].largest = "z";
+  result.output_files[0].marked_for_compaction = true;
+  result.num_input_records = 100;
+  result.num_output_records = 50;
+  result.total_bytes = 4096;
+
+  encoded.clear();
+  result.EncodeTo(&encoded);
+  CompactionServiceResult decoded_result;
+  ASSERT_OK(decoded_result.DecodeFrom(encoded));
+  ASSERT_OK(decoded_result.status);
+  ASSERT_EQ(result.output_path, decoded_result.output_path);
+  ASSERT_EQ(1U, decoded_result.output_files.size());
+  const auto& file = decoded_result.output_files[0];
+  ASSERT_EQ(12U, file.file_number);
+  ASSERT_EQ(4096U, file.file_size);
+  ASSERT_EQ(1U, file.smallest_seqno);
+  ASSERT_EQ(9U, file.largest_seqno);
+  ASSERT_EQ(result.output_files[0].smallest, file.smallest);
+  ASSERT_EQ("z", file.largest);
+  ASSERT_TRUE(file.marked_for_compaction);
+  ASSERT_EQ(100U, decoded_result.num_input_records);
+  ASSERT_EQ(50U, decoded_result.num_output_records);
+  ASSERT_EQ(4096U, decoded_result.total_bytes);
+
+  // Failures are passed on
+  result.status = Status::IOError("disk full");
+  encoded.clear();
+  result.EncodeTo(&encoded);
+  ASSERT_OK(decoded_result.DecodeFrom(encoded));
+  ASSERT_TRUE(decoded_result.status.IsAborted());
+
+  ASSERT_TRUE(decoded.DecodeFrom("output_level=x\n").IsCorruption());
+  ASSERT_TRUE(decoded_result.DecodeFrom("no value\n").IsCorruption());
+}
+
+}  // namespace rocksdb
+
+#endif  // !defined(ROCKSDB_LITE)
+
+int main(int argc, char** argv) {
+#if !defined(ROCKSDB_LITE)
+  rocksdb::port::InstallStackTraceHandler();
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+#else
+  return 0;
+#endif
+}
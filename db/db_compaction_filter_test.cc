@@ -525,6 +525,80 @@ TEST_F(DBTestCompactionFilter, CompactionFilterWithMergeOperator) {
   ASSERT_EQ(newvalue, four);
 }
 
+// Drops whole key ranges: the keys starting with 'b' expire together
+class SkipFilter : public CompactionFilter {
+ public:
+  SkipFilter() : num_values_(0), num_operands_(0) {}
+
+  virtual Decision FilterV2(int level, const Slice& key, ValueType value_type,
+                            const Slice& existing_value, std::string* new_value,
+                            std::string* skip_until) const override {
+    if (value_type == ValueType::kValue) {
+      num_values_++;
+    } else {
+      num_operands_++;
+      if (existing_value == "change") {
+        *new_value = "changed";
+        return Decision::kChangeValue;
+      }
+    }
+    if (key.starts_with("b")) {
+      *skip_until = "c";
+      return Decision::kRemoveAndSkipUntil;
+    }
+    if (key.starts_with("d")) {
+      // Can't skip backwards, the key is kept
+      *skip_until = "a";
+      return Decision::kRemoveAndSkipUntil;
+    }
+    return Decision::kKeep;
+  }
+
+  virtual const char* Name() const override { return "SkipFilter"; }
+
+  mutable std::atomic<int> num_values_;
+  mutable std::atomic<int> num_operands_;
+};
+
+TEST_F(DBTestCompactionFilter, CompactionFilterSkipUntil) {
+  SkipFilter filter;
+  Options options = CurrentOptions();
+  options.disable_auto_compactions = true;
+  options.compaction_filter = &filter;
+  options.merge_operator = MergeOperators::CreateStringAppendOperator();
+  DestroyAndReopen(options);
+
+  const int kNumKeys = 1000;
+  for (const char prefix : {'a', 'b', 'c', 'd'}) {
+    for (int i = 0; i < kNumKeys; i++) {
+      ASSERT_OK(Put(std::string(1, prefix) + Key(i), "v"));
+    }
+    ASSERT_OK(Flush());
+  }
+  // Merge operands in a separate file, so that the flush doesn't merge them
+  // into the values
+  ASSERT_OK(db_->Merge(WriteOptions(), "a" + Key(0), "change"));
+  ASSERT_OK(db_->Merge(WriteOptions(), "b" + Key(0), "x"));
+  ASSERT_OK(Flush());
+
+  ASSERT_OK(db_->CompactRange(CompactRangeOptions(), nullptr, nullptr));
+  // The operand of the first key starting with 'b' made the compaction skip
+  // all of them. The first keys starting with 'a' and 'b' are merges, so
+  // their values are not passed to the filter.
+  ASSERT_EQ(3 * kNumKeys - 1, filter.num_values_.load());
+  ASSERT_EQ(2, filter.num_operands_.load());
+
+  ASSERT_EQ("v,changed", Get("a" + Key(0)));
+  for (int i = 0; i < kNumKeys; i++) {
+    if (i > 0) {
+      ASSERT_EQ("v", Get("a" + Key(i)));
+    }
+    ASSERT_EQ("NOT_FOUND", Get("b" + Key(i)));
+    ASSERT_EQ("v", Get("c" + Key(i)));
+    ASSERT_EQ("v", Get("d" + Key(i)));
+  }
+}
+
 #ifndef ROCKSDB_LITE
 TEST_F(DBTestCompactionFilter, CompactionFilterContextManual) {
   KeepFilterFactory* filter = new KeepFilterFactory(true, true);
@@ -10,6 +10,8 @@
 #include "db/db_test_util.h"
 #include "port/stack_trace.h"
 #include "rocksdb/experimental.h"
+#include "rocksdb/perf_context.h"
+#include "rocksdb/perf_level.h"
 #include "rocksdb/utilities/convenience.h"
 #include "util/sync_point.h"
 namespace rocksdb {
@@ -95,6 +97,25 @@ class FlushedFileCollector : public EventListener {
   std::mutex mutex_;
 };
 
+class CompactionReasonCounter : public EventListener {
+ public:
+  explicit CompactionReasonCounter(CompactionReason reason)
+      : reason_(reason), count_(0) {}
+
+  virtual void OnCompactionCompleted(DB* db,
+                                     const CompactionJobInfo& ci) override {
+    if (ci.compaction_reason == reason_) {
+      count_++;
+    }
+  }
+
+  int count() const { return count_.load(); }
+
+ private:
+  const CompactionReason reason_;
+  std::atomic<int> count_;
+};
+
 static const int kCDTValueSize = 1000;
 static const int kCDTKeysPerBuffer = 4;
 static const int kCDTNumLevels = 8;
@@ -2367,6 +2388,396 @@ TEST_F(DBCompactionTest, SuggestCompactRangeNoTwoLevel0Compactions) {
   dbfull()->TEST_WaitForCompact();
 }
 
+TEST_F(DBCompactionTest, IntraL0CompactionWhileL0ToBaseRunning) {
+  Options options = CurrentOptions();
+  options.compaction_style = kCompactionStyleLevel;
+  options.level0_file_num_compaction_trigger = 2;
+  options.level0_slowdown_writes_trigger = 20;
+  options.level0_stop_writes_trigger = 30;
+  options.max_background_compactions = 2;
+  options.num_levels = 4;
+  DestroyAndReopen(options);
+
+  int num_intra_l0_picked = 0;
+  rocksdb::SyncPoint::GetInstance()->SetCallBack(
+      "LevelCompactionPicker::PickIntraL0Compaction", [&](void* arg) {
+        CompactionInputFiles* inputs = static_cast<CompactionInputFiles*>(arg);
+        ASSERT_EQ(0, inputs->level);
+        ASSERT_GE(inputs->size(), 4U);
+        num_intra_l0_picked++;
+      });
+  rocksdb::SyncPoint::GetInstance()->LoadDependency(
+      {{"CompactionJob::Run():Start",
+        "DBCompactionTest::IntraL0CompactionWhileL0ToBaseRunning:1"},
+       {"DBCompactionTest::IntraL0CompactionWhileL0ToBaseRunning:2",
+        "CompactionJob::Run():End"}});
+  rocksdb::SyncPoint::GetInstance()->EnableProcessing();
+
+  // Two files start an L0->L1 compaction that is held back until the end
+  for (int i = 0; i < 2; i++) {
+    for (int k = 0; k < 100; k++) {
+      ASSERT_OK(Put(Key(k), "old" + ToString(i)));
+    }
+    ASSERT_OK(Flush());
+  }
+  TEST_SYNC_POINT("DBCompactionTest::IntraL0CompactionWhileL0ToBaseRunning:1");
+
+  // Newer files overwrite or delete the same keys and pile up in L0. The
+  // tombstones must survive the intra-L0 compaction, since the older values
+  // are still on their way to L1.
+  for (int i = 0; i < 6; i++) {
+    for (int k = 0; k < 100; k++) {
+      if (k % 3 == 0) {
+        if (i < 4) {
+          ASSERT_OK(Delete(Key(k)));
+        }
+      } else {
+        ASSERT_OK(Put(Key(k), "new" + ToString(i)));
+      }
+    }
+    ASSERT_OK(Flush());
+  }
+  ASSERT_GT(num_intra_l0_picked, 0);
+
+  TEST_SYNC_POINT("DBCompactionTest::IntraL0CompactionWhileL0ToBaseRunning:2");
+  dbfull()->TEST_WaitForCompact();
+  rocksdb::SyncPoint::GetInstance()->DisableProcessing();
+  rocksdb::SyncPoint::GetInstance()->ClearAllCallBacks();
+
+  for (int k = 0; k < 100; k++) {
+    ASSERT_EQ(k % 3 == 0 ? "NOT_FOUND" : "new5", Get(Key(k)));
+  }
+  Reopen(options);
+  for (int k = 0; k < 100; k++) {
+    ASSERT_EQ(k % 3 == 0 ? "NOT_FOUND" : "new5", Get(Key(k)));
+  }
+}
+
+TEST_F(DBCompactionTest, SubcompactionBoundariesFromIndexBlocks) {
+  Options options = CurrentOptions();
+  options.compaction_style = kCompactionStyleUniversal;
+  options.num_levels = 3;
+  options.level0_file_num_compaction_trigger = 2;
+  options.max_subcompactions = 4;
+  options.target_file_size_base = 32 << 10;
+  options.write_buffer_size = 10 << 20;
+  options.compression = kNoCompression;
+  options.statistics = rocksdb::CreateDBStatistics();
+  DestroyAndReopen(options);
+
+  // Two files covering the same key range only provide two distinct file
+  // boundaries, so the compaction can only be split by the index keys
+  Random rnd(301);
+  std::vector<std::string> values;
+  for (int i = 0; i < 2; i++) {
+    values.clear();
+    for (int k = 0; k < 1000; k++) {
+      values.push_back(RandomString(&rnd, 500));
+      ASSERT_OK(Put(Key(k), values.back()));
+    }
+    ASSERT_OK(Flush());
+  }
+  dbfull()->TEST_WaitForCompact();
+  ASSERT_EQ(0, NumTableFilesAtLevel(0));
+  ASSERT_GE(NumTableFilesAtLevel(2), options.max_subcompactions);
+
+  HistogramData hist_data;
+  options.statistics->histogramData(NUM_SUBCOMPACTIONS_SCHEDULED, &hist_data);
+  ASSERT_EQ(static_cast<double>(options.max_subcompactions),
+            hist_data.average);
+  for (int k = 0; k < 1000; k++) {
+    ASSERT_EQ(values[k], Get(Key(k)));
+  }
+}
+
+
+TEST_F(DBCompactionTest, BottomPriCompactionDoesNotBlockLowPool) {
+  Options options = CurrentOptions();
+  options.compaction_style = kCompactionStyleUniversal;
+  options.num_levels = 3;
+  options.level0_file_num_compaction_trigger = 2;
+  options.max_background_compactions = 1;
+  DestroyAndReopen(options);
+  env_->SetBackgroundThreads(1, Env::Priority::BOTTOM);
+
+  int num_forwarded = 0;
+  int num_bottom_pri_runs = 0;
+  rocksdb::SyncPoint::GetInstance()->SetCallBack(
+      "DBImpl::BackgroundCompaction:ForwardToBottomPriPool",
+      [&](void* arg) { num_forwarded++; });
+  rocksdb::SyncPoint::GetInstance()->SetCallBack(
+      "DBImpl::BGWorkBottomCompaction",
+      [&](void* arg) { num_bottom_pri_runs++; });
+  // The compaction into the last level waits in the BOTTOM pool until a
+  // compaction of the newer files finished in the LOW pool
+  rocksdb::SyncPoint::GetInstance()->LoadDependency(
+      {{"DBImpl::BackgroundCompaction:ForwardToBottomPriPool",
+        "DBCompactionTest::BottomPriCompactionDoesNotBlockLowPool:0"},
+       {"DBImpl::BackgroundCompaction:NonTrivial:AfterRun",
+        "DBCompactionTest::BottomPriCompactionDoesNotBlockLowPool:1"},
+       {"DBCompactionTest::BottomPriCompactionDoesNotBlockLowPool:2",
+        "DBImpl::BGWorkBottomCompaction"}});
+  rocksdb::SyncPoint::GetInstance()->EnableProcessing();
+
+  Random rnd(301);
+  std::vector<std::string> values;
+  for (int i = 0; i < 4; i++) {
+    for (int k = 0; k < 100; k++) {
+      values.push_back(RandomString(&rnd, 100));
+      ASSERT_OK(Put(Key(i * 100 + k), values.back()));
+    }
+    ASSERT_OK(Flush());
+    if (i == 1) {
+      TEST_SYNC_POINT(
+          "DBCompactionTest::BottomPriCompactionDoesNotBlockLowPool:0");
+    }
+  }
+  // Only returns once a compaction finished in the LOW pool
+  TEST_SYNC_POINT("DBCompactionTest::BottomPriCompactionDoesNotBlockLowPool:1");
+
+  TEST_SYNC_POINT("DBCompactionTest::BottomPriCompactionDoesNotBlockLowPool:2");
+  dbfull()->TEST_WaitForCompact();
+  rocksdb::SyncPoint::GetInstance()->DisableProcessing();
+  rocksdb::SyncPoint::GetInstance()->ClearAllCallBacks();
+  env_->SetBackgroundThreads(0, Env::Priority::BOTTOM);
+
+  ASSERT_GE(num_forwarded, 1);
+  ASSERT_EQ(num_forwarded, num_bottom_pri_runs);
+  for (int k = 0; k < 400; k++) {
+    ASSERT_EQ(values[k], Get(Key(k)));
+  }
+}
+
+TEST_F(DBCompactionTest, ScanMarksDeletedRangeForCompaction) {
+  Options options = CurrentOptions();
+  options.num_levels = 3;
+  options.scan_deletion_compaction_trigger = 100;
+  DestroyAndReopen(options);
+
+  for (int i = 0; i < 1000; i++) {
+    ASSERT_OK(Put(Key(i), "v"));
+  }
+  ASSERT_OK(Flush());
+  MoveFilesToLevel(2);
+  for (int i = 100; i < 900; i++) {
+    ASSERT_OK(Delete(Key(i)));
+  }
+  // The keys are in L2, so the flush keeps the deletions
+  ASSERT_OK(Flush());
+  ASSERT_EQ("1,0,1", FilesPerLevel());
+
+  auto count_deleted_skipped = [&]() {
+    SetPerfLevel(kEnableCount);
+    perf_context.Reset();
+    int count = 0;
+    std::unique_ptr<Iterator> iter(db_->NewIterator(ReadOptions()));
+    for (iter->SeekToFirst(); iter->Valid(); iter->Next()) {
+      count++;
+    }
+    EXPECT_EQ(200, count);
+    uint64_t skipped = perf_context.internal_delete_skipped_count;
+    SetPerfLevel(kDisable);
+    return skipped;
+  };
+
+  // The scan marks the L0 file, which is moved to L1 and compacted into L2
+  ASSERT_EQ(800U, count_deleted_skipped());
+  dbfull()->TEST_WaitForCompact();
+  ASSERT_EQ("0,0,1", FilesPerLevel());
+  ASSERT_EQ(0U, count_deleted_skipped());
+  for (int i = 0; i < 1000; i++) {
+    ASSERT_EQ(i >= 100 && i < 900 ? "NOT_FOUND" : "v", Get(Key(i)));
+  }
+
+  // Short runs of deletions are not reported
+  for (int i = 0; i < 1000; i += 2) {
+    if (i < 100 || i >= 900) {
+      ASSERT_OK(Delete(Key(i)));
+    }
+  }
+  ASSERT_OK(Flush());
+  MoveFilesToLevel(1);
+  ASSERT_EQ("0,1,1", FilesPerLevel());
+  std::unique_ptr<Iterator> iter(db_->NewIterator(ReadOptions()));
+  for (iter->SeekToLast(); iter->Valid(); iter->Prev()) {
+  }
+  dbfull()->TEST_WaitForCompact();
+  ASSERT_EQ("0,1,1", FilesPerLevel());
+}
+
+TEST_F(DBCompactionTest, ScanRequestsFlushOfDeletions) {
+  Options options = CurrentOptions();
+  options.scan_deletion_compaction_trigger = 10;
+  DestroyAndReopen(options);
+
+  for (int i = 0; i < 100; i++) {
+    ASSERT_OK(Put(Key(i), "v"));
+  }
+  ASSERT_OK(Flush());
+  for (int i = 0; i < 50; i++) {
+    ASSERT_OK(Delete(Key(i)));
+  }
+  // A reverse scan reports the deletions in the memtable too
+  std::unique_ptr<Iterator> iter(db_->NewIterator(ReadOptions()));
+  int count = 0;
+  for (iter->SeekToLast(); iter->Valid(); iter->Prev()) {
+    count++;
+  }
+  ASSERT_EQ(50, count);
+  iter.reset();
+
+  // The next write switches the memtable
+  ASSERT_EQ("1", FilesPerLevel());
+  ASSERT_OK(Put(Key(100), "v"));
+  dbfull()->TEST_WaitForFlushMemTable();
+  ASSERT_EQ("2", FilesPerLevel());
+  ASSERT_EQ("NOT_FOUND", Get(Key(0)));
+  ASSERT_EQ("v", Get(Key(50)));
+}
+
+TEST_F(DBCompactionTest, FlushDropsDeletionsOfAbsentKeys) {
+  Options options = CurrentOptions();
+  options.num_levels = 3;
+  DestroyAndReopen(options);
+
+  // No file holds the keys, so the deletions are dropped with the puts they
+  // hide
+  for (int i = 0; i < 100; i++) {
+    ASSERT_OK(Put(Key(i), "v"));
+    ASSERT_OK(Delete(Key(i)));
+  }
+  for (int i = 100; i < 200; i++) {
+    ASSERT_OK(Delete(Key(i)));
+  }
+  ASSERT_OK(Put(Key(200), "v"));
+  ASSERT_OK(Flush());
+  ASSERT_EQ("[ ]", AllEntriesFor(Key(0)));
+  ASSERT_EQ("[ ]", AllEntriesFor(Key(100)));
+  TablePropertiesCollection props;
+  ASSERT_OK(db_->GetPropertiesOfAllTables(&props));
+  ASSERT_EQ(1U, props.size());
+  ASSERT_EQ(1U, props.begin()->second->num_entries);
+
+  // The deletions of keys in a file, or that a snapshot needs, are kept
+  MoveFilesToLevel(2);
+  const Snapshot* snapshot = db_->GetSnapshot();
+  ASSERT_OK(Delete(Key(200)));
+  ASSERT_OK(Delete(Key(300)));
+  ASSERT_OK(Flush());
+  ASSERT_EQ("[ DEL, v ]", AllEntriesFor(Key(200)));
+  ASSERT_EQ("[ DEL ]", AllEntriesFor(Key(300)));
+  db_->ReleaseSnapshot(snapshot);
+  ASSERT_OK(Delete(Key(400)));
+  ASSERT_OK(Flush());
+  ASSERT_EQ("[ ]", AllEntriesFor(Key(400)));
+  ASSERT_EQ("NOT_FOUND", Get(Key(200)));
+}
+
+TEST_F(DBCompactionTest, PeriodicCompaction) {
+  const uint64_t kPeriod = 48 * 60 * 60;
+  Options options = CurrentOptions();
+  options.num_levels = 4;
+  options.periodic_compaction_seconds = kPeriod;
+  auto* listener =
+      new CompactionReasonCounter(CompactionReason::kPeriodicCompaction);
+  options.listeners.emplace_back(listener);
+  DestroyAndReopen(options);
+
+  for (int i = 0; i < 10; i++) {
+    ASSERT_OK(Put(Key(i), "v"));
+  }
+  ASSERT_OK(Flush());
+  MoveFilesToLevel(3);
+  ASSERT_OK(Put(Key(10), "v"));
+  ASSERT_OK(Flush());
+  ASSERT_OK(dbfull()->TEST_WaitForCompact());
+  ASSERT_EQ("1,0,0,1", FilesPerLevel());
+  ASSERT_EQ(0, listener->count());
+
+  TablePropertiesCollection props;
+  ASSERT_OK(db_->GetPropertiesOfAllTables(&props));
+  for (const auto& prop : props) {
+    ASSERT_GT(prop.second->creation_time, 0U);
+  }
+  std::vector<LiveFileMetaData> files;
+  db_->GetLiveFilesMetaData(&files);
+  std::string last_level_file;
+  for (const auto& file : files) {
+    if (file.level == 3) {
+      last_level_file = file.name;
+    }
+  }
+
+  // The files are checked when the next version is installed. The file of
+  // the last level is rewritten in place, the one of L0 goes to L1.
+  env_->addon_time_.fetch_add(kPeriod + 60);
+  ASSERT_OK(Put(Key(20), "v"));
+  ASSERT_OK(Flush());
+  ASSERT_OK(dbfull()->TEST_WaitForCompact());
+  ASSERT_EQ(2, listener->count());
+  ASSERT_EQ("1,1,0,1", FilesPerLevel());
+  files.clear();
+  db_->GetLiveFilesMetaData(&files);
+  for (const auto& file : files) {
+    if (file.level == 3) {
+      ASSERT_NE(last_level_file, file.name);
+    }
+  }
+  for (int i = 0; i <= 10; i++) {
+    ASSERT_EQ("v", Get(Key(i)));
+  }
+
+  // The rewritten files are young again
+  ASSERT_OK(Put(Key(30), "v"));
+  ASSERT_OK(Flush());
+  ASSERT_OK(dbfull()->TEST_WaitForCompact());
+  ASSERT_EQ(2, listener->count());
+
+  // Disabled through SetOptions()
+  ASSERT_OK(dbfull()->SetOptions({{"periodic_compaction_seconds", "0"}}));
+  env_->addon_time_.fetch_add(kPeriod + 60);
+  ASSERT_OK(Put(Key(40), "v"));
+  ASSERT_OK(Flush());
+  ASSERT_OK(dbfull()->TEST_WaitForCompact());
+  ASSERT_EQ(2, listener->count());
+}
+
+TEST_F(DBCompactionTest, FIFOCompactionTtl) {
+  const uint64_t kTtl = 24 * 60 * 60;
+  Options options = CurrentOptions();
+  options.compaction_style = kCompactionStyleFIFO;
+  options.compaction_options_fifo.ttl = kTtl;
+  options.level0_file_num_compaction_trigger = 100;
+  auto* listener = new CompactionReasonCounter(CompactionReason::kFIFOTtl);
+  options.listeners.emplace_back(listener);
+  DestroyAndReopen(options);
+
+  for (int i = 0; i < 3; i++) {
+    ASSERT_OK(Put(Key(i), "v"));
+    ASSERT_OK(Flush());
+  }
+  ASSERT_OK(dbfull()->TEST_WaitForCompact());
+  ASSERT_EQ("3", FilesPerLevel());
+
+  // The expired files are deleted, well below the size limit
+  env_->addon_time_.fetch_add(kTtl + 60);
+  ASSERT_OK(Put(Key(3), "v"));
+  ASSERT_OK(Flush());
+  ASSERT_OK(dbfull()->TEST_WaitForCompact());
+  ASSERT_EQ(1, listener->count());
+  ASSERT_EQ("1", FilesPerLevel());
+  for (int i = 0; i < 3; i++) {
+    ASSERT_EQ("NOT_FOUND", Get(Key(i)));
+  }
+  ASSERT_EQ("v", Get(Key(3)));
+
+  // Also on reopen
+  env_->addon_time_.fetch_add(kTtl + 60);
+  Reopen(options);
+  ASSERT_OK(dbfull()->TEST_WaitForCompact());
+  ASSERT_EQ("NOT_FOUND", Get(Key(3)));
+  ASSERT_EQ("", FilesPerLevel());
+}
 
 TEST_P(DBCompactionTestWithParam, ForceBottommostLevelCompaction) {
   int32_t trivial_move = 0;
@@ -41,6 +41,7 @@
 #include "db/filename.h"
 #include "db/flush_job.h"
 #include "db/forward_iterator.h"
+#include "db/in_memory_compaction_job.h"
 #include "db/job_context.h"
 #include "db/log_reader.h"
 #include "db/log_writer.h"
@@ -49,13 +50,13 @@
 #include "db/memtable_list.h"
 #include "db/merge_context.h"
 #include "db/merge_helper.h"
+#include "db/range_del_aggregator.h"
 #include "db/table_cache.h"
 #include "db/table_properties_collector.h"
 #include "db/transaction_log_impl.h"
 #include "db/version_set.h"
 #include "db/write_batch_internal.h"
 #include "db/write_callback.h"
-#include "db/writebuffer.h"
 #include "db/xfunc_test_points.h"
 #include "memtable/hash_linklist_rep.h"
 #include "memtable/hash_skiplist_rep.h"
@@ -72,6 +73,7 @@
 #include "rocksdb/table.h"
 #include "rocksdb/version.h"
 #include "rocksdb/wal_filter.h"
+#include "rocksdb/write_buffer_manager.h"
 #include "table/block.h"
 #include "table/block_based_table_factory.h"
 #include "table/merger.h"
@@ -163,6 +165,11 @@ DBOptions SanitizeOptions(const std::string& dbname, const DBOptions& src) {
     }
   }
 
+  if (result.write_buffer_manager == nullptr) {
+    result.write_buffer_manager.reset(
+        new WriteBufferManager(result.db_write_buffer_size));
+  }
+
   if (result.WAL_ttl_seconds > 0 || result.WAL_size_limit_MB > 0) {
     result.recycle_log_file_num = false;
   }
@@ -229,6 +236,20 @@ static Status ValidateOptions(
         "More than four DB paths are not supported yet. ");
   }
 
+  if (db_options.wal_compression != kNoCompression &&
+      !StreamingCompressionTypeSupported(db_options.wal_compression)) {
+    return Status::NotSupported(
+        "WAL compression type not supported: ",
+        CompressionTypeToString(db_options.wal_compression));
+  }
+
+  if (db_options.unordered_write &&
+      !db_options.allow_concurrent_memtable_write) {
+    return Status::InvalidArgument(
+        "Unordered writes (unordered_write) require concurrent memtable "
+        "writes (allow_concurrent_memtable_write)");
+  }
+
   if (db_options.allow_mmap_reads && !db_options.allow_os_buffer) {
     // Protect against assert in PosixMMapReadableFile constructor
     return Status::NotSupported(
@@ -294,16 +315,18 @@ DBImpl::DBImpl(const DBOptions& options, const std::string& dbname)
       total_log_size_(0),
       max_total_in_memory_state_(0),
       is_snapshot_supported_(true),
-      write_buffer_(options.db_write_buffer_size),
+      write_buffer_manager_(db_options_.write_buffer_manager.get()),
       write_thread_(options.enable_write_thread_adaptive_yield
                         ? options.write_thread_max_yield_usec
                         : 0,
                     options.write_thread_slow_yield_usec),
+      has_inplace_update_cf_(false),
       write_controller_(options.delayed_write_rate),
       last_batch_group_size_(0),
       unscheduled_flushes_(0),
       unscheduled_compactions_(0),
       bg_compaction_scheduled_(0),
+      bg_bottom_compaction_scheduled_(0),
       num_running_compactions_(0),
       bg_flush_scheduled_(0),
       num_running_flushes_(0),
@@ -333,10 +356,13 @@ DBImpl::DBImpl(const DBOptions& options, const std::string& dbname)
       NewLRUCache(table_cache_size, db_options_.table_cache_numshardbits);
 
   versions_.reset(new VersionSet(dbname_, &db_options_, env_options_,
-                                 table_cache_.get(), &write_buffer_,
+                                 table_cache_.get(), write_buffer_manager_,
                                  &write_controller_));
   column_family_memtables_.reset(
       new ColumnFamilyMemTablesImpl(versions_->GetColumnFamilySet()));
+  if (db_options_.unordered_write) {
+    unordered_write_tracker_.reset(new UnorderedWriteTracker(versions_.get()));
+  }
 
   DumpRocksDBBuildVersion(db_options_.info_log.get());
   DumpDBFileSummary(db_options_, dbname_);
@@ -353,7 +379,8 @@ void DBImpl::CancelAllBackgroundWork(bool wait) {
     return;
   }
   // Wait for background work to finish
-  while (bg_compaction_scheduled_ || bg_flush_scheduled_) {
+  while (bg_bottom_compaction_scheduled_ || bg_compaction_scheduled_ ||
+         bg_flush_scheduled_) {
     bg_cv_.Wait();
   }
 }
@@ -379,14 +406,18 @@ DBImpl::~DBImpl() {
   // marker. After this we do a variant of the waiting and unschedule work
   // (to consider: moving all the waiting into CancelAllBackgroundWork(true))
   CancelAllBackgroundWork(false);
+  int bottom_compactions_unscheduled =
+      env_->UnSchedule(this, Env::Priority::BOTTOM);
   int compactions_unscheduled = env_->UnSchedule(this, Env::Priority::LOW);
   int flushes_unscheduled = env_->UnSchedule(this, Env::Priority::HIGH);
   mutex_.Lock();
+  bg_bottom_compaction_scheduled_ -= bottom_compactions_unscheduled;
   bg_compaction_scheduled_ -= compactions_unscheduled;
   bg_flush_scheduled_ -= flushes_unscheduled;
 
   // Wait for background work to finish
-  while (bg_compaction_scheduled_ || bg_flush_scheduled_) {
+  while (bg_bottom_compaction_scheduled_ || bg_compaction_scheduled_ ||
+         bg_flush_scheduled_) {
     bg_cv_.Wait();
   }
   EraseThreadStatusDbInfo();
@@ -1489,7 +1520,9 @@ Status DBImpl::WriteLevel0TableForRecovery(int job_id, ColumnFamilyData* cfd,
 
       s = BuildTable(
           dbname_, env_, *cfd->ioptions(), env_options_, cfd->table_cache(),
-          iter.get(), &meta, cfd->internal_comparator(),
+          iter.get(), std::unique_ptr<InternalIterator>(
+                          mem->NewRangeTombstoneIterator(ro)),
+          &meta, cfd->internal_comparator(),
           cfd->int_tbl_prop_collector_factories(), cfd->GetID(), cfd->GetName(),
           snapshot_seqs, earliest_write_conflict_snapshot,
           GetCompressionFlush(*cfd->ioptions()),
@@ -1978,7 +2011,8 @@ Status DBImpl::CompactFilesImpl(
 Status DBImpl::PauseBackgroundWork() {
   InstrumentedMutexLock guard_lock(&mutex_);
   bg_compaction_paused_++;
-  while (bg_compaction_scheduled_ > 0 || bg_flush_scheduled_ > 0) {
+  while (bg_bottom_compaction_scheduled_ > 0 || bg_compaction_scheduled_ > 0 ||
+         bg_flush_scheduled_ > 0) {
     bg_cv_.Wait();
   }
   bg_work_paused_++;
@@ -2394,7 +2428,8 @@ Status DBImpl::RunManualCompaction(ColumnFamilyData* cfd, int input_level,
   AddManualCompaction(&manual);
   TEST_SYNC_POINT_CALLBACK("DBImpl::RunManualCompaction:NotScheduled", &mutex_);
   if (exclusive) {
-    while (bg_compaction_scheduled_ > 0) {
+    while (bg_bottom_compaction_scheduled_ > 0 ||
+           bg_compaction_scheduled_ > 0) {
       Log(InfoLogLevel::INFO_LEVEL, db_options_.info_log,
           "[%s] Manual compaction waiting for all other scheduled background "
           "compactions to finish",
@@ -2441,6 +2476,7 @@ Status DBImpl::RunManualCompaction(ColumnFamilyData* cfd, int input_level,
       ca = new CompactionArg;
       ca->db = this;
       ca->m = &manual;
+      ca->prepicked_compaction = nullptr;
       manual.incomplete = false;
       bg_compaction_scheduled_++;
       env_->Schedule(&DBImpl::BGWorkCompaction, ca, Env::Priority::LOW, this,
@@ -2470,7 +2506,8 @@ InternalIterator* DBImpl::NewInternalIterator(
   SuperVersion* super_version = cfd->GetSuperVersion()->Ref();
   mutex_.Unlock();
   ReadOptions roptions;
-  return NewInternalIterator(roptions, cfd, super_version, arena);
+  return NewInternalIterator(roptions, cfd, super_version, arena,
+                             nullptr /* range_del_agg */);
 }
 
 Status DBImpl::FlushMemTable(ColumnFamilyData* cfd,
@@ -2594,6 +2631,7 @@ void DBImpl::MaybeScheduleFlushOrCompaction() {
     CompactionArg* ca = new CompactionArg;
     ca->db = this;
     ca->m = nullptr;
+    ca->prepicked_compaction = nullptr;
     bg_compaction_scheduled_++;
     unscheduled_compactions_--;
     env_->Schedule(&DBImpl::BGWorkCompaction, ca, Env::Priority::LOW, this,
@@ -2632,6 +2670,39 @@ void DBImpl::AddToFlushQueue(ColumnFamilyData* cfd) {
   cfd->set_pending_flush(true);
 }
 
+Status DBImpl::CompactMemTablesInMemory(
+    ColumnFamilyData* cfd, const MutableCFOptions& mutable_cf_options,
+    bool* made_progress, JobContext* job_context, LogBuffer* log_buffer) {
+#ifndef ROCKSDB_LITE
+  mutex_.AssertHeld();
+  assert(cfd->imm()->IsInMemoryCompactionPending());
+
+  SequenceNumber earliest_write_conflict_snapshot;
+  std::vector<SequenceNumber> snapshot_seqs =
+      snapshots_.GetAll(&earliest_write_conflict_snapshot);
+
+  InMemoryCompactionJob job(cfd, db_options_, mutable_cf_options, &mutex_,
+                            snapshot_seqs, earliest_write_conflict_snapshot,
+                            job_context, log_buffer);
+  // Unlocks and locks the mutex while the memtables are merged
+  Status s = job.Run();
+
+  if (s.ok()) {
+    InstallSuperVersionAndScheduleWorkWrapper(cfd, job_context,
+                                              mutable_cf_options);
+    if (made_progress) {
+      *made_progress = 1;
+    }
+  } else {
+    // The memtables can still be flushed
+    SchedulePendingFlush(cfd);
+  }
+  return s;
+#else
+  return Status::NotSupported("Not supported in ROCKSDB LITE");
+#endif  // ROCKSDB_LITE
+}
+
 ColumnFamilyData* DBImpl::PopFirstFromFlushQueue() {
   assert(!flush_queue_.empty());
   auto cfd = *flush_queue_.begin();
@@ -2642,7 +2713,9 @@ ColumnFamilyData* DBImpl::PopFirstFromFlushQueue() {
 }
 
 void DBImpl::SchedulePendingFlush(ColumnFamilyData* cfd) {
-  if (!cfd->pending_flush() && cfd->imm()->IsFlushPending()) {
+  if (!cfd->pending_flush() &&
+      (cfd->imm()->IsFlushPending() ||
+       cfd->imm()->IsInMemoryCompactionPending())) {
     AddToFlushQueue(cfd);
     ++unscheduled_flushes_;
   }
@@ -2672,7 +2745,18 @@ void DBImpl::BGWorkCompaction(void* arg) {
   delete reinterpret_cast<CompactionArg*>(arg);
   IOSTATS_SET_THREAD_POOL_ID(Env::Priority::LOW);
   TEST_SYNC_POINT("DBImpl::BGWorkCompaction");
-  reinterpret_cast<DBImpl*>(ca.db)->BackgroundCallCompaction(ca.m);
+  reinterpret_cast<DBImpl*>(ca.db)->BackgroundCallCompaction(
+      ca.m, nullptr, Env::Priority::LOW);
+}
+
+void DBImpl::BGWorkBottomCompaction(void* arg) {
+  CompactionArg ca = *(reinterpret_cast<CompactionArg*>(arg));
+  delete reinterpret_cast<CompactionArg*>(arg);
+  IOSTATS_SET_THREAD_POOL_ID(Env::Priority::BOTTOM);
+  TEST_SYNC_POINT("DBImpl::BGWorkBottomCompaction");
+  assert(ca.m == nullptr && ca.prepicked_compaction != nullptr);
+  ca.db->BackgroundCallCompaction(nullptr, ca.prepicked_compaction,
+                                  Env::Priority::BOTTOM);
 }
 
 void DBImpl::UnscheduleCallback(void* arg) {
@@ -2681,6 +2765,11 @@ void DBImpl::UnscheduleCallback(void* arg) {
   if ((ca.m != nullptr) && (ca.m->compaction != nullptr)) {
     delete ca.m->compaction;
   }
+  if (ca.prepicked_compaction != nullptr) {
+    // Only happens when the DB is closed, so the files don't need to be
+    // released for other compactions
+    delete ca.prepicked_compaction;
+  }
   TEST_SYNC_POINT("DBImpl::UnscheduleCallback");
 }
 
@@ -2702,7 +2791,9 @@ Status DBImpl::BackgroundFlush(bool* made_progress, JobContext* job_context,
     // This cfd is already referenced
     auto first_cfd = PopFirstFromFlushQueue();
 
-    if (first_cfd->IsDropped() || !first_cfd->imm()->IsFlushPending()) {
+    if (first_cfd->IsDropped() ||
+        (!first_cfd->imm()->IsFlushPending() &&
+         !first_cfd->imm()->IsInMemoryCompactionPending())) {
       // can't flush this CF, try next one
       if (first_cfd->Unref()) {
         delete first_cfd;
@@ -2715,7 +2806,18 @@ Status DBImpl::BackgroundFlush(bool* made_progress, JobContext* job_context,
     break;
   }
 
-  if (cfd != nullptr) {
+  if (cfd != nullptr && !cfd->imm()->IsFlushPending()) {
+    const MutableCFOptions mutable_cf_options =
+        *cfd->GetLatestMutableCFOptions();
+    LogToBuffer(log_buffer,
+                "Calling CompactMemTablesInMemory with column family [%s]",
+                cfd->GetName().c_str());
+    status = CompactMemTablesInMemory(cfd, mutable_cf_options, made_progress,
+                                      job_context, log_buffer);
+    if (cfd->Unref()) {
+      delete cfd;
+    }
+  } else if (cfd != nullptr) {
     const MutableCFOptions mutable_cf_options =
         *cfd->GetLatestMutableCFOptions();
     LogToBuffer(
@@ -2802,7 +2904,9 @@ void DBImpl::BackgroundCallFlush() {
   }
 }
 
-void DBImpl::BackgroundCallCompaction(void* arg) {
+void DBImpl::BackgroundCallCompaction(void* arg,
+                                      Compaction* prepicked_compaction,
+                                      Env::Priority thread_pri) {
   bool made_progress = false;
   ManualCompaction* m = reinterpret_cast<ManualCompaction*>(arg);
   JobContext job_context(next_job_id_.fetch_add(1), true);
@@ -2816,9 +2920,11 @@ void DBImpl::BackgroundCallCompaction(void* arg) {
     auto pending_outputs_inserted_elem =
         CaptureCurrentFileNumberInPendingOutputs();
 
-    assert(bg_compaction_scheduled_);
-    Status s =
-        BackgroundCompaction(&made_progress, &job_context, &log_buffer, m);
+    assert((thread_pri == Env::Priority::BOTTOM &&
+            bg_bottom_compaction_scheduled_) ||
+           (thread_pri == Env::Priority::LOW && bg_compaction_scheduled_));
+    Status s = BackgroundCompaction(&made_progress, &job_context, &log_buffer,
+                                    m, prepicked_compaction);
     TEST_SYNC_POINT("BackgroundCallCompaction:1");
     if (!s.ok() && !s.IsShutdownInProgress()) {
       // Wait a little bit before retrying background compaction in
@@ -2864,17 +2970,23 @@ void DBImpl::BackgroundCallCompaction(void* arg) {
 
     assert(num_running_compactions_ > 0);
     num_running_compactions_--;
-    bg_compaction_scheduled_--;
+    if (thread_pri == Env::Priority::BOTTOM) {
+      bg_bottom_compaction_scheduled_--;
+    } else {
+      bg_compaction_scheduled_--;
+    }
 
     versions_->GetColumnFamilySet()->FreeDeadColumnFamilies();
 
     // See if there's more work to be done
     MaybeScheduleFlushOrCompaction();
-    if (made_progress || bg_compaction_scheduled_ == 0 ||
+    if (made_progress ||
+        (bg_compaction_scheduled_ == 0 &&
+         bg_bottom_compaction_scheduled_ == 0) ||
         HasPendingManualCompaction()) {
       // signal if
       // * made_progress -- need to wakeup DelayWrite
-      // * bg_compaction_scheduled_ == 0 -- need to wakeup ~DBImpl
+      // * no compaction is scheduled in either pool -- need to wakeup ~DBImpl
       // * HasPendingManualCompaction -- need to wakeup RunManualCompaction
       // If none of this is true, there is no need to signal since nobody is
       // waiting for it
@@ -2889,13 +3001,15 @@ void DBImpl::BackgroundCallCompaction(void* arg) {
 
 Status DBImpl::BackgroundCompaction(bool* made_progress,
                                     JobContext* job_context,
-                                    LogBuffer* log_buffer, void* arg) {
+                                    LogBuffer* log_buffer, void* arg,
+                                    Compaction* prepicked_compaction) {
   ManualCompaction* manual_compaction =
       reinterpret_cast<ManualCompaction*>(arg);
   *made_progress = false;
   mutex_.AssertHeld();
 
   bool is_manual = (manual_compaction != nullptr);
+  bool is_prepicked = (prepicked_compaction != nullptr);
 
   // (manual_compaction->in_progress == false);
   bool trivial_move_disallowed =
@@ -2915,6 +3029,10 @@ Status DBImpl::BackgroundCompaction(bool* made_progress,
       delete manual_compaction->compaction;
       manual_compaction = nullptr;
     }
+    if (is_prepicked) {
+      prepicked_compaction->ReleaseCompactionFiles(status);
+      delete prepicked_compaction;
+    }
     return status;
   }
 
@@ -2926,7 +3044,9 @@ Status DBImpl::BackgroundCompaction(bool* made_progress,
   unique_ptr<Compaction> c;
   // InternalKey manual_end_storage;
   // InternalKey* manual_end = &manual_end_storage;
-  if (is_manual) {
+  if (is_prepicked) {
+    c.reset(prepicked_compaction);
+  } else if (is_manual) {
     ManualCompaction* m = manual_compaction;
     assert(m->in_progress);
     c.reset(std::move(m->compaction));
@@ -3095,6 +3215,17 @@ Status DBImpl::BackgroundCompaction(bool* made_progress,
 
     // Clear Instrument
     ThreadStatusUtil::ResetThreadStatus();
+  } else if (!is_prepicked && !is_manual && ShouldRunInBottomPool(c.get())) {
+    // The files stay marked as being compacted until the BOTTOM pool job
+    // has run the compaction
+    TEST_SYNC_POINT("DBImpl::BackgroundCompaction:ForwardToBottomPriPool");
+    CompactionArg* ca = new CompactionArg;
+    ca->db = this;
+    ca->m = nullptr;
+    ca->prepicked_compaction = c.release();
+    bg_bottom_compaction_scheduled_++;
+    env_->Schedule(&DBImpl::BGWorkBottomCompaction, ca, Env::Priority::BOTTOM,
+                   this, &DBImpl::UnscheduleCallback);
   } else {
     int output_level  __attribute__((unused)) = c->output_level();
     TEST_SYNC_POINT_CALLBACK("DBImpl::BackgroundCompaction:NonTrivial",
@@ -3123,6 +3254,11 @@ Status DBImpl::BackgroundCompaction(bool* made_progress,
 
     status = compaction_job.Install(*c->mutable_cf_options());
     if (status.ok()) {
+      // Feeds adaptive_delayed_write_rate, before the new version
+      // recalculates the write stall conditions
+      write_controller_.RecordCompaction(
+          compaction_job_stats.total_input_bytes,
+          compaction_job_stats.elapsed_micros, num_running_compactions_);
       InstallSuperVersionAndScheduleWorkWrapper(
           c->column_family_data(), job_context, *c->mutable_cf_options());
     }
@@ -3189,6 +3325,22 @@ Status DBImpl::BackgroundCompaction(bool* made_progress,
   return status;
 }
 
+bool DBImpl::ShouldRunInBottomPool(const Compaction* c) const {
+  if (c->output_level() == 0 || c->output_level() != c->number_levels() - 1) {
+    return false;
+  }
+  // Under level style, compactions of L0 files are what the LOW pool is kept
+  // free for, even when the base level is the last level. Universal
+  // compactions always start at L0, those into the last level are the large
+  // ones.
+  if (c->start_level() == 0 &&
+      c->column_family_data()->ioptions()->compaction_style ==
+          kCompactionStyleLevel) {
+    return false;
+  }
+  return env_->GetBackgroundThreads(Env::Priority::BOTTOM) > 0;
+}
+
 bool DBImpl::HasPendingManualCompaction() {
   return (!manual_compaction_dequeue_.empty());
 }
@@ -3214,7 +3366,8 @@ void DBImpl::RemoveManualCompaction(DBImpl::ManualCompaction* m) {
 
 bool DBImpl::ShouldntRunManualCompaction(ManualCompaction* m) {
   if (m->exclusive) {
-    return (bg_compaction_scheduled_ > 0);
+    return (bg_bottom_compaction_scheduled_ > 0 ||
+            bg_compaction_scheduled_ > 0);
   }
   std::deque<ManualCompaction*>::iterator it =
       manual_compaction_dequeue_.begin();
@@ -3310,23 +3463,39 @@ static void CleanupIteratorState(void* arg1, void* arg2) {
 }
 }  // namespace
 
-InternalIterator* DBImpl::NewInternalIterator(const ReadOptions& read_options,
-                                              ColumnFamilyData* cfd,
-                                              SuperVersion* super_version,
-                                              Arena* arena) {
+InternalIterator* DBImpl::NewInternalIterator(
+    const ReadOptions& read_options, ColumnFamilyData* cfd,
+    SuperVersion* super_version, Arena* arena,
+    RangeDelAggregator* range_del_agg) {
   InternalIterator* internal_iter;
   assert(arena != nullptr);
-  // Need to create internal iterator from the arena.
-  MergeIteratorBuilder merge_iter_builder(&cfd->internal_comparator(), arena);
-  // Collect iterator for mutable mem
-  merge_iter_builder.AddIterator(
-      super_version->mem->NewIterator(read_options, arena));
-  // Collect all needed child iterators for immutable memtables
-  super_version->imm->AddIterators(read_options, &merge_iter_builder);
-  // Collect iterators for files in L0 - Ln
-  super_version->current->AddIterators(read_options, env_options_,
-                                       &merge_iter_builder);
-  internal_iter = merge_iter_builder.Finish();
+  Status s;
+  if (range_del_agg != nullptr) {
+    // The range deletions of the memtables are needed from the start, those
+    // of the files are added as the files are opened
+    std::unique_ptr<InternalIterator> range_del_iter(
+        super_version->mem->NewRangeTombstoneIterator(read_options));
+    s = range_del_agg->AddTombstones(std::move(range_del_iter));
+    if (s.ok()) {
+      s = super_version->imm->AddRangeTombstones(read_options, range_del_agg);
+    }
+  }
+  if (s.ok()) {
+    // Need to create internal iterator from the arena.
+    MergeIteratorBuilder merge_iter_builder(&cfd->internal_comparator(),
+                                            arena);
+    // Collect iterator for mutable mem
+    merge_iter_builder.AddIterator(
+        super_version->mem->NewIterator(read_options, arena));
+    // Collect all needed child iterators for immutable memtables
+    super_version->imm->AddIterators(read_options, &merge_iter_builder);
+    // Collect iterators for files in L0 - Ln
+    super_version->current->AddIterators(read_options, env_options_,
+                                         &merge_iter_builder, range_del_agg);
+    internal_iter = merge_iter_builder.Finish();
+  } else {
+    internal_iter = NewErrorInternalIterator(s, arena);
+  }
   IterState* cleanup = new IterState(this, &mutex_, super_version);
   internal_iter->RegisterCleanup(CleanupIteratorState, cleanup, nullptr);
 
@@ -3425,12 +3594,14 @@ Status DBImpl::GetImpl(const ReadOptions& read_options,
 
   bool skip_memtable =
       (read_options.read_tier == kPersistedTier && has_unpersisted_data_);
+  RangeDelAggregator range_del_agg(cfd->internal_comparator(), {snapshot});
   bool done = false;
   if (!skip_memtable) {
-    if (sv->mem->Get(lkey, value, &s, &merge_context)) {
+    if (sv->mem->Get(lkey, value, &s, &merge_context, &range_del_agg)) {
       done = true;
       RecordTick(stats_, MEMTABLE_HIT);
-    } else if (sv->imm->Get(lkey, value, &s, &merge_context)) {
+    } else if (sv->imm->Get(lkey, value, &s, &merge_context,
+                            &range_del_agg)) {
       done = true;
       RecordTick(stats_, MEMTABLE_HIT);
     }
@@ -3438,7 +3609,7 @@ Status DBImpl::GetImpl(const ReadOptions& read_options,
   if (!done) {
     PERF_TIMER_GUARD(get_from_output_files_time);
     sv->current->Get(read_options, lkey, value, &s, &merge_context,
-                     value_found);
+                     &range_del_agg, value_found);
     RecordTick(stats_, MEMTABLE_MISS);
   }
 
@@ -3522,12 +3693,16 @@ std::vector<Status> DBImpl::MultiGet(
     auto super_version = mgd->super_version;
     bool skip_memtable =
         (read_options.read_tier == kPersistedTier && has_unpersisted_data_);
+    RangeDelAggregator range_del_agg(cfh->cfd()->internal_comparator(),
+                                     {snapshot});
     bool done = false;
     if (!skip_memtable) {
-      if (super_version->mem->Get(lkey, value, &s, &merge_context)) {
+      if (super_version->mem->Get(lkey, value, &s, &merge_context,
+                                  &range_del_agg)) {
         done = true;
         // TODO(?): RecordTick(stats_, MEMTABLE_HIT)?
-      } else if (super_version->imm->Get(lkey, value, &s, &merge_context)) {
+      } else if (super_version->imm->Get(lkey, value, &s, &merge_context,
+                                         &range_del_agg)) {
         done = true;
         // TODO(?): RecordTick(stats_, MEMTABLE_HIT)?
       }
@@ -3535,7 +3710,7 @@ std::vector<Status> DBImpl::MultiGet(
     if (!done) {
       PERF_TIMER_GUARD(get_from_output_files_time);
       super_version->current->Get(read_options, lkey, value, &s,
-                                  &merge_context);
+                                  &merge_context, &range_del_agg);
       // TODO(?): RecordTick(stats_, MEMTABLE_MISS)?
     }
 
@@ -3719,6 +3894,7 @@ Status DBImpl::AddFile(ColumnFamilyHandle* column_family,
 
     WriteThread::Writer w;
     write_thread_.EnterUnbatched(&w, &mutex_);
+    WaitForPendingUnorderedWrites();
 
     if (!snapshots_.empty()) {
       // Check that no snapshots are being held
@@ -3732,7 +3908,8 @@ Status DBImpl::AddFile(ColumnFamilyHandle* column_family,
       Arena arena;
       ReadOptions ro;
       ro.total_order_seek = true;
-      ScopedArenaIterator iter(NewInternalIterator(ro, cfd, sv, &arena));
+      ScopedArenaIterator iter(NewInternalIterator(
+          ro, cfd, sv, &arena, nullptr /* range_del_agg */));
 
       InternalKey range_start(file_info->smallest_key, kMaxSequenceNumber,
                               kTypeValue);
@@ -3831,6 +4008,7 @@ Status DBImpl::CreateColumnFamily(const ColumnFamilyOptions& cf_options,
     {  // write thread
       WriteThread::Writer w;
       write_thread_.EnterUnbatched(&w, &mutex_);
+      WaitForPendingUnorderedWrites();
       // LogAndApply will both write the creation in MANIFEST and create
       // ColumnFamilyData object
       s = versions_->LogAndApply(
@@ -3838,6 +4016,9 @@ Status DBImpl::CreateColumnFamily(const ColumnFamilyOptions& cf_options,
           &mutex_, directories_.GetDbDir(), false, &cf_options);
 
       if (s.ok()) {
+        // No write group is in flight, so the leader's view is consistent
+        has_inplace_update_cf_ =
+            has_inplace_update_cf_ || cf_options.inplace_update_support;
         // If the column family was created successfully, we then persist
         // the updated RocksDB options under the same single write thread
         persist_options_status = WriteOptionsFile();
@@ -3910,6 +4091,7 @@ Status DBImpl::DropColumnFamily(ColumnFamilyHandle* column_family) {
       // we drop column family from a single write thread
       WriteThread::Writer w;
       write_thread_.EnterUnbatched(&w, &mutex_);
+      WaitForPendingUnorderedWrites();
       s = versions_->LogAndApply(cfd, *cfd->GetLatestMutableCFOptions(),
                                  &edit, &mutex_);
       if (s.ok()) {
@@ -4082,8 +4264,10 @@ Iterator* DBImpl::NewIterator(const ReadOptions& read_options,
         read_options.prefix_same_as_start, read_options.pin_data);
 
     InternalIterator* internal_iter =
-        NewInternalIterator(read_options, cfd, sv, db_iter->GetArena());
+        NewInternalIterator(read_options, cfd, sv, db_iter->GetArena(),
+                            db_iter->GetRangeDelAggregator());
     db_iter->SetIterUnderDBIter(internal_iter);
+    SetDeletedRangeCallback(db_iter, cfd, sv);
 
     return db_iter;
   }
@@ -4155,8 +4339,10 @@ Status DBImpl::NewIterators(
           sv->mutable_cf_options.max_sequential_skip_in_iterations,
           sv->version_number, nullptr, false, read_options.pin_data);
       InternalIterator* internal_iter =
-          NewInternalIterator(read_options, cfd, sv, db_iter->GetArena());
+          NewInternalIterator(read_options, cfd, sv, db_iter->GetArena(),
+                              db_iter->GetRangeDelAggregator());
       db_iter->SetIterUnderDBIter(internal_iter);
+      SetDeletedRangeCallback(db_iter, cfd, sv);
       iterators->push_back(db_iter);
     }
   }
@@ -4164,6 +4350,81 @@ Status DBImpl::NewIterators(
   return Status::OK();
 }
 
+void DBImpl::SetDeletedRangeCallback(ArenaWrappedDBIter* db_iter,
+                                     ColumnFamilyData* cfd, SuperVersion* sv) {
+  const uint64_t trigger =
+      sv->mutable_cf_options.scan_deletion_compaction_trigger;
+  if (trigger == 0) {
+    return;
+  }
+  // Like sv, which it holds, the iterator does not outlive cfd
+  db_iter->SetDeletedRangeCallback(
+      trigger, [this, cfd](const Slice& smallest_user_key,
+                           const Slice& largest_user_key,
+                           uint64_t num_deletions) {
+        MarkDeletedRangeForCompaction(cfd, smallest_user_key, largest_user_key,
+                                      num_deletions);
+      });
+}
+
+void DBImpl::MarkDeletedRangeForCompaction(ColumnFamilyData* cfd,
+                                           const Slice& smallest_user_key,
+                                           const Slice& largest_user_key,
+                                           uint64_t num_deletions) {
+  InstrumentedMutexLock l(&mutex_);
+  if (cfd->IsDropped()) {
+    return;
+  }
+  // The flush drops the deletions that no older data needs, and puts the
+  // others into a file that the next scan can mark. The write thread switches
+  // the memtable before the next write.
+  bool flush_requested = false;
+  if (cfd->mem()->num_deletes() > 0 && cfd->mem()->MarkFlushScheduledEarly()) {
+    flush_scheduler_.ScheduleFlush(cfd);
+    flush_requested = true;
+  }
+
+  int num_marked = 0;
+  if (cfd->ioptions()->compaction_style == kCompactionStyleLevel) {
+    InternalKey begin, end;
+    begin.SetMaxPossibleForUserKey(smallest_user_key);
+    end.SetMinPossibleForUserKey(largest_user_key);
+    auto vstorage = cfd->current()->storage_info();
+    // Like ComputeFilesMarkedForCompaction(), leave out the last level with
+    // data
+    for (int level = 0; level < vstorage->num_non_empty_levels() - 1;
+         ++level) {
+      std::vector<FileMetaData*> inputs;
+      vstorage->GetOverlappingInputs(level, &begin, &end, &inputs);
+      for (auto f : inputs) {
+        // A file without entries has range deletions, or has not had its
+        // stats loaded
+        if (!f->being_compacted && !f->marked_for_compaction &&
+            (f->num_deletions > 0 || f->num_entries == 0)) {
+          f->marked_for_compaction = true;
+          num_marked++;
+        }
+      }
+    }
+    if (num_marked > 0) {
+      vstorage->ComputeCompactionScore(*cfd->GetLatestMutableCFOptions(),
+                                       cfd->ioptions()->compaction_options_fifo);
+      SchedulePendingCompaction(cfd);
+      MaybeScheduleFlushOrCompaction();
+    }
+  }
+
+  if (num_marked > 0 || flush_requested) {
+    Log(InfoLogLevel::INFO_LEVEL, db_options_.info_log,
+        "[%s] Iterator skipped %" PRIu64
+        " deleted entries in [%s, %s]: %d files marked for compaction%s",
+        cfd->GetName().c_str(), num_deletions,
+        smallest_user_key.ToString(true).c_str(),
+        largest_user_key.ToString(true).c_str(), num_marked,
+        flush_requested ? ", memtable flush requested" : "");
+  }
+}
+
 const Snapshot* DBImpl::GetSnapshot() { return GetSnapshotImpl(false); }
 
 #ifndef ROCKSDB_LITE
@@ -4223,6 +4484,18 @@ Status DBImpl::SingleDelete(const WriteOptions& write_options,
   return DB::SingleDelete(write_options, column_family, key);
 }
 
+Status DBImpl::DeleteRange(const WriteOptions& write_options,
+                           ColumnFamilyHandle* column_family,
+                           const Slice& begin_key, const Slice& end_key) {
+  auto cfh = reinterpret_cast<ColumnFamilyHandleImpl*>(column_family);
+  const ImmutableCFOptions* ioptions = cfh->cfd()->ioptions();
+  if (strcmp(ioptions->table_factory->Name(), "BlockBasedTable") != 0) {
+    return Status::NotSupported(
+        "DeleteRange is only supported with block based tables");
+  }
+  return DB::DeleteRange(write_options, column_family, begin_key, end_key);
+}
+
 Status DBImpl::Write(const WriteOptions& write_options, WriteBatch* my_batch) {
   return WriteImpl(write_options, my_batch, nullptr);
 }
@@ -4302,6 +4575,11 @@ Status DBImpl::WriteImpl(const WriteOptions& write_options,
     RecordTick(stats_, WRITE_DONE_BY_OTHER);
     return w.FinalStatus();
   }
+  if (w.state == WriteThread::STATE_UNORDERED_WRITER) {
+    // leader has written our batch to the WAL, we update the memtable
+    RecordTick(stats_, WRITE_DONE_BY_OTHER);
+    return UnorderedWriteMemtable(write_options, &w);
+  }
   // else we are the leader of the write batch group
   assert(w.state == WriteThread::STATE_GROUP_LEADER);
 
@@ -4350,11 +4628,17 @@ Status DBImpl::WriteImpl(const WriteOptions& write_options,
       }
     }
     MaybeScheduleFlushOrCompaction();
-  } else if (UNLIKELY(write_buffer_.ShouldFlush())) {
+  } else if (UNLIKELY(write_buffer_manager_->ShouldFlush())) {
+    // Before a new memtable is added in SwitchMemtable(),
+    // write_buffer_manager_->ShouldFlush() will keep returning true. If another
+    // thread is writing to another DB with the same write buffer, they may also
+    // be flushed. We may end up with flushing much more DBs than needed. It's
+    // suboptimal but still correct.
     Log(InfoLogLevel::INFO_LEVEL, db_options_.info_log,
         "Flushing column family with largest mem table size. Write buffer is "
         "using %" PRIu64 " bytes out of a total of %" PRIu64 ".",
-        write_buffer_.memory_usage(), write_buffer_.buffer_size());
+        write_buffer_manager_->mutable_memtable_memory_usage(),
+        write_buffer_manager_->buffer_size());
     // no need to refcount because drop is happening in write thread, so can't
     // happen while we're in the write thread
     ColumnFamilyData* largest_cfd = nullptr;
@@ -4438,19 +4722,24 @@ Status DBImpl::WriteImpl(const WriteOptions& write_options,
   if (status.ok()) {
     // Rules for when we can update the memtable concurrently
     // 1. supported by memtable
-    // 2. Puts are not okay if inplace_update_support
+    // 2. Puts are not okay with an inplace_callback
     // 3. Deletes or SingleDeletes are not okay if filtering deletes
     //    (controlled by both batch and memtable setting)
-    // 4. Merges are not okay
+    // 4. With inplace_update_support, a key must not be written by more
+    //    than one writer of the group, since in-place updates of the same
+    //    key would not be applied in sequence order
     //
     // Rules 1..3 are enforced by checking the options
     // during startup (CheckConcurrentWritesSupported), so if
     // options.allow_concurrent_memtable_write is true then they can be
-    // assumed to be true.  Rule 4 is checked for each batch.  We could
-    // relax rules 2 and 3 if we could prevent write batches from referring
-    // more than once to a particular key.
+    // assumed to be true.  Rule 4 is checked for each group.  Merge
+    // operands are fine, since every operand gets its own entry.
     bool parallel =
         db_options_.allow_concurrent_memtable_write && write_group.size() > 1;
+    // Unordered writes follow the same rules as parallel ones, but also
+    // apply to single-writer groups.  Rule 4 cannot be checked across
+    // groups, so it disables them.
+    bool unordered = db_options_.unordered_write && !has_inplace_update_cf_;
     int total_count = 0;
     uint64_t total_byte_size = 0;
     for (auto writer : write_group) {
@@ -4458,9 +4747,22 @@ Status DBImpl::WriteImpl(const WriteOptions& write_options,
         total_count += WriteBatchInternal::Count(writer->batch);
         total_byte_size = WriteBatchInternal::AppendedByteSize(
             total_byte_size, WriteBatchInternal::ByteSize(writer->batch));
-        parallel = parallel && !writer->batch->HasMerge();
       }
     }
+    if (parallel && has_inplace_update_cf_) {
+      parallel = WriteBatchInternal::HasDisjointKeys(write_group);
+    }
+
+    if (db_options_.unordered_write) {
+      if (!unordered) {
+        // An ordered group must not become visible before the unordered
+        // groups that precede it.
+        unordered_write_tracker_->WaitForPendingWrites();
+      }
+      // Earlier unordered groups may have allocated sequence numbers that
+      // are not published yet.
+      last_sequence = unordered_write_tracker_->LastAllocatedSequence();
+    }
 
     const SequenceNumber current_sequence = last_sequence + 1;
     last_sequence += total_count;
@@ -4559,6 +4861,29 @@ Status DBImpl::WriteImpl(const WriteOptions& write_options,
         }
       }
 
+      if (unordered) {
+        // Release the write queue so that the next group can write the WAL
+        // while the members of this group update the memtable.
+        size_t num_writers = 0;
+        for (auto writer : write_group) {
+          if (!writer->CallbackFailed() &&
+              WriteBatchInternal::Count(writer->batch) > 0) {
+            num_writers++;
+          }
+        }
+        if (num_writers > 0) {
+          unordered_write_tracker_->AddGroup(last_sequence, num_writers);
+        }
+        if (need_log_sync) {
+          mutex_.Lock();
+          MarkLogsSynced(logfile_number_, need_log_dir_sync, status);
+          mutex_.Unlock();
+        }
+        write_thread_.ExitAsUnorderedGroupLeader(&w, last_writer,
+                                                 current_sequence);
+        return UnorderedWriteMemtable(write_options, &w);
+      }
+
       if (!parallel) {
         status = WriteBatchInternal::InsertInto(
             write_group, current_sequence, column_family_memtables_.get(),
@@ -4646,6 +4971,43 @@ Status DBImpl::WriteImpl(const WriteOptions& write_options,
   return status;
 }
 
+Status DBImpl::UnorderedWriteMemtable(const WriteOptions& write_options,
+                                      WriteThread::Writer* w) {
+  PERF_TIMER_GUARD(write_memtable_time);
+
+  if (!w->CallbackFailed() && WriteBatchInternal::Count(w->batch) > 0) {
+    ColumnFamilyMemTablesImpl column_family_memtables(
+        versions_->GetColumnFamilySet());
+    WriteBatchInternal::SetSequence(w->batch, w->sequence);
+    w->status = WriteBatchInternal::InsertInto(
+        w->batch, &column_family_memtables, &flush_scheduler_,
+        write_options.ignore_missing_column_families, 0 /*log_number*/, this,
+        true /*dont_filter_deletes*/, true /*concurrent_memtable_writes*/);
+    TEST_SYNC_POINT("DBImpl::UnorderedWriteMemtable:BeforeComplete");
+    unordered_write_tracker_->CompleteWriter(w->sequence);
+    SetTickerCount(stats_, SEQUENCE_NUMBER, versions_->LastSequence());
+
+    if (!w->status.ok()) {
+      // The state implied by the WAL has diverged from the in-memory state.
+      // Stop compaction and fail any further writes.
+      InstrumentedMutexLock l(&mutex_);
+      if (bg_error_.ok()) {
+        bg_error_ = w->status;
+      }
+    }
+  }
+  return w->FinalStatus();
+}
+
+void DBImpl::WaitForPendingUnorderedWrites() {
+  mutex_.AssertHeld();
+  if (unordered_write_tracker_ != nullptr) {
+    mutex_.Unlock();
+    unordered_write_tracker_->WaitForPendingWrites();
+    mutex_.Lock();
+  }
+}
+
 // REQUIRES: mutex_ is held
 // REQUIRES: this thread is currently at the front of the writer queue
 Status DBImpl::DelayWrite(uint64_t num_bytes) {
@@ -4679,6 +5041,9 @@ Status DBImpl::DelayWrite(uint64_t num_bytes) {
 }
 
 Status DBImpl::ScheduleFlushes(WriteContext* context) {
+  // Unordered writers may still be scheduling flushes, which must not run
+  // concurrently with TakeNextColumnFamily().
+  WaitForPendingUnorderedWrites();
   ColumnFamilyData* cfd;
   while ((cfd = flush_scheduler_.TakeNextColumnFamily()) != nullptr) {
     auto status = SwitchMemtable(cfd, context);
@@ -4696,6 +5061,8 @@ Status DBImpl::ScheduleFlushes(WriteContext* context) {
 // REQUIRES: this thread is currently at the front of the writer queue
 Status DBImpl::SwitchMemtable(ColumnFamilyData* cfd, WriteContext* context) {
   mutex_.AssertHeld();
+  // The old memtable must not receive inserts after it becomes immutable.
+  WaitForPendingUnorderedWrites();
   unique_ptr<WritableFile> lfile;
   log::Writer* new_log = nullptr;
   MemTable* new_mem = nullptr;
@@ -4741,7 +5108,8 @@ Status DBImpl::SwitchMemtable(ColumnFamilyData* cfd, WriteContext* context) {
         unique_ptr<WritableFileWriter> file_writer(
             new WritableFileWriter(std::move(lfile), opt_env_opt));
         new_log = new log::Writer(std::move(file_writer), new_log_number,
-                                  db_options_.recycle_log_file_num > 0);
+                                  db_options_.recycle_log_file_num > 0,
+                                  db_options_.wal_compression);
       }
     }
 
@@ -5383,6 +5751,14 @@ Status DB::SingleDelete(const WriteOptions& opt,
   return Write(opt, &batch);
 }
 
+Status DB::DeleteRange(const WriteOptions& opt,
+                       ColumnFamilyHandle* column_family,
+                       const Slice& begin_key, const Slice& end_key) {
+  WriteBatch batch;
+  batch.DeleteRange(column_family, begin_key, end_key);
+  return Write(opt, &batch);
+}
+
 Status DB::Merge(const WriteOptions& opt, ColumnFamilyHandle* column_family,
                  const Slice& key, const Slice& value) {
   WriteBatch batch;
@@ -5436,12 +5812,16 @@ Status DB::Open(const DBOptions& db_options, const std::string& dbname,
   handles->clear();
 
   size_t max_write_buffer_size = 0;
+  bool has_inplace_update_cf = false;
   for (auto cf : column_families) {
     max_write_buffer_size =
         std::max(max_write_buffer_size, cf.options.write_buffer_size);
+    has_inplace_update_cf =
+        has_inplace_update_cf || cf.options.inplace_update_support;
   }
 
   DBImpl* impl = new DBImpl(db_options, dbname);
+  impl->has_inplace_update_cf_ = has_inplace_update_cf;
   s = impl->env_->CreateDirIfMissing(impl->db_options_.wal_dir);
   if (s.ok()) {
     for (auto db_path : impl->db_options_.db_paths) {
@@ -5482,7 +5862,8 @@ Status DB::Open(const DBOptions& db_options, const std::string& dbname,
       impl->logs_.emplace_back(
           new_log_number,
           new log::Writer(std::move(file_writer), new_log_number,
-                          impl->db_options_.recycle_log_file_num > 0));
+                          impl->db_options_.recycle_log_file_num > 0,
+                          impl->db_options_.wal_compression));
 
       // set column family handles
       for (auto cf : column_families) {
@@ -5889,7 +6270,8 @@ Status DBImpl::GetLatestSequenceForKey(SuperVersion* sv, const Slice& key,
   *found_record_for_key = false;
 
   // Check if there is a record for this key in the latest memtable
-  sv->mem->Get(lkey, nullptr, &s, &merge_context, seq);
+  sv->mem->Get(lkey, nullptr, &s, &merge_context, nullptr /* range_del_agg */,
+               seq);
 
   if (!(s.ok() || s.IsNotFound() || s.IsMergeInProgress())) {
     // unexpected error reading memtable.
@@ -5907,7 +6289,8 @@ Status DBImpl::GetLatestSequenceForKey(SuperVersion* sv, const Slice& key,
   }
 
   // Check if there is a record for this key in the immutable memtables
-  sv->imm->Get(lkey, nullptr, &s, &merge_context, seq);
+  sv->imm->Get(lkey, nullptr, &s, &merge_context, nullptr /* range_del_agg */,
+               seq);
 
   if (!(s.ok() || s.IsNotFound() || s.IsMergeInProgress())) {
     // unexpected error reading memtable.
@@ -5949,7 +6332,8 @@ Status DBImpl::GetLatestSequenceForKey(SuperVersion* sv, const Slice& key,
     ReadOptions read_options;
 
     sv->current->Get(read_options, lkey, nullptr, &s, &merge_context,
-                     nullptr /* value_found */, found_record_for_key, seq);
+                     nullptr /* range_del_agg */, nullptr /* value_found */,
+                     found_record_for_key, seq);
 
     if (!(s.ok() || s.IsNotFound() || s.IsMergeInProgress())) {
       // unexpected error reading SST files
@@ -25,17 +25,18 @@
 #include "db/internal_stats.h"
 #include "db/log_writer.h"
 #include "db/snapshot_impl.h"
+#include "db/unordered_write_tracker.h"
 #include "db/version_edit.h"
 #include "db/wal_manager.h"
 #include "db/write_controller.h"
 #include "db/write_thread.h"
-#include "db/writebuffer.h"
 #include "memtable_list.h"
 #include "port/port.h"
 #include "rocksdb/db.h"
 #include "rocksdb/env.h"
 #include "rocksdb/memtablerep.h"
 #include "rocksdb/transaction_log.h"
+#include "rocksdb/write_buffer_manager.h"
 #include "table/scoped_arena_iterator.h"
 #include "util/autovector.h"
 #include "util/event_logger.h"
@@ -47,11 +48,13 @@
 namespace rocksdb {
 
 class MemTable;
+class RangeDelAggregator;
 class TableCache;
 class Version;
 class VersionEdit;
 class VersionSet;
 class Arena;
+class ArenaWrappedDBIter;
 class WriteCallback;
 struct JobContext;
 struct ExternalSstFileInfo;
@@ -78,6 +81,11 @@ class DBImpl : public DB {
   virtual Status SingleDelete(const WriteOptions& options,
                               ColumnFamilyHandle* column_family,
                               const Slice& key) override;
+  using DB::DeleteRange;
+  virtual Status DeleteRange(const WriteOptions& options,
+                             ColumnFamilyHandle* column_family,
+                             const Slice& begin_key,
+                             const Slice& end_key) override;
   using DB::Write;
   virtual Status Write(const WriteOptions& options,
                        WriteBatch* updates) override;
@@ -345,6 +353,12 @@ class DBImpl : public DB {
 
   WriteController& TEST_write_controler() { return write_controller_; }
 
+  // Last sequence number allocated to an unordered write group.
+  // REQUIRES: db_options_.unordered_write
+  SequenceNumber TEST_GetUnorderedWriteAllocatedSequence() const {
+    return unordered_write_tracker_->LastAllocatedSequence();
+  }
+
 #endif  // NDEBUG
 
   // Return maximum background compaction alowed to be scheduled based on
@@ -428,10 +442,28 @@ class DBImpl : public DB {
   const DBOptions db_options_;
   Statistics* stats_;
 
+  // The range deletions of the memtables and files are added to
+  // range_del_agg, if it is not null
   InternalIterator* NewInternalIterator(const ReadOptions&,
                                         ColumnFamilyData* cfd,
                                         SuperVersion* super_version,
-                                        Arena* arena);
+                                        Arena* arena,
+                                        RangeDelAggregator* range_del_agg);
+
+  // Has db_iter report the runs of deleted entries it skips to
+  // MarkDeletedRangeForCompaction(), if the column family sets
+  // scan_deletion_compaction_trigger
+  void SetDeletedRangeCallback(ArenaWrappedDBIter* db_iter,
+                               ColumnFamilyData* cfd, SuperVersion* sv);
+
+  // Called when an iterator skipped num_deletions deleted entries between
+  // smallest_user_key and largest_user_key. Requests a flush of the memtable
+  // if it holds deletions, and marks the files that overlap the range and
+  // hold deletions for compaction.
+  void MarkDeletedRangeForCompaction(ColumnFamilyData* cfd,
+                                     const Slice& smallest_user_key,
+                                     const Slice& largest_user_key,
+                                     uint64_t num_deletions);
 
   // Except in DB::Open(), WriteOptionsFile can only be called when:
   // 1. WriteThread::Writer::EnterUnbatched() is used.
@@ -518,6 +550,13 @@ class DBImpl : public DB {
                                    bool* madeProgress, JobContext* job_context,
                                    LogBuffer* log_buffer);
 
+  // Merge the immutable memtables of cfd that wait for a flush into one
+  // memtable. See ColumnFamilyOptions::in_memory_compaction.
+  Status CompactMemTablesInMemory(ColumnFamilyData* cfd,
+                                  const MutableCFOptions& mutable_cf_options,
+                                  bool* made_progress, JobContext* job_context,
+                                  LogBuffer* log_buffer);
+
   // REQUIRES: log_numbers are sorted in ascending order
   Status RecoverLogFiles(const std::vector<uint64_t>& log_numbers,
                          SequenceNumber* max_sequence, bool read_only);
@@ -538,6 +577,18 @@ class DBImpl : public DB {
 
   Status SwitchMemtable(ColumnFamilyData* cfd, WriteContext* context);
 
+  // Applies the batch of w to the memtable after the leader of its write
+  // group has written it to the WAL in unordered write mode, then waits
+  // until its sequence number is visible.
+  Status UnorderedWriteMemtable(const WriteOptions& write_options,
+                                WriteThread::Writer* w);
+
+  // Waits until the memtable inserts of all unordered write groups have
+  // completed. No-op unless db_options_.unordered_write is set.
+  // REQUIRES: mutex_ is held
+  // REQUIRES: this thread is currently at the front of the writer queue
+  void WaitForPendingUnorderedWrites();
+
   // Force current memtable contents to be flushed.
   Status FlushMemTable(ColumnFamilyData* cfd, const FlushOptions& options);
 
@@ -561,12 +612,22 @@ class DBImpl : public DB {
   void SchedulePendingFlush(ColumnFamilyData* cfd);
   void SchedulePendingCompaction(ColumnFamilyData* cfd);
   static void BGWorkCompaction(void* arg);
+  static void BGWorkBottomCompaction(void* arg);
   static void BGWorkFlush(void* db);
   static void UnscheduleCallback(void* arg);
-  void BackgroundCallCompaction(void* arg);
+  void BackgroundCallCompaction(void* arg, Compaction* prepicked_compaction,
+                                Env::Priority thread_pri);
   void BackgroundCallFlush();
+  // prepicked_compaction, if not null, is a compaction that was picked by a
+  // LOW pool thread and handed to the BOTTOM pool, see
+  // ShouldRunInBottomPool()
   Status BackgroundCompaction(bool* madeProgress, JobContext* job_context,
-                              LogBuffer* log_buffer, void* m = 0);
+                              LogBuffer* log_buffer, void* m = 0,
+                              Compaction* prepicked_compaction = nullptr);
+  // Compactions into the last level can run for hours, so they are moved to
+  // the BOTTOM pool, if it has threads, to keep the LOW pool free for L0 and
+  // intermediate-level compactions
+  bool ShouldRunInBottomPool(const Compaction* c) const;
   Status BackgroundFlush(bool* madeProgress, JobContext* job_context,
                          LogBuffer* log_buffer);
 
@@ -611,7 +672,8 @@ class DBImpl : public DB {
 
   std::atomic<bool> shutting_down_;
   // This condition variable is signaled on these conditions:
-  // * whenever bg_compaction_scheduled_ goes down to 0
+  // * whenever bg_compaction_scheduled_ or bg_bottom_compaction_scheduled_
+  // goes down to 0
   // * if AnyManualCompaction, whenever a compaction finishes, even if it hasn't
   // made any progress
   // * whenever a compaction made any progress
@@ -710,10 +772,19 @@ class DBImpl : public DB {
 
   Directories directories_;
 
-  WriteBuffer write_buffer_;
+  WriteBufferManager* write_buffer_manager_;
 
   WriteThread write_thread_;
 
+  // Publishes sequence numbers of unordered writes. nullptr unless
+  // db_options_.unordered_write is set.
+  std::unique_ptr<UnorderedWriteTracker> unordered_write_tracker_;
+
+  // True if a column family uses inplace_update_support, in which case
+  // write groups are only inserted in parallel if their writers update
+  // disjoint keys.  Only changed while no write group is in flight.
+  bool has_inplace_update_cf_;
+
   WriteBatch tmp_batch_;
 
   WriteController write_controller_;
@@ -765,8 +836,14 @@ class DBImpl : public DB {
   int unscheduled_compactions_;
 
   // count how many background compactions are running or have been scheduled
+  // in the LOW pool
   int bg_compaction_scheduled_;
 
+  // count how many background compactions are running or have been scheduled
+  // in the BOTTOM pool. They are not limited by BGCompactionsAllowed(), but
+  // by the number of threads of the BOTTOM pool.
+  int bg_bottom_compaction_scheduled_;
+
   // stores the number of compactions are currently running
   int num_running_compactions_;
 
@@ -800,6 +877,8 @@ class DBImpl : public DB {
   struct CompactionArg {
     DBImpl* db;
     ManualCompaction* m;
+    // Only set for jobs of the BOTTOM pool
+    Compaction* prepicked_compaction;
   };
 
   // Have we encountered a background error in paranoid mode?
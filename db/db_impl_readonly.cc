@@ -6,11 +6,18 @@
 
 #include "db/db_impl_readonly.h"
 
+#include <algorithm>
+
 #include "db/compacted_db_impl.h"
+#include "db/compaction_job.h"
+#include "db/compaction_service.h"
 #include "db/db_impl.h"
 #include "db/merge_context.h"
+#include "db/range_del_aggregator.h"
 #include "db/db_iter.h"
+#include "util/log_buffer.h"
 #include "util/perf_context_imp.h"
+#include "util/string_util.h"
 
 namespace rocksdb {
 
@@ -36,11 +43,14 @@ Status DBImplReadOnly::Get(const ReadOptions& read_options,
   auto cfd = cfh->cfd();
   SuperVersion* super_version = cfd->GetSuperVersion();
   MergeContext merge_context;
+  RangeDelAggregator range_del_agg(cfd->internal_comparator(), {snapshot});
   LookupKey lkey(key, snapshot);
-  if (super_version->mem->Get(lkey, value, &s, &merge_context)) {
+  if (super_version->mem->Get(lkey, value, &s, &merge_context,
+                              &range_del_agg)) {
   } else {
     PERF_TIMER_GUARD(get_from_output_files_time);
-    super_version->current->Get(read_options, lkey, value, &s, &merge_context);
+    super_version->current->Get(read_options, lkey, value, &s, &merge_context,
+                                &range_del_agg);
   }
   return s;
 }
@@ -59,8 +69,9 @@ Iterator* DBImplReadOnly::NewIterator(const ReadOptions& read_options,
            : latest_snapshot),
       super_version->mutable_cf_options.max_sequential_skip_in_iterations,
       super_version->version_number);
-  auto internal_iter = NewInternalIterator(
-      read_options, cfd, super_version, db_iter->GetArena());
+  auto internal_iter =
+      NewInternalIterator(read_options, cfd, super_version,
+                          db_iter->GetArena(), db_iter->GetRangeDelAggregator());
   db_iter->SetIterUnderDBIter(internal_iter);
   return db_iter;
 }
@@ -87,8 +98,9 @@ Status DBImplReadOnly::NewIterators(
              : latest_snapshot),
         sv->mutable_cf_options.max_sequential_skip_in_iterations,
         sv->version_number);
-    auto* internal_iter = NewInternalIterator(
-        read_options, cfd, sv, db_iter->GetArena());
+    auto* internal_iter =
+        NewInternalIterator(read_options, cfd, sv, db_iter->GetArena(),
+                            db_iter->GetRangeDelAggregator());
     db_iter->SetIterUnderDBIter(internal_iter);
     iterators->push_back(db_iter);
   }
@@ -170,6 +182,140 @@ Status DB::OpenForReadOnly(
   return s;
 }
 
+namespace {
+// Looks up the files of a level of the compaction in the version of the DB
+// that runs it
+Status GetCompactionInputFiles(
+    VersionStorageInfo* vstorage,
+    const CompactionServiceInput::InputLevel& input_level,
+    CompactionInputFiles* input_files) {
+  if (input_level.level < 0 || input_level.level >= vstorage->num_levels()) {
+    return Status::InvalidArgument("Compaction input level out of range");
+  }
+  input_files->level = input_level.level;
+  const auto& level_files = vstorage->LevelFiles(input_level.level);
+  for (uint64_t number : input_level.files) {
+    auto it = std::find_if(level_files.begin(), level_files.end(),
+                           [number](const FileMetaData* f) {
+                             return f->fd.GetNumber() == number;
+                           });
+    if (it == level_files.end()) {
+      return Status::NotFound("Compaction input file not found",
+                              ToString(number));
+    }
+    input_files->files.push_back(*it);
+  }
+  return Status::OK();
+}
+}  // namespace
+
+Status DB::OpenAndCompact(const Options& options, const std::string& name,
+                          const std::string& output_directory,
+                          const std::string& input, std::string* result) {
+  CompactionServiceInput compaction_input;
+  Status s = compaction_input.DecodeFrom(input);
+  if (!s.ok()) {
+    return s;
+  }
+
+  DBOptions db_options(options);
+  // The compaction is run right here
+  db_options.compaction_service.reset();
+  ColumnFamilyOptions cf_options(options);
+  std::vector<ColumnFamilyDescriptor> column_families;
+  column_families.push_back(
+      ColumnFamilyDescriptor(kDefaultColumnFamilyName, cf_options));
+  if (compaction_input.column_family_name != kDefaultColumnFamilyName) {
+    column_families.push_back(ColumnFamilyDescriptor(
+        compaction_input.column_family_name, cf_options));
+  }
+  std::vector<ColumnFamilyHandle*> handles;
+  DB* db = nullptr;
+  s = DB::OpenForReadOnly(db_options, name, column_families, &handles, &db);
+  if (!s.ok()) {
+    return s;
+  }
+  DBImpl* impl = static_cast<DBImpl*>(db);
+  auto cfd = reinterpret_cast<ColumnFamilyHandleImpl*>(handles.back())->cfd();
+
+  s = impl->env_->CreateDirIfMissing(output_directory);
+
+  Compaction* c = nullptr;
+  impl->mutex_.Lock();
+  if (s.ok()) {
+    auto* vstorage = cfd->current()->storage_info();
+    std::vector<CompactionInputFiles> inputs(compaction_input.inputs.size());
+    for (size_t i = 0; s.ok() && i < inputs.size(); i++) {
+      s = GetCompactionInputFiles(vstorage, compaction_input.inputs[i],
+                                  &inputs[i]);
+    }
+    CompactionInputFiles grandparents;
+    if (s.ok() && compaction_input.grandparents.level < vstorage->num_levels()) {
+      s = GetCompactionInputFiles(vstorage, compaction_input.grandparents,
+                                  &grandparents);
+    }
+    if (s.ok() && (inputs.empty() || compaction_input.output_level < 0 ||
+                   compaction_input.output_level >= vstorage->num_levels())) {
+      s = Status::InvalidArgument("Invalid compaction levels");
+    }
+    if (s.ok()) {
+      // The snapshots and the sequence number at the tip of the DB that
+      // requested the compaction decide which entries can be dropped
+      if (compaction_input.last_sequence > impl->versions_->LastSequence()) {
+        impl->versions_->SetLastSequence(compaction_input.last_sequence);
+      }
+      c = new Compaction(
+          vstorage, *cfd->GetLatestMutableCFOptions(), std::move(inputs),
+          compaction_input.output_level, compaction_input.max_output_file_size,
+          compaction_input.max_grandparent_overlap_bytes,
+          compaction_input.output_path_id, compaction_input.compression,
+          std::move(grandparents.files), compaction_input.manual_compaction,
+          -1 /* score */, false /* deletion_compaction */,
+          compaction_input.compaction_reason);
+      c->SetInputVersion(cfd->current());
+    }
+  }
+
+  const bool run = c != nullptr;
+  CompactionServiceResult compaction_result;
+  if (run) {
+    LogBuffer log_buffer(InfoLogLevel::INFO_LEVEL,
+                         impl->db_options_.info_log.get());
+    CompactionJob compaction_job(
+        impl->next_job_id_.fetch_add(1), c, impl->db_options_,
+        impl->env_options_, impl->versions_.get(), &impl->shutting_down_,
+        &log_buffer, nullptr /* db_directory */,
+        nullptr /* output_directory */, impl->stats_, &impl->mutex_,
+        &impl->bg_error_, compaction_input.snapshots,
+        compaction_input.earliest_write_conflict_snapshot, impl->table_cache_,
+        &impl->event_logger_, c->mutable_cf_options()->paranoid_file_checks,
+        c->mutable_cf_options()->report_bg_io_stats, impl->dbname_, nullptr);
+    Slice begin(compaction_input.begin);
+    Slice end(compaction_input.end);
+    compaction_job.PrepareForCompactionService(
+        output_directory, compaction_input.has_begin ? &begin : nullptr,
+        compaction_input.has_end ? &end : nullptr);
+
+    impl->mutex_.Unlock();
+    s = compaction_job.RunForCompactionService(&compaction_result);
+    log_buffer.FlushBufferToLog();
+    impl->mutex_.Lock();
+
+    c->ReleaseCompactionFiles(s);
+    delete c;
+  }
+  impl->mutex_.Unlock();
+
+  if (run) {
+    compaction_result.EncodeTo(result);
+  }
+  for (auto* h : handles) {
+    delete h;
+  }
+  delete db;
+  return s;
+}
+
 #else  // !ROCKSDB_LITE
 
 Status DB::OpenForReadOnly(const Options& options, const std::string& dbname,
@@ -184,6 +330,12 @@ Status DB::OpenForReadOnly(
     bool error_if_log_file_exist) {
   return Status::NotSupported("Not supported in ROCKSDB_LITE.");
 }
+
+Status DB::OpenAndCompact(const Options& options, const std::string& name,
+                          const std::string& output_directory,
+                          const std::string& input, std::string* result) {
+  return Status::NotSupported("Not supported in ROCKSDB_LITE.");
+}
 #endif  // !ROCKSDB_LITE
 
 }   // namespace rocksdb
@@ -16,6 +16,7 @@
 #include "db/dbformat.h"
 #include "db/filename.h"
 #include "db/merge_context.h"
+#include "db/range_del_aggregator.h"
 #include "port/port.h"
 #include "rocksdb/env.h"
 #include "rocksdb/iterator.h"
@@ -118,7 +119,9 @@ class DBIter: public Iterator {
         version_number_(version_number),
         iterate_upper_bound_(iterate_upper_bound),
         prefix_same_as_start_(prefix_same_as_start),
-        iter_pinned_(false) {
+        iter_pinned_(false),
+        range_del_agg_(InternalKeyComparator(cmp), {s}),
+        deleted_range_threshold_(0) {
     RecordTick(statistics_, NO_ITERATORS);
     prefix_extractor_ = ioptions.prefix_extractor;
     max_skip_ = max_sequential_skip_in_iterations;
@@ -132,6 +135,14 @@ class DBIter: public Iterator {
       iter_->~InternalIterator();
     }
   }
+  RangeDelAggregator* GetRangeDelAggregator() { return &range_del_agg_; }
+
+  void SetDeletedRangeCallback(uint64_t threshold,
+                               const DeletedRangeCallback& callback) {
+    deleted_range_threshold_ = threshold;
+    deleted_range_callback_ = callback;
+  }
+
   virtual void SetIter(InternalIterator* iter) {
     assert(iter_ == nullptr);
     iter_ = iter;
@@ -219,6 +230,11 @@ class DBIter: public Iterator {
   void FindNextUserEntryInternal(bool skipping);
   bool ParseKey(ParsedInternalKey* key);
   void MergeValuesNewToOld();
+  inline void CountDeletedEntry(const Slice& user_key,
+                                uint64_t* num_deleted);
+  inline void ReportDeletedRange(const Slice& smallest_user_key,
+                                 const Slice& largest_user_key,
+                                 uint64_t num_deleted);
 
   inline void ClearSavedValue() {
     if (saved_value_.capacity() > 1048576) {
@@ -253,7 +269,15 @@ class DBIter: public Iterator {
   bool iter_pinned_;
   // List of operands for merge operator.
   MergeContext merge_context_;
+  // The range deletions of the memtables and files that iter_ goes through
+  RangeDelAggregator range_del_agg_;
   LocalStatistics local_stats_;
+  // The runs of deleted entries that are at least this long are reported to
+  // deleted_range_callback_, 0 if they are not tracked
+  uint64_t deleted_range_threshold_;
+  DeletedRangeCallback deleted_range_callback_;
+  // The first user key of the current run of deleted entries
+  std::string deleted_range_start_;
 
   // No copying allowed
   DBIter(const DBIter&);
@@ -272,6 +296,28 @@ inline bool DBIter::ParseKey(ParsedInternalKey* ikey) {
   }
 }
 
+// Counts an entry of a run of deleted entries, remembering the key that
+// starts the run
+inline void DBIter::CountDeletedEntry(const Slice& user_key,
+                                      uint64_t* num_deleted) {
+  if (deleted_range_threshold_ == 0) {
+    return;
+  }
+  if (*num_deleted == 0) {
+    deleted_range_start_.assign(user_key.data(), user_key.size());
+  }
+  ++*num_deleted;
+}
+
+inline void DBIter::ReportDeletedRange(const Slice& smallest_user_key,
+                                       const Slice& largest_user_key,
+                                       uint64_t num_deleted) {
+  if (deleted_range_threshold_ != 0 &&
+      num_deleted >= deleted_range_threshold_) {
+    deleted_range_callback_(smallest_user_key, largest_user_key, num_deleted);
+  }
+}
+
 void DBIter::Next() {
   assert(valid_);
 
@@ -332,6 +378,7 @@ void DBIter::FindNextUserEntryInternal(bool skipping) {
   assert(direction_ == kForward);
   current_entry_is_merged_ = false;
   uint64_t num_skipped = 0;
+  uint64_t num_deleted = 0;
   do {
     ParsedInternalKey ikey;
 
@@ -347,21 +394,30 @@ void DBIter::FindNextUserEntryInternal(bool skipping) {
           num_skipped++;  // skip this entry
           PERF_COUNTER_ADD(internal_key_skipped_count, 1);
         } else {
-          switch (ikey.type) {
+          ValueType type = ikey.type;
+          if ((type == kTypeValue || type == kTypeMerge) &&
+              range_del_agg_.ShouldDelete(ikey)) {
+            type = kTypeRangeDeletion;
+          }
+          switch (type) {
             case kTypeDeletion:
             case kTypeSingleDeletion:
+            case kTypeRangeDeletion:
               // Arrange to skip all upcoming entries for this key since
               // they are hidden by this deletion.
               saved_key_.SetKey(ikey.user_key,
                                 !iter_->IsKeyPinned() /* copy */);
               skipping = true;
               num_skipped = 0;
+              CountDeletedEntry(ikey.user_key, &num_deleted);
               PERF_COUNTER_ADD(internal_delete_skipped_count, 1);
               break;
             case kTypeValue:
               valid_ = true;
               saved_key_.SetKey(ikey.user_key,
                                 !iter_->IsKeyPinned() /* copy */);
+              ReportDeletedRange(deleted_range_start_, saved_key_.GetKey(),
+                                 num_deleted);
               return;
             case kTypeMerge:
               // By now, we are sure the current ikey is going to yield a value
@@ -369,6 +425,8 @@ void DBIter::FindNextUserEntryInternal(bool skipping) {
                                 !iter_->IsKeyPinned() /* copy */);
               current_entry_is_merged_ = true;
               valid_ = true;
+              ReportDeletedRange(deleted_range_start_, saved_key_.GetKey(),
+                                 num_deleted);
               MergeValuesNewToOld();  // Go to a different state machine
               return;
             default:
@@ -395,6 +453,8 @@ void DBIter::FindNextUserEntryInternal(bool skipping) {
     }
   } while (iter_->Valid());
   valid_ = false;
+  // saved_key_ holds the last deleted key of the run, if any
+  ReportDeletedRange(deleted_range_start_, saved_key_.GetKey(), num_deleted);
 }
 
 // Merge values of the same user key starting from the current iter_ position
@@ -426,8 +486,10 @@ void DBIter::MergeValuesNewToOld() {
     if (!user_comparator_->Equal(ikey.user_key, saved_key_.GetKey())) {
       // hit the next user key, stop right here
       break;
-    } else if (kTypeDeletion == ikey.type || kTypeSingleDeletion == ikey.type) {
-      // hit a delete with the same user key, stop right here
+    } else if (kTypeDeletion == ikey.type || kTypeSingleDeletion == ikey.type ||
+               range_del_agg_.ShouldDelete(ikey)) {
+      // hit a delete with the same user key, or an entry that a range
+      // deletion deletes, stop right here
       // iter_ is positioned after delete
       iter_->Next();
       break;
@@ -526,12 +588,16 @@ void DBIter::PrevInternal() {
   }
 
   ParsedInternalKey ikey;
+  // The run of deleted keys goes backwards, from deleted_range_start_
+  uint64_t num_deleted = 0;
 
   while (iter_->Valid()) {
     saved_key_.SetKey(ExtractUserKey(iter_->key()),
                       !iter_->IsKeyPinned() /* copy */);
     if (FindValueForCurrentKey()) {
       valid_ = true;
+      ReportDeletedRange(saved_key_.GetKey(), deleted_range_start_,
+                         num_deleted);
       if (!iter_->Valid()) {
         return;
       }
@@ -541,6 +607,7 @@ void DBIter::PrevInternal() {
       }
       return;
     }
+    CountDeletedEntry(saved_key_.GetKey(), &num_deleted);
     if (!iter_->Valid()) {
       break;
     }
@@ -552,6 +619,7 @@ void DBIter::PrevInternal() {
   // We haven't found any key - iterator is not valid
   assert(!iter_->Valid());
   valid_ = false;
+  ReportDeletedRange(saved_key_.GetKey(), deleted_range_start_, num_deleted);
 }
 
 // This function checks, if the entry with biggest sequence_number <= sequence_
@@ -577,6 +645,11 @@ bool DBIter::FindValueForCurrentKey() {
     }
 
     last_key_entry_type = ikey.type;
+    if ((last_key_entry_type == kTypeValue ||
+         last_key_entry_type == kTypeMerge) &&
+        range_del_agg_.ShouldDelete(ikey)) {
+      last_key_entry_type = kTypeRangeDeletion;
+    }
     switch (last_key_entry_type) {
       case kTypeValue:
         merge_context_.Clear();
@@ -585,6 +658,7 @@ bool DBIter::FindValueForCurrentKey() {
         break;
       case kTypeDeletion:
       case kTypeSingleDeletion:
+      case kTypeRangeDeletion:
         merge_context_.Clear();
         last_not_merge_type = last_key_entry_type;
         PERF_COUNTER_ADD(internal_delete_skipped_count, 1);
@@ -607,10 +681,11 @@ bool DBIter::FindValueForCurrentKey() {
   switch (last_key_entry_type) {
     case kTypeDeletion:
     case kTypeSingleDeletion:
+    case kTypeRangeDeletion:
       valid_ = false;
       return false;
     case kTypeMerge:
-      if (last_not_merge_type == kTypeDeletion) {
+      if (last_not_merge_type != kTypeValue) {
         StopWatchNano timer(env_, statistics_ != nullptr);
         PERF_TIMER_GUARD(merge_operator_time_nanos);
         user_merge_operator_->FullMerge(saved_key_.GetKey(), nullptr,
@@ -619,7 +694,6 @@ bool DBIter::FindValueForCurrentKey() {
         RecordTick(statistics_, MERGE_OPERATION_TOTAL_TIME,
                    timer.ElapsedNanos());
       } else {
-        assert(last_not_merge_type == kTypeValue);
         std::string last_put_value = saved_value_;
         Slice temp_slice(last_put_value);
         {
@@ -657,6 +731,10 @@ bool DBIter::FindValueForCurrentKeyUsingSeek() {
   ParsedInternalKey ikey;
   FindParseableKey(&ikey, kForward);
 
+  if (range_del_agg_.ShouldDelete(ikey)) {
+    valid_ = false;
+    return false;
+  }
   if (ikey.type == kTypeValue || ikey.type == kTypeDeletion ||
       ikey.type == kTypeSingleDeletion) {
     if (ikey.type == kTypeValue) {
@@ -673,7 +751,7 @@ bool DBIter::FindValueForCurrentKeyUsingSeek() {
   merge_context_.Clear();
   while (iter_->Valid() &&
          user_comparator_->Equal(ikey.user_key, saved_key_.GetKey()) &&
-         ikey.type == kTypeMerge) {
+         ikey.type == kTypeMerge && !range_del_agg_.ShouldDelete(ikey)) {
     merge_context_.PushOperand(iter_->value());
     iter_->Next();
     FindParseableKey(&ikey, kForward);
@@ -681,7 +759,8 @@ bool DBIter::FindValueForCurrentKeyUsingSeek() {
 
   if (!iter_->Valid() ||
       !user_comparator_->Equal(ikey.user_key, saved_key_.GetKey()) ||
-      ikey.type == kTypeDeletion || ikey.type == kTypeSingleDeletion) {
+      ikey.type == kTypeDeletion || ikey.type == kTypeSingleDeletion ||
+      range_del_agg_.ShouldDelete(ikey)) {
     {
       StopWatchNano timer(env_, statistics_ != nullptr);
       PERF_TIMER_GUARD(merge_operator_time_nanos);
@@ -901,6 +980,15 @@ ArenaWrappedDBIter::~ArenaWrappedDBIter() { db_iter_->~DBIter(); }
 
 void ArenaWrappedDBIter::SetDBIter(DBIter* iter) { db_iter_ = iter; }
 
+RangeDelAggregator* ArenaWrappedDBIter::GetRangeDelAggregator() {
+  return db_iter_->GetRangeDelAggregator();
+}
+
+void ArenaWrappedDBIter::SetDeletedRangeCallback(
+    uint64_t threshold, const DeletedRangeCallback& callback) {
+  db_iter_->SetDeletedRangeCallback(threshold, callback);
+}
+
 void ArenaWrappedDBIter::SetIterUnderDBIter(InternalIterator* iter) {
   static_cast<DBIter*>(db_iter_)->SetIter(iter);
 }
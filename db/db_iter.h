@@ -9,6 +9,7 @@
 
 #pragma once
 #include <stdint.h>
+#include <functional>
 #include <string>
 #include "rocksdb/db.h"
 #include "rocksdb/iterator.h"
@@ -21,6 +22,14 @@ namespace rocksdb {
 class Arena;
 class DBIter;
 class InternalIterator;
+class RangeDelAggregator;
+
+// Called by a DB iterator with the user key range of a run of deleted
+// entries that it skipped between two keys, when there were at least as many
+// as the threshold set with ArenaWrappedDBIter::SetDeletedRangeCallback()
+typedef std::function<void(const Slice& smallest_user_key,
+                           const Slice& largest_user_key,
+                           uint64_t num_deletions)> DeletedRangeCallback;
 
 // Return a new iterator that converts internal keys (yielded by
 // "*internal_iter") that were live at the specified "sequence" number
@@ -49,6 +58,15 @@ class ArenaWrappedDBIter : public Iterator {
 
   virtual void SetDBIter(DBIter* iter);
 
+  // The range deletions that apply to the iterator under the DB iterator are
+  // added to it as the memtables and files are visited
+  virtual RangeDelAggregator* GetRangeDelAggregator();
+
+  // Report the runs of at least threshold deleted entries to callback. A
+  // threshold of 0 disables the reports.
+  virtual void SetDeletedRangeCallback(uint64_t threshold,
+                                       const DeletedRangeCallback& callback);
+
   // Set the internal iterator wrapped inside the DB Iterator. Usually it is
   // a merging iterator.
   virtual void SetIterUnderDBIter(InternalIterator* iter);
@@ -14,6 +14,7 @@
 
 #include "db/db_test_util.h"
 #include "port/stack_trace.h"
+#include "util/compression.h"
 
 namespace rocksdb {
 
@@ -206,6 +207,27 @@ TEST_F(DBTestXactLogIterator, TransactionLogIteratorCorruptedLog) {
   } while (ChangeCompactOptions());
 }
 
+TEST_F(DBTestXactLogIterator, TransactionLogIteratorCompressedLog) {
+  if (!StreamingCompressionTypeSupported(kZlibCompression)) {
+    return;
+  }
+  Options options = OptionsForLogIterTest();
+  options.wal_compression = kZlibCompression;
+  DestroyAndReopen(options);
+  for (int i = 0; i < 1024; i++) {
+    ASSERT_OK(Put("key" + ToString(i), DummyString(1024)));
+  }
+  // Also read the records of a log written before the latest one
+  Reopen(options);
+  for (int i = 0; i < 1024; i++) {
+    ASSERT_OK(Put("key" + ToString(i), DummyString(1024)));
+  }
+  auto iter = OpenTransactionLogIter(0);
+  ExpectRecords(2048, iter);
+  iter = OpenTransactionLogIter(1500);
+  ExpectRecords(549, iter);
+}
+
 TEST_F(DBTestXactLogIterator, TransactionLogIteratorBatchOperations) {
   do {
     Options options = OptionsForLogIterTest();
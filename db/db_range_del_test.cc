@@ -0,0 +1,286 @@
+//  Copyright (c) 2011-present, Facebook, Inc.  All rights reserved.
+//  This source code is licensed under the BSD-style license found in the
+//  LICENSE file in the root directory of this source tree. An additional grant
+//  of patent rights can be found in the PATENTS file in the same directory.
+
+#include "db/db_test_util.h"
+#include "port/stack_trace.h"
+#include "rocksdb/table.h"
+#include "util/sync_point.h"
+#include "utilities/merge_operators.h"
+
+namespace rocksdb {
+
+class DBRangeDelTest : public DBTestBase {
+ public:
+  DBRangeDelTest() : DBTestBase("/db_range_del_test") {}
+
+  Options RangeDelOptions() {
+    Options options = CurrentOptions();
+    options.disable_auto_compactions = true;
+    options.num_levels = 3;
+    return options;
+  }
+
+  Status DeleteRange(int begin, int end) {
+    return db_->DeleteRange(WriteOptions(), db_->DefaultColumnFamily(),
+                            Key(begin), Key(end));
+  }
+
+  int CountKeys(const Snapshot* snapshot = nullptr, bool reverse = false) {
+    ReadOptions read_options;
+    read_options.snapshot = snapshot;
+    std::unique_ptr<Iterator> iter(db_->NewIterator(read_options));
+    int count = 0;
+    if (reverse) {
+      for (iter->SeekToLast(); iter->Valid(); iter->Prev()) {
+        count++;
+      }
+    } else {
+      for (iter->SeekToFirst(); iter->Valid(); iter->Next()) {
+        count++;
+      }
+    }
+    EXPECT_OK(iter->status());
+    return count;
+  }
+
+  void VerifyRangeDeleted(int begin, int end, int num_keys,
+                          const std::string& value) {
+    for (int i = 0; i < num_keys; i++) {
+      if (i >= begin && i < end) {
+        ASSERT_EQ("NOT_FOUND", Get(Key(i)));
+      } else {
+        ASSERT_EQ(value, Get(Key(i)));
+      }
+    }
+    ASSERT_EQ(num_keys - (end - begin), CountKeys());
+    ASSERT_EQ(num_keys - (end - begin), CountKeys(nullptr, true));
+  }
+};
+
+TEST_F(DBRangeDelTest, GetAndIterate) {
+  DestroyAndReopen(RangeDelOptions());
+  for (int i = 0; i < 10; i++) {
+    ASSERT_OK(Put(Key(i), "v"));
+  }
+  ASSERT_OK(DeleteRange(2, 5));
+  VerifyRangeDeleted(2, 5, 10, "v");
+
+  // From the WAL
+  Reopen(RangeDelOptions());
+  VerifyRangeDeleted(2, 5, 10, "v");
+
+  // From a file
+  ASSERT_OK(Flush());
+  VerifyRangeDeleted(2, 5, 10, "v");
+
+  // Seeks into the range land on the first key after it
+  std::unique_ptr<Iterator> iter(db_->NewIterator(ReadOptions()));
+  iter->Seek(Key(3));
+  ASSERT_TRUE(iter->Valid());
+  ASSERT_EQ(Key(5), iter->key().ToString());
+  iter->Prev();
+  ASSERT_TRUE(iter->Valid());
+  ASSERT_EQ(Key(1), iter->key().ToString());
+}
+
+TEST_F(DBRangeDelTest, NewerWritesAreKept) {
+  DestroyAndReopen(RangeDelOptions());
+  for (int i = 0; i < 10; i++) {
+    ASSERT_OK(Put(Key(i), "v1"));
+  }
+  ASSERT_OK(Flush());
+  ASSERT_OK(DeleteRange(0, 10));
+  ASSERT_OK(Put(Key(3), "v2"));
+  ASSERT_EQ("NOT_FOUND", Get(Key(2)));
+  ASSERT_EQ("v2", Get(Key(3)));
+  ASSERT_EQ(1, CountKeys());
+
+  ASSERT_OK(Flush());
+  ASSERT_OK(db_->CompactRange(CompactRangeOptions(), nullptr, nullptr));
+  ASSERT_EQ("NOT_FOUND", Get(Key(2)));
+  ASSERT_EQ("v2", Get(Key(3)));
+  ASSERT_EQ(1, CountKeys(nullptr, true));
+}
+
+TEST_F(DBRangeDelTest, Snapshot) {
+  DestroyAndReopen(RangeDelOptions());
+  for (int i = 0; i < 10; i++) {
+    ASSERT_OK(Put(Key(i), "v"));
+  }
+  const Snapshot* snapshot = db_->GetSnapshot();
+  ASSERT_OK(DeleteRange(0, 5));
+  ASSERT_EQ(10, CountKeys(snapshot));
+  ASSERT_EQ("v", Get(Key(0), snapshot));
+
+  // The compaction keeps what the snapshot sees
+  ASSERT_OK(Flush());
+  ASSERT_OK(db_->CompactRange(CompactRangeOptions(), nullptr, nullptr));
+  ASSERT_EQ(10, CountKeys(snapshot));
+  ASSERT_EQ("v", Get(Key(0), snapshot));
+  VerifyRangeDeleted(0, 5, 10, "v");
+
+  db_->ReleaseSnapshot(snapshot);
+  CompactRangeOptions compact_options;
+  compact_options.bottommost_level_compaction =
+      BottommostLevelCompaction::kForce;
+  ASSERT_OK(db_->CompactRange(compact_options, nullptr, nullptr));
+  ASSERT_EQ("[ ]", AllEntriesFor(Key(0)));
+  VerifyRangeDeleted(0, 5, 10, "v");
+}
+
+TEST_F(DBRangeDelTest, Merge) {
+  Options options = RangeDelOptions();
+  options.merge_operator = MergeOperators::CreateStringAppendOperator();
+  DestroyAndReopen(options);
+  ASSERT_OK(db_->Merge(WriteOptions(), Key(0), "a"));
+  ASSERT_OK(DeleteRange(0, 1));
+  ASSERT_OK(db_->Merge(WriteOptions(), Key(0), "b"));
+  ASSERT_EQ("b", Get(Key(0)));
+  ASSERT_EQ(1, CountKeys());
+
+  ASSERT_OK(Flush());
+  ASSERT_EQ("b", Get(Key(0)));
+  ASSERT_OK(db_->CompactRange(CompactRangeOptions(), nullptr, nullptr));
+  ASSERT_EQ("b", Get(Key(0)));
+  ASSERT_EQ(1, CountKeys(nullptr, true));
+}
+
+TEST_F(DBRangeDelTest, TableProperties) {
+  DestroyAndReopen(RangeDelOptions());
+  ASSERT_OK(DeleteRange(0, 10));
+  ASSERT_OK(DeleteRange(20, 30));
+  // A file of tombstones only
+  ASSERT_OK(Flush());
+  ASSERT_EQ("1", FilesPerLevel());
+
+  TablePropertiesCollection props;
+  ASSERT_OK(db_->GetPropertiesOfAllTables(&props));
+  ASSERT_EQ(1U, props.size());
+  ASSERT_EQ(0U, props.begin()->second->num_entries);
+  ASSERT_EQ(2U, props.begin()->second->num_range_deletions);
+}
+
+TEST_F(DBRangeDelTest, CompactionDropsCoveredFile) {
+  DestroyAndReopen(RangeDelOptions());
+  for (int i = 0; i < 100; i++) {
+    ASSERT_OK(Put(Key(i), "v"));
+  }
+  ASSERT_OK(Flush());
+  MoveFilesToLevel(2);
+  ASSERT_OK(DeleteRange(0, 100));
+  ASSERT_OK(Flush());
+  ASSERT_EQ("1,0,1", FilesPerLevel());
+
+  int num_skipped = 0;
+  rocksdb::SyncPoint::GetInstance()->SetCallBack(
+      "VersionSet::MakeInputIterator:SkipFile",
+      [&](void* arg) { num_skipped++; });
+  rocksdb::SyncPoint::GetInstance()->EnableProcessing();
+  ASSERT_OK(db_->CompactRange(CompactRangeOptions(), nullptr, nullptr));
+  rocksdb::SyncPoint::GetInstance()->DisableProcessing();
+  rocksdb::SyncPoint::GetInstance()->ClearAllCallBacks();
+
+  // The file of the keys was dropped unread, and the tombstone with it
+  ASSERT_EQ(1, num_skipped);
+  ASSERT_EQ("", FilesPerLevel());
+  VerifyRangeDeleted(0, 100, 100, "v");
+}
+
+TEST_F(DBRangeDelTest, CompactionDropsCoveredL0File) {
+  DestroyAndReopen(RangeDelOptions());
+  for (int i = 0; i < 100; i++) {
+    ASSERT_OK(Put(Key(i), "v"));
+  }
+  ASSERT_OK(Flush());
+  // L0 files are opened from the newest, so the range deletion is known
+  // before the older file would be read
+  ASSERT_OK(DeleteRange(0, 100));
+  ASSERT_OK(Put(Key(100), "v"));
+  ASSERT_OK(Flush());
+  ASSERT_EQ("2", FilesPerLevel());
+
+  int num_skipped = 0;
+  rocksdb::SyncPoint::GetInstance()->SetCallBack(
+      "VersionSet::MakeInputIterator:SkipFile",
+      [&](void* arg) { num_skipped++; });
+  rocksdb::SyncPoint::GetInstance()->EnableProcessing();
+  ASSERT_OK(dbfull()->TEST_CompactRange(0, nullptr, nullptr));
+  rocksdb::SyncPoint::GetInstance()->DisableProcessing();
+  rocksdb::SyncPoint::GetInstance()->ClearAllCallBacks();
+
+  ASSERT_EQ(1, num_skipped);
+  ASSERT_EQ("0,1", FilesPerLevel());
+  VerifyRangeDeleted(0, 100, 101, "v");
+}
+
+TEST_F(DBRangeDelTest, CompactionSplitsOutputFiles) {
+  Options options = RangeDelOptions();
+  options.target_file_size_base = 20 << 10;
+  DestroyAndReopen(options);
+  Random rnd(301);
+  const int kNumKeys = 200;
+  std::vector<std::string> values;
+  for (int i = 0; i < kNumKeys; i++) {
+    values.push_back(RandomString(&rnd, 1000));
+    ASSERT_OK(Put(Key(i), values[i]));
+  }
+  ASSERT_OK(Flush());
+  MoveFilesToLevel(2);
+  for (int i = 0; i < kNumKeys; i += 2) {
+    ASSERT_OK(Put(Key(i), values[i]));
+  }
+  ASSERT_OK(DeleteRange(50, 150));
+  ASSERT_OK(Flush());
+
+  // The tombstone is spread over the L1 outputs, and keeps deleting the keys
+  // in L2
+  ASSERT_OK(dbfull()->TEST_CompactRange(0, nullptr, nullptr));
+  ASSERT_GT(NumTableFilesAtLevel(1), 1);
+  for (int i = 0; i < kNumKeys; i++) {
+    ASSERT_EQ(i >= 50 && i < 150 ? "NOT_FOUND" : values[i], Get(Key(i)));
+  }
+  ASSERT_EQ(kNumKeys - 100, CountKeys());
+  ASSERT_EQ(kNumKeys - 100, CountKeys(nullptr, true));
+
+  ASSERT_OK(db_->CompactRange(CompactRangeOptions(), nullptr, nullptr));
+  for (int i = 0; i < kNumKeys; i++) {
+    ASSERT_EQ(i >= 50 && i < 150 ? "NOT_FOUND" : values[i], Get(Key(i)));
+  }
+  ASSERT_EQ("[ ]", AllEntriesFor(Key(100)));
+}
+
+TEST_F(DBRangeDelTest, Repair) {
+  Options options = RangeDelOptions();
+  DestroyAndReopen(options);
+  for (int i = 0; i < 10; i++) {
+    ASSERT_OK(Put(Key(i), "v"));
+  }
+  ASSERT_OK(Flush());
+  ASSERT_OK(DeleteRange(2, 5));
+  ASSERT_OK(Flush());
+  Close();
+  ASSERT_OK(RepairDB(dbname_, options));
+  Reopen(options);
+  VerifyRangeDeleted(2, 5, 10, "v");
+}
+
+#ifndef ROCKSDB_LITE
+TEST_F(DBRangeDelTest, NotSupportedWithPlainTable) {
+  Options options = RangeDelOptions();
+  options.table_factory.reset(NewPlainTableFactory());
+  options.prefix_extractor.reset(NewNoopTransform());
+  options.allow_mmap_reads = true;
+  DestroyAndReopen(options);
+  ASSERT_TRUE(DeleteRange(0, 10).IsNotSupported());
+}
+#endif  // ROCKSDB_LITE
+
+}  // namespace rocksdb
+
+int main(int argc, char** argv) {
+  rocksdb::port::InstallStackTraceHandler();
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
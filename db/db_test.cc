@@ -4504,7 +4504,7 @@ class RecoveryTestHelper {
 
     shared_ptr<Cache> table_cache = NewLRUCache(50000, 16);
     EnvOptions env_options;
-    WriteBuffer write_buffer(db_options.db_write_buffer_size);
+    WriteBufferManager write_buffer(db_options.db_write_buffer_size);
 
     unique_ptr<VersionSet> versions;
     unique_ptr<WalManager> wal_manager;
@@ -5908,19 +5908,73 @@ TEST_F(DBTest, ConcurrentMemtableNotSupported) {
   options.create_if_missing = true;
 
   DestroyDB(dbname_, options);
-  options.memtable_factory.reset(NewHashLinkListRepFactory(4, 0, 3, true, 4));
+  options.memtable_factory.reset(new VectorRepFactory());
   ASSERT_NOK(TryReopen(options));
 
   options.memtable_factory.reset(new SkipListFactory);
   ASSERT_OK(TryReopen(options));
 
   ColumnFamilyOptions cf_options(options);
-  cf_options.memtable_factory.reset(
-      NewHashLinkListRepFactory(4, 0, 3, true, 4));
+  cf_options.memtable_factory.reset(new VectorRepFactory());
   ColumnFamilyHandle* handle;
   ASSERT_NOK(db_->CreateColumnFamily(cf_options, "name", &handle));
 }
 
+TEST_F(DBTest, ConcurrentWritesWithHashMemtables) {
+  const int kNumThreads = 4;
+  const int kNumKeys = 2000;
+  for (int rep = 0; rep < 2; rep++) {
+    Options options = CurrentOptions();
+    options.allow_concurrent_memtable_write = true;
+    options.enable_write_thread_adaptive_yield = true;
+    options.prefix_extractor.reset(NewFixedPrefixTransform(4));
+    if (rep == 0) {
+      options.memtable_factory.reset(NewHashSkipListRepFactory(16));
+    } else {
+      // Small buckets that turn into skip lists under the writers
+      options.memtable_factory.reset(
+          NewHashLinkListRepFactory(16, 0, 0, false, 3));
+    }
+    DestroyAndReopen(options);
+
+    // The writers share the prefixes, so that they insert into the same
+    // buckets
+    auto key = [](int thread, int i) {
+      char buf[20];
+      snprintf(buf, sizeof(buf), "%04d%02d%06d", i % 8, thread, i);
+      return std::string(buf);
+    };
+    std::vector<std::thread> threads;
+    for (int t = 0; t < kNumThreads; t++) {
+      threads.emplace_back([&, t]() {
+        for (int i = 0; i < kNumKeys; i++) {
+          ASSERT_OK(Put(key(t, i), "v" + ToString(i)));
+        }
+      });
+    }
+    for (auto& t : threads) {
+      t.join();
+    }
+
+    for (int verify = 0; verify < 2; verify++) {
+      for (int t = 0; t < kNumThreads; t++) {
+        for (int i = 0; i < kNumKeys; i++) {
+          ASSERT_EQ("v" + ToString(i), Get(key(t, i)));
+        }
+      }
+      ReadOptions read_options;
+      read_options.total_order_seek = true;
+      std::unique_ptr<Iterator> iter(db_->NewIterator(read_options));
+      int count = 0;
+      for (iter->SeekToFirst(); iter->Valid(); iter->Next()) {
+        count++;
+      }
+      ASSERT_EQ(kNumThreads * kNumKeys, count);
+      ASSERT_OK(Flush());
+    }
+  }
+}
+
 #endif  // ROCKSDB_LITE
 
 TEST_F(DBTest, SanitizeNumThreads) {
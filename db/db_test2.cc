@@ -9,7 +9,9 @@
 #include <cstdlib>
 #include "db/db_test_util.h"
 #include "port/stack_trace.h"
+#include "rocksdb/memory_allocator.h"
 #include "rocksdb/wal_filter.h"
+#include "rocksdb/write_buffer_manager.h"
 
 namespace rocksdb {
 
@@ -731,6 +733,556 @@ TEST_F(DBTest2, FirstSnapshotTest) {
   db_->ReleaseSnapshot(s1);
 }
 
+TEST_F(DBTest2, SharedWriteBufferAcrossDBs) {
+  Options options = CurrentOptions();
+  options.arena_block_size = 4096;
+  options.write_buffer_size = 500000;  // this is never hit
+  std::shared_ptr<Cache> cache = NewLRUCache(4 * 1024 * 1024, 2);
+  options.write_buffer_manager.reset(new WriteBufferManager(100000, cache));
+  Reopen(options);
+
+  std::string dbname2 = test::TmpDir(env_) + "/db_shared_wb_db2";
+  ASSERT_OK(DestroyDB(dbname2, options));
+  DB* db2 = nullptr;
+  ASSERT_OK(DB::Open(options, dbname2, &db2));
+
+  WriteOptions wo;
+  // The memtables of both DBs are charged to the cache.
+  ASSERT_OK(db2->Put(wo, Key(1), DummyString(60000)));
+  ASSERT_OK(Put(Key(1), DummyString(1)));
+  ASSERT_GE(cache->GetUsage(), 1024 * 1024);
+
+  // db2 alone stays below the limit; the write to this DB pushes the shared
+  // usage over it, so the next write here flushes this DB.
+  ASSERT_OK(Put(Key(2), DummyString(50000)));
+  ASSERT_OK(Put(Key(3), DummyString(1)));
+  dbfull()->TEST_WaitForFlushMemTable();
+  ASSERT_EQ("1", FilesPerLevel());
+  std::string num_files;
+  ASSERT_TRUE(
+      db2->GetProperty("rocksdb.num-files-at-level0", &num_files));
+  ASSERT_EQ("0", num_files);
+
+  // Now db2 pushes the shared usage over the limit and flushes itself.
+  ASSERT_OK(db2->Put(wo, Key(2), DummyString(50000)));
+  ASSERT_OK(db2->Put(wo, Key(3), DummyString(1)));
+  reinterpret_cast<DBImpl*>(db2)->TEST_WaitForFlushMemTable();
+  ASSERT_TRUE(
+      db2->GetProperty("rocksdb.num-files-at-level0", &num_files));
+  ASSERT_EQ("1", num_files);
+  ASSERT_EQ("1", FilesPerLevel());
+
+  delete db2;
+  ASSERT_OK(DestroyDB(dbname2, options));
+}
+
+TEST_F(DBTest2, UnorderedWriteRequiresConcurrentMemtableWrite) {
+  Options options = CurrentOptions();
+  options.unordered_write = true;
+  options.allow_concurrent_memtable_write = false;
+  ASSERT_TRUE(TryReopen(options).IsInvalidArgument());
+}
+
+TEST_F(DBTest2, UnorderedWrite) {
+  Options options = CurrentOptions();
+  options.allow_concurrent_memtable_write = true;
+  options.unordered_write = true;
+  options.write_buffer_size = 64 << 10;
+  DestroyAndReopen(options);
+
+  const int kNumThreads = 8;
+  const int kNumKeys = 500;
+  std::vector<std::thread> threads;
+  for (int t = 0; t < kNumThreads; t++) {
+    threads.emplace_back([&, t]() {
+      for (int i = 0; i < kNumKeys; i++) {
+        std::string key = Key(t * kNumKeys + i);
+        ASSERT_OK(Put(key, key));
+        // A writer can always read its own write.
+        ASSERT_EQ(key, Get(key));
+      }
+    });
+  }
+  for (auto& t : threads) {
+    t.join();
+  }
+  // Merge operands are inserted out of order as well.
+  options.merge_operator = MergeOperators::CreateStringAppendOperator();
+  Reopen(options);
+  ASSERT_OK(db_->Merge(WriteOptions(), Key(0), "m"));
+
+  ASSERT_EQ(static_cast<SequenceNumber>(kNumThreads * kNumKeys + 1),
+            db_->GetLatestSequenceNumber());
+  ASSERT_EQ(Key(0) + ",m", Get(Key(0)));
+  for (int i = 1; i < kNumThreads * kNumKeys; i++) {
+    ASSERT_EQ(Key(i), Get(Key(i)));
+  }
+}
+
+TEST_F(DBTest2, UnorderedWriteVisibility) {
+  Options options = CurrentOptions();
+  options.allow_concurrent_memtable_write = true;
+  options.unordered_write = true;
+  DestroyAndReopen(options);
+  ASSERT_OK(Put("a", "v0"));
+  SequenceNumber seq = db_->GetLatestSequenceNumber();
+
+  // Hold the memtable insert of the first write while a later write
+  // completes.
+  std::atomic<bool> first(true);
+  std::atomic<bool> paused(false);
+  std::atomic<bool> resume(false);
+  rocksdb::SyncPoint::GetInstance()->SetCallBack(
+      "DBImpl::UnorderedWriteMemtable:BeforeComplete", [&](void* arg) {
+        if (first.exchange(false)) {
+          paused = true;
+          while (!resume) {
+            env_->SleepForMicroseconds(100);
+          }
+        }
+      });
+  rocksdb::SyncPoint::GetInstance()->EnableProcessing();
+
+  std::thread slow_writer([&]() { ASSERT_OK(Put("a", "v1")); });
+  while (!paused) {
+    env_->SleepForMicroseconds(100);
+  }
+  // The write queue has been released, so another write can proceed...
+  std::thread fast_writer([&]() { ASSERT_OK(Put("b", "v1")); });
+  while (dbfull()->TEST_GetUnorderedWriteAllocatedSequence() < seq + 2) {
+    env_->SleepForMicroseconds(100);
+  }
+  // ...but neither write is visible while the earlier one is in flight.
+  ASSERT_EQ(seq, db_->GetLatestSequenceNumber());
+  ASSERT_EQ("v0", Get("a"));
+  ASSERT_EQ("NOT_FOUND", Get("b"));
+
+  resume = true;
+  slow_writer.join();
+  fast_writer.join();
+  rocksdb::SyncPoint::GetInstance()->DisableProcessing();
+  rocksdb::SyncPoint::GetInstance()->ClearAllCallBacks();
+
+  ASSERT_EQ(seq + 2, db_->GetLatestSequenceNumber());
+  ASSERT_EQ("v1", Get("a"));
+  ASSERT_EQ("v1", Get("b"));
+}
+
+TEST_F(DBTest2, ConcurrentMemtableMerge) {
+  Options options = CurrentOptions();
+  options.allow_concurrent_memtable_write = true;
+  options.merge_operator = MergeOperators::CreateUInt64AddOperator();
+  // Ignored by concurrent inserts
+  options.max_successive_merges = 3;
+  DestroyAndReopen(options);
+
+  const int kNumThreads = 8;
+  const int kNumCounters = 4;
+  const int kNumMerges = 1000;
+  std::string one;
+  PutFixed64(&one, 1);
+  std::vector<std::thread> threads;
+  for (int t = 0; t < kNumThreads; t++) {
+    threads.emplace_back([&, t]() {
+      for (int i = 0; i < kNumMerges; i++) {
+        ASSERT_OK(db_->Merge(WriteOptions(), Key((t + i) % kNumCounters), one));
+      }
+    });
+  }
+  for (auto& t : threads) {
+    t.join();
+  }
+
+  for (int reopen = 0; reopen < 2; reopen++) {
+    uint64_t total = 0;
+    for (int c = 0; c < kNumCounters; c++) {
+      std::string value = Get(Key(c));
+      ASSERT_EQ(8U, value.size());
+      total += DecodeFixed64(value.data());
+    }
+    ASSERT_EQ(static_cast<uint64_t>(kNumThreads * kNumMerges), total);
+    // The counters are the same once rebuilt from the WAL
+    Reopen(options);
+  }
+}
+
+TEST_F(DBTest2, ConcurrentMemtableInplaceUpdate) {
+  Options options = CurrentOptions();
+  options.allow_concurrent_memtable_write = true;
+  options.inplace_update_support = true;
+  options.inplace_update_num_locks = 16;
+  DestroyAndReopen(options);
+
+  // Every thread overwrites its own keys in place, and a shared key
+  // that forces conflicting groups to be inserted serially.
+  const int kNumThreads = 8;
+  const int kNumKeys = 10;
+  const int kNumRounds = 200;
+  std::vector<std::thread> threads;
+  for (int t = 0; t < kNumThreads; t++) {
+    threads.emplace_back([&, t]() {
+      for (int r = 0; r < kNumRounds; r++) {
+        std::string value = "v" + ToString(kNumRounds - r);
+        ASSERT_OK(Put(Key(t * kNumKeys + r % kNumKeys), value));
+        if (r % 10 == 0) {
+          ASSERT_OK(Put("shared", value + "_" + ToString(t)));
+        }
+      }
+    });
+  }
+  for (auto& t : threads) {
+    t.join();
+  }
+
+  std::vector<std::string> values;
+  for (int k = 0; k < kNumThreads * kNumKeys; k++) {
+    values.push_back(Get(Key(k)));
+    ASSERT_EQ("v" + ToString(kNumKeys - k % kNumKeys), values.back());
+  }
+  values.push_back(Get("shared"));
+  ASSERT_NE("NOT_FOUND", values.back());
+
+  // Replaying the WAL in sequence order gives the same values
+  Reopen(options);
+  for (int k = 0; k < kNumThreads * kNumKeys; k++) {
+    ASSERT_EQ(values[k], Get(Key(k)));
+  }
+  ASSERT_EQ(values.back(), Get("shared"));
+
+  options.inplace_callback = [](char*, uint32_t*, Slice,
+                                std::string*) -> UpdateStatus {
+    return UpdateStatus::UPDATE_FAILED;
+  };
+  ASSERT_TRUE(TryReopen(options).IsInvalidArgument());
+}
+
+TEST_F(DBTest2, CompactionParallelCompression) {
+  if (!Zlib_Supported()) {
+    return;
+  }
+  Options options = CurrentOptions();
+  options.compression = kZlibCompression;
+  options.compression_opts.parallel_threads = 4;
+  options.write_buffer_size = 100 << 10;  // 100KB
+  options.target_file_size_base = 200 << 10;  // 200KB
+  options.level0_file_num_compaction_trigger = 100;
+  BlockBasedTableOptions table_options;
+  table_options.block_size = 1024;
+  table_options.filter_policy.reset(NewBloomFilterPolicy(10, false));
+  options.table_factory.reset(NewBlockBasedTableFactory(table_options));
+  DestroyAndReopen(options);
+
+  Random rnd(301);
+  std::vector<std::string> values;
+  for (int i = 0; i < 10000; i++) {
+    values.push_back(RandomString(&rnd, 50) + std::string(50, 'x'));
+    ASSERT_OK(Put(Key(i), values.back()));
+  }
+  ASSERT_OK(db_->CompactRange(CompactRangeOptions(), nullptr, nullptr));
+
+  // Output files are still cut by their estimated size
+  std::vector<LiveFileMetaData> files;
+  db_->GetLiveFilesMetaData(&files);
+  ASSERT_GT(files.size(), 1U);
+  for (auto& file : files) {
+    ASSERT_EQ(1, file.level);
+    ASSERT_LT(file.size, options.target_file_size_base * 3 / 2);
+  }
+  for (int i = 0; i < 10000; i++) {
+    ASSERT_EQ(values[i], Get(Key(i)));
+  }
+  std::unique_ptr<Iterator> iter(db_->NewIterator(ReadOptions()));
+  int count = 0;
+  for (iter->SeekToFirst(); iter->Valid(); iter->Next()) {
+    ASSERT_EQ(values[count], iter->value().ToString());
+    count++;
+  }
+  ASSERT_EQ(10000, count);
+}
+
+TEST_F(DBTest2, FlushParallelCompression) {
+  if (!Zlib_Supported()) {
+    return;
+  }
+  Options options = CurrentOptions();
+  options.compression = kZlibCompression;
+  options.compression_opts.parallel_threads = 3;
+  options.write_buffer_size = 4 << 20;  // 4MB
+  options.statistics = rocksdb::CreateDBStatistics();
+  BlockBasedTableOptions table_options;
+  table_options.block_size = 1024;
+  options.table_factory.reset(NewBlockBasedTableFactory(table_options));
+  DestroyAndReopen(options);
+
+  Random rnd(301);
+  std::vector<std::string> values;
+  for (int i = 0; i < 10000; i++) {
+    values.push_back(RandomString(&rnd, 50) + std::string(50, 'x'));
+    ASSERT_OK(Put(Key(i), values.back()));
+  }
+  ASSERT_OK(Flush());
+  ASSERT_EQ("1", FilesPerLevel());
+
+  for (int i = 0; i < 10000; i++) {
+    ASSERT_EQ(values[i], Get(Key(i)));
+  }
+  HistogramData queue_depth;
+  options.statistics->histogramData(PARALLEL_COMPRESSION_QUEUE_DEPTH,
+                                    &queue_depth);
+  ASSERT_GT(queue_depth.average, 0);
+  ASSERT_LE(queue_depth.average, 2 * 3 + 1);
+}
+
+TEST_F(DBTest2, MemtableInsertWithHint) {
+  Options options = CurrentOptions();
+  options.memtable_insert_with_hint_prefix_extractor.reset(
+      NewFixedPrefixTransform(4));
+  DestroyAndReopen(options);
+
+  // Interleaved streams of increasing keys, plus keys too short for the
+  // extractor and deletions, which go through the same hints
+  std::map<std::string, std::string> expected;
+  Random rnd(301);
+  for (int i = 0; i < 2000; i++) {
+    std::string key;
+    if (rnd.OneIn(10)) {
+      key = ToString(rnd.Uniform(1000));
+    } else {
+      char buf[32];
+      snprintf(buf, sizeof(buf), "s%03d%08d", static_cast<int>(rnd.Uniform(8)),
+               i);
+      key = buf;
+    }
+    if (!expected.empty() && rnd.OneIn(8)) {
+      auto it = expected.lower_bound(key);
+      if (it != expected.end()) {
+        ASSERT_OK(Delete(it->first));
+        expected.erase(it);
+        continue;
+      }
+    }
+    std::string value = RandomString(&rnd, 10);
+    ASSERT_OK(Put(key, value));
+    expected[key] = value;
+  }
+
+  auto verify = [&]() {
+    for (const auto& kv : expected) {
+      ASSERT_EQ(kv.second, Get(kv.first));
+    }
+    std::unique_ptr<Iterator> iter(db_->NewIterator(ReadOptions()));
+    auto expected_it = expected.begin();
+    for (iter->SeekToFirst(); iter->Valid(); iter->Next(), ++expected_it) {
+      ASSERT_TRUE(expected_it != expected.end());
+      ASSERT_EQ(expected_it->first, iter->key().ToString());
+      ASSERT_EQ(expected_it->second, iter->value().ToString());
+    }
+    ASSERT_TRUE(expected_it == expected.end());
+  };
+  verify();
+  ASSERT_OK(Flush());
+  verify();
+}
+
+TEST_F(DBTest2, MemtableKeyIndex) {
+  // A small index makes some of the lookups fall back to the memtable rep
+  for (uint32_t num_slots : {10000, 64}) {
+    Options options = CurrentOptions();
+    options.memtable_key_index_slots = num_slots;
+    options.merge_operator = MergeOperators::CreateStringAppendOperator();
+    DestroyAndReopen(options);
+
+    std::map<std::string, std::string> expected;
+    Random rnd(301);
+    for (int i = 0; i < 2000; i++) {
+      std::string key = Key(rnd.Uniform(300));
+      if (rnd.OneIn(8)) {
+        ASSERT_OK(Delete(key));
+        expected.erase(key);
+      } else if (rnd.OneIn(8)) {
+        ASSERT_OK(db_->Merge(WriteOptions(), key, "m"));
+        auto it = expected.find(key);
+        expected[key] = it == expected.end() ? "m" : it->second + ",m";
+      } else {
+        std::string value = RandomString(&rnd, 10);
+        ASSERT_OK(Put(key, value));
+        expected[key] = value;
+      }
+    }
+
+    const Snapshot* snapshot = db_->GetSnapshot();
+    std::map<std::string, std::string> expected_at_snapshot = expected;
+    for (int i = 0; i < 300; i += 3) {
+      ASSERT_OK(Put(Key(i), "new"));
+      expected[Key(i)] = "new";
+    }
+    ASSERT_OK(db_->DeleteRange(WriteOptions(), db_->DefaultColumnFamily(),
+                               Key(100), Key(120)));
+    for (int i = 100; i < 120; i++) {
+      expected.erase(Key(i));
+    }
+
+    for (int i = 0; i < 300; i++) {
+      auto it = expected.find(Key(i));
+      ASSERT_EQ(it == expected.end() ? "NOT_FOUND" : it->second, Get(Key(i)));
+      it = expected_at_snapshot.find(Key(i));
+      ASSERT_EQ(it == expected_at_snapshot.end() ? "NOT_FOUND" : it->second,
+                Get(Key(i), snapshot));
+    }
+    db_->ReleaseSnapshot(snapshot);
+  }
+}
+
+namespace {
+// Counts the bytes that are outstanding from a NUMA memory allocator
+class CountingMemoryAllocator : public MemoryAllocator {
+ public:
+  CountingMemoryAllocator()
+      : target_(NewNumaMemoryAllocator(kNumaInterleave)), allocated_(0) {}
+
+  const char* Name() const override { return "CountingMemoryAllocator"; }
+
+  void* Allocate(size_t size) override {
+    allocated_ += size;
+    return target_->Allocate(size);
+  }
+
+  void Deallocate(void* p, size_t size) override {
+    allocated_ -= size;
+    target_->Deallocate(p, size);
+  }
+
+  size_t allocated() const { return allocated_.load(); }
+
+ private:
+  std::shared_ptr<MemoryAllocator> target_;
+  std::atomic<size_t> allocated_;
+};
+}  // namespace
+
+TEST_F(DBTest2, MemoryAllocator) {
+  auto memory_allocator = std::make_shared<CountingMemoryAllocator>();
+  Options options = CurrentOptions();
+  options.memtable_memory_allocator = memory_allocator;
+  BlockBasedTableOptions table_options;
+  table_options.block_cache =
+      NewLRUCache(1 << 20, 0, false /* strict_capacity_limit */,
+                  memory_allocator);
+  options.table_factory.reset(NewBlockBasedTableFactory(table_options));
+  DestroyAndReopen(options);
+
+  // The memtable arena takes its blocks from the allocator
+  for (int i = 0; i < 100; i++) {
+    ASSERT_OK(Put(Key(i), "v" + ToString(i)));
+  }
+  ASSERT_GT(memory_allocator->allocated(), 0);
+  ASSERT_OK(Flush());
+
+  // And so do the data blocks read into the block cache
+  const size_t memtable_allocated = memory_allocator->allocated();
+  for (int i = 0; i < 100; i++) {
+    ASSERT_EQ("v" + ToString(i), Get(Key(i)));
+  }
+  ASSERT_GT(memory_allocator->allocated(), memtable_allocated);
+
+  // The blocks go back to the allocator when they leave the cache
+  Close();
+  table_options.block_cache->EraseUnRefEntries();
+  ASSERT_EQ(0, memory_allocator->allocated());
+}
+
+#ifndef ROCKSDB_LITE
+TEST_F(DBTest2, InMemoryCompaction) {
+  Options options = CurrentOptions();
+  options.write_buffer_size = 64 << 10;
+  options.max_write_buffer_number = 6;
+  options.min_write_buffer_number_to_merge = 4;
+  options.in_memory_compaction = true;
+  options.disable_auto_compactions = true;
+  options.merge_operator = MergeOperators::CreateStringAppendOperator();
+  DestroyAndReopen(options);
+
+  std::atomic<int> num_compactions(0);
+  rocksdb::SyncPoint::GetInstance()->SetCallBack(
+      "InMemoryCompactionJob::Run:Merged",
+      [&](void* arg) { num_compactions++; });
+  rocksdb::SyncPoint::GetInstance()->EnableProcessing();
+
+  // The keys are overwritten many times over, so the merged memtable stays
+  // much smaller than four memtables and is never flushed
+  std::map<std::string, std::string> expected;
+  Random rnd(301);
+  const Snapshot* snapshot = nullptr;
+  std::map<std::string, std::string> expected_at_snapshot;
+  for (int i = 0; i < 5000; i++) {
+    std::string key = Key(rnd.Uniform(50));
+    if (rnd.OneIn(10)) {
+      ASSERT_OK(Delete(key));
+      expected.erase(key);
+    } else if (rnd.OneIn(10)) {
+      ASSERT_OK(db_->Merge(WriteOptions(), key, "m"));
+      auto it = expected.find(key);
+      expected[key] = it == expected.end() ? "m" : it->second + ",m";
+    } else {
+      std::string value = RandomString(&rnd, 200);
+      ASSERT_OK(Put(key, value));
+      expected[key] = value;
+    }
+    if (i == 2500) {
+      snapshot = db_->GetSnapshot();
+      expected_at_snapshot = expected;
+    }
+    if (i % 100 == 0) {
+      // Let the in-memory compactions keep up with the writes
+      dbfull()->TEST_WaitForCompact();
+    }
+  }
+  ASSERT_OK(db_->DeleteRange(WriteOptions(), db_->DefaultColumnFamily(),
+                             Key(10), Key(20)));
+  for (int i = 10; i < 20; i++) {
+    expected.erase(Key(i));
+  }
+  dbfull()->TEST_WaitForCompact();
+  rocksdb::SyncPoint::GetInstance()->DisableProcessing();
+  ASSERT_GT(num_compactions.load(), 0);
+  ASSERT_EQ(0, NumTableFilesAtLevel(0));
+  std::string num_imm;
+  ASSERT_TRUE(
+      db_->GetProperty("rocksdb.num-immutable-mem-table", &num_imm));
+  ASSERT_LE(std::stoi(num_imm), 2);
+
+  auto verify = [&]() {
+    for (int i = 0; i < 50; i++) {
+      auto it = expected.find(Key(i));
+      ASSERT_EQ(it == expected.end() ? "NOT_FOUND" : it->second, Get(Key(i)));
+      it = expected_at_snapshot.find(Key(i));
+      ASSERT_EQ(it == expected_at_snapshot.end() ? "NOT_FOUND" : it->second,
+                Get(Key(i), snapshot));
+    }
+    std::unique_ptr<Iterator> iter(db_->NewIterator(ReadOptions()));
+    auto it = expected.begin();
+    for (iter->SeekToFirst(); iter->Valid(); iter->Next(), ++it) {
+      ASSERT_TRUE(it != expected.end());
+      ASSERT_EQ(it->first, iter->key().ToString());
+      ASSERT_EQ(it->second, iter->value().ToString());
+    }
+    ASSERT_TRUE(it == expected.end());
+  };
+  verify();
+
+  // A requested flush writes out all the memtables
+  ASSERT_OK(Flush());
+  ASSERT_EQ(1, NumTableFilesAtLevel(0));
+  verify();
+  db_->ReleaseSnapshot(snapshot);
+  snapshot = nullptr;
+  expected_at_snapshot = expected;
+
+  Reopen(options);
+  verify();
+}
+#endif  // ROCKSDB_LITE
+
 class PinL0IndexAndFilterBlocksTest : public DBTestBase,
                                       public testing::WithParamInterface<bool> {
  public:
@@ -86,7 +86,8 @@ bool DBTestBase::ShouldSkipOptions(int option_config, int skip_mask) {
       option_config == kUniversalCompactionMultiLevel ||
       option_config == kUniversalSubcompactions ||
       option_config == kFIFOCompaction ||
-      option_config == kConcurrentSkipList) {
+      option_config == kConcurrentSkipList ||
+      option_config == kConcurrentBTree) {
     return true;
     }
 #endif
@@ -374,6 +375,14 @@ Options DBTestBase::CurrentOptions(
       options.enable_write_thread_adaptive_yield = true;
       break;
     }
+#ifndef ROCKSDB_LITE
+    case kConcurrentBTree: {
+      options.memtable_factory.reset(new BTreeRepFactory());
+      options.allow_concurrent_memtable_write = true;
+      options.enable_write_thread_adaptive_yield = true;
+      break;
+    }
+#endif  // ROCKSDB_LITE
 
     default:
       break;
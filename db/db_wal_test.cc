@@ -9,6 +9,7 @@
 
 #include "db/db_test_util.h"
 #include "port/stack_trace.h"
+#include "util/compression.h"
 #include "util/sync_point.h"
 
 namespace rocksdb {
@@ -127,6 +128,44 @@ TEST_F(DBWALTest, SyncWALNotWaitWrite) {
   ASSERT_EQ(Get("foo2"), "bar2");
   rocksdb::SyncPoint::GetInstance()->DisableProcessing();
 }
+
+TEST_F(DBWALTest, CompressedWAL) {
+  if (!StreamingCompressionTypeSupported(kZlibCompression)) {
+    return;
+  }
+  for (size_t recycle_log_file_num : {0, 2}) {
+    Options options = CurrentOptions();
+    options.wal_compression = kZlibCompression;
+    options.recycle_log_file_num = recycle_log_file_num;
+    DestroyAndReopen(options);
+
+    for (int round = 0; round < 4; round++) {
+      for (int i = 0; i < 200; i++) {
+        ASSERT_OK(Put(Key(i), "{\"round\": " + ToString(round) +
+                                  ", \"value\": " + ToString(i) + "}"));
+      }
+      // Recover from compressed and uncompressed logs
+      options.wal_compression =
+          round % 2 == 0 ? kNoCompression : kZlibCompression;
+      Reopen(options);
+      for (int i = 0; i < 200; i++) {
+        ASSERT_EQ("{\"round\": " + ToString(round) +
+                      ", \"value\": " + ToString(i) + "}",
+                  Get(Key(i)));
+      }
+      if (round == 1) {
+        // Make the next log files recycled ones
+        ASSERT_OK(Flush());
+      }
+    }
+  }
+}
+
+TEST_F(DBWALTest, CompressedWALNotSupported) {
+  Options options = CurrentOptions();
+  options.wal_compression = kBZip2Compression;
+  ASSERT_TRUE(TryReopen(options).IsNotSupported());
+}
 }  // namespace rocksdb
 
 int main(int argc, char** argv) {
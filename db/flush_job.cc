@@ -222,6 +222,11 @@ Status FlushJob::WriteLevel0Table(const autovector<MemTable*>& mems,
 
   Version* base = cfd_->current();
   base->Ref();  // it is likely that we do not need this reference
+  // The deletions of keys that no file holds can be dropped if there is no
+  // older memtable, whose data is not in base yet
+  VersionStorageInfo* flush_base = cfd_->imm()->IsOldestMemTable(mems[0])
+                                       ? base->storage_info()
+                                       : nullptr;
   Status s;
   {
     db_mutex_->Unlock();
@@ -229,6 +234,7 @@ Status FlushJob::WriteLevel0Table(const autovector<MemTable*>& mems,
       log_buffer_->FlushBufferToLog();
     }
     std::vector<InternalIterator*> memtables;
+    std::vector<InternalIterator*> range_del_iters;
     ReadOptions ro;
     ro.total_order_seek = true;
     Arena arena;
@@ -239,6 +245,10 @@ Status FlushJob::WriteLevel0Table(const autovector<MemTable*>& mems,
           "[%s] [JOB %d] Flushing memtable with next log file: %" PRIu64 "\n",
           cfd_->GetName().c_str(), job_context_->job_id, m->GetNextLogNumber());
       memtables.push_back(m->NewIterator(ro, &arena));
+      auto* range_del_iter = m->NewRangeTombstoneIterator(ro);
+      if (range_del_iter != nullptr) {
+        range_del_iters.push_back(range_del_iter);
+      }
       total_num_entries += m->num_entries();
       total_num_deletes += m->num_deletes();
       total_memory_usage += m->ApproximateMemoryUsage();
@@ -256,6 +266,10 @@ Status FlushJob::WriteLevel0Table(const autovector<MemTable*>& mems,
       ScopedArenaIterator iter(
           NewMergingIterator(&cfd_->internal_comparator(), &memtables[0],
                              static_cast<int>(memtables.size()), &arena));
+      std::unique_ptr<InternalIterator> range_del_iter(NewMergingIterator(
+          &cfd_->internal_comparator(),
+          range_del_iters.empty() ? nullptr : &range_del_iters[0],
+          static_cast<int>(range_del_iters.size())));
       Log(InfoLogLevel::INFO_LEVEL, db_options_.info_log,
           "[%s] [JOB %d] Level-0 flush table #%" PRIu64 ": started",
           cfd_->GetName().c_str(), job_context_->job_id, meta->fd.GetNumber());
@@ -264,13 +278,14 @@ Status FlushJob::WriteLevel0Table(const autovector<MemTable*>& mems,
                                &output_compression_);
       s = BuildTable(
           dbname_, db_options_.env, *cfd_->ioptions(), env_options_,
-          cfd_->table_cache(), iter.get(), meta, cfd_->internal_comparator(),
+          cfd_->table_cache(), iter.get(), std::move(range_del_iter), meta,
+          cfd_->internal_comparator(),
           cfd_->int_tbl_prop_collector_factories(), cfd_->GetID(),
           cfd_->GetName(), existing_snapshots_,
           earliest_write_conflict_snapshot_, output_compression_,
           cfd_->ioptions()->compression_opts,
           mutable_cf_options_.paranoid_file_checks, cfd_->internal_stats(),
-          Env::IO_HIGH, &table_properties_, 0 /* level */);
+          Env::IO_HIGH, &table_properties_, 0 /* level */, flush_base);
       info.table_properties = table_properties_;
       LogFlush(db_options_.info_log);
     }
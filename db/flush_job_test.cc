@@ -10,8 +10,8 @@
 #include "db/flush_job.h"
 #include "db/column_family.h"
 #include "db/version_set.h"
-#include "db/writebuffer.h"
 #include "rocksdb/cache.h"
+#include "rocksdb/write_buffer_manager.h"
 #include "util/file_reader_writer.h"
 #include "util/string_util.h"
 #include "util/testharness.h"
@@ -77,7 +77,7 @@ class FlushJobTest : public testing::Test {
   std::shared_ptr<Cache> table_cache_;
   WriteController write_controller_;
   DBOptions db_options_;
-  WriteBuffer write_buffer_;
+  WriteBufferManager write_buffer_;
   ColumnFamilyOptions cf_options_;
   std::unique_ptr<VersionSet> versions_;
   InstrumentedMutex mutex_;
@@ -64,7 +64,14 @@ ColumnFamilyData* FlushScheduler::TakeNextColumnFamily() {
 
 bool FlushScheduler::Empty() {
   auto rv = head_.load(std::memory_order_relaxed) == nullptr;
-  assert(rv == checking_set_.empty());
+#ifndef NDEBUG
+  {
+    // ScheduleFlush() may be running concurrently (unordered writes), in
+    // which case the checking set can briefly lead the list.
+    std::lock_guard<std::mutex> lock(checking_mutex_);
+    assert(rv || !checking_set_.empty());
+  }
+#endif  // NDEBUG
   return rv;
 }
 
@@ -21,7 +21,7 @@ class FlushScheduler {
   FlushScheduler() : head_(nullptr) {}
 
   // May be called from multiple threads at once, but not concurrent with
-  // any other method calls on this instance
+  // any other method calls on this instance, except Empty()
   void ScheduleFlush(ColumnFamilyData* cfd);
 
   // Removes and returns Ref()-ed column family. Client needs to Unref().
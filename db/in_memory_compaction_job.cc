@@ -0,0 +1,202 @@
+//  Copyright (c) 2011-present, Facebook, Inc.  All rights reserved.
+//  This source code is licensed under the BSD-style license found in the
+//  LICENSE file in the root directory of this source tree. An additional grant
+//  of patent rights can be found in the PATENTS file in the same directory.
+
+#ifndef ROCKSDB_LITE
+
+#include "db/in_memory_compaction_job.h"
+
+#ifndef __STDC_FORMAT_MACROS
+#define __STDC_FORMAT_MACROS
+#endif
+
+#include <inttypes.h>
+#include <algorithm>
+#include <memory>
+
+#include "db/column_family.h"
+#include "db/compaction_iterator.h"
+#include "db/job_context.h"
+#include "db/memtable.h"
+#include "db/memtable_list.h"
+#include "db/merge_helper.h"
+#include "db/range_del_aggregator.h"
+#include "rocksdb/memtablerep.h"
+#include "rocksdb/options.h"
+#include "table/internal_iterator.h"
+#include "table/merger.h"
+#include "table/scoped_arena_iterator.h"
+#include "util/arena.h"
+#include "util/instrumented_mutex.h"
+#include "util/log_buffer.h"
+#include "util/sync_point.h"
+
+namespace rocksdb {
+
+InMemoryCompactionJob::InMemoryCompactionJob(
+    ColumnFamilyData* cfd, const DBOptions& db_options,
+    const MutableCFOptions& mutable_cf_options, InstrumentedMutex* db_mutex,
+    std::vector<SequenceNumber> existing_snapshots,
+    SequenceNumber earliest_write_conflict_snapshot, JobContext* job_context,
+    LogBuffer* log_buffer)
+    : cfd_(cfd),
+      db_options_(db_options),
+      mutable_cf_options_(mutable_cf_options),
+      db_mutex_(db_mutex),
+      existing_snapshots_(std::move(existing_snapshots)),
+      earliest_write_conflict_snapshot_(earliest_write_conflict_snapshot),
+      job_context_(job_context),
+      log_buffer_(log_buffer) {}
+
+Status InMemoryCompactionJob::Run() {
+  db_mutex_->AssertHeld();
+  autovector<MemTable*> mems;
+  cfd_->imm()->PickMemtablesForInMemoryCompaction(&mems);
+  assert(!mems.empty());
+
+  uint64_t input_entries = 0;
+  size_t input_memory_usage = 0;
+  for (MemTable* m : mems) {
+    input_entries += m->num_entries();
+    input_memory_usage += m->ApproximateMemoryUsage();
+  }
+
+  MemTable* result = nullptr;
+  Status s;
+  {
+    db_mutex_->Unlock();
+    s = MergeMemTables(mems, &result);
+    TEST_SYNC_POINT("InMemoryCompactionJob::Run:Merged");
+    db_mutex_->Lock();
+  }
+
+  if (s.ok() && cfd_->IsDropped()) {
+    s = Status::ShutdownInProgress("Column family drop during in-memory "
+                                   "compaction");
+  }
+  if (!s.ok()) {
+    delete result;
+    result = nullptr;
+  } else {
+    // The memtable list takes over this reference
+    result->Ref();
+  }
+  cfd_->imm()->InstallInMemoryCompactionResult(
+      mems, result, &job_context_->memtables_to_free);
+
+  if (s.ok()) {
+    LogToBuffer(log_buffer_,
+                "[%s] [JOB %d] In-memory compaction of %" ROCKSDB_PRIszt
+                " memtables: %" PRIu64 " entries, %" ROCKSDB_PRIszt
+                " bytes -> %" PRIu64 " entries, %" ROCKSDB_PRIszt " bytes",
+                cfd_->GetName().c_str(), job_context_->job_id, mems.size(),
+                input_entries, input_memory_usage, result->num_entries(),
+                result->ApproximateMemoryUsage());
+  } else {
+    LogToBuffer(log_buffer_, "[%s] [JOB %d] In-memory compaction failed: %s",
+                cfd_->GetName().c_str(), job_context_->job_id,
+                s.ToString().c_str());
+  }
+  return s;
+}
+
+Status InMemoryCompactionJob::MergeMemTables(
+    const autovector<MemTable*>& mems, MemTable** result) {
+  const InternalKeyComparator& icmp = cfd_->internal_comparator();
+  std::vector<InternalIterator*> memtables;
+  std::vector<InternalIterator*> range_del_iters;
+  ReadOptions ro;
+  ro.total_order_seek = true;
+  Arena arena;
+  uint64_t total_num_entries = 0;
+  SequenceNumber first_seqno = kMaxSequenceNumber;
+  for (MemTable* m : mems) {
+    memtables.push_back(m->NewIterator(ro, &arena));
+    auto* range_del_iter = m->NewRangeTombstoneIterator(ro);
+    if (range_del_iter != nullptr) {
+      range_del_iters.push_back(range_del_iter);
+    }
+    total_num_entries += m->num_entries();
+    if (!m->IsEmpty()) {
+      first_seqno = std::min(first_seqno, m->GetFirstSequenceNumber());
+    }
+  }
+
+  // The entries are added in key order and the memtable is read-only
+  // afterwards, so a sorted vector holds them more compactly than the
+  // default memtable rep
+  VectorRepFactory factory(static_cast<size_t>(total_num_entries));
+  std::unique_ptr<MemTable> merged(cfd_->ConstructNewMemtable(
+      mutable_cf_options_, mems.front()->GetEarliestSequenceNumber(),
+      &factory));
+  if (first_seqno != kMaxSequenceNumber) {
+    merged->SetFirstSequenceNumber(first_seqno);
+  }
+
+  RangeDelAggregator range_del_agg(icmp, existing_snapshots_);
+  Status s = range_del_agg.AddTombstones(
+      std::unique_ptr<InternalIterator>(NewMergingIterator(
+          &icmp, range_del_iters.empty() ? nullptr : &range_del_iters[0],
+          static_cast<int>(range_del_iters.size()))));
+  if (!s.ok()) {
+    return s;
+  }
+
+  {
+    ScopedArenaIterator iter(NewMergingIterator(
+        &icmp, &memtables[0], static_cast<int>(memtables.size()), &arena));
+    iter->SeekToFirst();
+    const ImmutableCFOptions& ioptions = *cfd_->ioptions();
+    MergeHelper merge(db_options_.env, icmp.user_comparator(),
+                      ioptions.merge_operator, nullptr, ioptions.info_log,
+                      ioptions.min_partial_merge_operands,
+                      true /* internal key corruption is not ok */,
+                      existing_snapshots_.empty() ? 0
+                                                  : existing_snapshots_.back());
+    // Older entries of the keys may still be in other memtables or in the
+    // files, so no deletion can be dropped
+    CompactionIterator c_iter(
+        iter.get(), icmp.user_comparator(), &merge, kMaxSequenceNumber,
+        &existing_snapshots_, earliest_write_conflict_snapshot_,
+        db_options_.env, true /* internal key corruption is not ok */,
+        nullptr /* compaction */, nullptr /* compaction_filter */,
+        nullptr /* log_buffer */, &range_del_agg, nullptr /* flush_base */);
+    c_iter.SeekToFirst();
+    for (; c_iter.Valid(); c_iter.Next()) {
+      const ParsedInternalKey& ikey = c_iter.ikey();
+      merged->Add(ikey.sequence, ikey.type, ikey.user_key, c_iter.value());
+    }
+    s = c_iter.status();
+  }
+  if (!s.ok()) {
+    return s;
+  }
+
+  // The entries covered by the range deletions were dropped above, but the
+  // range deletions still cover older entries of the keys
+  for (MemTable* m : mems) {
+    std::unique_ptr<InternalIterator> range_del_iter(
+        m->NewRangeTombstoneIterator(ro));
+    if (range_del_iter == nullptr) {
+      continue;
+    }
+    for (range_del_iter->SeekToFirst(); range_del_iter->Valid();
+         range_del_iter->Next()) {
+      ParsedInternalKey ikey;
+      if (!ParseInternalKey(range_del_iter->key(), &ikey)) {
+        return Status::Corruption("Bad range deletion in memtable");
+      }
+      merged->Add(ikey.sequence, kTypeRangeDeletion, ikey.user_key,
+                  range_del_iter->value());
+    }
+  }
+
+  merged->SetNextLogNumber(mems.back()->GetNextLogNumber());
+  *result = merged.release();
+  return s;
+}
+
+}  // namespace rocksdb
+
+#endif  // ROCKSDB_LITE
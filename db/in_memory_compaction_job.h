@@ -0,0 +1,61 @@
+//  Copyright (c) 2011-present, Facebook, Inc.  All rights reserved.
+//  This source code is licensed under the BSD-style license found in the
+//  LICENSE file in the root directory of this source tree. An additional grant
+//  of patent rights can be found in the PATENTS file in the same directory.
+#pragma once
+
+#ifndef ROCKSDB_LITE
+
+#include <vector>
+
+#include "db/dbformat.h"
+#include "rocksdb/status.h"
+#include "util/autovector.h"
+
+namespace rocksdb {
+
+class ColumnFamilyData;
+class InstrumentedMutex;
+class LogBuffer;
+class MemTable;
+struct DBOptions;
+struct JobContext;
+struct MutableCFOptions;
+
+// An InMemoryCompactionJob merges the immutable memtables of a column family
+// that wait for a flush into a single memtable, backed by a sorted vector,
+// and replaces them by it. Like a flush, it drops the entries that are
+// hidden by newer entries of the same key in all snapshots, so a workload
+// that overwrites its keys keeps less data in memory and writes less to
+// level 0. Used when ColumnFamilyOptions::in_memory_compaction is set.
+class InMemoryCompactionJob {
+ public:
+  // IMPORTANT: mutable_cf_options needs to be alive while the job is alive
+  InMemoryCompactionJob(ColumnFamilyData* cfd, const DBOptions& db_options,
+                        const MutableCFOptions& mutable_cf_options,
+                        InstrumentedMutex* db_mutex,
+                        std::vector<SequenceNumber> existing_snapshots,
+                        SequenceNumber earliest_write_conflict_snapshot,
+                        JobContext* job_context, LogBuffer* log_buffer);
+
+  // REQUIRES: db_mutex held, cfd->imm()->IsInMemoryCompactionPending()
+  // Releases and re-acquires db_mutex while merging the memtables.
+  Status Run();
+
+ private:
+  // Returns the memtable that holds the merged entries of mems
+  Status MergeMemTables(const autovector<MemTable*>& mems, MemTable** result);
+
+  ColumnFamilyData* cfd_;
+  const DBOptions& db_options_;
+  const MutableCFOptions& mutable_cf_options_;
+  InstrumentedMutex* db_mutex_;
+  std::vector<SequenceNumber> existing_snapshots_;
+  SequenceNumber earliest_write_conflict_snapshot_;
+  JobContext* job_context_;
+  LogBuffer* log_buffer_;
+};
+
+}  // namespace rocksdb
+
+#endif  // ROCKSDB_LITE
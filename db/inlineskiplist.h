@@ -20,7 +20,8 @@
 //
 // Thread safety -------------
 //
-// Writes via Insert require external synchronization, most likely a mutex.
+// Writes via Insert and InsertWithHint require external synchronization,
+// most likely a mutex.
 // InsertConcurrently can be safely called concurrently with reads and
 // with other concurrent inserts.  Reads require a guarantee that the
 // InlineSkipList will not be destroyed while the read is in progress.
@@ -55,6 +56,7 @@ template <class Comparator>
 class InlineSkipList {
  private:
   struct Node;
+  struct Splice;
 
  public:
   // Create a new InlineSkipList object that will use "cmp" for comparing
@@ -77,6 +79,18 @@ class InlineSkipList {
   // REQUIRES: no concurrent calls to INSERT
   void Insert(const char* key);
 
+  // Like Insert, but starts the search from a splice, the predecessors and
+  // successors at every level of an earlier insert, instead of from the
+  // head. The splice is kept in *hint, which must be nullptr for the first
+  // call, and is updated to bracket key. The levels of the splice that still
+  // bracket key are reused, so a series of inserts of nearby keys through
+  // the same hint only compares a few keys at the lowest levels. A hint
+  // lives as long as the allocator and must only be used with this list.
+  //
+  // REQUIRES: nothing that compares equal to key is currently in the list.
+  // REQUIRES: no concurrent calls to INSERT
+  void InsertWithHint(const char* key, void** hint);
+
   // Like Insert, but external synchronization is not required.
   void InsertConcurrently(const char* key);
 
@@ -194,6 +208,14 @@ class InlineSkipList {
   void FindLevelSplice(const char* key, Node* before, Node* after, int level,
                        Node** out_prev, Node** out_next);
 
+  // Allocates an empty splice from the allocator
+  Splice* AllocateSplice();
+
+  // Recomputes levels [0, recompute_level) of the splice for key, from the
+  // bracket of level recompute_level down
+  void RecomputeSpliceLevels(const char* key, Splice* splice,
+                             int recompute_level);
+
   // No copying allowed
   InlineSkipList(const InlineSkipList&);
   InlineSkipList& operator=(const InlineSkipList&);
@@ -264,6 +286,20 @@ struct InlineSkipList<Comparator>::Node {
   std::atomic<Node*> next_[1];
 };
 
+// A Splice brackets a key at every level: prev_[i] is a node before the key,
+// or head_, and next_[i] a node after it, or nullptr. The brackets narrow
+// down the levels, prev_[i + 1] <= prev_[i] and next_[i] <= next_[i + 1],
+// so a key bracketed at one level is bracketed at all the levels above.
+// prev_[i]->Next(i) == next_[i] held when the splice was computed, but
+// later inserts may have put nodes in between. prev_[height_] == head_ and
+// next_[height_] == nullptr; a height_ of 0 means the splice is unset.
+template <class Comparator>
+struct InlineSkipList<Comparator>::Splice {
+  int height_;
+  Node** prev_;
+  Node** next_;
+};
+
 template <class Comparator>
 inline InlineSkipList<Comparator>::Iterator::Iterator(
     const InlineSkipList* list) {
@@ -589,6 +625,122 @@ void InlineSkipList<Comparator>::FindLevelSplice(const char* key, Node* before,
   }
 }
 
+template <class Comparator>
+typename InlineSkipList<Comparator>::Splice*
+InlineSkipList<Comparator>::AllocateSplice() {
+  // prev_ and next_ have an entry for each level, plus the top sentinel
+  size_t array_size = sizeof(Node*) * (kMaxHeight_ + 1);
+  char* raw = allocator_->AllocateAligned(sizeof(Splice) + array_size * 2);
+  Splice* splice = reinterpret_cast<Splice*>(raw);
+  splice->height_ = 0;
+  splice->prev_ = reinterpret_cast<Node**>(raw + sizeof(Splice));
+  splice->next_ = reinterpret_cast<Node**>(raw + sizeof(Splice) + array_size);
+  return splice;
+}
+
+template <class Comparator>
+void InlineSkipList<Comparator>::RecomputeSpliceLevels(const char* key,
+                                                       Splice* splice,
+                                                       int recompute_level) {
+  assert(recompute_level > 0);
+  assert(recompute_level <= splice->height_);
+  for (int i = recompute_level - 1; i >= 0; --i) {
+    FindLevelSplice(key, splice->prev_[i + 1], splice->next_[i + 1], i,
+                    &splice->prev_[i], &splice->next_[i]);
+  }
+}
+
+template <class Comparator>
+void InlineSkipList<Comparator>::InsertWithHint(const char* key,
+                                                void** hint) {
+  assert(hint != nullptr);
+  Splice* splice = reinterpret_cast<Splice*>(*hint);
+  if (splice == nullptr) {
+    splice = AllocateSplice();
+    *hint = reinterpret_cast<void*>(splice);
+  }
+
+  Node* x = reinterpret_cast<Node*>(const_cast<char*>(key)) - 1;
+  int height = x->UnstashHeight();
+  assert(height >= 1 && height <= kMaxHeight_);
+
+  // The node may land between prev_[height - 1] and prev_[0] of the
+  // sequential-insertion cache of Insert, see InsertConcurrently
+  if (height > 1 && prev_height_.load(std::memory_order_relaxed) != 0) {
+    prev_height_.store(0, std::memory_order_relaxed);
+  }
+
+  int max_height = GetMaxHeight();
+  if (height > max_height) {
+    // See Insert for why this needs no synchronization with readers
+    max_height = height;
+    max_height_.store(height, std::memory_order_relaxed);
+  }
+
+  // Find the lowest level from which the splice brackets key, levels
+  // [0, recompute_height) are searched again
+  int recompute_height = 0;
+  if (splice->height_ < max_height) {
+    // The splice is unset, or the list grew taller since it was computed
+    splice->prev_[max_height] = head_;
+    splice->next_[max_height] = nullptr;
+    splice->height_ = max_height;
+    recompute_height = max_height;
+  } else {
+    while (recompute_height < max_height) {
+      Node* prev = splice->prev_[recompute_height];
+      Node* next = splice->next_[recompute_height];
+      if (prev->Next(recompute_height) != next) {
+        // Other inserts went in between; a level further up is likely to
+        // still be tight
+        ++recompute_height;
+      } else if (prev != head_ && !KeyIsAfterNode(key, prev)) {
+        // The key is before the splice. Skip the levels with the same
+        // node without comparing again.
+        while (recompute_height < max_height &&
+               splice->prev_[recompute_height] == prev) {
+          ++recompute_height;
+        }
+      } else if (KeyIsAfterNode(key, next)) {
+        // The key is after the splice
+        while (recompute_height < max_height &&
+               splice->next_[recompute_height] == next) {
+          ++recompute_height;
+        }
+      } else {
+        // This level, and with it all the ones above, brackets key
+        break;
+      }
+    }
+  }
+  assert(recompute_height <= max_height);
+  if (recompute_height > 0) {
+    RecomputeSpliceLevels(key, splice, recompute_height);
+  }
+
+  for (int i = 0; i < height; ++i) {
+    if (i >= recompute_height &&
+        splice->prev_[i]->Next(i) != splice->next_[i]) {
+      // The level brackets key, but is not tight
+      FindLevelSplice(key, splice->prev_[i], nullptr, i, &splice->prev_[i],
+                      &splice->next_[i]);
+    }
+    assert(splice->next_[i] == nullptr ||
+           compare_(key, splice->next_[i]->Key()) < 0);
+    assert(splice->prev_[i] == head_ ||
+           compare_(splice->prev_[i]->Key(), key) < 0);
+    assert(splice->prev_[i]->Next(i) == splice->next_[i]);
+    // NoBarrier_SetNext() suffices since we will add a barrier when
+    // we publish a pointer to "x" in prev[i].
+    x->NoBarrier_SetNext(i, splice->next_[i]);
+    splice->prev_[i]->SetNext(i, x);
+  }
+  // The splice now brackets the position right after key
+  for (int i = 0; i < height; ++i) {
+    splice->prev_[i] = x;
+  }
+}
+
 template <class Comparator>
 void InlineSkipList<Comparator>::InsertConcurrently(const char* key) {
   Node* x = reinterpret_cast<Node*>(const_cast<char*>(key)) - 1;
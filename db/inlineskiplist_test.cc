@@ -142,6 +142,85 @@ TEST_F(InlineSkipTest, InsertAndLookup) {
   }
 }
 
+// Counts the comparisons
+struct CountingComparator {
+  explicit CountingComparator(int* count) : count_(count) {}
+  int operator()(const char* a, const char* b) const {
+    ++*count_;
+    return TestComparator()(a, b);
+  }
+  int* count_;
+};
+
+TEST_F(InlineSkipTest, InsertWithHint) {
+  const int kNumStreams = 8;
+  const int kNumKeys = 4000;
+  Random rnd(301);
+  std::set<Key> keys;
+  Arena arena;
+  int num_compares = 0;
+  CountingComparator cmp(&num_compares);
+  InlineSkipList<CountingComparator> list(cmp, &arena);
+  void* hints[kNumStreams] = {};
+  Key next_key[kNumStreams] = {};
+
+  auto insert = [&](Key key, void** hint) {
+    if (keys.insert(key).second) {
+      char* buf = list.AllocateKey(sizeof(Key));
+      memcpy(buf, &key, sizeof(Key));
+      if (hint == nullptr) {
+        list.Insert(buf);
+      } else {
+        list.InsertWithHint(buf, hint);
+      }
+    }
+  };
+
+  // Interleaved increasing streams, with the odd key out of order and the
+  // odd plain insert in between, which the hints have to cope with
+  for (int i = 0; i < kNumKeys; i++) {
+    int stream = rnd.Uniform(kNumStreams);
+    Key key = (static_cast<Key>(stream) << 32) + next_key[stream];
+    next_key[stream] += 1 + rnd.Uniform(3);
+    if (rnd.OneIn(20)) {
+      key = (static_cast<Key>(rnd.Uniform(kNumStreams)) << 32) +
+            rnd.Uniform(kNumKeys);
+    }
+    insert(key, rnd.OneIn(10) ? nullptr : &hints[stream]);
+  }
+
+  InlineSkipList<CountingComparator>::Iterator iter(&list);
+  iter.SeekToFirst();
+  for (Key key : keys) {
+    ASSERT_TRUE(iter.Valid());
+    ASSERT_EQ(key, Decode(iter.key()));
+    iter.Next();
+  }
+  ASSERT_TRUE(!iter.Valid());
+  for (Key key : keys) {
+    ASSERT_TRUE(list.Contains(Encode(&key)));
+  }
+
+  // Appending to a stream through its hint only compares with the
+  // neighbours of the previous key, while a search from the head compares
+  // with a node or two per level
+  auto append = [&](bool use_hint) {
+    for (int stream = 0; stream < kNumStreams; stream++) {
+      next_key[stream] += kNumKeys;
+    }
+    num_compares = 0;
+    for (int i = 0; i < kNumKeys; i++) {
+      int stream = i % kNumStreams;
+      insert((static_cast<Key>(stream) << 32) + next_key[stream]++,
+             use_hint ? &hints[stream] : nullptr);
+    }
+    return num_compares;
+  };
+  int hint_compares = append(true);
+  int plain_compares = append(false);
+  ASSERT_LT(hint_compares * 2, plain_compares);
+}
+
 // We want to make sure that with a single writer and multiple
 // concurrent readers (with no synchronization other than when a
 // reader's iterator is created), the reader always observes all the
@@ -145,6 +145,11 @@ static const std::string aggregated_table_properties_at_level =
     aggregated_table_properties + "-at-level";
 static const std::string num_running_compactions = "num-running-compactions";
 static const std::string num_running_flushes = "num-running-flushes";
+static const std::string actual_delayed_write_rate =
+    "actual-delayed-write-rate";
+static const std::string is_write_stopped = "is-write-stopped";
+static const std::string estimate_compaction_throughput =
+    "estimate-compaction-throughput";
 
 const std::string DB::Properties::kNumFilesAtLevelPrefix =
                       rocksdb_prefix + num_files_at_level_prefix;
@@ -202,6 +207,12 @@ const std::string DB::Properties::kTotalSstFilesSize =
 const std::string DB::Properties::kBaseLevel = rocksdb_prefix + base_level;
 const std::string DB::Properties::kEstimatePendingCompactionBytes =
     rocksdb_prefix + estimate_pending_comp_bytes;
+const std::string DB::Properties::kActualDelayedWriteRate =
+    rocksdb_prefix + actual_delayed_write_rate;
+const std::string DB::Properties::kIsWriteStopped =
+    rocksdb_prefix + is_write_stopped;
+const std::string DB::Properties::kEstimateCompactionThroughput =
+    rocksdb_prefix + estimate_compaction_throughput;
 const std::string DB::Properties::kAggregatedTableProperties =
     rocksdb_prefix + aggregated_table_properties;
 const std::string DB::Properties::kAggregatedTablePropertiesAtLevel =
@@ -272,6 +283,12 @@ const std::unordered_map<std::string,
      {false, nullptr, &InternalStats::HandleNumRunningFlushes}},
     {DB::Properties::kNumRunningCompactions,
      {false, nullptr, &InternalStats::HandleNumRunningCompactions}},
+    {DB::Properties::kActualDelayedWriteRate,
+     {false, nullptr, &InternalStats::HandleActualDelayedWriteRate}},
+    {DB::Properties::kIsWriteStopped,
+     {false, nullptr, &InternalStats::HandleIsWriteStopped}},
+    {DB::Properties::kEstimateCompactionThroughput,
+     {false, nullptr, &InternalStats::HandleEstimateCompactionThroughput}},
 };
 
 const DBPropertyInfo* GetPropertyInfo(const Slice& property) {
@@ -558,6 +575,26 @@ bool InternalStats::HandleEstimatePendingCompactionBytes(uint64_t* value,
   return true;
 }
 
+bool InternalStats::HandleActualDelayedWriteRate(uint64_t* value, DBImpl* db,
+                                                 Version* version) {
+  const WriteController& wc = db->write_controller_;
+  *value = wc.NeedsDelay() ? wc.delayed_write_rate() : 0;
+  return true;
+}
+
+bool InternalStats::HandleIsWriteStopped(uint64_t* value, DBImpl* db,
+                                         Version* version) {
+  *value = db->write_controller_.IsStopped() ? 1 : 0;
+  return true;
+}
+
+bool InternalStats::HandleEstimateCompactionThroughput(uint64_t* value,
+                                                       DBImpl* db,
+                                                       Version* version) {
+  *value = db->write_controller_.compaction_throughput();
+  return true;
+}
+
 bool InternalStats::HandleEstimateTableReadersMem(uint64_t* value, DBImpl* db,
                                                   Version* version) {
   *value = (version == nullptr) ? 0 : version->GetMemoryUsageByTableReaders();
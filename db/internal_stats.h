@@ -336,6 +336,11 @@ class InternalStats {
   bool HandleTotalSstFilesSize(uint64_t* value, DBImpl* db, Version* version);
   bool HandleEstimatePendingCompactionBytes(uint64_t* value, DBImpl* db,
                                             Version* version);
+  bool HandleActualDelayedWriteRate(uint64_t* value, DBImpl* db,
+                                    Version* version);
+  bool HandleIsWriteStopped(uint64_t* value, DBImpl* db, Version* version);
+  bool HandleEstimateCompactionThroughput(uint64_t* value, DBImpl* db,
+                                          Version* version);
   bool HandleEstimateTableReadersMem(uint64_t* value, DBImpl* db,
                                      Version* version);
   bool HandleEstimateLiveDataSize(uint64_t* value, DBImpl* db,
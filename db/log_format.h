@@ -29,8 +29,13 @@ enum RecordType {
   kRecyclableFirstType = 6,
   kRecyclableMiddleType = 7,
   kRecyclableLastType = 8,
+
+  // Precedes the first compressed record of a log file, and holds the
+  // compression type of the records after it (1 byte)
+  kSetCompressionType = 9,
+  kRecyclableSetCompressionType = 10,
 };
-static const int kMaxRecordType = kRecyclableLastType;
+static const int kMaxRecordType = kRecyclableSetCompressionType;
 
 static const unsigned int kBlockSize = 32768;
 
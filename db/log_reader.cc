@@ -12,6 +12,7 @@
 #include <stdio.h>
 #include "rocksdb/env.h"
 #include "util/coding.h"
+#include "util/compression.h"
 #include "util/crc32c.h"
 #include "util/file_reader_writer.h"
 
@@ -106,6 +107,10 @@ bool Reader::ReadRecord(Slice* record, std::string* scratch,
         prospective_record_offset = physical_record_offset;
         scratch->clear();
         *record = fragment;
+        if (!UncompressRecord(record)) {
+          in_fragmented_record = false;
+          break;
+        }
         last_record_offset_ = prospective_record_offset;
         return true;
 
@@ -141,11 +146,26 @@ bool Reader::ReadRecord(Slice* record, std::string* scratch,
         } else {
           scratch->append(fragment.data(), fragment.size());
           *record = Slice(*scratch);
+          if (!UncompressRecord(record)) {
+            in_fragmented_record = false;
+            scratch->clear();
+            break;
+          }
           last_record_offset_ = prospective_record_offset;
           return true;
         }
         break;
 
+      case kSetCompressionType:
+      case kRecyclableSetCompressionType:
+        if (in_fragmented_record) {
+          ReportCorruption(scratch->size(), "partial record without end(3)");
+          in_fragmented_record = false;
+          scratch->clear();
+        }
+        InitCompression(fragment);
+        break;
+
       case kBadHeader:
         if (wal_recovery_mode == WALRecoveryMode::kAbsoluteConsistency) {
           // in clean shutdown we don't expect any error in the log files
@@ -206,6 +226,39 @@ bool Reader::ReadRecord(Slice* record, std::string* scratch,
   return false;
 }
 
+void Reader::InitCompression(const Slice& payload) {
+  if (uncompress_) {
+    ReportCorruption(payload.size(), "duplicate compression type record");
+    return;
+  }
+  if (payload.size() != 1) {
+    ReportCorruption(payload.size(), "bad compression type record");
+    return;
+  }
+  CompressionType compression_type = static_cast<CompressionType>(payload[0]);
+  uncompress_.reset(StreamingUncompress::Create(compression_type));
+  if (!uncompress_) {
+    // The records after it will be reported as corrupted when they can not
+    // be decompressed
+    ReportDrop(payload.size(),
+               Status::NotSupported("Unsupported log compression type",
+                                    CompressionTypeToString(compression_type)));
+  }
+}
+
+bool Reader::UncompressRecord(Slice* record) {
+  if (!uncompress_) {
+    return true;
+  }
+  uncompressed_record_.clear();
+  if (!uncompress_->Uncompress(*record, &uncompressed_record_)) {
+    ReportCorruption(record->size(), "failed to uncompress record");
+    return false;
+  }
+  *record = Slice(uncompressed_record_);
+  return true;
+}
+
 uint64_t Reader::LastRecordOffset() {
   return last_record_offset_;
 }
@@ -336,7 +389,8 @@ unsigned int Reader::ReadPhysicalRecord(Slice* result, size_t* drop_size) {
     const unsigned int type = header[6];
     const uint32_t length = a | (b << 8);
     int header_size = kHeaderSize;
-    if (type >= kRecyclableFullType && type <= kRecyclableLastType) {
+    if ((type >= kRecyclableFullType && type <= kRecyclableLastType) ||
+        type == kRecyclableSetCompressionType) {
       header_size = kRecyclableHeaderSize;
       // We need enough for the larger header
       if (buffer_.size() < (size_t)kRecyclableHeaderSize) {
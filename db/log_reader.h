@@ -10,6 +10,7 @@
 #pragma once
 #include <memory>
 #include <stdint.h>
+#include <string>
 
 #include "db/log_format.h"
 #include "rocksdb/slice.h"
@@ -19,6 +20,7 @@
 namespace rocksdb {
 
 class SequentialFileReader;
+class StreamingUncompress;
 class Logger;
 using std::unique_ptr;
 
@@ -52,7 +54,9 @@ class Reader {
   // If "checksum" is true, verify checksums if available.
   //
   // The Reader will start reading at the first record located at physical
-  // position >= initial_offset within the file.
+  // position >= initial_offset within the file.  Compressed records can only
+  // be read from the start of the file, so initial_offset must be 0 for
+  // logs written with a compression type.
   Reader(std::shared_ptr<Logger> info_log,
 	 unique_ptr<SequentialFileReader>&& file,
          Reporter* reporter, bool checksum, uint64_t initial_offset,
@@ -113,6 +117,11 @@ class Reader {
   // which log number this is
   uint64_t const log_number_;
 
+  // Set once the kSetCompressionType record has been read
+  unique_ptr<StreamingUncompress> uncompress_;
+  // Holds the decompressed form of the last record returned by ReadRecord
+  std::string uncompressed_record_;
+
   // Extend record types with the following special values
   enum {
     kEof = kMaxRecordType + 1,
@@ -139,6 +148,13 @@ class Reader {
   // Read some more
   bool ReadMore(size_t* drop_size, int *error);
 
+  // Handles a kSetCompressionType record. Handles reporting.
+  void InitCompression(const Slice& payload);
+
+  // Replaces *record by its decompressed form if the log is compressed.
+  // Returns false after reporting a corruption if it can not be decompressed.
+  bool UncompressRecord(Slice* record);
+
   // Reports dropped bytes to the reporter.
   // buffer_ must be updated to remove the dropped bytes prior to invocation.
   void ReportCorruption(size_t bytes, const char* reason);
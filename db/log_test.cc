@@ -11,6 +11,7 @@
 #include "db/log_writer.h"
 #include "rocksdb/env.h"
 #include "util/coding.h"
+#include "util/compression.h"
 #include "util/crc32c.h"
 #include "util/file_reader_writer.h"
 #include "util/random.h"
@@ -294,6 +295,39 @@ class LogTest : public ::testing::TestWithParam<int> {
     ASSERT_EQ((char)('a' + expected_record_offset), record.data()[0]);
   }
 
+  // Returns the contents of a new log file holding records compressed with
+  // compression_type
+  std::string WriteCompressedLog(const std::vector<std::string>& records,
+                                 CompressionType compression_type,
+                                 uint64_t log_number) {
+    Writer writer(unique_ptr<WritableFileWriter>(
+                      test::GetWritableFileWriter(new test::StringSink())),
+                  log_number, GetParam(), compression_type);
+    for (auto& record : records) {
+      EXPECT_OK(writer.AddRecord(Slice(record)));
+    }
+    auto dest =
+        dynamic_cast<test::StringSink*>(writer.file()->writable_file());
+    assert(dest);
+    return dest->contents_;
+  }
+
+  // Returns all the records that can be read from contents
+  std::vector<std::string> ReadLog(const std::string& contents,
+                                   uint64_t log_number) {
+    Slice source_contents(contents);
+    unique_ptr<SequentialFileReader> file_reader(
+        test::GetSequentialFileReader(new StringSource(source_contents)));
+    Reader reader(NULL, std::move(file_reader), &report_, true /*checksum*/,
+                  0 /*initial_offset*/, log_number);
+    std::vector<std::string> records;
+    std::string scratch;
+    Slice record;
+    while (reader.ReadRecord(&record, &scratch)) {
+      records.push_back(record.ToString());
+    }
+    return records;
+  }
 };
 
 size_t LogTest::initial_offset_record_sizes_[] =
@@ -690,6 +724,77 @@ TEST_P(LogTest, ClearEofError2) {
   ASSERT_EQ("OK", MatchError("read error"));
 }
 
+TEST_P(LogTest, CompressedReadWrite) {
+  if (!StreamingCompressionTypeSupported(kZlibCompression)) {
+    return;
+  }
+  Random rnd(301);
+  std::vector<std::string> records;
+  for (int i = 0; i < 1000; i++) {
+    records.push_back("{\"id\": " + NumberString(i) +
+                      " \"name\": \"" + RandomSkewedString(i, &rnd) + "\"}");
+  }
+  records.push_back("");
+  // Spans several blocks even after compression
+  records.push_back(test::RandomHumanReadableString(&rnd, 3 * kBlockSize));
+  records.push_back("end");
+
+  for (auto& record : records) {
+    Write(record);
+  }
+  std::string contents = WriteCompressedLog(records, kZlibCompression, 123);
+  ASSERT_LT(contents.size(), WrittenBytes());
+
+  ASSERT_EQ(records, ReadLog(contents, 123));
+  ASSERT_EQ(0U, DroppedBytes());
+}
+
+TEST_P(LogTest, CompressedRecycledLog) {
+  if (!GetParam() || !StreamingCompressionTypeSupported(kZlibCompression)) {
+    return;
+  }
+  std::vector<std::string> old_records;
+  for (int i = 0; i < 10000; i++) {
+    old_records.push_back(BigString(NumberString(i), 100));
+  }
+  std::string old_contents =
+      WriteCompressedLog(old_records, kZlibCompression, 123);
+
+  // Overwrite the head of the old log, as a recycled log file would be
+  std::vector<std::string> new_records = {"foo", "bar", BigString("baz", 500)};
+  std::string contents = WriteCompressedLog(new_records, kZlibCompression, 124);
+  ASSERT_LT(contents.size(), old_contents.size());
+  old_contents.replace(0, contents.size(), contents);
+
+  // The old records are never decompressed with the new stream; the bytes
+  // torn in the middle of an old record only fail their checksum
+  ASSERT_EQ(new_records, ReadLog(old_contents, 124));
+  ASSERT_NE("OK", MatchError("uncompress"));
+}
+
+TEST_P(LogTest, CompressedCorruptedRecord) {
+  if (!StreamingCompressionTypeSupported(kZlibCompression)) {
+    return;
+  }
+  std::vector<std::string> records = {BigString("foo", 100),
+                                      BigString("bar", 100)};
+  std::string contents = WriteCompressedLog(records, kZlibCompression, 123);
+  // Corrupt the payload of the first data record, after the compression type
+  // record, and fix up its checksum
+  const int header_size = GetParam() ? kRecyclableHeaderSize : kHeaderSize;
+  const int offset = header_size + 1;
+  contents[offset + header_size] ^= 0x5a;
+  const size_t length = static_cast<unsigned char>(contents[offset + 4]) |
+                        (static_cast<unsigned char>(contents[offset + 5]) << 8);
+  uint32_t crc =
+      crc32c::Value(&contents[offset + 6], header_size - 6 + length);
+  EncodeFixed32(&contents[offset], crc32c::Mask(crc));
+
+  ReadLog(contents, 123);
+  ASSERT_GT(DroppedBytes(), 0U);
+  ASSERT_EQ("OK", MatchError("failed to uncompress record"));
+}
+
 INSTANTIATE_TEST_CASE_P(bool, LogTest, ::testing::Values(0, 2));
 
 }  // namespace log
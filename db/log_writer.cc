@@ -12,6 +12,7 @@
 #include <stdint.h>
 #include "rocksdb/env.h"
 #include "util/coding.h"
+#include "util/compression.h"
 #include "util/crc32c.h"
 #include "util/file_reader_writer.h"
 
@@ -19,11 +20,13 @@ namespace rocksdb {
 namespace log {
 
 Writer::Writer(unique_ptr<WritableFileWriter>&& dest,
-               uint64_t log_number, bool recycle_log_files)
+               uint64_t log_number, bool recycle_log_files,
+               CompressionType compression_type)
     : dest_(std::move(dest)),
       block_offset_(0),
       log_number_(log_number),
-      recycle_log_files_(recycle_log_files) {
+      recycle_log_files_(recycle_log_files),
+      compression_type_(compression_type) {
   for (int i = 0; i <= kMaxRecordType; i++) {
     char t = static_cast<char>(i);
     type_crc_[i] = crc32c::Value(&t, 1);
@@ -37,6 +40,21 @@ Status Writer::AddRecord(const Slice& slice) {
   const char* ptr = slice.data();
   size_t left = slice.size();
 
+  if (compression_type_ != kNoCompression) {
+    if (!compress_) {
+      Status s = AddCompressionTypeRecord();
+      if (!s.ok()) {
+        return s;
+      }
+    }
+    compressed_buffer_.clear();
+    if (!compress_->Compress(slice, &compressed_buffer_)) {
+      return Status::Corruption("Failed to compress log record");
+    }
+    ptr = compressed_buffer_.data();
+    left = compressed_buffer_.size();
+  }
+
   // Header size varies depending on whether we are recycling or not.
   const int header_size =
       recycle_log_files_ ? kRecyclableHeaderSize : kHeaderSize;
@@ -87,6 +105,20 @@ Status Writer::AddRecord(const Slice& slice) {
   return s;
 }
 
+Status Writer::AddCompressionTypeRecord() {
+  assert(block_offset_ == 0);
+  compress_.reset(
+      StreamingCompress::Create(compression_type_, CompressionOptions()));
+  if (!compress_) {
+    return Status::NotSupported("Unsupported log compression type",
+                                CompressionTypeToString(compression_type_));
+  }
+  char type = static_cast<char>(compression_type_);
+  return EmitPhysicalRecord(
+      recycle_log_files_ ? kRecyclableSetCompressionType : kSetCompressionType,
+      &type, 1);
+}
+
 Status Writer::EmitPhysicalRecord(RecordType t, const char* ptr, size_t n) {
   assert(n <= 0xffff);  // Must fit in two bytes
 
@@ -99,7 +131,7 @@ Status Writer::EmitPhysicalRecord(RecordType t, const char* ptr, size_t n) {
   buf[6] = static_cast<char>(t);
 
   uint32_t crc = type_crc_[t];
-  if (t < kRecyclableFullType) {
+  if (t < kRecyclableFullType || t == kSetCompressionType) {
     // Legacy record format
     assert(block_offset_ + kHeaderSize + n <= kBlockSize);
     header_size = kHeaderSize;
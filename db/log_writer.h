@@ -11,13 +11,16 @@
 #include <stdint.h>
 
 #include <memory>
+#include <string>
 
 #include "db/log_format.h"
+#include "rocksdb/options.h"
 #include "rocksdb/slice.h"
 #include "rocksdb/status.h"
 
 namespace rocksdb {
 
+class StreamingCompress;
 class WritableFileWriter;
 
 using std::unique_ptr;
@@ -66,14 +69,24 @@ namespace log {
  * Same as above, with the addition of
  * Log number = 32bit log file number, so that we can distinguish between
  * records written by the most recent log writer vs a previous one.
+ *
+ * Compressed logs:
+ *
+ * If a compression type is given, the first record of the file is a
+ * kSetCompressionType (or kRecyclableSetCompressionType) record whose
+ * payload is the compression type.  Every record after it is compressed,
+ * as one stream for the whole file, before being fragmented as above.
  */
 class Writer {
  public:
   // Create a writer that will append data to "*dest".
   // "*dest" must be initially empty.
   // "*dest" must remain live while this Writer is in use.
+  // If compression_type is not kNoCompression, the records are compressed;
+  // it must be supported by StreamingCompress.
   explicit Writer(unique_ptr<WritableFileWriter>&& dest,
-                  uint64_t log_number, bool recycle_log_files);
+                  uint64_t log_number, bool recycle_log_files,
+                  CompressionType compression_type = kNoCompression);
   ~Writer();
 
   Status AddRecord(const Slice& slice);
@@ -86,6 +99,10 @@ class Writer {
   size_t block_offset_;       // Current offset in block
   uint64_t log_number_;
   bool recycle_log_files_;
+  CompressionType compression_type_;
+  unique_ptr<StreamingCompress> compress_;
+  // Output of compress_ for the record being added
+  std::string compressed_buffer_;
 
   // crc32c values for all supported record types.  These are
   // pre-computed to reduce the overhead of computing the crc of the
@@ -94,6 +111,9 @@ class Writer {
 
   Status EmitPhysicalRecord(RecordType type, const char* ptr, size_t length);
 
+  // Emits the kSetCompressionType record and sets up compress_
+  Status AddCompressionTypeRecord();
+
   // No copying allowed
   Writer(const Writer&);
   void operator=(const Writer&);
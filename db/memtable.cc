@@ -15,12 +15,13 @@
 
 #include "db/dbformat.h"
 #include "db/merge_context.h"
-#include "db/writebuffer.h"
+#include "db/range_del_aggregator.h"
 #include "rocksdb/comparator.h"
 #include "rocksdb/env.h"
 #include "rocksdb/iterator.h"
 #include "rocksdb/merge_operator.h"
 #include "rocksdb/slice_transform.h"
+#include "rocksdb/write_buffer_manager.h"
 #include "table/internal_iterator.h"
 #include "table/merger.h"
 #include "util/arena.h"
@@ -43,6 +44,7 @@ MemTableOptions::MemTableOptions(
         mutable_cf_options.memtable_prefix_bloom_probes),
     memtable_prefix_bloom_huge_page_tlb_size(
         mutable_cf_options.memtable_prefix_bloom_huge_page_tlb_size),
+    memtable_key_index_slots(mutable_cf_options.memtable_key_index_slots),
     inplace_update_support(ioptions.inplace_update_support),
     inplace_update_num_locks(mutable_cf_options.inplace_update_num_locks),
     inplace_callback(ioptions.inplace_callback),
@@ -55,22 +57,33 @@ MemTableOptions::MemTableOptions(
 MemTable::MemTable(const InternalKeyComparator& cmp,
                    const ImmutableCFOptions& ioptions,
                    const MutableCFOptions& mutable_cf_options,
-                   WriteBuffer* write_buffer, SequenceNumber earliest_seq)
+                   WriteBufferManager* write_buffer_manager,
+                   SequenceNumber earliest_seq,
+                   MemTableRepFactory* memtable_factory)
     : comparator_(cmp),
       moptions_(ioptions, mutable_cf_options),
       refs_(0),
       kArenaBlockSize(OptimizeBlockSize(moptions_.arena_block_size)),
-      arena_(moptions_.arena_block_size, 0),
-      allocator_(&arena_, write_buffer),
-      table_(ioptions.memtable_factory->CreateMemTableRep(
-          comparator_, &allocator_, ioptions.prefix_extractor,
+      arena_(moptions_.arena_block_size, 0,
+             ioptions.memtable_memory_allocator),
+      allocator_(&arena_, write_buffer_manager),
+      table_((memtable_factory != nullptr ? memtable_factory
+                                          : ioptions.memtable_factory)
+                 ->CreateMemTableRep(comparator_, &allocator_,
+                                     ioptions.prefix_extractor,
+                                     ioptions.info_log)),
+      range_del_table_(SkipListFactory().CreateMemTableRep(
+          comparator_, &allocator_, nullptr /* transform */,
           ioptions.info_log)),
+      is_range_del_table_empty_(true),
       data_size_(0),
       num_entries_(0),
       num_deletes_(0),
       flush_in_progress_(false),
       flush_completed_(false),
       file_number_(0),
+      in_memory_compaction_in_progress_(false),
+      compacted_in_memory_(false),
       first_seqno_(0),
       earliest_seqno_(earliest_seq),
       mem_next_logfile_number_(0),
@@ -78,6 +91,8 @@ MemTable::MemTable(const InternalKeyComparator& cmp,
                  ? moptions_.inplace_update_num_locks
                  : 0),
       prefix_extractor_(ioptions.prefix_extractor),
+      insert_with_hint_prefix_extractor_(
+          ioptions.memtable_insert_with_hint_prefix_extractor),
       flush_state_(FLUSH_NOT_REQUESTED),
       env_(ioptions.env) {
   UpdateFlushState();
@@ -92,13 +107,20 @@ MemTable::MemTable(const InternalKeyComparator& cmp,
         moptions_.memtable_prefix_bloom_huge_page_tlb_size,
         ioptions.info_log));
   }
+
+  if (moptions_.memtable_key_index_slots > 0) {
+    key_index_.reset(new MemTableKeyIndex(
+        &allocator_, moptions_.memtable_key_index_slots,
+        moptions_.memtable_prefix_bloom_huge_page_tlb_size, ioptions.info_log));
+  }
 }
 
 MemTable::~MemTable() { assert(refs_ == 0); }
 
 size_t MemTable::ApproximateMemoryUsage() {
   size_t arena_usage = arena_.ApproximateMemoryUsage();
-  size_t table_usage = table_->ApproximateMemoryUsage();
+  size_t table_usage = table_->ApproximateMemoryUsage() +
+                       range_del_table_->ApproximateMemoryUsage();
   // let MAX_USAGE =  std::numeric_limits<size_t>::max()
   // then if arena_usage + total_usage >= MAX_USAGE, return MAX_USAGE.
   // the following variation is to avoid numeric overflow.
@@ -120,8 +142,9 @@ bool MemTable::ShouldFlushNow() const {
 
   // If arena still have room for new block allocation, we can safely say it
   // shouldn't flush.
-  auto allocated_memory =
-      table_->ApproximateMemoryUsage() + arena_.MemoryAllocatedBytes();
+  auto allocated_memory = table_->ApproximateMemoryUsage() +
+                          range_del_table_->ApproximateMemoryUsage() +
+                          arena_.MemoryAllocatedBytes();
 
   // if we can still allocate one more block without exceeding the
   // over-allocation ratio, then we should not flush.
@@ -216,13 +239,16 @@ const char* EncodeKey(std::string* scratch, const Slice& target) {
 
 class MemTableIterator : public InternalIterator {
  public:
-  MemTableIterator(
-      const MemTable& mem, const ReadOptions& read_options, Arena* arena)
+  MemTableIterator(const MemTable& mem, const ReadOptions& read_options,
+                   Arena* arena, bool use_range_del_table = false)
       : bloom_(nullptr),
         prefix_extractor_(mem.prefix_extractor_),
         valid_(false),
         arena_mode_(arena != nullptr) {
-    if (prefix_extractor_ != nullptr && !read_options.total_order_seek) {
+    if (use_range_del_table) {
+      iter_ = mem.range_del_table_->GetIterator(arena);
+    } else if (prefix_extractor_ != nullptr &&
+               !read_options.total_order_seek) {
       bloom_ = mem.prefix_bloom_.get();
       iter_ = mem.table_->GetDynamicPrefixIterator(arena);
     } else {
@@ -319,6 +345,15 @@ InternalIterator* MemTable::NewIterator(const ReadOptions& read_options,
   return new (mem) MemTableIterator(*this, read_options, arena);
 }
 
+InternalIterator* MemTable::NewRangeTombstoneIterator(
+    const ReadOptions& read_options) {
+  if (is_range_del_table_empty_.load(std::memory_order_relaxed)) {
+    return nullptr;
+  }
+  return new MemTableIterator(*this, read_options, nullptr /* arena */,
+                              true /* use_range_del_table */);
+}
+
 port::RWMutex* MemTable::GetLock(const Slice& key) {
   static murmur_hash hash;
   return &locks_[hash(key) % locks_.size()];
@@ -359,7 +394,9 @@ void MemTable::Add(SequenceNumber s, ValueType type,
                                internal_key_size + VarintLength(val_size) +
                                val_size;
   char* buf = nullptr;
-  KeyHandle handle = table_->Allocate(encoded_len, &buf);
+  std::unique_ptr<MemTableRep>& table =
+      type == kTypeRangeDeletion ? range_del_table_ : table_;
+  KeyHandle handle = table->Allocate(encoded_len, &buf);
 
   char* p = EncodeVarint32(buf, internal_key_size);
   memcpy(p, key.data(), key_size);
@@ -371,7 +408,15 @@ void MemTable::Add(SequenceNumber s, ValueType type,
   memcpy(p, value.data(), val_size);
   assert((unsigned)(p + val_size - buf) == (unsigned)encoded_len);
   if (!allow_concurrent) {
-    table_->Insert(handle);
+    if (insert_with_hint_prefix_extractor_ != nullptr &&
+        type != kTypeRangeDeletion &&
+        insert_with_hint_prefix_extractor_->InDomain(key)) {
+      Slice prefix = insert_with_hint_prefix_extractor_->Transform(
+          Slice(buf + VarintLength(internal_key_size), key_size));
+      table->InsertWithHint(handle, &insert_hints_[prefix]);
+    } else {
+      table->Insert(handle);
+    }
 
     // this is a bit ugly, but is the way to avoid locked instructions
     // when incrementing an atomic
@@ -384,13 +429,18 @@ void MemTable::Add(SequenceNumber s, ValueType type,
                          std::memory_order_relaxed);
     }
 
-    if (prefix_bloom_) {
+    if (prefix_bloom_ && type != kTypeRangeDeletion) {
       assert(prefix_extractor_);
       prefix_bloom_->Add(prefix_extractor_->Transform(key));
     }
+    if (key_index_ && type != kTypeRangeDeletion) {
+      key_index_->Add(key, buf, false /* allow_concurrent */);
+    }
 
-    // The first sequence number inserted into the memtable
-    assert(first_seqno_ == 0 || s > first_seqno_);
+    // The first sequence number inserted into the memtable. It is only
+    // equal to s in a memtable built by an in-memory compaction, which
+    // knows it in advance.
+    assert(first_seqno_ == 0 || s >= first_seqno_);
     if (first_seqno_ == 0) {
       first_seqno_.store(s, std::memory_order_relaxed);
 
@@ -401,7 +451,7 @@ void MemTable::Add(SequenceNumber s, ValueType type,
       assert(first_seqno_.load() >= earliest_seqno_.load());
     }
   } else {
-    table_->InsertConcurrently(handle);
+    table->InsertConcurrently(handle);
 
     num_entries_.fetch_add(1, std::memory_order_relaxed);
     data_size_.fetch_add(encoded_len, std::memory_order_relaxed);
@@ -409,10 +459,13 @@ void MemTable::Add(SequenceNumber s, ValueType type,
       num_deletes_.fetch_add(1, std::memory_order_relaxed);
     }
 
-    if (prefix_bloom_) {
+    if (prefix_bloom_ && type != kTypeRangeDeletion) {
       assert(prefix_extractor_);
       prefix_bloom_->AddConcurrently(prefix_extractor_->Transform(key));
     }
+    if (key_index_ && type != kTypeRangeDeletion) {
+      key_index_->Add(key, buf, true /* allow_concurrent */);
+    }
 
     // atomically update first_seqno_ and earliest_seqno_.
     uint64_t cur_seq_num = first_seqno_.load(std::memory_order_relaxed);
@@ -426,6 +479,9 @@ void MemTable::Add(SequenceNumber s, ValueType type,
         !first_seqno_.compare_exchange_weak(cur_earliest_seqno, s)) {
     }
   }
+  if (type == kTypeRangeDeletion) {
+    is_range_del_table_empty_.store(false, std::memory_order_relaxed);
+  }
 
   UpdateFlushState();
 }
@@ -443,6 +499,7 @@ struct Saver {
   const MergeOperator* merge_operator;
   // the merge operations encountered;
   MergeContext* merge_context;
+  RangeDelAggregator* range_del_agg;
   MemTable* mem;
   Logger* logger;
   Statistics* statistics;
@@ -475,6 +532,11 @@ static bool SaveValue(void* arg, const char* entry) {
     const uint64_t tag = DecodeFixed64(key_ptr + key_length - 8);
     ValueType type;
     UnPackSequenceAndType(tag, &s->seq, &type);
+    if ((type == kTypeValue || type == kTypeMerge) &&
+        s->range_del_agg != nullptr &&
+        s->range_del_agg->ShouldDelete(Slice(key_ptr, key_length))) {
+      type = kTypeRangeDeletion;
+    }
 
     switch (type) {
       case kTypeValue: {
@@ -510,7 +572,8 @@ static bool SaveValue(void* arg, const char* entry) {
         return false;
       }
       case kTypeDeletion:
-      case kTypeSingleDeletion: {
+      case kTypeSingleDeletion:
+      case kTypeRangeDeletion: {
         if (*(s->merge_in_progress)) {
           assert(merge_operator != nullptr);
           *(s->status) = Status::OK();
@@ -562,7 +625,8 @@ static bool SaveValue(void* arg, const char* entry) {
 }
 
 bool MemTable::Get(const LookupKey& key, std::string* value, Status* s,
-                   MergeContext* merge_context, SequenceNumber* seq) {
+                   MergeContext* merge_context,
+                   RangeDelAggregator* range_del_agg, SequenceNumber* seq) {
   // The sequence number is updated synchronously in version_set.h
   if (IsEmpty()) {
     // Avoiding recording stats for speed.
@@ -570,6 +634,16 @@ bool MemTable::Get(const LookupKey& key, std::string* value, Status* s,
   }
   PERF_TIMER_GUARD(get_from_memtable_time);
 
+  if (range_del_agg != nullptr) {
+    std::unique_ptr<InternalIterator> range_del_iter(
+        NewRangeTombstoneIterator(ReadOptions()));
+    Status status = range_del_agg->AddTombstones(std::move(range_del_iter));
+    if (!status.ok()) {
+      *s = status;
+      return true;
+    }
+  }
+
   Slice user_key = key.user_key();
   bool found_final_value = false;
   bool merge_in_progress = s->IsMergeInProgress();
@@ -585,6 +659,7 @@ bool MemTable::Get(const LookupKey& key, std::string* value, Status* s,
     if (prefix_bloom_) {
       PERF_COUNTER_ADD(bloom_memtable_hit_count, 1);
     }
+    const char* entry = nullptr;
     Saver saver;
     saver.status = s;
     saver.found_final_value = &found_final_value;
@@ -594,12 +669,22 @@ bool MemTable::Get(const LookupKey& key, std::string* value, Status* s,
     saver.seq = kMaxSequenceNumber;
     saver.mem = this;
     saver.merge_context = merge_context;
+    saver.range_del_agg = range_del_agg;
     saver.merge_operator = moptions_.merge_operator;
     saver.logger = moptions_.info_log;
     saver.inplace_update_support = moptions_.inplace_update_support;
     saver.statistics = moptions_.statistics;
     saver.env_ = env_;
-    table_->Get(key, &saver, SaveValue);
+    switch (LookupKeyIndex(key, &entry)) {
+      case MemTableKeyIndex::kFound:
+        SaveValue(&saver, entry);
+        break;
+      case MemTableKeyIndex::kNotFound:
+        break;
+      case MemTableKeyIndex::kUnknown:
+        table_->Get(key, &saver, SaveValue);
+        break;
+    }
 
     *seq = saver.seq;
   }
@@ -612,9 +697,31 @@ bool MemTable::Get(const LookupKey& key, std::string* value, Status* s,
   return found_final_value;
 }
 
+MemTableKeyIndex::LookupResult MemTable::LookupKeyIndex(
+    const LookupKey& key, const char** entry) const {
+  if (key_index_ == nullptr) {
+    return MemTableKeyIndex::kUnknown;
+  }
+  MemTableKeyIndex::LookupResult result =
+      key_index_->Lookup(key.user_key(), entry);
+  if (result != MemTableKeyIndex::kFound) {
+    return result;
+  }
+  // The newest entry answers the lookup on its own unless the read can't see
+  // it or it is a merge operand, which needs the older entries
+  const Slice internal_key = GetLengthPrefixedSlice(*entry);
+  if (GetInternalKeySeqno(internal_key) >
+          GetInternalKeySeqno(key.internal_key()) ||
+      ExtractValueType(internal_key) == kTypeMerge) {
+    return MemTableKeyIndex::kUnknown;
+  }
+  return result;
+}
+
 void MemTable::Update(SequenceNumber seq,
                       const Slice& key,
-                      const Slice& value) {
+                      const Slice& value,
+                      bool allow_concurrent) {
   LookupKey lkey(key, seq);
   Slice mem_key = lkey.memtable_key();
 
@@ -650,9 +757,9 @@ void MemTable::Update(SequenceNumber seq,
 
           // Update value, if new value size  <= previous value size
           if (new_size <= prev_size ) {
+            WriteLock wl(GetLock(lkey.user_key()));
             char* p = EncodeVarint32(const_cast<char*>(key_ptr) + key_length,
                                      new_size);
-            WriteLock wl(GetLock(lkey.user_key()));
             memcpy(p, value.data(), value.size());
             assert((unsigned)((p + value.size()) - entry) ==
                    (unsigned)(VarintLength(key_length) + key_length +
@@ -663,14 +770,14 @@ void MemTable::Update(SequenceNumber seq,
         default:
           // If the latest value is kTypeDeletion, kTypeMerge or kTypeLogData
           // we don't have enough space for update inplace
-            Add(seq, kTypeValue, key, value);
+            Add(seq, kTypeValue, key, value, allow_concurrent);
             return;
       }
     }
   }
 
   // key doesn't exist
-  Add(seq, kTypeValue, key, value);
+  Add(seq, kTypeValue, key, value, allow_concurrent);
 }
 
 bool MemTable::UpdateCallback(SequenceNumber seq,
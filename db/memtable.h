@@ -13,6 +13,7 @@
 #include <functional>
 #include <memory>
 #include <string>
+#include <unordered_map>
 #include <vector>
 #include "db/dbformat.h"
 #include "db/skiplist.h"
@@ -22,8 +23,10 @@
 #include "rocksdb/memtablerep.h"
 #include "rocksdb/immutable_options.h"
 #include "db/memtable_allocator.h"
+#include "db/memtable_key_index.h"
 #include "util/concurrent_arena.h"
 #include "util/dynamic_bloom.h"
+#include "util/hash.h"
 #include "util/instrumented_mutex.h"
 #include "util/mutable_cf_options.h"
 
@@ -32,7 +35,8 @@ namespace rocksdb {
 class Mutex;
 class MemTableIterator;
 class MergeContext;
-class WriteBuffer;
+class RangeDelAggregator;
+class WriteBufferManager;
 class InternalIterator;
 
 struct MemTableOptions {
@@ -44,6 +48,7 @@ struct MemTableOptions {
   uint32_t memtable_prefix_bloom_bits;
   uint32_t memtable_prefix_bloom_probes;
   size_t memtable_prefix_bloom_huge_page_tlb_size;
+  uint32_t memtable_key_index_slots;
   bool inplace_update_support;
   size_t inplace_update_num_locks;
   UpdateStatus (*inplace_callback)(char* existing_value,
@@ -90,10 +95,15 @@ class MemTable {
   // If the earliest sequence number is not known, kMaxSequenceNumber may be
   // used, but this may prevent some transactions from succeeding until the
   // first key is inserted into the memtable.
+  //
+  // If memtable_factory is not null, it is used instead of
+  // ioptions.memtable_factory to create the memtable rep.
   explicit MemTable(const InternalKeyComparator& comparator,
                     const ImmutableCFOptions& ioptions,
                     const MutableCFOptions& mutable_cf_options,
-                    WriteBuffer* write_buffer, SequenceNumber earliest_seq);
+                    WriteBufferManager* write_buffer_manager,
+                    SequenceNumber earliest_seq,
+                    MemTableRepFactory* memtable_factory = nullptr);
 
   // Do not delete this MemTable unless Unref() indicates it not in use.
   ~MemTable();
@@ -138,6 +148,15 @@ class MemTable {
                                                 std::memory_order_relaxed);
   }
 
+  // Like MarkFlushScheduled(), for a memtable that does not need a flush yet.
+  // Returns true if the caller should be the one to schedule the flush.
+  bool MarkFlushScheduledEarly() {
+    auto before = FLUSH_NOT_REQUESTED;
+    return flush_state_.compare_exchange_strong(before, FLUSH_SCHEDULED,
+                                                std::memory_order_relaxed,
+                                                std::memory_order_relaxed);
+  }
+
   // Return an iterator that yields the contents of the memtable.
   //
   // The caller must ensure that the underlying MemTable remains live
@@ -152,9 +171,15 @@ class MemTable {
   //        those allocated in arena.
   InternalIterator* NewIterator(const ReadOptions& read_options, Arena* arena);
 
+  // Returns an iterator over the range deletions of the memtable, whose keys
+  // are the internal keys of the start keys and whose values are the end
+  // keys, or nullptr if there are none. The caller must delete it.
+  InternalIterator* NewRangeTombstoneIterator(const ReadOptions& read_options);
+
   // Add an entry into memtable that maps key to value at the
   // specified sequence number and with the specified type.
-  // Typically value will be empty if type==kTypeDeletion.
+  // Typically value will be empty if type==kTypeDeletion. For
+  // type==kTypeRangeDeletion, key is the start and value the end of the range.
   //
   // REQUIRES: if allow_concurrent = false, external synchronization to prevent
   // simultaneous operations on the same MemTable.
@@ -174,13 +199,16 @@ class MemTable {
   // returned).  Otherwise, *seq will be set to kMaxSequenceNumber.
   // On success, *s may be set to OK, NotFound, or MergeInProgress.  Any other
   // status returned indicates a corruption or other unexpected error.
+  // The range deletions of the memtable are added to range_del_agg, if it is
+  // not null, and the entries it deletes are treated as deletions.
   bool Get(const LookupKey& key, std::string* value, Status* s,
-           MergeContext* merge_context, SequenceNumber* seq);
+           MergeContext* merge_context, RangeDelAggregator* range_del_agg,
+           SequenceNumber* seq);
 
   bool Get(const LookupKey& key, std::string* value, Status* s,
-           MergeContext* merge_context) {
+           MergeContext* merge_context, RangeDelAggregator* range_del_agg) {
     SequenceNumber seq;
-    return Get(key, value, s, merge_context, &seq);
+    return Get(key, value, s, merge_context, range_del_agg, &seq);
   }
 
   // Attempts to update the new_value inplace, else does normal Add
@@ -191,11 +219,14 @@ class MemTable {
   //     else add(key, new_value)
   //   else add(key, new_value)
   //
-  // REQUIRES: external synchronization to prevent simultaneous
-  // operations on the same MemTable.
+  // REQUIRES: if allow_concurrent = false, external synchronization to prevent
+  // simultaneous operations on the same MemTable.  Otherwise, no other writer
+  // may update the same key concurrently; the in-place write itself is
+  // guarded by the key's lock (GetLock()) against concurrent readers.
   void Update(SequenceNumber seq,
               const Slice& key,
-              const Slice& value);
+              const Slice& value,
+              bool allow_concurrent = false);
 
   // If prev_value for key exists, attempts to update it inplace.
   // else returns false
@@ -248,6 +279,15 @@ class MemTable {
     return first_seqno_.load(std::memory_order_relaxed);
   }
 
+  // Sets the first sequence number of a memtable that an in-memory
+  // compaction builds from older memtables, before their entries are added
+  // in key order rather than in sequence number order.
+  // REQUIRES: the memtable is empty and not shared with other threads.
+  void SetFirstSequenceNumber(SequenceNumber seq) {
+    assert(IsEmpty());
+    first_seqno_.store(seq, std::memory_order_relaxed);
+  }
+
   // Returns the sequence number that is guaranteed to be smaller than or equal
   // to the sequence number of any key that could be inserted into this
   // memtable. It can then be assumed that any write with a larger(or equal)
@@ -317,6 +357,10 @@ class MemTable {
   ConcurrentArena arena_;
   MemTableAllocator allocator_;
   unique_ptr<MemTableRep> table_;
+  // The range deletions, always in a skip list since they are few and need
+  // to be iterated in order
+  unique_ptr<MemTableRep> range_del_table_;
+  std::atomic<bool> is_range_del_table_empty_;
 
   // Total data size of all data inserted
   std::atomic<uint64_t> data_size_;
@@ -328,6 +372,10 @@ class MemTable {
   bool flush_completed_;   // finished the flush
   uint64_t file_number_;    // filled up after flush is complete
 
+  // These are used to manage the in-memory compactions of immutable memtables
+  bool in_memory_compaction_in_progress_;
+  bool compacted_in_memory_;  // built by an in-memory compaction
+
   // The updates to be applied to the transaction log when this
   // memtable is flushed to storage.
   VersionEdit edit_;
@@ -347,6 +395,13 @@ class MemTable {
 
   const SliceTransform* const prefix_extractor_;
   std::unique_ptr<DynamicBloom> prefix_bloom_;
+  std::unique_ptr<MemTableKeyIndex> key_index_;
+
+  // The insert hints of table_ by the prefixes of
+  // memtable_insert_with_hint_prefix_extractor. The prefixes point into the
+  // copies of the keys in the arena.
+  const SliceTransform* const insert_with_hint_prefix_extractor_;
+  std::unordered_map<Slice, void*, SliceHasher> insert_hints_;
 
   std::atomic<FlushStateEnum> flush_state_;
 
@@ -358,6 +413,11 @@ class MemTable {
   // Updates flush_state_ using ShouldFlushNow()
   void UpdateFlushState();
 
+  // Looks key up in key_index_. Returns kFound only if *entry answers the
+  // lookup on its own, and kUnknown if the memtable rep has to be searched.
+  MemTableKeyIndex::LookupResult LookupKeyIndex(const LookupKey& key,
+                                                const char** entry) const;
+
   // No copying allowed
   MemTable(const MemTable&);
   MemTable& operator=(const MemTable&);
@@ -10,36 +10,47 @@
 #include "db/memtable_allocator.h"
 
 #include <assert.h>
-#include "db/writebuffer.h"
+#include "rocksdb/write_buffer_manager.h"
 #include "util/arena.h"
 
 namespace rocksdb {
 
 MemTableAllocator::MemTableAllocator(Allocator* allocator,
-                                     WriteBuffer* write_buffer)
-    : allocator_(allocator), write_buffer_(write_buffer), bytes_allocated_(0) {}
-
-MemTableAllocator::~MemTableAllocator() { DoneAllocating(); }
+                                     WriteBufferManager* write_buffer_manager)
+    : allocator_(allocator),
+      write_buffer_manager_(write_buffer_manager),
+      bytes_allocated_(0),
+      done_allocating_(false) {}
+
+MemTableAllocator::~MemTableAllocator() {
+  DoneAllocating();
+  if (write_buffer_manager_ != nullptr) {
+    write_buffer_manager_->FreeMem(
+        bytes_allocated_.load(std::memory_order_relaxed));
+    write_buffer_manager_ = nullptr;
+  }
+}
 
 char* MemTableAllocator::Allocate(size_t bytes) {
-  assert(write_buffer_ != nullptr);
+  assert(write_buffer_manager_ != nullptr);
   bytes_allocated_.fetch_add(bytes, std::memory_order_relaxed);
-  write_buffer_->ReserveMem(bytes);
+  write_buffer_manager_->ReserveMem(bytes);
   return allocator_->Allocate(bytes);
 }
 
 char* MemTableAllocator::AllocateAligned(size_t bytes, size_t huge_page_size,
                                          Logger* logger) {
-  assert(write_buffer_ != nullptr);
+  assert(write_buffer_manager_ != nullptr);
   bytes_allocated_.fetch_add(bytes, std::memory_order_relaxed);
-  write_buffer_->ReserveMem(bytes);
+  write_buffer_manager_->ReserveMem(bytes);
   return allocator_->AllocateAligned(bytes, huge_page_size, logger);
 }
 
 void MemTableAllocator::DoneAllocating() {
-  if (write_buffer_ != nullptr) {
-    write_buffer_->FreeMem(bytes_allocated_.load(std::memory_order_relaxed));
-    write_buffer_ = nullptr;
+  if (write_buffer_manager_ != nullptr && !done_allocating_) {
+    write_buffer_manager_->ScheduleFreeMem(
+        bytes_allocated_.load(std::memory_order_relaxed));
+    done_allocating_ = true;
   }
 }
 
@@ -8,7 +8,8 @@
 // found in the LICENSE file. See the AUTHORS file for names of contributors.
 //
 // This is used by the MemTable to allocate write buffer memory. It connects
-// to WriteBuffer so we can track and enforce overall write buffer limits.
+// to WriteBufferManager so we can track and enforce overall write buffer
+// limits.
 
 #pragma once
 
@@ -18,11 +19,12 @@
 namespace rocksdb {
 
 class Logger;
-class WriteBuffer;
+class WriteBufferManager;
 
 class MemTableAllocator : public Allocator {
  public:
-  explicit MemTableAllocator(Allocator* allocator, WriteBuffer* write_buffer);
+  explicit MemTableAllocator(Allocator* allocator,
+                             WriteBufferManager* write_buffer_manager);
   ~MemTableAllocator();
 
   // Allocator interface
@@ -32,13 +34,15 @@ class MemTableAllocator : public Allocator {
   size_t BlockSize() const override;
 
   // Call when we're finished allocating memory so we can free it from
-  // the write buffer's limit.
+  // the write buffer's limit. The memory stays charged to the write buffer
+  // manager (and its cache, if any) until the allocator is destroyed.
   void DoneAllocating();
 
  private:
   Allocator* allocator_;
-  WriteBuffer* write_buffer_;
+  WriteBufferManager* write_buffer_manager_;
   std::atomic<size_t> bytes_allocated_;
+  bool done_allocating_;
 
   // No copying allowed
   MemTableAllocator(const MemTableAllocator&);
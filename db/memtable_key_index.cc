@@ -0,0 +1,86 @@
+//  Copyright (c) 2011-present, Facebook, Inc.  All rights reserved.
+//  This source code is licensed under the BSD-style license found in the
+//  LICENSE file in the root directory of this source tree. An additional grant
+//  of patent rights can be found in the PATENTS file in the same directory.
+
+#include "db/memtable_key_index.h"
+
+#include <assert.h>
+#include <string.h>
+#include <new>
+
+#include "db/dbformat.h"
+#include "util/allocator.h"
+#include "util/coding.h"
+#include "util/hash.h"
+
+namespace rocksdb {
+
+MemTableKeyIndex::MemTableKeyIndex(Allocator* allocator, uint32_t num_slots,
+                                   size_t huge_page_tlb_size, Logger* logger)
+    : num_slots_(num_slots) {
+  assert(num_slots_ > 0);
+  size_t bytes = sizeof(std::atomic<const char*>) * num_slots_;
+  char* mem = allocator->AllocateAligned(bytes, huge_page_tlb_size, logger);
+  slots_ = new (mem) std::atomic<const char*>[num_slots_];
+  for (uint32_t i = 0; i < num_slots_; i++) {
+    slots_[i].store(nullptr, std::memory_order_relaxed);
+  }
+}
+
+void MemTableKeyIndex::Add(const Slice& user_key, const char* entry,
+                           bool allow_concurrent) {
+  const SequenceNumber seq =
+      GetInternalKeySeqno(GetLengthPrefixedSlice(entry));
+  uint32_t slot = GetSliceHash(user_key) % num_slots_;
+  for (uint32_t i = 0; i < kMaxProbes; i++) {
+    std::atomic<const char*>& s = slots_[slot];
+    const char* cur = s.load(std::memory_order_acquire);
+    while (true) {
+      if (cur != nullptr) {
+        Slice cur_key = GetLengthPrefixedSlice(cur);
+        if (ExtractUserKey(cur_key) != user_key) {
+          break;
+        }
+        if (GetInternalKeySeqno(cur_key) >= seq) {
+          // A newer entry of the key won the race
+          return;
+        }
+      }
+      if (!allow_concurrent) {
+        s.store(entry, std::memory_order_release);
+        return;
+      }
+      if (s.compare_exchange_weak(cur, entry, std::memory_order_release,
+                                  std::memory_order_acquire)) {
+        return;
+      }
+    }
+    if (++slot == num_slots_) {
+      slot = 0;
+    }
+  }
+  // The probe sequence is full of other keys, which it will stay, so the
+  // lookups of user_key will report kUnknown
+}
+
+MemTableKeyIndex::LookupResult MemTableKeyIndex::Lookup(
+    const Slice& user_key, const char** entry) const {
+  uint32_t slot = GetSliceHash(user_key) % num_slots_;
+  for (uint32_t i = 0; i < kMaxProbes; i++) {
+    const char* cur = slots_[slot].load(std::memory_order_acquire);
+    if (cur == nullptr) {
+      return kNotFound;
+    }
+    if (ExtractUserKey(GetLengthPrefixedSlice(cur)) == user_key) {
+      *entry = cur;
+      return kFound;
+    }
+    if (++slot == num_slots_) {
+      slot = 0;
+    }
+  }
+  return kUnknown;
+}
+
+}  // namespace rocksdb
@@ -0,0 +1,64 @@
+//  Copyright (c) 2011-present, Facebook, Inc.  All rights reserved.
+//  This source code is licensed under the BSD-style license found in the
+//  LICENSE file in the root directory of this source tree. An additional grant
+//  of patent rights can be found in the PATENTS file in the same directory.
+
+#pragma once
+
+#include <atomic>
+#include <stdint.h>
+
+#include "rocksdb/slice.h"
+
+namespace rocksdb {
+
+class Allocator;
+class Logger;
+
+// A MemTableKeyIndex maps each user key of a memtable to its newest entry, so
+// that a point lookup does not have to search the memtable rep. It is an
+// open-addressing hash table with a fixed number of slots and linear probing.
+// A slot is only ever set to an entry of the same user key as the entry it
+// holds, so the slots of a key never move and lookups need no locks.
+//
+// A key whose probe sequence is full is not indexed. Lookups of such a key
+// report kUnknown, as do the lookups that can't be answered by the newest
+// entry alone, and the caller falls back to the memtable rep.
+//
+// The index hashes and compares user keys bytewise, so it may only be used
+// with comparators under which equal keys are bytewise equal.
+class MemTableKeyIndex {
+ public:
+  enum LookupResult {
+    // *entry is the newest entry of the key
+    kFound,
+    // The memtable has no entry of the key
+    kNotFound,
+    // The index does not know about the key
+    kUnknown,
+  };
+
+  // num_slots: number of slots, allocated from allocator. The index works
+  //            best with at least twice as many slots as keys.
+  // huge_page_tlb_size: if >0, try to allocate the slots from huge page TLB
+  //                     within this page size.
+  MemTableKeyIndex(Allocator* allocator, uint32_t num_slots,
+                   size_t huge_page_tlb_size = 0, Logger* logger = nullptr);
+
+  // Records entry as the newest entry of its user key, unless an entry with
+  // a larger sequence number is already recorded. entry is encoded as in the
+  // memtable: the length prefixed internal key followed by the value.
+  // allow_concurrent has to be set when other threads may call Add() at the
+  // same time. Lookup() may always run concurrently.
+  void Add(const Slice& user_key, const char* entry, bool allow_concurrent);
+
+  LookupResult Lookup(const Slice& user_key, const char** entry) const;
+
+ private:
+  static const uint32_t kMaxProbes = 8;
+
+  const uint32_t num_slots_;
+  std::atomic<const char*>* slots_;
+};
+
+}  // namespace rocksdb
@@ -0,0 +1,118 @@
+//  Copyright (c) 2011-present, Facebook, Inc.  All rights reserved.
+//  This source code is licensed under the BSD-style license found in the
+//  LICENSE file in the root directory of this source tree. An additional grant
+//  of patent rights can be found in the PATENTS file in the same directory.
+
+#include "db/memtable_key_index.h"
+
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "db/dbformat.h"
+#include "util/arena.h"
+#include "util/coding.h"
+#include "util/string_util.h"
+#include "util/testharness.h"
+
+namespace rocksdb {
+
+class MemTableKeyIndexTest : public testing::Test {
+ public:
+  // Returns a memtable entry of user_key with sequence number seq
+  const char* NewEntry(const std::string& user_key, SequenceNumber seq) {
+    InternalKey internal_key(user_key, seq, kTypeValue);
+    const Slice encoded = internal_key.Encode();
+    char* buf = arena_.AllocateAligned(VarintLength(encoded.size()) +
+                                       encoded.size());
+    char* p = EncodeVarint32(buf, static_cast<uint32_t>(encoded.size()));
+    memcpy(p, encoded.data(), encoded.size());
+    return buf;
+  }
+
+  static SequenceNumber Seq(const char* entry) {
+    return GetInternalKeySeqno(GetLengthPrefixedSlice(entry));
+  }
+
+  Arena arena_;
+};
+
+TEST_F(MemTableKeyIndexTest, AddAndLookup) {
+  MemTableKeyIndex index(&arena_, 1000);
+  const char* entry = nullptr;
+  ASSERT_EQ(MemTableKeyIndex::kNotFound, index.Lookup("a", &entry));
+
+  index.Add("a", NewEntry("a", 10), false);
+  index.Add("b", NewEntry("b", 11), false);
+  ASSERT_EQ(MemTableKeyIndex::kFound, index.Lookup("a", &entry));
+  ASSERT_EQ(10U, Seq(entry));
+  ASSERT_EQ(MemTableKeyIndex::kFound, index.Lookup("b", &entry));
+  ASSERT_EQ(11U, Seq(entry));
+  ASSERT_EQ(MemTableKeyIndex::kNotFound, index.Lookup("c", &entry));
+
+  // The newest entry of a key is kept
+  index.Add("a", NewEntry("a", 12), false);
+  index.Add("a", NewEntry("a", 9), true);
+  ASSERT_EQ(MemTableKeyIndex::kFound, index.Lookup("a", &entry));
+  ASSERT_EQ(12U, Seq(entry));
+}
+
+TEST_F(MemTableKeyIndexTest, Full) {
+  const uint32_t kNumSlots = 4;
+  MemTableKeyIndex index(&arena_, kNumSlots);
+  for (uint32_t i = 0; i < kNumSlots; i++) {
+    index.Add(ToString(i), NewEntry(ToString(i), i + 1), false);
+  }
+  index.Add("x", NewEntry("x", 10), false);
+
+  const char* entry = nullptr;
+  for (uint32_t i = 0; i < kNumSlots; i++) {
+    ASSERT_EQ(MemTableKeyIndex::kFound, index.Lookup(ToString(i), &entry));
+    ASSERT_EQ(i + 1, Seq(entry));
+  }
+  // Keys that are not indexed can't be told apart from missing keys
+  ASSERT_EQ(MemTableKeyIndex::kUnknown, index.Lookup("x", &entry));
+  ASSERT_EQ(MemTableKeyIndex::kUnknown, index.Lookup("y", &entry));
+}
+
+TEST_F(MemTableKeyIndexTest, ConcurrentAdd) {
+  const int kNumThreads = 4;
+  const int kNumKeys = 1000;
+  MemTableKeyIndex index(&arena_, 4 * kNumKeys);
+
+  // Each thread writes every key, with the sequence numbers of the threads
+  // interleaved, so that the threads race on the slots of each key
+  std::vector<std::vector<const char*>> entries(kNumThreads);
+  for (int t = 0; t < kNumThreads; t++) {
+    for (int k = 0; k < kNumKeys; k++) {
+      entries[t].push_back(NewEntry(ToString(k), k * kNumThreads + t + 1));
+    }
+  }
+  std::vector<std::thread> threads;
+  for (int t = 0; t < kNumThreads; t++) {
+    threads.emplace_back([&, t]() {
+      for (int k = 0; k < kNumKeys; k++) {
+        index.Add(ToString(k), entries[t][k], true);
+      }
+    });
+  }
+  for (auto& thread : threads) {
+    thread.join();
+  }
+
+  const char* entry = nullptr;
+  for (int k = 0; k < kNumKeys; k++) {
+    ASSERT_NE(MemTableKeyIndex::kNotFound, index.Lookup(ToString(k), &entry));
+    if (index.Lookup(ToString(k), &entry) == MemTableKeyIndex::kFound) {
+      ASSERT_EQ(static_cast<SequenceNumber>((k + 1) * kNumThreads),
+                Seq(entry));
+    }
+  }
+}
+
+}  // namespace rocksdb
+
+int main(int argc, char** argv) {
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -10,9 +10,11 @@
 #endif
 
 #include <inttypes.h>
+#include <algorithm>
 #include <string>
 #include "rocksdb/db.h"
 #include "db/memtable.h"
+#include "db/range_del_aggregator.h"
 #include "db/version_set.h"
 #include "rocksdb/env.h"
 #include "rocksdb/iterator.h"
@@ -101,27 +103,32 @@ int MemTableList::NumFlushed() const {
 // Operands stores the list of merge operations to apply, so far.
 bool MemTableListVersion::Get(const LookupKey& key, std::string* value,
                               Status* s, MergeContext* merge_context,
+                              RangeDelAggregator* range_del_agg,
                               SequenceNumber* seq) {
-  return GetFromList(&memlist_, key, value, s, merge_context, seq);
+  return GetFromList(&memlist_, key, value, s, merge_context, range_del_agg,
+                     seq);
 }
 
 bool MemTableListVersion::GetFromHistory(const LookupKey& key,
                                          std::string* value, Status* s,
                                          MergeContext* merge_context,
                                          SequenceNumber* seq) {
-  return GetFromList(&memlist_history_, key, value, s, merge_context, seq);
+  return GetFromList(&memlist_history_, key, value, s, merge_context,
+                     nullptr /* range_del_agg */, seq);
 }
 
 bool MemTableListVersion::GetFromList(std::list<MemTable*>* list,
                                       const LookupKey& key, std::string* value,
                                       Status* s, MergeContext* merge_context,
+                                      RangeDelAggregator* range_del_agg,
                                       SequenceNumber* seq) {
   *seq = kMaxSequenceNumber;
 
   for (auto& memtable : *list) {
     SequenceNumber current_seq = kMaxSequenceNumber;
 
-    bool done = memtable->Get(key, value, s, merge_context, &current_seq);
+    bool done = memtable->Get(key, value, s, merge_context, range_del_agg,
+                              &current_seq);
     if (*seq == kMaxSequenceNumber) {
       // Store the most recent sequence number of any operation on this key.
       // Since we only care about the most recent change, we only need to
@@ -154,6 +161,19 @@ void MemTableListVersion::AddIterators(
   }
 }
 
+Status MemTableListVersion::AddRangeTombstones(
+    const ReadOptions& options, RangeDelAggregator* range_del_agg) {
+  for (auto& m : memlist_) {
+    std::unique_ptr<InternalIterator> range_del_iter(
+        m->NewRangeTombstoneIterator(options));
+    Status s = range_del_agg->AddTombstones(std::move(range_del_iter));
+    if (!s.ok()) {
+      return s;
+    }
+  }
+  return Status::OK();
+}
+
 uint64_t MemTableListVersion::GetTotalNumEntries() const {
   uint64_t total_num = 0;
   for (auto& m : memlist_) {
@@ -212,6 +232,23 @@ void MemTableListVersion::Remove(MemTable* m,
   }
 }
 
+void MemTableListVersion::Replace(const autovector<MemTable*>& mems,
+                                  MemTable* m,
+                                  autovector<MemTable*>* to_delete) {
+  assert(refs_ == 1);  // only when refs_ == 1 is MemTableListVersion mutable
+  assert(!mems.empty());
+  // mems are in the ascending order of created time, so m goes in front of
+  // the newest of them
+  auto it = std::find(memlist_.begin(), memlist_.end(), mems.back());
+  assert(it != memlist_.end());
+  memlist_.insert(it, m);
+  *parent_memtable_list_memory_usage_ += m->ApproximateMemoryUsage();
+  for (MemTable* mem : mems) {
+    memlist_.remove(mem);
+    UnrefMemTable(to_delete, mem);
+  }
+}
+
 // Make sure we don't use up too much space in history
 void MemTableListVersion::TrimHistory(autovector<MemTable*>* to_delete) {
   while (memlist_.size() + memlist_history_.size() >
@@ -227,6 +264,27 @@ void MemTableListVersion::TrimHistory(autovector<MemTable*>* to_delete) {
 // Returns true if there is at least one memtable on which flush has
 // not yet started.
 bool MemTableList::IsFlushPending() const {
+  if (in_memory_compaction_) {
+    if (num_flush_not_started_ == 0 || in_memory_compaction_running_) {
+      return false;
+    }
+    assert(imm_flush_needed.load(std::memory_order_relaxed));
+    if (flush_requested_) {
+      return true;
+    }
+    // The memtables waiting for a flush are merged in memory until they are
+    // as big as min_write_buffer_number_to_merge memtables
+    size_t not_started_usage = 0;
+    for (MemTable* m : current_->memlist_) {
+      if (!m->flush_in_progress_) {
+        not_started_usage += m->ApproximateMemoryUsage();
+      }
+    }
+    const size_t write_buffer_size =
+        current_->memlist_.front()->GetMemTableOptions()->write_buffer_size;
+    return not_started_usage >=
+           min_write_buffer_number_to_merge_ * write_buffer_size;
+  }
   if ((flush_requested_ && num_flush_not_started_ >= 1) ||
       (num_flush_not_started_ >= min_write_buffer_number_to_merge_)) {
     assert(imm_flush_needed.load(std::memory_order_relaxed));
@@ -244,6 +302,7 @@ void MemTableList::PickMemtablesToFlush(autovector<MemTable*>* ret) {
     MemTable* m = *it;
     if (!m->flush_in_progress_) {
       assert(!m->flush_completed_);
+      assert(!m->in_memory_compaction_in_progress_);
       num_flush_not_started_--;
       if (num_flush_not_started_ == 0) {
         imm_flush_needed.store(false, std::memory_order_release);
@@ -255,6 +314,73 @@ void MemTableList::PickMemtablesToFlush(autovector<MemTable*>* ret) {
   flush_requested_ = false;  // start-flush request is complete
 }
 
+bool MemTableList::IsInMemoryCompactionPending() const {
+  if (!in_memory_compaction_ || in_memory_compaction_running_ ||
+      flush_requested_) {
+    return false;
+  }
+  // Only the newest memtables, after the last one on which flush has
+  // started, can be merged
+  for (MemTable* m : current_->memlist_) {
+    if (m->flush_in_progress_) {
+      break;
+    }
+    if (!m->compacted_in_memory_) {
+      return true;
+    }
+  }
+  return false;
+}
+
+void MemTableList::PickMemtablesForInMemoryCompaction(
+    autovector<MemTable*>* ret) {
+  assert(IsInMemoryCompactionPending());
+  const auto& memlist = current_->memlist_;
+  auto it = memlist.begin();
+  while (it != memlist.end() && !(*it)->flush_in_progress_) {
+    ++it;
+  }
+  // Return them oldest first
+  while (it != memlist.begin()) {
+    MemTable* m = *--it;
+    assert(!m->in_memory_compaction_in_progress_);
+    m->in_memory_compaction_in_progress_ = true;
+    num_flush_not_started_--;
+    ret->push_back(m);
+  }
+  if (num_flush_not_started_ == 0) {
+    imm_flush_needed.store(false, std::memory_order_release);
+  }
+  in_memory_compaction_running_ = true;
+}
+
+void MemTableList::InstallInMemoryCompactionResult(
+    const autovector<MemTable*>& mems, MemTable* m,
+    autovector<MemTable*>* to_delete) {
+  assert(in_memory_compaction_running_);
+  in_memory_compaction_running_ = false;
+  if (m == nullptr) {
+    for (MemTable* mem : mems) {
+      assert(mem->in_memory_compaction_in_progress_);
+      mem->in_memory_compaction_in_progress_ = false;
+      num_flush_not_started_++;
+    }
+    imm_flush_needed.store(true, std::memory_order_release);
+    return;
+  }
+  InstallNewVersion();
+  current_->Replace(mems, m, to_delete);
+  m->MarkImmutable();
+  m->compacted_in_memory_ = true;
+  num_flush_not_started_++;
+  imm_flush_needed.store(true, std::memory_order_release);
+}
+
+bool MemTableList::IsOldestMemTable(const MemTable* m) const {
+  const auto& memlist = current_->memlist_;
+  return !memlist.empty() && memlist.back() == m;
+}
+
 void MemTableList::RollbackMemtableFlush(const autovector<MemTable*>& mems,
                                          uint64_t file_number) {
   AutoThreadOperationStageUpdater stage_updater(
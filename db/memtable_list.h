@@ -52,13 +52,15 @@ class MemTableListVersion {
   // If any operation was found for this key, its most recent sequence number
   // will be stored in *seq on success (regardless of whether true/false is
   // returned).  Otherwise, *seq will be set to kMaxSequenceNumber.
+  // See MemTable::Get() for range_del_agg.
   bool Get(const LookupKey& key, std::string* value, Status* s,
-           MergeContext* merge_context, SequenceNumber* seq);
+           MergeContext* merge_context, RangeDelAggregator* range_del_agg,
+           SequenceNumber* seq);
 
   bool Get(const LookupKey& key, std::string* value, Status* s,
-           MergeContext* merge_context) {
+           MergeContext* merge_context, RangeDelAggregator* range_del_agg) {
     SequenceNumber seq;
-    return Get(key, value, s, merge_context, &seq);
+    return Get(key, value, s, merge_context, range_del_agg, &seq);
   }
 
   // Similar to Get(), but searches the Memtable history of memtables that
@@ -80,6 +82,10 @@ class MemTableListVersion {
   void AddIterators(const ReadOptions& options,
                     MergeIteratorBuilder* merge_iter_builder);
 
+  // Adds the range deletions of the memtables to range_del_agg
+  Status AddRangeTombstones(const ReadOptions& options,
+                            RangeDelAggregator* range_del_agg);
+
   uint64_t GetTotalNumEntries() const;
 
   uint64_t GetTotalNumDeletes() const;
@@ -98,11 +104,17 @@ class MemTableListVersion {
   // REQUIRE: m is an immutable memtable
   void Remove(MemTable* m, autovector<MemTable*>* to_delete);
 
+  // Replaces mems, which are next to each other in the list, by m. mems are
+  // not kept in the history.
+  // REQUIRE: m is an immutable memtable
+  void Replace(const autovector<MemTable*>& mems, MemTable* m,
+               autovector<MemTable*>* to_delete);
+
   void TrimHistory(autovector<MemTable*>* to_delete);
 
   bool GetFromList(std::list<MemTable*>* list, const LookupKey& key,
                    std::string* value, Status* s, MergeContext* merge_context,
-                   SequenceNumber* seq);
+                   RangeDelAggregator* range_del_agg, SequenceNumber* seq);
 
   void AddMemTable(MemTable* m);
 
@@ -134,6 +146,10 @@ class MemTableListVersion {
 // recoverability from a crash.
 //
 //
+// With in_memory_compaction, the memtables that wait for a flush are first
+// merged into a single memtable by an in-memory compaction, and are only
+// flushed once the merged memtable is big enough or a flush is requested.
+//
 // Other than imm_flush_needed, this class is not thread-safe and requires
 // external synchronization (such as holding the db mutex or being on the
 // write thread.)
@@ -141,14 +157,17 @@ class MemTableList {
  public:
   // A list of memtables.
   explicit MemTableList(int min_write_buffer_number_to_merge,
-                        int max_write_buffer_number_to_maintain)
+                        int max_write_buffer_number_to_maintain,
+                        bool in_memory_compaction = false)
       : imm_flush_needed(false),
         min_write_buffer_number_to_merge_(min_write_buffer_number_to_merge),
+        in_memory_compaction_(in_memory_compaction),
         current_(new MemTableListVersion(&current_memory_usage_,
                                          max_write_buffer_number_to_maintain)),
         num_flush_not_started_(0),
         commit_in_progress_(false),
-        flush_requested_(false) {
+        flush_requested_(false),
+        in_memory_compaction_running_(false) {
     current_->Ref();
     current_memory_usage_ = 0;
   }
@@ -179,6 +198,28 @@ class MemTableList {
   // memtables are guaranteed to be in the ascending order of created time.
   void PickMemtablesToFlush(autovector<MemTable*>* mems);
 
+  // Returns true if there are memtables that wait for a flush and have not
+  // been merged by an in-memory compaction yet, and no in-memory compaction
+  // is running.
+  bool IsInMemoryCompactionPending() const;
+
+  // Returns the memtables to merge by an in-memory compaction, the newest
+  // ones on which flush has not started, in the ascending order of created
+  // time. They can't be picked for flush until
+  // InstallInMemoryCompactionResult() is called.
+  void PickMemtablesForInMemoryCompaction(autovector<MemTable*>* mems);
+
+  // Replaces mems, returned by PickMemtablesForInMemoryCompaction(), by m,
+  // the memtable that merges them, and takes over the reference that the
+  // caller holds on m. If m is null, mems are put back as they were.
+  void InstallInMemoryCompactionResult(const autovector<MemTable*>& mems,
+                                       MemTable* m,
+                                       autovector<MemTable*>* to_delete);
+
+  // Returns whether m is the oldest memtable of the list, that is, whether
+  // all the data older than m is in the current version.
+  bool IsOldestMemTable(const MemTable* m) const;
+
   // Reset status of the given memtable list back to pending state so that
   // they can get picked up again on the next round of flush.
   void RollbackMemtableFlush(const autovector<MemTable*>& mems,
@@ -221,6 +262,8 @@ class MemTableList {
 
   const int min_write_buffer_number_to_merge_;
 
+  const bool in_memory_compaction_;
+
   MemTableListVersion* current_;
 
   // the number of elements that still need flushing
@@ -232,6 +275,9 @@ class MemTableList {
   // Requested a flush of all memtables to storage
   bool flush_requested_;
 
+  // An in-memory compaction is running
+  bool in_memory_compaction_running_;
+
   // The current memory usage.
   size_t current_memory_usage_;
 };
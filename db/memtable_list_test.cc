@@ -10,9 +10,9 @@
 #include "db/merge_context.h"
 #include "db/version_set.h"
 #include "db/write_controller.h"
-#include "db/writebuffer.h"
 #include "rocksdb/db.h"
 #include "rocksdb/status.h"
+#include "rocksdb/write_buffer_manager.h"
 #include "util/testutil.h"
 #include "util/string_util.h"
 #include "util/testharness.h"
@@ -59,7 +59,7 @@ class MemTableListTest : public testing::Test {
     DBOptions db_options;
     EnvOptions env_options;
     shared_ptr<Cache> table_cache(NewLRUCache(50000, 16));
-    WriteBuffer write_buffer(db_options.db_write_buffer_size);
+    WriteBufferManager write_buffer(db_options.db_write_buffer_size);
     WriteController write_controller(10000000u);
 
     CreateDB();
@@ -117,7 +117,7 @@ TEST_F(MemTableListTest, GetTest) {
   autovector<MemTable*> to_delete;
 
   LookupKey lkey("key1", seq);
-  bool found = list.current()->Get(lkey, &value, &s, &merge_context);
+  bool found = list.current()->Get(lkey, &value, &s, &merge_context, nullptr);
   ASSERT_FALSE(found);
 
   // Create a MemTable
@@ -126,7 +126,7 @@ TEST_F(MemTableListTest, GetTest) {
   options.memtable_factory = factory;
   ImmutableCFOptions ioptions(options);
 
-  WriteBuffer wb(options.db_write_buffer_size);
+  WriteBufferManager wb(options.db_write_buffer_size);
   MemTable* mem =
       new MemTable(cmp, ioptions, MutableCFOptions(options, ioptions), &wb,
                    kMaxSequenceNumber);
@@ -140,17 +140,17 @@ TEST_F(MemTableListTest, GetTest) {
 
   // Fetch the newly written keys
   merge_context.Clear();
-  found = mem->Get(LookupKey("key1", seq), &value, &s, &merge_context);
+  found = mem->Get(LookupKey("key1", seq), &value, &s, &merge_context, nullptr);
   ASSERT_TRUE(s.ok() && found);
   ASSERT_EQ(value, "value1");
 
   merge_context.Clear();
-  found = mem->Get(LookupKey("key1", 2), &value, &s, &merge_context);
+  found = mem->Get(LookupKey("key1", 2), &value, &s, &merge_context, nullptr);
   // MemTable found out that this key is *not* found (at this sequence#)
   ASSERT_TRUE(found && s.IsNotFound());
 
   merge_context.Clear();
-  found = mem->Get(LookupKey("key2", seq), &value, &s, &merge_context);
+  found = mem->Get(LookupKey("key2", seq), &value, &s, &merge_context, nullptr);
   ASSERT_TRUE(s.ok() && found);
   ASSERT_EQ(value, "value2.2");
 
@@ -163,7 +163,7 @@ TEST_F(MemTableListTest, GetTest) {
   SequenceNumber saved_seq = seq;
 
   // Create another memtable and write some keys to it
-  WriteBuffer wb2(options.db_write_buffer_size);
+  WriteBufferManager wb2(options.db_write_buffer_size);
   MemTable* mem2 =
       new MemTable(cmp, ioptions, MutableCFOptions(options, ioptions), &wb2,
                    kMaxSequenceNumber);
@@ -177,24 +177,25 @@ TEST_F(MemTableListTest, GetTest) {
 
   // Fetch keys via MemTableList
   merge_context.Clear();
-  found =
-      list.current()->Get(LookupKey("key1", seq), &value, &s, &merge_context);
+  found = list.current()->Get(LookupKey("key1", seq), &value, &s,
+                              &merge_context, nullptr);
   ASSERT_TRUE(found && s.IsNotFound());
 
   merge_context.Clear();
   found = list.current()->Get(LookupKey("key1", saved_seq), &value, &s,
-                              &merge_context);
+                              &merge_context, nullptr);
   ASSERT_TRUE(s.ok() && found);
   ASSERT_EQ("value1", value);
 
   merge_context.Clear();
-  found =
-      list.current()->Get(LookupKey("key2", seq), &value, &s, &merge_context);
+  found = list.current()->Get(LookupKey("key2", seq), &value, &s,
+                              &merge_context, nullptr);
   ASSERT_TRUE(s.ok() && found);
   ASSERT_EQ(value, "value2.3");
 
   merge_context.Clear();
-  found = list.current()->Get(LookupKey("key2", 1), &value, &s, &merge_context);
+  found = list.current()->Get(LookupKey("key2", 1), &value, &s,
+                              &merge_context, nullptr);
   ASSERT_FALSE(found);
 
   ASSERT_EQ(2, list.NumNotFlushed());
@@ -219,7 +220,7 @@ TEST_F(MemTableListTest, GetFromHistoryTest) {
   autovector<MemTable*> to_delete;
 
   LookupKey lkey("key1", seq);
-  bool found = list.current()->Get(lkey, &value, &s, &merge_context);
+  bool found = list.current()->Get(lkey, &value, &s, &merge_context, nullptr);
   ASSERT_FALSE(found);
 
   // Create a MemTable
@@ -228,7 +229,7 @@ TEST_F(MemTableListTest, GetFromHistoryTest) {
   options.memtable_factory = factory;
   ImmutableCFOptions ioptions(options);
 
-  WriteBuffer wb(options.db_write_buffer_size);
+  WriteBufferManager wb(options.db_write_buffer_size);
   MemTable* mem =
       new MemTable(cmp, ioptions, MutableCFOptions(options, ioptions), &wb,
                    kMaxSequenceNumber);
@@ -241,12 +242,12 @@ TEST_F(MemTableListTest, GetFromHistoryTest) {
 
   // Fetch the newly written keys
   merge_context.Clear();
-  found = mem->Get(LookupKey("key1", seq), &value, &s, &merge_context);
+  found = mem->Get(LookupKey("key1", seq), &value, &s, &merge_context, nullptr);
   // MemTable found out that this key is *not* found (at this sequence#)
   ASSERT_TRUE(found && s.IsNotFound());
 
   merge_context.Clear();
-  found = mem->Get(LookupKey("key2", seq), &value, &s, &merge_context);
+  found = mem->Get(LookupKey("key2", seq), &value, &s, &merge_context, nullptr);
   ASSERT_TRUE(s.ok() && found);
   ASSERT_EQ(value, "value2.2");
 
@@ -256,13 +257,13 @@ TEST_F(MemTableListTest, GetFromHistoryTest) {
 
   // Fetch keys via MemTableList
   merge_context.Clear();
-  found =
-      list.current()->Get(LookupKey("key1", seq), &value, &s, &merge_context);
+  found = list.current()->Get(LookupKey("key1", seq), &value, &s,
+                              &merge_context, nullptr);
   ASSERT_TRUE(found && s.IsNotFound());
 
   merge_context.Clear();
-  found =
-      list.current()->Get(LookupKey("key2", seq), &value, &s, &merge_context);
+  found = list.current()->Get(LookupKey("key2", seq), &value, &s,
+                              &merge_context, nullptr);
   ASSERT_TRUE(s.ok() && found);
   ASSERT_EQ("value2.2", value);
 
@@ -281,13 +282,13 @@ TEST_F(MemTableListTest, GetFromHistoryTest) {
 
   // Verify keys are no longer in MemTableList
   merge_context.Clear();
-  found =
-      list.current()->Get(LookupKey("key1", seq), &value, &s, &merge_context);
+  found = list.current()->Get(LookupKey("key1", seq), &value, &s,
+                              &merge_context, nullptr);
   ASSERT_FALSE(found);
 
   merge_context.Clear();
-  found =
-      list.current()->Get(LookupKey("key2", seq), &value, &s, &merge_context);
+  found = list.current()->Get(LookupKey("key2", seq), &value, &s,
+                              &merge_context, nullptr);
   ASSERT_FALSE(found);
 
   // Verify keys are present in history
@@ -303,7 +304,7 @@ TEST_F(MemTableListTest, GetFromHistoryTest) {
   ASSERT_EQ("value2.2", value);
 
   // Create another memtable and write some keys to it
-  WriteBuffer wb2(options.db_write_buffer_size);
+  WriteBufferManager wb2(options.db_write_buffer_size);
   MemTable* mem2 =
       new MemTable(cmp, ioptions, MutableCFOptions(options, ioptions), &wb2,
                    kMaxSequenceNumber);
@@ -329,7 +330,7 @@ TEST_F(MemTableListTest, GetFromHistoryTest) {
   ASSERT_EQ(0, to_delete.size());
 
   // Add a third memtable to push the first memtable out of the history
-  WriteBuffer wb3(options.db_write_buffer_size);
+  WriteBufferManager wb3(options.db_write_buffer_size);
   MemTable* mem3 =
       new MemTable(cmp, ioptions, MutableCFOptions(options, ioptions), &wb3,
                    kMaxSequenceNumber);
@@ -341,18 +342,18 @@ TEST_F(MemTableListTest, GetFromHistoryTest) {
 
   // Verify keys are no longer in MemTableList
   merge_context.Clear();
-  found =
-      list.current()->Get(LookupKey("key1", seq), &value, &s, &merge_context);
+  found = list.current()->Get(LookupKey("key1", seq), &value, &s,
+                              &merge_context, nullptr);
   ASSERT_FALSE(found);
 
   merge_context.Clear();
-  found =
-      list.current()->Get(LookupKey("key2", seq), &value, &s, &merge_context);
+  found = list.current()->Get(LookupKey("key2", seq), &value, &s,
+                              &merge_context, nullptr);
   ASSERT_FALSE(found);
 
   merge_context.Clear();
-  found =
-      list.current()->Get(LookupKey("key3", seq), &value, &s, &merge_context);
+  found = list.current()->Get(LookupKey("key3", seq), &value, &s,
+                              &merge_context, nullptr);
   ASSERT_FALSE(found);
 
   // Verify that the second memtable's keys are in the history
@@ -369,8 +370,8 @@ TEST_F(MemTableListTest, GetFromHistoryTest) {
 
   // Verify that key2 from the first memtable is no longer in the history
   merge_context.Clear();
-  found =
-      list.current()->Get(LookupKey("key2", seq), &value, &s, &merge_context);
+  found = list.current()->Get(LookupKey("key2", seq), &value, &s,
+                              &merge_context, nullptr);
   ASSERT_FALSE(found);
 
   // Cleanup
@@ -390,7 +391,7 @@ TEST_F(MemTableListTest, FlushPendingTest) {
   options.memtable_factory = factory;
   ImmutableCFOptions ioptions(options);
   InternalKeyComparator cmp(BytewiseComparator());
-  WriteBuffer wb(options.db_write_buffer_size);
+  WriteBufferManager wb(options.db_write_buffer_size);
   autovector<MemTable*> to_delete;
 
   // Create MemTableList
@@ -593,6 +594,86 @@ TEST_F(MemTableListTest, FlushPendingTest) {
   to_delete.clear();
 }
 
+TEST_F(MemTableListTest, InMemoryCompactionTest) {
+  ImmutableCFOptions ioptions(options);
+  InternalKeyComparator cmp(BytewiseComparator());
+  WriteBufferManager wb(options.db_write_buffer_size);
+  MutableCFOptions mutable_cf_options(options, ioptions);
+  autovector<MemTable*> to_delete;
+  SequenceNumber seq = 1;
+
+  MemTableList list(2, 0, true /* in_memory_compaction */);
+
+  std::vector<MemTable*> tables;
+  for (int i = 0; i < 4; i++) {
+    MemTable* mem = new MemTable(cmp, ioptions, mutable_cf_options, &wb,
+                                 kMaxSequenceNumber);
+    mem->Ref();
+    mem->Add(++seq, kTypeValue, "key", ToString(i));
+    tables.push_back(mem);
+  }
+
+  ASSERT_FALSE(list.IsInMemoryCompactionPending());
+  list.Add(tables[0], &to_delete);
+  list.Add(tables[1], &to_delete);
+  // The memtables are much smaller than two write buffers, so they are
+  // merged rather than flushed
+  ASSERT_FALSE(list.IsFlushPending());
+  ASSERT_TRUE(list.IsInMemoryCompactionPending());
+
+  autovector<MemTable*> mems;
+  list.PickMemtablesForInMemoryCompaction(&mems);
+  ASSERT_EQ(2, mems.size());
+  ASSERT_EQ(tables[0], mems[0]);
+  ASSERT_EQ(tables[1], mems[1]);
+  ASSERT_FALSE(list.IsInMemoryCompactionPending());
+  ASSERT_FALSE(list.IsFlushPending());
+  ASSERT_FALSE(list.imm_flush_needed.load(std::memory_order_acquire));
+
+  // A failed compaction puts the memtables back
+  list.InstallInMemoryCompactionResult(mems, nullptr, &to_delete);
+  ASSERT_EQ(0, to_delete.size());
+  ASSERT_EQ(2, list.NumNotFlushed());
+  ASSERT_TRUE(list.IsInMemoryCompactionPending());
+
+  mems.clear();
+  list.PickMemtablesForInMemoryCompaction(&mems);
+  ASSERT_EQ(2, mems.size());
+  // A memtable added while the compaction runs stays in front of the result
+  list.Add(tables[2], &to_delete);
+  ASSERT_FALSE(list.IsInMemoryCompactionPending());
+  list.InstallInMemoryCompactionResult(mems, tables[3], &to_delete);
+  ASSERT_EQ(2, to_delete.size());
+  for (MemTable* m : to_delete) {
+    delete m;
+  }
+  to_delete.clear();
+  ASSERT_EQ(2, list.NumNotFlushed());
+  ASSERT_TRUE(list.imm_flush_needed.load(std::memory_order_acquire));
+
+  // tables[2] has not been merged yet
+  ASSERT_TRUE(list.IsInMemoryCompactionPending());
+
+  // A requested flush takes both, the merged memtable first
+  list.FlushRequested();
+  ASSERT_FALSE(list.IsInMemoryCompactionPending());
+  ASSERT_TRUE(list.IsFlushPending());
+  autovector<MemTable*> to_flush;
+  list.PickMemtablesToFlush(&to_flush);
+  ASSERT_EQ(2, to_flush.size());
+  ASSERT_EQ(tables[3], to_flush[0]);
+  ASSERT_EQ(tables[2], to_flush[1]);
+  ASSERT_FALSE(list.IsFlushPending());
+  ASSERT_FALSE(list.IsInMemoryCompactionPending());
+
+  list.RollbackMemtableFlush(to_flush, 0);
+  list.current()->Unref(&to_delete);
+  ASSERT_EQ(2, to_delete.size());
+  for (MemTable* m : to_delete) {
+    delete m;
+  }
+}
+
 }  // namespace rocksdb
 
 int main(int argc, char** argv) {
@@ -28,13 +28,13 @@ int main() {
 
 #include "db/dbformat.h"
 #include "db/memtable.h"
-#include "db/writebuffer.h"
 #include "port/port.h"
 #include "port/stack_trace.h"
 #include "rocksdb/comparator.h"
 #include "rocksdb/memtablerep.h"
 #include "rocksdb/options.h"
 #include "rocksdb/slice_transform.h"
+#include "rocksdb/write_buffer_manager.h"
 #include "util/arena.h"
 #include "util/mutexlock.h"
 #include "util/stop_watch.h"
@@ -64,6 +64,7 @@ DEFINE_string(memtablerep, "skiplist",
               "\tvector              -- backed by an std::vector\n"
               "\thashskiplist        -- backed by a hash skip list\n"
               "\thashlinklist        -- backed by a hash linked list\n"
+              "\tbtree               -- backed by a B+-tree\n"
               "\tcuckoo              -- backed by a cuckoo hash table");
 
 DEFINE_int64(bucket_count, 1000000,
@@ -606,6 +607,8 @@ int main(int argc, char** argv) {
         FLAGS_if_log_bucket_dist_when_flash, FLAGS_threshold_use_skiplist));
     options.prefix_extractor.reset(
         rocksdb::NewFixedPrefixTransform(FLAGS_prefix_length));
+  } else if (FLAGS_memtablerep == "btree") {
+    factory.reset(new rocksdb::BTreeRepFactory);
   } else if (FLAGS_memtablerep == "cuckoo") {
     factory.reset(rocksdb::NewHashCuckooRepFactory(
         FLAGS_write_buffer_size, FLAGS_average_data_size,
@@ -622,7 +625,7 @@ int main(int argc, char** argv) {
       rocksdb::BytewiseComparator());
   rocksdb::MemTable::KeyComparator key_comp(internal_key_comp);
   rocksdb::Arena arena;
-  rocksdb::WriteBuffer wb(FLAGS_write_buffer_size);
+  rocksdb::WriteBufferManager wb(FLAGS_write_buffer_size);
   rocksdb::MemTableAllocator memtable_allocator(&arena, &wb);
   uint64_t sequence;
   auto createMemtableRep = [&] {
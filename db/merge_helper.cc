@@ -9,6 +9,7 @@
 #include <string>
 
 #include "db/dbformat.h"
+#include "db/range_del_aggregator.h"
 #include "rocksdb/comparator.h"
 #include "rocksdb/db.h"
 #include "rocksdb/merge_operator.h"
@@ -59,12 +60,14 @@ Status MergeHelper::TimedFullMerge(const Slice& key, const Slice* value,
 //       keys_[i] corresponds to operands_[i] for each i.
 Status MergeHelper::MergeUntil(InternalIterator* iter,
                                const SequenceNumber stop_before,
-                               const bool at_bottom) {
+                               const bool at_bottom,
+                               RangeDelAggregator* range_del_agg) {
   // Get a copy of the internal key, before it's invalidated by iter->Next()
   // Also maintain the list of merge operands seen.
   assert(HasOperator());
   keys_.clear();
   operands_.clear();
+  has_compaction_filter_skip_until_ = false;
   assert(user_merge_operator_);
   bool first_key = true;
 
@@ -84,6 +87,7 @@ Status MergeHelper::MergeUntil(InternalIterator* iter,
 
   Status s;
   bool hit_the_next_user_key = false;
+  bool hit_range_deletion = false;
   for (; iter->Valid(); iter->Next(), original_key_is_iter = false) {
     ParsedInternalKey ikey;
     assert(keys_.size() == operands_.size());
@@ -105,6 +109,12 @@ Status MergeHelper::MergeUntil(InternalIterator* iter,
     } else if (stop_before && ikey.sequence <= stop_before) {
       // hit an entry that's visible by the previous snapshot, can't touch that
       break;
+    } else if (range_del_agg != nullptr && range_del_agg->ShouldDelete(ikey)) {
+      // hit an entry deleted by a range deletion, which is the start of the
+      // history of this user key as far as the operands are concerned. The
+      // entry itself is dropped by the caller.
+      hit_range_deletion = true;
+      break;
     }
 
     // At this point we are guaranteed that we need to process this key.
@@ -175,8 +185,19 @@ Status MergeHelper::MergeUntil(InternalIterator* iter,
       // 1) it's included in one of the snapshots. in that case we *must* write
       // it out, no matter what compaction filter says
       // 2) it's not filtered by a compaction filter
-      if (ikey.sequence <= latest_snapshot_ ||
-          !FilterMerge(orig_ikey.user_key, value_slice)) {
+      CompactionFilter::Decision filter =
+          ikey.sequence <= latest_snapshot_
+              ? CompactionFilter::Decision::kKeep
+              : FilterMerge(orig_ikey.user_key, value_slice);
+      if (filter == CompactionFilter::Decision::kRemoveAndSkipUntil) {
+        // The filter asked to drop the whole key, not only this operand,
+        // along with the keys that follow it. The caller seeks past them.
+        keys_.clear();
+        operands_.clear();
+        has_compaction_filter_skip_until_ = true;
+        return Status::OK();
+      }
+      if (filter != CompactionFilter::Decision::kRemove) {
         if (original_key_is_iter) {
           // this is just an optimization that saves us one memcpy
           keys_.push_front(std::move(original_key));
@@ -188,7 +209,11 @@ Status MergeHelper::MergeUntil(InternalIterator* iter,
           // original_key before
           ParseInternalKey(keys_.back(), &orig_ikey);
         }
-        operands_.push_front(value_slice.ToString());
+        if (filter == CompactionFilter::Decision::kChangeValue) {
+          operands_.push_front(compaction_filter_value_);
+        } else {
+          operands_.push_front(value_slice.ToString());
+        }
       }
     }
   }
@@ -213,7 +238,8 @@ Status MergeHelper::MergeUntil(InternalIterator* iter,
   //
   // So, we only perform the following logic (to merge all operands together
   // without a Put/Delete) if we are certain that we have seen the end of key.
-  bool surely_seen_the_beginning = hit_the_next_user_key && at_bottom;
+  bool surely_seen_the_beginning =
+      (hit_the_next_user_key && at_bottom) || hit_range_deletion;
   if (surely_seen_the_beginning) {
     // do a final merge with nullptr as the existing value and say
     // bye to the merge type (it's now converted to a Put)
@@ -291,17 +317,26 @@ void MergeOutputIterator::Next() {
   ++it_values_;
 }
 
-bool MergeHelper::FilterMerge(const Slice& user_key, const Slice& value_slice) {
+CompactionFilter::Decision MergeHelper::FilterMerge(const Slice& user_key,
+                                                    const Slice& value_slice) {
   if (compaction_filter_ == nullptr) {
-    return false;
+    return CompactionFilter::Decision::kKeep;
   }
   if (stats_ != nullptr) {
     filter_timer_.Start();
   }
-  bool to_delete =
-      compaction_filter_->FilterMergeOperand(level_, user_key, value_slice);
+  compaction_filter_value_.clear();
+  compaction_filter_skip_until_.clear();
+  auto ret = compaction_filter_->FilterV2(
+      level_, user_key, CompactionFilter::ValueType::kMergeOperand,
+      value_slice, &compaction_filter_value_, &compaction_filter_skip_until_);
+  if (ret == CompactionFilter::Decision::kRemoveAndSkipUntil &&
+      user_comparator_->Compare(compaction_filter_skip_until_, user_key) <= 0) {
+    // Can't skip backwards, keep the operand as documented for FilterV2()
+    ret = CompactionFilter::Decision::kKeep;
+  }
   total_filter_time_ += filter_timer_.ElapsedNanosSafe();
-  return to_delete;
+  return ret;
 }
 
 } // namespace rocksdb
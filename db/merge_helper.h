@@ -21,6 +21,7 @@ class Comparator;
 class Iterator;
 class Logger;
 class MergeOperator;
+class RangeDelAggregator;
 class Statistics;
 class InternalIterator;
 
@@ -43,6 +44,7 @@ class MergeHelper {
         level_(level),
         keys_(),
         operands_(),
+        has_compaction_filter_skip_until_(false),
         filter_timer_(env_),
         total_filter_time_(0U),
         stats_(stats) {
@@ -64,7 +66,7 @@ class MergeHelper {
 
   // Merge entries until we hit
   //     - a corrupted key
-  //     - a Put/Delete,
+  //     - a Put/Delete, or an entry that range_del_agg deletes,
   //     - a different user key,
   //     - a specific sequence number (snapshot boundary),
   //  or - the end of iteration
@@ -74,9 +76,11 @@ class MergeHelper {
   //                   0 means no restriction
   // at_bottom:   (IN) true if the iterator covers the bottem level, which means
   //                   we could reach the start of the history of this user key.
+  // range_del_agg: (IN) the range deletions of the input, or nullptr
   //
   // Returns one of the following statuses:
-  // - OK: Entries were successfully merged.
+  // - OK: Entries were successfully merged, or the compaction filter asked to
+  //   skip the key, see FilteredUntil().
   // - MergeInProgress: Put/Delete not encountered and unable to merge operands.
   // - Corruption: Merge operator reported unsuccessful merge or a corrupted
   //   key has been encountered and not expected (applies only when compiling
@@ -85,11 +89,27 @@ class MergeHelper {
   // REQUIRED: The first key in the input is not corrupted.
   Status MergeUntil(InternalIterator* iter,
                     const SequenceNumber stop_before = 0,
-                    const bool at_bottom = false);
-
-  // Filters a merge operand using the compaction filter specified
-  // in the constructor. Returns true if the operand should be filtered out.
-  bool FilterMerge(const Slice& user_key, const Slice& value_slice);
+                    const bool at_bottom = false,
+                    RangeDelAggregator* range_del_agg = nullptr);
+
+  // Filters a merge operand using the compaction filter specified in the
+  // constructor. A changed operand is stored in compaction_filter_value_.
+  // kRemoveAndSkipUntil is turned into kKeep if the filter returned a key
+  // to skip to that is not greater than user_key.
+  CompactionFilter::Decision FilterMerge(const Slice& user_key,
+                                         const Slice& value_slice);
+
+  // Returns true, and sets *skip_until to the user key to continue at, if
+  // the compaction filter returned kRemoveAndSkipUntil for an operand during
+  // the last MergeUntil call. The key is then dropped altogether, keys() and
+  // values() are empty and the caller is expected to seek past *skip_until.
+  bool FilteredUntil(Slice* skip_until) const {
+    if (!has_compaction_filter_skip_until_) {
+      return false;
+    }
+    *skip_until = compaction_filter_skip_until_;
+    return true;
+  }
 
   // Query the merge result
   // These are valid until the next MergeUntil call
@@ -137,6 +157,10 @@ class MergeHelper {
   std::deque<std::string> keys_;    // Keeps track of the sequence of keys seen
   std::deque<std::string> operands_;  // Parallel with keys_; stores the values
 
+  std::string compaction_filter_value_;
+  bool has_compaction_filter_skip_until_;
+  std::string compaction_filter_skip_until_;
+
   StopWatchNano filter_timer_;
   uint64_t total_filter_time_;
   Statistics* stats_;
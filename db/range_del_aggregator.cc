@@ -0,0 +1,188 @@
+//  Copyright (c) 2011-present, Facebook, Inc.  All rights reserved.
+//  This source code is licensed under the BSD-style license found in the
+//  LICENSE file in the root directory of this source tree. An additional grant
+//  of patent rights can be found in the PATENTS file in the same directory.
+
+#include "db/range_del_aggregator.h"
+
+#include <algorithm>
+
+#include "db/version_edit.h"
+#include "table/table_builder.h"
+
+namespace rocksdb {
+
+RangeDelAggregator::RangeDelAggregator(
+    const InternalKeyComparator& icmp,
+    const std::vector<SequenceNumber>& snapshots)
+    : icmp_(icmp), snapshots_(snapshots) {
+  assert(std::is_sorted(snapshots_.begin(), snapshots_.end()));
+}
+
+SequenceNumber RangeDelAggregator::StripeUpperBound(SequenceNumber seq) const {
+  auto it = std::lower_bound(snapshots_.begin(), snapshots_.end(), seq);
+  return it == snapshots_.end() ? kMaxSequenceNumber : *it;
+}
+
+bool RangeDelAggregator::ShouldDelete(const ParsedInternalKey& parsed) const {
+  if (stripe_map_.empty()) {
+    return false;
+  }
+  auto stripe = stripe_map_.find(StripeUpperBound(parsed.sequence));
+  if (stripe == stripe_map_.end()) {
+    return false;
+  }
+  const Comparator* ucmp = icmp_.user_comparator();
+  for (const auto& entry : stripe->second) {
+    const RangeTombstone& tombstone = entry.second;
+    if (ucmp->Compare(tombstone.start_key_, parsed.user_key) > 0) {
+      break;
+    }
+    if (tombstone.seq_ > parsed.sequence &&
+        ucmp->Compare(parsed.user_key, tombstone.end_key_) < 0) {
+      return true;
+    }
+  }
+  return false;
+}
+
+bool RangeDelAggregator::ShouldDelete(const Slice& internal_key) const {
+  if (stripe_map_.empty()) {
+    return false;
+  }
+  ParsedInternalKey parsed;
+  if (!ParseInternalKey(internal_key, &parsed)) {
+    assert(false);
+    return false;
+  }
+  return ShouldDelete(parsed);
+}
+
+bool RangeDelAggregator::ShouldDropFile(const FileMetaData& file) const {
+  if (stripe_map_.empty()) {
+    return false;
+  }
+  // All the keys of the file have to be in the stripe of the tombstone
+  const SequenceNumber upper_bound = StripeUpperBound(file.largest_seqno);
+  if (StripeUpperBound(file.smallest_seqno) != upper_bound) {
+    return false;
+  }
+  auto stripe = stripe_map_.find(upper_bound);
+  if (stripe == stripe_map_.end()) {
+    return false;
+  }
+  const Comparator* ucmp = icmp_.user_comparator();
+  const Slice smallest = file.smallest.user_key();
+  const Slice largest = file.largest.user_key();
+  // The end key of a range deletion that bounds the file is exclusive
+  const bool largest_exclusive =
+      ExtractValueType(file.largest.Encode()) == kTypeRangeDeletion;
+  for (const auto& entry : stripe->second) {
+    const RangeTombstone& tombstone = entry.second;
+    if (ucmp->Compare(tombstone.start_key_, smallest) > 0) {
+      break;
+    }
+    if (tombstone.seq_ > file.largest_seqno) {
+      int cmp = ucmp->Compare(largest, tombstone.end_key_);
+      if (cmp < 0 || (cmp == 0 && largest_exclusive)) {
+        return true;
+      }
+    }
+  }
+  return false;
+}
+
+Status RangeDelAggregator::AddTombstones(
+    std::unique_ptr<InternalIterator> input) {
+  if (input == nullptr) {
+    return Status::OK();
+  }
+  for (input->SeekToFirst(); input->Valid(); input->Next()) {
+    ParsedInternalKey parsed;
+    if (!ParseInternalKey(input->key(), &parsed) ||
+        parsed.type != kTypeRangeDeletion) {
+      return Status::Corruption("Unable to parse range tombstone");
+    }
+    RangeTombstone tombstone;
+    tombstone.start_key_ = parsed.user_key.ToString();
+    tombstone.end_key_ = input->value().ToString();
+    tombstone.seq_ = parsed.sequence;
+    auto stripe = stripe_map_.find(StripeUpperBound(parsed.sequence));
+    if (stripe == stripe_map_.end()) {
+      stripe =
+          stripe_map_
+              .emplace(StripeUpperBound(parsed.sequence),
+                       TombstoneMap(UserKeyLess(icmp_.user_comparator())))
+              .first;
+    }
+    stripe->second.emplace(tombstone.start_key_, std::move(tombstone));
+  }
+  return input->status();
+}
+
+void RangeDelAggregator::AddToBuilder(TableBuilder* builder,
+                                      const Slice* lower_bound,
+                                      const Slice* upper_bound,
+                                      FileMetaData* meta,
+                                      bool bottommost_level) const {
+  const Comparator* ucmp = icmp_.user_comparator();
+  const SequenceNumber oldest_stripe =
+      snapshots_.empty() ? kMaxSequenceNumber : snapshots_.front();
+  // The block of the range deletions is written in key order
+  std::vector<std::pair<InternalKey, Slice>> tombstones;
+  for (const auto& stripe : stripe_map_) {
+    if (bottommost_level && stripe.first == oldest_stripe) {
+      continue;
+    }
+    for (const auto& entry : stripe.second) {
+      const RangeTombstone& tombstone = entry.second;
+      if (upper_bound != nullptr &&
+          ucmp->Compare(*upper_bound, tombstone.start_key_) <= 0) {
+        // This and the following tombstones start after the file
+        break;
+      }
+      if (lower_bound != nullptr &&
+          ucmp->Compare(tombstone.end_key_, *lower_bound) <= 0) {
+        continue;
+      }
+      Slice start = tombstone.start_key_;
+      if (lower_bound != nullptr && ucmp->Compare(start, *lower_bound) < 0) {
+        start = *lower_bound;
+      }
+      Slice end = tombstone.end_key_;
+      if (upper_bound != nullptr && ucmp->Compare(*upper_bound, end) < 0) {
+        end = *upper_bound;
+      }
+      if (ucmp->Compare(start, end) >= 0) {
+        continue;
+      }
+      tombstones.emplace_back(
+          InternalKey(start, tombstone.seq_, kTypeRangeDeletion), end);
+    }
+  }
+  std::sort(tombstones.begin(), tombstones.end(),
+            [this](const std::pair<InternalKey, Slice>& a,
+                   const std::pair<InternalKey, Slice>& b) {
+              return icmp_.Compare(a.first, b.first) < 0;
+            });
+
+  for (const auto& tombstone : tombstones) {
+    builder->Add(tombstone.first.Encode(), tombstone.second);
+    // The file covers the range up to, but not including, the end key
+    InternalKey largest(tombstone.second, kMaxSequenceNumber,
+                        kTypeRangeDeletion);
+    if (meta->smallest.size() == 0 ||
+        icmp_.Compare(tombstone.first, meta->smallest) < 0) {
+      meta->smallest = tombstone.first;
+    }
+    if (meta->largest.size() == 0 ||
+        icmp_.Compare(meta->largest, largest) < 0) {
+      meta->largest = largest;
+    }
+    const SequenceNumber seq = GetInternalKeySeqno(tombstone.first.Encode());
+    meta->smallest_seqno = std::min(meta->smallest_seqno, seq);
+    meta->largest_seqno = std::max(meta->largest_seqno, seq);
+  }
+}
+
+}  // namespace rocksdb
@@ -0,0 +1,93 @@
+//  Copyright (c) 2011-present, Facebook, Inc.  All rights reserved.
+//  This source code is licensed under the BSD-style license found in the
+//  LICENSE file in the root directory of this source tree. An additional grant
+//  of patent rights can be found in the PATENTS file in the same directory.
+
+#pragma once
+
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "db/dbformat.h"
+#include "rocksdb/comparator.h"
+#include "rocksdb/slice.h"
+#include "rocksdb/status.h"
+#include "table/internal_iterator.h"
+
+namespace rocksdb {
+
+struct FileMetaData;
+class TableBuilder;
+
+// A RangeDelAggregator collects the range deletions (tombstones) of the
+// memtables and files that a read or a compaction goes through, and tells
+// which keys they delete.
+//
+// A tombstone deletes the keys in [start_key, end_key) that are older than
+// it and in the same snapshot stripe, that is, the keys that no snapshot sees
+// unless it also sees the tombstone. A read passes its sequence number as the
+// only snapshot, so that the tombstones newer than the read are ignored.
+//
+// Tombstones are looked up by a scan of the ones that start before the key,
+// which is fine as long as there are few of them.
+class RangeDelAggregator {
+ public:
+  // @param snapshots the snapshots, sorted in increasing order
+  RangeDelAggregator(const InternalKeyComparator& icmp,
+                     const std::vector<SequenceNumber>& snapshots);
+
+  // Returns whether a tombstone added so far deletes the key
+  bool ShouldDelete(const ParsedInternalKey& parsed) const;
+  bool ShouldDelete(const Slice& internal_key) const;
+
+  // Returns whether a tombstone added so far deletes all the keys of the
+  // file, so that a compaction can drop it without reading it.
+  bool ShouldDropFile(const FileMetaData& file) const;
+
+  // Adds the tombstones of input, whose keys are the internal keys of the
+  // start keys and whose values are the end keys. input may be null.
+  Status AddTombstones(std::unique_ptr<InternalIterator> input);
+
+  // Adds the tombstones that overlap [lower_bound, upper_bound) to builder,
+  // cut to that range, and extends the key range and sequence numbers of
+  // meta to cover them. A null bound means unbounded. If bottommost_level is
+  // set, the tombstones that no snapshot needs are left out: the keys they
+  // delete have been dropped by the compaction that writes the file.
+  void AddToBuilder(TableBuilder* builder, const Slice* lower_bound,
+                    const Slice* upper_bound, FileMetaData* meta,
+                    bool bottommost_level = false) const;
+
+  bool IsEmpty() const { return stripe_map_.empty(); }
+
+ private:
+  struct RangeTombstone {
+    std::string start_key_;
+    std::string end_key_;
+    SequenceNumber seq_;
+  };
+
+  struct UserKeyLess {
+    explicit UserKeyLess(const Comparator* ucmp) : ucmp_(ucmp) {}
+    bool operator()(const std::string& a, const std::string& b) const {
+      return ucmp_->Compare(a, b) < 0;
+    }
+    const Comparator* ucmp_;
+  };
+
+  // The tombstones of a stripe by start key
+  typedef std::multimap<std::string, RangeTombstone, UserKeyLess>
+      TombstoneMap;
+  // The stripes, by the upper bound of their sequence numbers, a snapshot or
+  // kMaxSequenceNumber
+  typedef std::map<SequenceNumber, TombstoneMap> StripeMap;
+
+  SequenceNumber StripeUpperBound(SequenceNumber seq) const;
+
+  const InternalKeyComparator icmp_;
+  const std::vector<SequenceNumber> snapshots_;
+  StripeMap stripe_map_;
+};
+
+}  // namespace rocksdb
@@ -74,13 +74,13 @@
 #include "db/memtable.h"
 #include "db/table_cache.h"
 #include "db/version_edit.h"
-#include "db/writebuffer.h"
 #include "db/write_batch_internal.h"
 #include "rocksdb/comparator.h"
 #include "rocksdb/db.h"
 #include "rocksdb/env.h"
 #include "rocksdb/options.h"
 #include "rocksdb/immutable_options.h"
+#include "rocksdb/write_buffer_manager.h"
 #include "table/scoped_arena_iterator.h"
 #include "util/file_reader_writer.h"
 
@@ -257,7 +257,7 @@ class Repairer {
     std::string scratch;
     Slice record;
     WriteBatch batch;
-    WriteBuffer wb(options_.db_write_buffer_size);
+    WriteBufferManager wb(options_.db_write_buffer_size);
     MemTable* mem =
         new MemTable(icmp_, ioptions_, MutableCFOptions(options_, ioptions_),
                      &wb, kMaxSequenceNumber);
@@ -293,6 +293,8 @@ class Repairer {
       ScopedArenaIterator iter(mem->NewIterator(ro, &arena));
       status = BuildTable(
           dbname_, env_, ioptions_, env_options_, table_cache_, iter.get(),
+          std::unique_ptr<InternalIterator>(
+              mem->NewRangeTombstoneIterator(ro)),
           &meta, icmp_, &int_tbl_prop_collector_factories_,
           TablePropertiesCollectorFactory::Context::kUnknownColumnFamily,
           std::string() /* column_family_name */, {}, kMaxSequenceNumber,
@@ -343,8 +345,9 @@ class Repairer {
     t->meta.fd = FileDescriptor(t->meta.fd.GetNumber(), t->meta.fd.GetPathId(),
                                 file_size);
     if (status.ok()) {
+      TableReader* table_reader = nullptr;
       InternalIterator* iter = table_cache_->NewIterator(
-          ReadOptions(), env_options_, icmp_, t->meta.fd);
+          ReadOptions(), env_options_, icmp_, t->meta.fd, &table_reader);
       bool empty = true;
       ParsedInternalKey parsed;
       t->min_sequence = 0;
@@ -374,6 +377,41 @@ class Repairer {
       if (!iter->status().ok()) {
         status = iter->status();
       }
+      // The key range of the table covers its range deletions too
+      std::unique_ptr<InternalIterator> range_del_iter(
+          status.ok() && table_reader != nullptr
+              ? table_reader->NewRangeTombstoneIterator(ReadOptions())
+              : nullptr);
+      if (range_del_iter != nullptr) {
+        for (range_del_iter->SeekToFirst(); range_del_iter->Valid();
+             range_del_iter->Next()) {
+          Slice key = range_del_iter->key();
+          if (!ParseInternalKey(key, &parsed)) {
+            Log(InfoLogLevel::ERROR_LEVEL, options_.info_log,
+                "Table #%" PRIu64 ": unparsable range deletion %s",
+                t->meta.fd.GetNumber(), EscapeString(key).c_str());
+            continue;
+          }
+          counter++;
+          InternalKey start;
+          start.DecodeFrom(key);
+          InternalKey end(range_del_iter->value(), kMaxSequenceNumber,
+                          kTypeRangeDeletion);
+          if (empty || icmp_.Compare(start, t->meta.smallest) < 0) {
+            t->meta.smallest = start;
+          }
+          if (empty || icmp_.Compare(t->meta.largest, end) < 0) {
+            t->meta.largest = end;
+          }
+          empty = false;
+          if (parsed.sequence > t->max_sequence) {
+            t->max_sequence = parsed.sequence;
+          }
+        }
+        if (!range_del_iter->status().ok()) {
+          status = range_del_iter->status();
+        }
+      }
       delete iter;
     }
     Log(InfoLogLevel::INFO_LEVEL,
@@ -10,7 +10,9 @@
 // Thread safety
 // -------------
 //
-// Writes require external synchronization, most likely a mutex.
+// Writes require external synchronization, most likely a mutex, unless
+// they all go through InsertConcurrently, which can be safely called
+// concurrently with reads and with other concurrent inserts.
 // Reads require a guarantee that the SkipList will not be destroyed
 // while the read is in progress.  Apart from that, reads progress
 // without any internal locking or synchronization.
@@ -56,6 +58,9 @@ class SkipList {
   // REQUIRES: nothing that compares equal to key is currently in the list.
   void Insert(const Key& key);
 
+  // Like Insert, but external synchronization is not required.
+  void InsertConcurrently(const Key& key);
+
   // Returns true iff an entry that compares equal to key is in the list.
   bool Contains(const Key& key) const;
 
@@ -107,6 +112,8 @@ class SkipList {
   };
 
  private:
+  enum MaxPossibleHeightEnum : uint16_t { kMaxPossibleHeight = 32 };
+
   const uint16_t kMaxHeight_;
   const uint16_t kBranching_;
   const uint32_t kScaledInverseBranching_;
@@ -125,8 +132,10 @@ class SkipList {
   // i up to max_height_ is the predecessor of prev_[0] and prev_height_
   // is the height of prev_[0].  prev_[0] can only be equal to head before
   // insertion, in which case max_height_ and prev_height_ are 1.
+  // InsertConcurrently sets prev_height_ to 0 when it may have broken
+  // that, so that the next Insert does a full search.
   Node** prev_;
-  int32_t prev_height_;
+  std::atomic<int32_t> prev_height_;
 
   inline int GetMaxHeight() const {
     return max_height_.load(std::memory_order_relaxed);
@@ -149,6 +158,15 @@ class SkipList {
   // level in [0..max_height_-1], if prev is non-null.
   Node* FindLessThan(const Key& key, Node** prev = nullptr) const;
 
+  // Traverses a single level of the list, setting *out_prev to the last
+  // node before the key and *out_next to the first node after. Assumes
+  // that the key is not present in the skip list. On entry, before should
+  // point to a node that is before the key, and after should point to
+  // a node that is after the key. after should be nullptr if a good after
+  // node isn't conveniently available.
+  void FindLevelSplice(const Key& key, Node* before, Node* after, int level,
+                       Node** out_prev, Node** out_next);
+
   // Return the last node in the list.
   // Return head_ if list is empty.
   Node* FindLast() const;
@@ -190,6 +208,11 @@ struct SkipList<Key, Comparator>::Node {
     next_[n].store(x, std::memory_order_relaxed);
   }
 
+  bool CASNext(int n, Node* expected, Node* x) {
+    assert(n >= 0);
+    return next_[n].compare_exchange_strong(expected, x);
+  }
+
  private:
   // Array of length equal to the node height.  next_[0] is lowest level link.
   std::atomic<Node*> next_[1];
@@ -271,6 +294,7 @@ int SkipList<Key, Comparator>::RandomHeight() {
   }
   assert(height > 0);
   assert(height <= kMaxHeight_);
+  assert(height <= kMaxPossibleHeight);
   return height;
 }
 
@@ -398,6 +422,7 @@ SkipList<Key, Comparator>::SkipList(const Comparator cmp, Allocator* allocator,
       max_height_(1),
       prev_height_(1) {
   assert(max_height > 0 && kMaxHeight_ == static_cast<uint32_t>(max_height));
+  assert(max_height <= kMaxPossibleHeight);
   assert(branching_factor > 0 &&
          kBranching_ == static_cast<uint32_t>(branching_factor));
   assert(kScaledInverseBranching_ > 0);
@@ -414,16 +439,22 @@ SkipList<Key, Comparator>::SkipList(const Comparator cmp, Allocator* allocator,
 
 template<typename Key, class Comparator>
 void SkipList<Key, Comparator>::Insert(const Key& key) {
+  // InsertConcurrently can't maintain the prev_ invariants, and sets
+  // prev_height_ to zero when it may have broken them. A relaxed load
+  // suffices because write thread synchronization separates Insert calls
+  // from InsertConcurrently calls.
+  auto prev_height = prev_height_.load(std::memory_order_relaxed);
+
   // fast path for sequential insertion
-  if (!KeyIsAfterNode(key, prev_[0]->NoBarrier_Next(0)) &&
+  if (prev_height > 0 && !KeyIsAfterNode(key, prev_[0]->NoBarrier_Next(0)) &&
       (prev_[0] == head_ || KeyIsAfterNode(key, prev_[0]))) {
-    assert(prev_[0] != head_ || (prev_height_ == 1 && GetMaxHeight() == 1));
+    assert(prev_[0] != head_ || (prev_height == 1 && GetMaxHeight() == 1));
 
     // Outside of this method prev_[1..max_height_] is the predecessor
     // of prev_[0], and prev_height_ refers to prev_[0].  Inside Insert
     // prev_[0..max_height - 1] is the predecessor of key.  Switch from
     // the external state to the internal
-    for (int i = 1; i < prev_height_; i++) {
+    for (int i = 1; i < prev_height; i++) {
       prev_[i] = prev_[0];
     }
   } else {
@@ -461,7 +492,77 @@ void SkipList<Key, Comparator>::Insert(const Key& key) {
     prev_[i]->SetNext(i, x);
   }
   prev_[0] = x;
-  prev_height_ = height;
+  prev_height_.store(height, std::memory_order_relaxed);
+}
+
+template <typename Key, class Comparator>
+void SkipList<Key, Comparator>::FindLevelSplice(const Key& key, Node* before,
+                                                Node* after, int level,
+                                                Node** out_prev,
+                                                Node** out_next) {
+  while (true) {
+    Node* next = before->Next(level);
+    assert(before == head_ || next == nullptr ||
+           KeyIsAfterNode(next->key, before));
+    assert(before == head_ || KeyIsAfterNode(key, before));
+    if (next == after || !KeyIsAfterNode(key, next)) {
+      // found it
+      *out_prev = before;
+      *out_next = next;
+      return;
+    }
+    before = next;
+  }
+}
+
+template <typename Key, class Comparator>
+void SkipList<Key, Comparator>::InsertConcurrently(const Key& key) {
+  int height = RandomHeight();
+
+  // Like in InlineSkipList, the sequential-insertion cache is invalidated
+  // rather than maintained. It can only be broken by a node taller than
+  // one level, and prev_height_ is only written if nobody else has, to
+  // avoid invalidating it in all of the other CPU caches.
+  if (height > 1 && prev_height_.load(std::memory_order_relaxed) != 0) {
+    prev_height_.store(0, std::memory_order_relaxed);
+  }
+
+  int max_height = max_height_.load(std::memory_order_relaxed);
+  while (height > max_height) {
+    if (max_height_.compare_exchange_strong(max_height, height)) {
+      // successfully updated it
+      max_height = height;
+      break;
+    }
+    // else retry, possibly exiting the loop because somebody else
+    // increased it
+  }
+  assert(max_height <= kMaxPossibleHeight);
+
+  Node* prev[kMaxPossibleHeight + 1];
+  Node* next[kMaxPossibleHeight + 1];
+  prev[max_height] = head_;
+  next[max_height] = nullptr;
+  for (int i = max_height - 1; i >= 0; --i) {
+    FindLevelSplice(key, prev[i + 1], next[i + 1], i, &prev[i], &next[i]);
+  }
+
+  // Our data structure does not allow duplicate insertion
+  assert(next[0] == nullptr || !Equal(key, next[0]->key));
+
+  Node* x = NewNode(key, height);
+  for (int i = 0; i < height; ++i) {
+    while (true) {
+      x->NoBarrier_SetNext(i, next[i]);
+      if (prev[i]->CASNext(i, next[i], x)) {
+        // success
+        break;
+      }
+      // CAS failed, another insert got between prev[i] and next[i], so
+      // search again from prev[i]
+      FindLevelSplice(key, prev[i], nullptr, i, &prev[i], &next[i]);
+    }
+  }
 }
 
 template<typename Key, class Comparator>
@@ -11,6 +11,7 @@
 #include <set>
 #include "rocksdb/env.h"
 #include "util/arena.h"
+#include "util/concurrent_arena.h"
 #include "util/hash.h"
 #include "util/random.h"
 #include "util/testharness.h"
@@ -152,9 +153,10 @@ TEST_F(SkipTest, InsertAndLookup) {
 // check that it is either expected given the initial snapshot or has
 // been concurrently added since the iterator started.
 class ConcurrentTest {
- private:
+ public:
   static const uint32_t K = 4;
 
+ private:
   static uint64_t key(Key key) { return (key >> 40); }
   static uint64_t gen(Key key) { return (key >> 8) & 0xffffffffu; }
   static uint64_t hash(Key key) { return key & 0xff; }
@@ -207,10 +209,10 @@ class ConcurrentTest {
   // Current state of the test
   State current_;
 
-  Arena arena_;
+  ConcurrentArena arena_;
 
   // SkipList is not protected by mu_.  We just use a single writer
-  // thread to modify it.
+  // thread to modify it, or writers that go through InsertConcurrently.
   SkipList<Key, TestComparator> list_;
 
  public:
@@ -225,6 +227,15 @@ class ConcurrentTest {
     current_.Set(k, g);
   }
 
+  // REQUIRES: No concurrent calls for the same k
+  void ConcurrentWriteStep(uint32_t k) {
+    const int g = current_.Get(k) + 1;
+    const Key new_key = MakeKey(k, g);
+    list_.InsertConcurrently(new_key);
+    ASSERT_EQ(g, current_.Get(k) + 1);
+    current_.Set(k, g);
+  }
+
   void ReadStep(Random* rnd) {
     // Remember the initial committed state of the skiplist.
     State initial_state;
@@ -296,11 +307,27 @@ TEST_F(SkipTest, ConcurrentWithoutThreads) {
   }
 }
 
+TEST_F(SkipTest, ConcurrentInsertWithoutThreads) {
+  ConcurrentTest test;
+  Random rnd(test::RandomSeed());
+  for (int i = 0; i < 10000; i++) {
+    test.ReadStep(&rnd);
+    uint32_t base = rnd.Next();
+    for (int j = 0; j < 4; ++j) {
+      test.ConcurrentWriteStep((base + j) % ConcurrentTest::K);
+    }
+    // Plain inserts in between have to cope with what the concurrent ones
+    // did to the sequential-insertion cache
+    test.WriteStep(&rnd);
+  }
+}
+
 class TestState {
  public:
   ConcurrentTest t_;
   int seed_;
   std::atomic<bool> quit_flag_;
+  std::atomic<uint32_t> next_writer_;
 
   enum ReaderState {
     STARTING,
@@ -309,7 +336,11 @@ class TestState {
   };
 
   explicit TestState(int s)
-      : seed_(s), quit_flag_(false), state_(STARTING), state_cv_(&mu_) {}
+      : seed_(s),
+        quit_flag_(false),
+        state_(STARTING),
+        pending_writers_(0),
+        state_cv_(&mu_) {}
 
   void Wait(ReaderState s) {
     mu_.Lock();
@@ -326,9 +357,27 @@ class TestState {
     mu_.Unlock();
   }
 
+  void AdjustPendingWriters(int delta) {
+    mu_.Lock();
+    pending_writers_ += delta;
+    if (pending_writers_ == 0) {
+      state_cv_.Signal();
+    }
+    mu_.Unlock();
+  }
+
+  void WaitForPendingWriters() {
+    mu_.Lock();
+    while (pending_writers_ != 0) {
+      state_cv_.Wait();
+    }
+    mu_.Unlock();
+  }
+
  private:
   port::Mutex mu_;
   ReaderState state_;
+  int pending_writers_;
   port::CondVar state_cv_;
 };
 
@@ -344,6 +393,13 @@ static void ConcurrentReader(void* arg) {
   state->Change(TestState::DONE);
 }
 
+static void ConcurrentWriter(void* arg) {
+  TestState* state = reinterpret_cast<TestState*>(arg);
+  uint32_t k = state->next_writer_++ % ConcurrentTest::K;
+  state->t_.ConcurrentWriteStep(k);
+  state->AdjustPendingWriters(-1);
+}
+
 static void RunConcurrent(int run) {
   const int seed = test::RandomSeed() + (run * 100);
   Random rnd(seed);
@@ -364,11 +420,41 @@ static void RunConcurrent(int run) {
   }
 }
 
+static void RunConcurrentInsert(int run, int write_parallelism = 4) {
+  Env::Default()->SetBackgroundThreads(1 + write_parallelism,
+                                       Env::Priority::LOW);
+  const int seed = test::RandomSeed() + (run * 100);
+  Random rnd(seed);
+  const int N = 1000;
+  const int kSize = 1000;
+  for (int i = 0; i < N; i++) {
+    if ((i % 100) == 0) {
+      fprintf(stderr, "Run %d of %d\n", i, N);
+    }
+    TestState state(seed + 1);
+    Env::Default()->Schedule(ConcurrentReader, &state);
+    state.Wait(TestState::RUNNING);
+    for (int k = 0; k < kSize; k += write_parallelism) {
+      state.next_writer_ = rnd.Next();
+      state.AdjustPendingWriters(write_parallelism);
+      for (int p = 0; p < write_parallelism; ++p) {
+        Env::Default()->Schedule(ConcurrentWriter, &state);
+      }
+      state.WaitForPendingWriters();
+    }
+    state.quit_flag_.store(true, std::memory_order_release);
+    state.Wait(TestState::DONE);
+  }
+}
+
 TEST_F(SkipTest, Concurrent1) { RunConcurrent(1); }
 TEST_F(SkipTest, Concurrent2) { RunConcurrent(2); }
 TEST_F(SkipTest, Concurrent3) { RunConcurrent(3); }
 TEST_F(SkipTest, Concurrent4) { RunConcurrent(4); }
 TEST_F(SkipTest, Concurrent5) { RunConcurrent(5); }
+TEST_F(SkipTest, ConcurrentInsert1) { RunConcurrentInsert(1); }
+TEST_F(SkipTest, ConcurrentInsert2) { RunConcurrentInsert(2); }
+TEST_F(SkipTest, ConcurrentInsert3) { RunConcurrentInsert(3); }
 
 }  // namespace rocksdb
 
@@ -11,6 +11,7 @@
 
 #include "db/dbformat.h"
 #include "db/filename.h"
+#include "db/range_del_aggregator.h"
 #include "db/version_edit.h"
 
 #include "rocksdb/statistics.h"
@@ -166,7 +167,8 @@ InternalIterator* TableCache::NewIterator(
     const ReadOptions& options, const EnvOptions& env_options,
     const InternalKeyComparator& icomparator, const FileDescriptor& fd,
     TableReader** table_reader_ptr, HistogramImpl* file_read_hist,
-    bool for_compaction, Arena* arena, bool skip_filters, int level) {
+    bool for_compaction, Arena* arena, bool skip_filters, int level,
+    RangeDelAggregator* range_del_agg) {
   PERF_TIMER_GUARD(new_table_iterator_nanos);
 
   if (table_reader_ptr != nullptr) {
@@ -201,6 +203,20 @@ InternalIterator* TableCache::NewIterator(
     }
   }
 
+  if (range_del_agg != nullptr) {
+    std::unique_ptr<InternalIterator> range_del_iter(
+        table_reader->NewRangeTombstoneIterator(options));
+    Status s = range_del_agg->AddTombstones(std::move(range_del_iter));
+    if (!s.ok()) {
+      if (create_new_table_reader) {
+        delete table_reader;
+      } else if (handle != nullptr) {
+        ReleaseHandle(handle);
+      }
+      return NewErrorInternalIterator(s, arena);
+    }
+  }
+
   InternalIterator* result =
       table_reader->NewIterator(options, arena, skip_filters);
 
@@ -231,13 +247,48 @@ Status TableCache::Get(const ReadOptions& options,
   Cache::Handle* handle = nullptr;
   std::string* row_cache_entry = nullptr;
 
+  // The range deletions of the file apply to the older files too, so they
+  // are added even if the key is found in the row cache
+  RangeDelAggregator* range_del_agg = get_context->range_del_agg();
+  // The row cache holds what the file alone says about the key, which the
+  // range deletions of newer files and memtables may override
+  const bool may_use_row_cache =
+      range_del_agg == nullptr || range_del_agg->IsEmpty();
+  if (range_del_agg != nullptr) {
+    if (!t) {
+      s = FindTable(env_options_, internal_comparator, fd, &handle,
+                    options.read_tier == kBlockCacheTier /* no_io */,
+                    true /* record_read_stats */, file_read_hist,
+                    skip_filters, level);
+      if (s.ok()) {
+        t = GetTableReaderFromHandle(handle);
+      } else if (options.read_tier == kBlockCacheTier && s.IsIncomplete()) {
+        // Couldn't find Table in cache but treat as kFound if no_io set
+        get_context->MarkKeyMayExist();
+        return Status::OK();
+      } else {
+        return s;
+      }
+    }
+    std::unique_ptr<InternalIterator> range_del_iter(
+        t->NewRangeTombstoneIterator(options));
+    s = range_del_agg->AddTombstones(std::move(range_del_iter));
+    if (!s.ok()) {
+      if (handle != nullptr) {
+        ReleaseHandle(handle);
+      }
+      return s;
+    }
+  }
+
 #ifndef ROCKSDB_LITE
   IterKey row_cache_key;
   std::string row_cache_entry_buffer;
 
   // Check row cache if enabled. Since row cache does not currently store
   // sequence numbers, we cannot use it if we need to fetch the sequence.
-  if (ioptions_.row_cache && !get_context->NeedToReadSequence()) {
+  if (ioptions_.row_cache && !get_context->NeedToReadSequence() &&
+      may_use_row_cache) {
     uint64_t fd_number = fd.GetNumber();
     auto user_key = ExtractUserKey(k);
     // We use the user key as cache key instead of the internal key,
@@ -262,6 +313,9 @@ Status TableCache::Get(const ReadOptions& options,
       replayGetContextLog(*found_row_cache_entry, user_key, get_context);
       ioptions_.row_cache->Release(row_handle);
       RecordTick(ioptions_.statistics, ROW_CACHE_HIT);
+      if (handle != nullptr) {
+        ReleaseHandle(handle);
+      }
       return Status::OK();
     }
 
@@ -30,6 +30,7 @@ struct FileDescriptor;
 class GetContext;
 class HistogramImpl;
 class InternalIterator;
+class RangeDelAggregator;
 
 class TableCache {
  public:
@@ -46,16 +47,20 @@ class TableCache {
   // returned iterator is live.
   // @param skip_filters Disables loading/accessing the filter block
   // @param level The level this table is at, -1 for "not set / don't know"
+  // @param range_del_agg If not null, the range deletions of the file are
+  //    added to it
   InternalIterator* NewIterator(
       const ReadOptions& options, const EnvOptions& toptions,
       const InternalKeyComparator& internal_comparator,
       const FileDescriptor& file_fd, TableReader** table_reader_ptr = nullptr,
       HistogramImpl* file_read_hist = nullptr, bool for_compaction = false,
-      Arena* arena = nullptr, bool skip_filters = false, int level = -1);
+      Arena* arena = nullptr, bool skip_filters = false, int level = -1,
+      RangeDelAggregator* range_del_agg = nullptr);
 
   // If a seek to internal key "k" in specified file finds an entry,
   // call (*handle_result)(arg, found_key, found_value) repeatedly until
-  // it returns false.
+  // it returns false. The range deletions of the file are added to the
+  // RangeDelAggregator of get_context, if it has one.
   // @param skip_filters Disables loading/accessing the filter block
   // @param level The level this table is at, -1 for "not set / don't know"
   Status Get(const ReadOptions& options,
@@ -0,0 +1,64 @@
+//  Copyright (c) 2011-present, Facebook, Inc.  All rights reserved.
+//  This source code is licensed under the BSD-style license found in the
+//  LICENSE file in the root directory of this source tree. An additional grant
+//  of patent rights can be found in the PATENTS file in the same directory.
+
+#include "db/unordered_write_tracker.h"
+
+#include <assert.h>
+#include <algorithm>
+
+#include "db/version_set.h"
+
+namespace rocksdb {
+
+UnorderedWriteTracker::UnorderedWriteTracker(VersionSet* versions)
+    : versions_(versions), last_allocated_sequence_(0) {}
+
+SequenceNumber UnorderedWriteTracker::LastAllocatedSequence() const {
+  return std::max(versions_->LastSequence(),
+                  last_allocated_sequence_.load(std::memory_order_acquire));
+}
+
+void UnorderedWriteTracker::AddGroup(SequenceNumber last_sequence,
+                                     size_t num_writers) {
+  assert(last_sequence > LastAllocatedSequence());
+  assert(num_writers > 0);
+  std::lock_guard<std::mutex> lock(mutex_);
+  pending_groups_[last_sequence] = num_writers;
+  last_allocated_sequence_.store(last_sequence, std::memory_order_release);
+}
+
+void UnorderedWriteTracker::CompleteWriter(SequenceNumber sequence) {
+  std::unique_lock<std::mutex> lock(mutex_);
+  // The group of this writer is the first one ending at or after sequence.
+  auto group = pending_groups_.lower_bound(sequence);
+  assert(group != pending_groups_.end());
+  assert(group->second > 0);
+  const SequenceNumber group_last_sequence = group->first;
+  group->second--;
+
+  // Publish every leading group whose writers have all completed.
+  bool published = false;
+  while (!pending_groups_.empty() && pending_groups_.begin()->second == 0) {
+    versions_->SetLastSequence(pending_groups_.begin()->first);
+    pending_groups_.erase(pending_groups_.begin());
+    published = true;
+  }
+  if (published) {
+    cv_.notify_all();
+  }
+
+  while (versions_->LastSequence() < group_last_sequence) {
+    cv_.wait(lock);
+  }
+}
+
+void UnorderedWriteTracker::WaitForPendingWrites() {
+  std::unique_lock<std::mutex> lock(mutex_);
+  while (!pending_groups_.empty()) {
+    cv_.wait(lock);
+  }
+}
+
+}  // namespace rocksdb
@@ -0,0 +1,73 @@
+//  Copyright (c) 2011-present, Facebook, Inc.  All rights reserved.
+//  This source code is licensed under the BSD-style license found in the
+//  LICENSE file in the root directory of this source tree. An additional grant
+//  of patent rights can be found in the PATENTS file in the same directory.
+
+#pragma once
+
+#include <stdint.h>
+#include <atomic>
+#include <condition_variable>
+#include <map>
+#include <mutex>
+
+#include "rocksdb/types.h"
+
+namespace rocksdb {
+
+class VersionSet;
+
+// UnorderedWriteTracker publishes sequence numbers for writes whose memtable
+// inserts are performed out of order (DBOptions::unordered_write).
+//
+// A write group leader allocates a contiguous range of sequence numbers and
+// registers it with AddGroup() before it releases the write queue. Every
+// writer of the group then inserts its batch into the memtable on its own
+// thread, concurrently with later groups, and reports completion with
+// CompleteWriter(). The last sequence of a group is made visible through
+// VersionSet::SetLastSequence() only once all the writers of that group and
+// of all earlier groups have completed, so readers never observe a sequence
+// number whose data is not fully in the memtable.
+class UnorderedWriteTracker {
+ public:
+  explicit UnorderedWriteTracker(VersionSet* versions);
+
+  // Returns the last sequence number handed out to a write group, which is
+  // at least VersionSet::LastSequence().  Safe to call from any thread.
+  SequenceNumber LastAllocatedSequence() const;
+
+  // Registers a write group whose sequence numbers end at last_sequence and
+  // whose memtable inserts are performed by num_writers writers.
+  // REQUIRES: called by the write group leader, with num_writers > 0 and
+  // last_sequence larger than any previously allocated sequence.
+  void AddGroup(SequenceNumber last_sequence, size_t num_writers);
+
+  // Reports that the writer whose batch starts at sequence has finished its
+  // memtable insert, and waits until the sequence number of its group has
+  // been published, so that the writer can read its own write once this
+  // returns.
+  void CompleteWriter(SequenceNumber sequence);
+
+  // Blocks until every registered group has been published. Used before
+  // operations that need the memtables to be quiescent, such as switching
+  // the memtable or dropping a column family.
+  // REQUIRES: called by the write group leader or from EnterUnbatched(),
+  // so that no new group can be registered concurrently.
+  void WaitForPendingWrites();
+
+ private:
+  VersionSet* versions_;
+  std::atomic<SequenceNumber> last_allocated_sequence_;
+
+  // Guards pending_groups_ and is the mutex of cv_.
+  std::mutex mutex_;
+  std::condition_variable cv_;
+  // Last sequence of each unpublished group -> writers yet to complete.
+  std::map<SequenceNumber, size_t> pending_groups_;
+
+  // No copying allowed
+  UnorderedWriteTracker(const UnorderedWriteTracker&) = delete;
+  void operator=(const UnorderedWriteTracker&) = delete;
+};
+
+}  // namespace rocksdb
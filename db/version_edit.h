@@ -91,6 +91,11 @@ struct FileMetaData {
   bool marked_for_compaction;  // True if client asked us nicely to compact this
                                // file.
 
+  // The time the data of the file was written, in seconds since the epoch;
+  // 0 until known. Like the stats above, it is filled in from the table
+  // properties by the LogAndApply thread.
+  uint64_t creation_time;
+
   FileMetaData()
       : refs(0),
         being_compacted(false),
@@ -103,7 +108,8 @@ struct FileMetaData {
         raw_key_size(0),
         raw_value_size(0),
         init_stats_from_file(false),
-        marked_for_compaction(false) {}
+        marked_for_compaction(false),
+        creation_time(0) {}
 
   // REQUIRED: Keys must be given to the function in sorted order (it expects
   // the last key to be the largest).
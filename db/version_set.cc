@@ -30,11 +30,12 @@
 #include "db/log_writer.h"
 #include "db/memtable.h"
 #include "db/merge_context.h"
+#include "db/range_del_aggregator.h"
 #include "db/table_cache.h"
 #include "db/version_builder.h"
-#include "db/writebuffer.h"
 #include "rocksdb/env.h"
 #include "rocksdb/merge_operator.h"
+#include "rocksdb/write_buffer_manager.h"
 #include "table/format.h"
 #include "table/get_context.h"
 #include "table/internal_iterator.h"
@@ -486,12 +487,17 @@ class LevelFileNumIterator : public InternalIterator {
 class LevelFileIteratorState : public TwoLevelIteratorState {
  public:
   // @param skip_filters Disables loading/accessing the filter block
-  LevelFileIteratorState(TableCache* table_cache,
-                         const ReadOptions& read_options,
-                         const EnvOptions& env_options,
-                         const InternalKeyComparator& icomparator,
-                         HistogramImpl* file_read_hist, bool for_compaction,
-                         bool prefix_enabled, bool skip_filters, int level)
+  // @param range_del_agg If not null, the range deletions of the files are
+  //    added to it as they are opened
+  // @param compaction_inputs If not null, the files of the level. The ones
+  //    whose keys range_del_agg all deletes by the time they would be opened
+  //    are read as if they were empty.
+  LevelFileIteratorState(
+      TableCache* table_cache, const ReadOptions& read_options,
+      const EnvOptions& env_options, const InternalKeyComparator& icomparator,
+      HistogramImpl* file_read_hist, bool for_compaction, bool prefix_enabled,
+      bool skip_filters, int level, RangeDelAggregator* range_del_agg,
+      const std::vector<FileMetaData*>* compaction_inputs = nullptr)
       : TwoLevelIteratorState(prefix_enabled),
         table_cache_(table_cache),
         read_options_(read_options),
@@ -500,7 +506,14 @@ class LevelFileIteratorState : public TwoLevelIteratorState {
         file_read_hist_(file_read_hist),
         for_compaction_(for_compaction),
         skip_filters_(skip_filters),
-        level_(level) {}
+        level_(level),
+        range_del_agg_(range_del_agg) {
+    if (range_del_agg != nullptr && compaction_inputs != nullptr) {
+      for (FileMetaData* f : *compaction_inputs) {
+        compaction_inputs_.emplace(f->fd.GetNumber(), f);
+      }
+    }
+  }
 
   InternalIterator* NewSecondaryIterator(const Slice& meta_handle) override {
     if (meta_handle.size() != sizeof(FileDescriptor)) {
@@ -509,10 +522,20 @@ class LevelFileIteratorState : public TwoLevelIteratorState {
     } else {
       const FileDescriptor* fd =
           reinterpret_cast<const FileDescriptor*>(meta_handle.data());
+      if (!compaction_inputs_.empty() && !range_del_agg_->IsEmpty()) {
+        auto f = compaction_inputs_.find(fd->GetNumber());
+        if (f != compaction_inputs_.end() &&
+            range_del_agg_->ShouldDropFile(*f->second)) {
+          TEST_SYNC_POINT_CALLBACK("VersionSet::MakeInputIterator:SkipFile",
+                                   f->second);
+          return NewEmptyInternalIterator();
+        }
+      }
       return table_cache_->NewIterator(
           read_options_, env_options_, icomparator_, *fd,
           nullptr /* don't need reference to table*/, file_read_hist_,
-          for_compaction_, nullptr /* arena */, skip_filters_, level_);
+          for_compaction_, nullptr /* arena */, skip_filters_, level_,
+          range_del_agg_);
     }
   }
 
@@ -529,6 +552,8 @@ class LevelFileIteratorState : public TwoLevelIteratorState {
   bool for_compaction_;
   bool skip_filters_;
   int level_;
+  RangeDelAggregator* range_del_agg_;
+  std::unordered_map<uint64_t, FileMetaData*> compaction_inputs_;
 };
 
 // A wrapper of version builder which references the current version in
@@ -781,7 +806,8 @@ uint64_t VersionStorageInfo::GetEstimatedActiveKeys() const {
 
 void Version::AddIterators(const ReadOptions& read_options,
                            const EnvOptions& soptions,
-                           MergeIteratorBuilder* merge_iter_builder) {
+                           MergeIteratorBuilder* merge_iter_builder,
+                           RangeDelAggregator* range_del_agg) {
   assert(storage_info_.finalized_);
 
   if (storage_info_.num_non_empty_levels() == 0) {
@@ -797,7 +823,7 @@ void Version::AddIterators(const ReadOptions& read_options,
     merge_iter_builder->AddIterator(cfd_->table_cache()->NewIterator(
         read_options, soptions, cfd_->internal_comparator(), file.fd, nullptr,
         cfd_->internal_stats()->GetFileReadHist(0), false, arena,
-        false /* skip_filters */, 0 /* level */));
+        false /* skip_filters */, 0 /* level */, range_del_agg));
   }
 
   // For levels > 0, we can use a concatenating iterator that sequentially
@@ -812,7 +838,7 @@ void Version::AddIterators(const ReadOptions& read_options,
                                  cfd_->internal_stats()->GetFileReadHist(level),
                                  false /* for_compaction */,
                                  cfd_->ioptions()->prefix_extractor != nullptr,
-                                 IsFilterSkipped(level), level);
+                                 IsFilterSkipped(level), level, range_del_agg);
       mem = arena->AllocateAligned(sizeof(LevelFileNumIterator));
       auto* first_level_iter = new (mem) LevelFileNumIterator(
           cfd_->internal_comparator(), &storage_info_.LevelFilesBrief(level));
@@ -890,7 +916,8 @@ Version::Version(ColumnFamilyData* column_family_data, VersionSet* vset,
 
 void Version::Get(const ReadOptions& read_options, const LookupKey& k,
                   std::string* value, Status* status,
-                  MergeContext* merge_context, bool* value_found,
+                  MergeContext* merge_context,
+                  RangeDelAggregator* range_del_agg, bool* value_found,
                   bool* key_exists, SequenceNumber* seq) {
   Slice ikey = k.internal_key();
   Slice user_key = k.user_key();
@@ -905,7 +932,7 @@ void Version::Get(const ReadOptions& read_options, const LookupKey& k,
   GetContext get_context(
       user_comparator(), merge_operator_, info_log_, db_statistics_,
       status->ok() ? GetContext::kNotFound : GetContext::kMerge, user_key,
-      value, value_found, merge_context, this->env_, seq);
+      value, value_found, merge_context, this->env_, seq, range_del_agg);
 
   FilePicker fp(
       storage_info_.files_, user_key, ikey, &storage_info_.level_files_brief_,
@@ -1008,6 +1035,7 @@ void Version::PrepareApply(
   storage_info_.GenerateFileIndexer();
   storage_info_.GenerateLevelFilesBrief();
   storage_info_.GenerateLevel0NonOverlapping();
+  ComputeFilesMarkedForPeriodicCompaction(mutable_cf_options);
 }
 
 bool Version::MaybeInitializeFileMetaData(FileMetaData* file_meta) {
@@ -1033,6 +1061,61 @@ bool Version::MaybeInitializeFileMetaData(FileMetaData* file_meta) {
   return true;
 }
 
+void Version::MaybeInitializeFileCreationTime(FileMetaData* file_meta) {
+  if (file_meta->creation_time > 0) {
+    return;
+  }
+  std::shared_ptr<const TableProperties> tp;
+  Status s = GetTableProperties(&tp, file_meta);
+  if (s.ok() && tp != nullptr && tp->creation_time > 0) {
+    file_meta->creation_time = tp->creation_time;
+    return;
+  }
+  uint64_t mtime = 0;
+  s = vset_->env_->GetFileModificationTime(
+      TableFileName(vset_->db_options_->db_paths, file_meta->fd.GetNumber(),
+                    file_meta->fd.GetPathId()),
+      &mtime);
+  if (s.ok()) {
+    file_meta->creation_time = mtime;
+  }
+}
+
+void Version::ComputeFilesMarkedForPeriodicCompaction(
+    const MutableCFOptions& mutable_cf_options) {
+  const ImmutableCFOptions* ioptions = cfd_->ioptions();
+  uint64_t period = 0;
+  if (ioptions->compaction_style == kCompactionStyleLevel) {
+    period = mutable_cf_options.periodic_compaction_seconds;
+  } else if (ioptions->compaction_style == kCompactionStyleFIFO) {
+    period = ioptions->compaction_options_fifo.ttl;
+  }
+  int64_t now = 0;
+  if (period == 0 || !vset_->env_->GetCurrentTime(&now).ok() ||
+      static_cast<uint64_t>(now) < period) {
+    return;
+  }
+  const uint64_t cutoff = static_cast<uint64_t>(now) - period;
+
+  std::vector<std::pair<int, FileMetaData*>> marked_files;
+  for (int level = 0; level < storage_info_.num_levels_; level++) {
+    for (auto* f : storage_info_.files_[level]) {
+      MaybeInitializeFileCreationTime(f);
+      if (f->creation_time > 0 && f->creation_time <= cutoff) {
+        marked_files.emplace_back(level, f);
+      }
+    }
+  }
+  std::stable_sort(marked_files.begin(), marked_files.end(),
+                   [](const std::pair<int, FileMetaData*>& a,
+                      const std::pair<int, FileMetaData*>& b) {
+                     return a.second->creation_time < b.second->creation_time;
+                   });
+  for (const auto& level_file : marked_files) {
+    storage_info_.files_marked_for_periodic_compaction_.push_back(level_file);
+  }
+}
+
 void VersionStorageInfo::UpdateAccumulatedStats(FileMetaData* file_meta) {
   assert(file_meta->init_stats_from_file);
   accumulated_file_size_ += file_meta->fd.GetFileSize();
@@ -1294,13 +1377,30 @@ void VersionStorageInfo::ComputeFilesMarkedForCompaction() {
     }
   }
 
+  std::vector<std::pair<int, FileMetaData*>> marked_files;
   for (int level = 0; level <= last_qualify_level; level++) {
     for (auto* f : files_[level]) {
       if (!f->being_compacted && f->marked_for_compaction) {
-        files_marked_for_compaction_.emplace_back(level, f);
+        marked_files.emplace_back(level, f);
       }
     }
   }
+  // The files with the largest share of deletions first, they slow down the
+  // reads the most
+  auto deletion_density = [](const FileMetaData* f) {
+    return f->num_entries == 0 ? 0.0
+                               : static_cast<double>(f->num_deletions) /
+                                     static_cast<double>(f->num_entries);
+  };
+  std::stable_sort(marked_files.begin(), marked_files.end(),
+                   [&](const std::pair<int, FileMetaData*>& a,
+                       const std::pair<int, FileMetaData*>& b) {
+                     return deletion_density(a.second) >
+                            deletion_density(b.second);
+                   });
+  for (const auto& level_file : marked_files) {
+    files_marked_for_compaction_.push_back(level_file);
+  }
 }
 
 namespace {
@@ -2059,11 +2159,11 @@ struct VersionSet::ManifestWriter {
 
 VersionSet::VersionSet(const std::string& dbname, const DBOptions* db_options,
                        const EnvOptions& storage_options, Cache* table_cache,
-                       WriteBuffer* write_buffer,
+                       WriteBufferManager* write_buffer_manager,
                        WriteController* write_controller)
     : column_family_set_(new ColumnFamilySet(
           dbname, db_options, storage_options, table_cache,
-          write_buffer, write_controller)),
+          write_buffer_manager, write_controller)),
       env_(db_options->env),
       dbname_(dbname),
       db_options_(db_options),
@@ -2792,7 +2892,7 @@ Status VersionSet::ReduceNumberOfLevels(const std::string& dbname,
   std::shared_ptr<Cache> tc(NewLRUCache(options->max_open_files - 10,
                                         options->table_cache_numshardbits));
   WriteController wc(options->delayed_write_rate);
-  WriteBuffer wb(options->db_write_buffer_size);
+  WriteBufferManager wb(options->db_write_buffer_size);
   VersionSet versions(dbname, options, env_options, tc.get(), &wb, &wc);
   Status status;
 
@@ -3273,7 +3373,8 @@ void VersionSet::AddLiveFiles(std::vector<FileDescriptor>* live_list) {
   }
 }
 
-InternalIterator* VersionSet::MakeInputIterator(const Compaction* c) {
+InternalIterator* VersionSet::MakeInputIterator(
+    const Compaction* c, RangeDelAggregator* range_del_agg) {
   auto cfd = c->column_family_data();
   ReadOptions read_options;
   read_options.verify_checksums =
@@ -3295,13 +3396,22 @@ InternalIterator* VersionSet::MakeInputIterator(const Compaction* c) {
     if (c->input_levels(which)->num_files != 0) {
       if (c->level(which) == 0) {
         const LevelFilesBrief* flevel = c->input_levels(which);
+        // From the newest file to the oldest, so that a file is only opened
+        // if the range deletions of the newer ones don't cover it
         for (size_t i = 0; i < flevel->num_files; i++) {
+          if (range_del_agg != nullptr &&
+              range_del_agg->ShouldDropFile(*c->input(which, i))) {
+            TEST_SYNC_POINT_CALLBACK("VersionSet::MakeInputIterator:SkipFile",
+                                     c->input(which, i));
+            continue;
+          }
           list[num++] = cfd->table_cache()->NewIterator(
               read_options, env_options_compactions_,
               cfd->internal_comparator(), flevel->files[i].fd, nullptr,
               nullptr, /* no per level latency histogram*/
               true /* for_compaction */, nullptr /* arena */,
-              false /* skip_filters */, (int)which /* level */);
+              false /* skip_filters */, (int)which /* level */,
+              range_del_agg);
         }
       } else {
         // Create concatenating iterator for the files from this level
@@ -3311,7 +3421,8 @@ InternalIterator* VersionSet::MakeInputIterator(const Compaction* c) {
                 cfd->internal_comparator(),
                 nullptr /* no per level latency histogram */,
                 true /* for_compaction */, false /* prefix enabled */,
-                false /* skip_filters */, (int)which /* level */),
+                false /* skip_filters */, (int)which /* level */,
+                range_del_agg, c->inputs(which)),
             new LevelFileNumIterator(cfd->internal_comparator(),
                                      c->input_levels(which)));
       }
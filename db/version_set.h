@@ -55,12 +55,13 @@ class LookupKey;
 class MemTable;
 class Version;
 class VersionSet;
-class WriteBuffer;
+class WriteBufferManager;
 class MergeContext;
 class ColumnFamilyData;
 class ColumnFamilySet;
 class TableCache;
 class MergeIteratorBuilder;
+class RangeDelAggregator;
 
 // Return the smallest index i such that file_level.files[i]->largest >= key.
 // Return file_level.num_files if there is no such file.
@@ -129,8 +130,8 @@ class VersionStorageInfo {
   void EstimateCompactionBytesNeeded(
       const MutableCFOptions& mutable_cf_options);
 
-  // This computes files_marked_for_compaction_ and is called by
-  // ComputeCompactionScore()
+  // This computes files_marked_for_compaction_, densest in deletions first,
+  // and is called by ComputeCompactionScore()
   void ComputeFilesMarkedForCompaction();
 
   // Generate level_files_brief_ from files_
@@ -241,6 +242,16 @@ class VersionStorageInfo {
     return files_marked_for_compaction_;
   }
 
+  // The files whose data is older than periodic_compaction_seconds, or the
+  // FIFO ttl, oldest first. Some of them may be being compacted.
+  // REQUIRES: This version has been saved (see VersionSet::SaveTo)
+  // REQUIRES: DB mutex held during access
+  const autovector<std::pair<int, FileMetaData*>>&
+  FilesMarkedForPeriodicCompaction() const {
+    assert(finalized_);
+    return files_marked_for_periodic_compaction_;
+  }
+
   int base_level() const { return base_level_; }
 
   // REQUIRES: lock is held
@@ -379,6 +390,11 @@ class VersionStorageInfo {
   // ComputeCompactionScore()
   autovector<std::pair<int, FileMetaData*>> files_marked_for_compaction_;
 
+  // The files that are due for a periodic or a TTL compaction. It is
+  // calculated once, in Version::PrepareApply()
+  autovector<std::pair<int, FileMetaData*>>
+      files_marked_for_periodic_compaction_;
+
   // Level that should be compacted next and its compaction score.
   // Score < 1 means compaction is not strictly needed.  These fields
   // are initialized by Finalize().
@@ -423,9 +439,12 @@ class Version {
  public:
   // Append to *iters a sequence of iterators that will
   // yield the contents of this Version when merged together.
+  // The range deletions of the files are added to range_del_agg, if it is not
+  // null, as the iterators open them.
   // REQUIRES: This version has been saved (see VersionSet::SaveTo)
   void AddIterators(const ReadOptions&, const EnvOptions& soptions,
-                    MergeIteratorBuilder* merger_iter_builder);
+                    MergeIteratorBuilder* merger_iter_builder,
+                    RangeDelAggregator* range_del_agg);
 
   // Lookup the value for key.  If found, store it in *val and
   // return OK.  Else return a non-OK status.
@@ -442,10 +461,14 @@ class Version {
   // If seq is non-null, *seq will be set to the sequence number found
   // for the key if a key was found.
   //
+  // If range_del_agg is non-null, the range deletions of the files looked at
+  // are added to it, and the entries it deletes are treated as deletions.
+  //
   // REQUIRES: lock is not held
   void Get(const ReadOptions&, const LookupKey& key, std::string* val,
            Status* status, MergeContext* merge_context,
-           bool* value_found = nullptr, bool* key_exists = nullptr,
+           RangeDelAggregator* range_del_agg, bool* value_found = nullptr,
+           bool* key_exists = nullptr,
            SequenceNumber* seq = nullptr);
 
   // Loads some stats information from files. Call without mutex held. It needs
@@ -542,6 +565,14 @@ class Version {
   // This accumulated stats will be used in compaction.
   void UpdateAccumulatedStats(bool update_stats);
 
+  // Fills in the creation time of a file written by an older version, from
+  // its table properties or else from its modification time.
+  void MaybeInitializeFileCreationTime(FileMetaData* file_meta);
+
+  // Computes files_marked_for_periodic_compaction_ of the storage info
+  void ComputeFilesMarkedForPeriodicCompaction(
+      const MutableCFOptions& mutable_cf_options);
+
   // Sort all files for this version based on their file size and
   // record results in files_by_compaction_pri_. The largest files are listed
   // first.
@@ -576,7 +607,8 @@ class VersionSet {
  public:
   VersionSet(const std::string& dbname, const DBOptions* db_options,
              const EnvOptions& env_options, Cache* table_cache,
-             WriteBuffer* write_buffer, WriteController* write_controller);
+             WriteBufferManager* write_buffer_manager,
+             WriteController* write_controller);
   ~VersionSet();
 
   // Apply *edit to the current version to form a new descriptor that
@@ -671,7 +703,12 @@ class VersionSet {
 
   // Create an iterator that reads over the compaction inputs for "*c".
   // The caller should delete the iterator when no longer needed.
-  InternalIterator* MakeInputIterator(const Compaction* c);
+  // If range_del_agg is not null, the range deletions of the inputs are added
+  // to it as the files are opened, at the latest when the iterator reaches
+  // their smallest keys, and the files whose keys the range deletions seen
+  // so far all delete are not read.
+  InternalIterator* MakeInputIterator(const Compaction* c,
+                                      RangeDelAggregator* range_del_agg);
 
   // Add all files listed in any live version to *live.
   void AddLiveFiles(std::vector<FileDescriptor>* live_list);
@@ -10,12 +10,12 @@
 
 #include "rocksdb/cache.h"
 #include "rocksdb/write_batch.h"
+#include "rocksdb/write_buffer_manager.h"
 
 #include "db/wal_manager.h"
 #include "db/log_writer.h"
 #include "db/column_family.h"
 #include "db/version_set.h"
-#include "db/writebuffer.h"
 #include "util/file_reader_writer.h"
 #include "util/mock_env.h"
 #include "util/string_util.h"
@@ -104,7 +104,7 @@ class WalManagerTest : public testing::Test {
   EnvOptions env_options_;
   std::shared_ptr<Cache> table_cache_;
   DBOptions db_options_;
-  WriteBuffer write_buffer_;
+  WriteBufferManager write_buffer_;
   std::unique_ptr<VersionSet> versions_;
   std::unique_ptr<WalManager> wal_manager_;
 
@@ -20,6 +20,8 @@
 //    kTypeColumnFamilyDeletion varint32 varstring varstring
 //    kTypeColumnFamilySingleDeletion varint32 varstring varstring
 //    kTypeColumnFamilyMerge varint32 varstring varstring
+//    kTypeRangeDeletion varstring varstring
+//    kTypeColumnFamilyRangeDeletion varint32 varstring varstring
 // varstring :=
 //    len: varint32
 //    data: uint8[len]
@@ -28,6 +30,8 @@
 
 #include <stack>
 #include <stdexcept>
+#include <string>
+#include <unordered_map>
 #include <vector>
 
 #include "db/column_family.h"
@@ -53,6 +57,7 @@ enum ContentFlags : uint32_t {
   HAS_DELETE = 4,
   HAS_SINGLE_DELETE = 8,
   HAS_MERGE = 16,
+  HAS_DELETE_RANGE = 32,
 };
 
 struct BatchContentClassifier : public WriteBatch::Handler {
@@ -73,12 +78,62 @@ struct BatchContentClassifier : public WriteBatch::Handler {
     return Status::OK();
   }
 
+  Status DeleteRangeCF(uint32_t, const Slice&, const Slice&) override {
+    content_flags |= ContentFlags::HAS_DELETE_RANGE;
+    return Status::OK();
+  }
+
   Status MergeCF(uint32_t, const Slice&, const Slice&) override {
     content_flags |= ContentFlags::HAS_MERGE;
     return Status::OK();
   }
 };
 
+// Remembers which writer of a write group updates each key, and stops as
+// soon as a key is found to be updated by two different writers.
+struct GroupKeyChecker : public WriteBatch::Handler {
+  std::unordered_map<std::string, size_t> key_owners;
+  size_t writer = 0;
+  bool disjoint = true;
+
+  Status AddKey(uint32_t column_family_id, const Slice& key) {
+    std::string owned_key;
+    PutVarint32(&owned_key, column_family_id);
+    owned_key.append(key.data(), key.size());
+    auto result = key_owners.emplace(std::move(owned_key), writer);
+    if (!result.second && result.first->second != writer) {
+      disjoint = false;
+    }
+    return Status::OK();
+  }
+
+  Status PutCF(uint32_t column_family_id, const Slice& key,
+               const Slice&) override {
+    return AddKey(column_family_id, key);
+  }
+
+  Status DeleteCF(uint32_t column_family_id, const Slice& key) override {
+    return AddKey(column_family_id, key);
+  }
+
+  Status SingleDeleteCF(uint32_t column_family_id, const Slice& key) override {
+    return AddKey(column_family_id, key);
+  }
+
+  // A range may cover the keys of any other writer
+  Status DeleteRangeCF(uint32_t, const Slice&, const Slice&) override {
+    disjoint = false;
+    return Status::OK();
+  }
+
+  Status MergeCF(uint32_t column_family_id, const Slice& key,
+                 const Slice&) override {
+    return AddKey(column_family_id, key);
+  }
+
+  bool Continue() override { return disjoint; }
+};
+
 }  // anon namespace
 
 
@@ -188,6 +243,10 @@ bool WriteBatch::HasSingleDelete() const {
   return (ComputeContentFlags() & ContentFlags::HAS_SINGLE_DELETE) != 0;
 }
 
+bool WriteBatch::HasDeleteRange() const {
+  return (ComputeContentFlags() & ContentFlags::HAS_DELETE_RANGE) != 0;
+}
+
 bool WriteBatch::HasMerge() const {
   return (ComputeContentFlags() & ContentFlags::HAS_MERGE) != 0;
 }
@@ -240,6 +299,18 @@ Status ReadRecordFromWriteBatch(Slice* input, char* tag,
         return Status::Corruption("bad WriteBatch Delete");
       }
       break;
+    case kTypeColumnFamilyRangeDeletion:
+      if (!GetVarint32(input, column_family)) {
+        return Status::Corruption("bad WriteBatch DeleteRange");
+      }
+    // intentional fallthrough
+    case kTypeRangeDeletion:
+      // for range delete, "key" is begin_key, "value" is end_key
+      if (!GetLengthPrefixedSlice(input, key) ||
+          !GetLengthPrefixedSlice(input, value)) {
+        return Status::Corruption("bad WriteBatch DeleteRange");
+      }
+      break;
     case kTypeColumnFamilyMerge:
       if (!GetVarint32(input, column_family)) {
         return Status::Corruption("bad WriteBatch Merge");
@@ -305,6 +376,13 @@ Status WriteBatch::Iterate(Handler* handler) const {
         s = handler->SingleDeleteCF(column_family, key);
         found++;
         break;
+      case kTypeColumnFamilyRangeDeletion:
+      case kTypeRangeDeletion:
+        assert(content_flags_.load(std::memory_order_relaxed) &
+               (ContentFlags::DEFERRED | ContentFlags::HAS_DELETE_RANGE));
+        s = handler->DeleteRangeCF(column_family, key, value);
+        found++;
+        break;
       case kTypeColumnFamilyMerge:
       case kTypeMerge:
         assert(content_flags_.load(std::memory_order_relaxed) &
@@ -470,6 +548,29 @@ void WriteBatch::SingleDelete(ColumnFamilyHandle* column_family,
   WriteBatchInternal::SingleDelete(this, GetColumnFamilyID(column_family), key);
 }
 
+void WriteBatchInternal::DeleteRange(WriteBatch* b, uint32_t column_family_id,
+                                     const Slice& begin_key,
+                                     const Slice& end_key) {
+  WriteBatchInternal::SetCount(b, WriteBatchInternal::Count(b) + 1);
+  if (column_family_id == 0) {
+    b->rep_.push_back(static_cast<char>(kTypeRangeDeletion));
+  } else {
+    b->rep_.push_back(static_cast<char>(kTypeColumnFamilyRangeDeletion));
+    PutVarint32(&b->rep_, column_family_id);
+  }
+  PutLengthPrefixedSlice(&b->rep_, begin_key);
+  PutLengthPrefixedSlice(&b->rep_, end_key);
+  b->content_flags_.store(b->content_flags_.load(std::memory_order_relaxed) |
+                              ContentFlags::HAS_DELETE_RANGE,
+                          std::memory_order_relaxed);
+}
+
+void WriteBatch::DeleteRange(ColumnFamilyHandle* column_family,
+                             const Slice& begin_key, const Slice& end_key) {
+  WriteBatchInternal::DeleteRange(this, GetColumnFamilyID(column_family),
+                                  begin_key, end_key);
+}
+
 void WriteBatchInternal::Merge(WriteBatch* b, uint32_t column_family_id,
                                const Slice& key, const Slice& value) {
   WriteBatchInternal::SetCount(b, WriteBatchInternal::Count(b) + 1);
@@ -627,8 +728,7 @@ class MemTableInserter : public WriteBatch::Handler {
     if (!moptions->inplace_update_support) {
       mem->Add(sequence_, kTypeValue, key, value, concurrent_memtable_writes_);
     } else if (moptions->inplace_callback == nullptr) {
-      assert(!concurrent_memtable_writes_);
-      mem->Update(sequence_, key, value);
+      mem->Update(sequence_, key, value, concurrent_memtable_writes_);
       RecordTick(moptions->statistics, NUMBER_KEYS_UPDATED);
     } else {
       assert(!concurrent_memtable_writes_);
@@ -714,9 +814,24 @@ class MemTableInserter : public WriteBatch::Handler {
     return DeleteImpl(column_family_id, key, kTypeSingleDeletion);
   }
 
+  virtual Status DeleteRangeCF(uint32_t column_family_id,
+                               const Slice& begin_key,
+                               const Slice& end_key) override {
+    Status seek_status;
+    if (!SeekToColumnFamily(column_family_id, &seek_status)) {
+      ++sequence_;
+      return seek_status;
+    }
+    MemTable* mem = cf_mems_->GetMemTable();
+    mem->Add(sequence_, kTypeRangeDeletion, begin_key, end_key,
+             concurrent_memtable_writes_);
+    sequence_++;
+    CheckMemtableFull();
+    return Status::OK();
+  }
+
   virtual Status MergeCF(uint32_t column_family_id, const Slice& key,
                          const Slice& value) override {
-    assert(!concurrent_memtable_writes_);
     Status seek_status;
     if (!SeekToColumnFamily(column_family_id, &seek_status)) {
       ++sequence_;
@@ -726,7 +841,11 @@ class MemTableInserter : public WriteBatch::Handler {
     auto* moptions = mem->GetMemTableOptions();
     bool perform_merge = false;
 
-    if (moptions->max_successive_merges > 0 && db_ != nullptr) {
+    // Collapsing successive merges reads the operands of the key at
+    // sequence_, which concurrent writers with smaller sequence numbers may
+    // not have inserted yet, so it is skipped for concurrent writes.
+    if (moptions->max_successive_merges > 0 && db_ != nullptr &&
+        !concurrent_memtable_writes_) {
       LookupKey lkey(key, sequence_);
 
       // Count the number of successive merges at the head
@@ -787,7 +906,7 @@ class MemTableInserter : public WriteBatch::Handler {
 
     if (!perform_merge) {
       // Add merge operator to memtable
-      mem->Add(sequence_, kTypeMerge, key, value);
+      mem->Add(sequence_, kTypeMerge, key, value, concurrent_memtable_writes_);
     }
 
     sequence_++;
@@ -866,6 +985,19 @@ void WriteBatchInternal::Append(WriteBatch* dst, const WriteBatch* src) {
       std::memory_order_relaxed);
 }
 
+bool WriteBatchInternal::HasDisjointKeys(
+    const autovector<WriteThread::Writer*>& writers) {
+  GroupKeyChecker checker;
+  for (size_t i = 0; i < writers.size() && checker.disjoint; i++) {
+    if (!writers[i]->CallbackFailed()) {
+      checker.writer = i;
+      // A malformed batch is reported when it is inserted.
+      writers[i]->batch->Iterate(&checker);
+    }
+  }
+  return checker.disjoint;
+}
+
 size_t WriteBatchInternal::AppendedByteSize(size_t leftByteSize,
                                             size_t rightByteSize) {
   if (leftByteSize == 0 || rightByteSize == 0) {
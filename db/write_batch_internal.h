@@ -86,6 +86,9 @@ class WriteBatchInternal {
   static void SingleDelete(WriteBatch* batch, uint32_t column_family_id,
                            const Slice& key);
 
+  static void DeleteRange(WriteBatch* batch, uint32_t column_family_id,
+                          const Slice& begin_key, const Slice& end_key);
+
   static void Merge(WriteBatch* batch, uint32_t column_family_id,
                     const Slice& key, const Slice& value);
 
@@ -159,6 +162,10 @@ class WriteBatchInternal {
 
   static void Append(WriteBatch* dst, const WriteBatch* src);
 
+  // Returns true if no key is updated by the batches of more than one of
+  // the writers.  Writers whose callback failed are skipped.
+  static bool HasDisjointKeys(const autovector<WriteThread::Writer*>& writers);
+
   // Returns the byte size of appending a WriteBatch with ByteSize
   // leftByteSize and a WriteBatch with ByteSize rightByteSize
   static size_t AppendedByteSize(size_t leftByteSize, size_t rightByteSize);
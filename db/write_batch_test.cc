@@ -13,10 +13,10 @@
 #include "db/memtable.h"
 #include "db/column_family.h"
 #include "db/write_batch_internal.h"
-#include "db/writebuffer.h"
 #include "rocksdb/env.h"
 #include "rocksdb/memtablerep.h"
 #include "rocksdb/utilities/write_batch_with_index.h"
+#include "rocksdb/write_buffer_manager.h"
 #include "table/scoped_arena_iterator.h"
 #include "util/logging.h"
 #include "util/string_util.h"
@@ -30,7 +30,7 @@ static std::string PrintContents(WriteBatch* b) {
   Options options;
   options.memtable_factory = factory;
   ImmutableCFOptions ioptions(options);
-  WriteBuffer wb(options.db_write_buffer_size);
+  WriteBufferManager wb(options.db_write_buffer_size);
   MemTable* mem =
       new MemTable(cmp, ioptions, MutableCFOptions(options, ioptions), &wb,
                    kMaxSequenceNumber);
@@ -43,6 +43,7 @@ static std::string PrintContents(WriteBatch* b) {
   int delete_count = 0;
   int single_delete_count = 0;
   int merge_count = 0;
+  int delete_range_count = 0;
   Arena arena;
   ScopedArenaIterator iter(mem->NewIterator(ReadOptions(), &arena));
   for (iter->SeekToFirst(); iter->Valid(); iter->Next()) {
@@ -89,10 +90,30 @@ static std::string PrintContents(WriteBatch* b) {
     state.append("@");
     state.append(NumberToString(ikey.sequence));
   }
+  std::unique_ptr<InternalIterator> range_del_iter(
+      mem->NewRangeTombstoneIterator(ReadOptions()));
+  if (range_del_iter != nullptr) {
+    range_del_iter->SeekToFirst();
+  }
+  for (; range_del_iter != nullptr && range_del_iter->Valid();
+       range_del_iter->Next()) {
+    ParsedInternalKey ikey;
+    EXPECT_TRUE(ParseInternalKey(range_del_iter->key(), &ikey));
+    EXPECT_EQ(kTypeRangeDeletion, ikey.type);
+    state.append("DeleteRange(");
+    state.append(ikey.user_key.ToString());
+    state.append(", ");
+    state.append(range_del_iter->value().ToString());
+    state.append(")@");
+    state.append(NumberToString(ikey.sequence));
+    count++;
+    delete_range_count++;
+  }
   EXPECT_EQ(b->HasPut(), put_count > 0);
   EXPECT_EQ(b->HasDelete(), delete_count > 0);
   EXPECT_EQ(b->HasSingleDelete(), single_delete_count > 0);
   EXPECT_EQ(b->HasMerge(), merge_count > 0);
+  EXPECT_EQ(b->HasDeleteRange(), delete_range_count > 0);
   if (!s.ok()) {
     state.append(s.ToString());
   } else if (count != WriteBatchInternal::Count(b)) {
@@ -274,6 +295,18 @@ TEST_F(WriteBatchTest, MergeNotImplemented) {
   ASSERT_OK(batch.Iterate(&handler));
 }
 
+TEST_F(WriteBatchTest, DeleteRangeNotImplemented) {
+  WriteBatch batch;
+  batch.Put(Slice("k2"), Slice("v2"));
+  batch.DeleteRange(Slice("k1"), Slice("k3"));
+  ASSERT_EQ(2, batch.Count());
+  ASSERT_EQ("Put(k2, v2)@0DeleteRange(k1, k3)@1", PrintContents(&batch));
+
+  // Unlike the other operations, handlers must implement it
+  WriteBatch::Handler handler;
+  ASSERT_TRUE(batch.Iterate(&handler).IsInvalidArgument());
+}
+
 TEST_F(WriteBatchTest, Blob) {
   WriteBatch batch;
   batch.Put(Slice("k1"), Slice("v1"));
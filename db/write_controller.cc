@@ -5,6 +5,7 @@
 
 #include "db/write_controller.h"
 
+#include <algorithm>
 #include <atomic>
 #include <cassert>
 #include "rocksdb/env.h"
@@ -26,6 +27,16 @@ std::unique_ptr<WriteControllerToken> WriteController::GetDelayToken(
   return std::unique_ptr<WriteControllerToken>(new DelayWriteToken(this));
 }
 
+std::unique_ptr<WriteControllerToken> WriteController::GetAdjustedDelayToken(
+    uint64_t write_rate) {
+  if (total_delayed_ == 0) {
+    return GetDelayToken(write_rate);
+  }
+  total_delayed_++;
+  set_delayed_write_rate(write_rate);
+  return std::unique_ptr<WriteControllerToken>(new DelayWriteToken(this));
+}
+
 std::unique_ptr<WriteControllerToken>
 WriteController::GetCompactionPressureToken() {
   ++total_compaction_pressure_;
@@ -34,6 +45,23 @@ WriteController::GetCompactionPressureToken() {
 }
 
 bool WriteController::IsStopped() const { return total_stopped_ > 0; }
+
+void WriteController::RecordCompaction(uint64_t num_bytes, uint64_t micros,
+                                       int num_running) {
+  if (micros == 0 || num_bytes == 0) {
+    return;
+  }
+  const uint64_t kMicrosPerSecond = 1000000;
+  uint64_t throughput = static_cast<uint64_t>(
+      static_cast<double>(num_bytes) / micros * kMicrosPerSecond *
+      std::max(num_running, 1));
+  if (compaction_throughput_ == 0) {
+    compaction_throughput_ = throughput;
+  } else {
+    // Exponential moving average, with the newest sample weighted 1/4
+    compaction_throughput_ = (compaction_throughput_ * 3 + throughput) / 4;
+  }
+}
 // This is inside DB mutex, so we can't sleep and need to minimize
 // frequency to get time.
 // If it turns out to be a performance issue, we can redesign the thread
@@ -25,7 +25,8 @@ class WriteController {
         total_delayed_(0),
         total_compaction_pressure_(0),
         bytes_left_(0),
-        last_refill_time_(0) {
+        last_refill_time_(0),
+        compaction_throughput_(0) {
     set_delayed_write_rate(_delayed_write_rate);
   }
   ~WriteController() = default;
@@ -39,6 +40,12 @@ class WriteController {
   // which returns number of microseconds to sleep.
   std::unique_ptr<WriteControllerToken> GetDelayToken(
       uint64_t delayed_write_rate);
+  // Same as GetDelayToken(), except that if writes are already delayed only
+  // the refill rate of the token bucket shared by all writers changes; the
+  // bucket itself is not reset, so writers that already slept ahead keep
+  // their sleep debt.  Used when the rate is adjusted continuously.
+  std::unique_ptr<WriteControllerToken> GetAdjustedDelayToken(
+      uint64_t delayed_write_rate);
   // When an actor (column family) requests a moderate token, compaction
   // threads will be increased
   std::unique_ptr<WriteControllerToken> GetCompactionPressureToken();
@@ -62,6 +69,13 @@ class WriteController {
   }
   uint64_t delayed_write_rate() const { return delayed_write_rate_; }
 
+  // Reports that a compaction processed num_bytes in micros, while
+  // num_running compactions (including this one) were running.  The samples
+  // are smoothed into an estimate of the aggregate compaction throughput.
+  void RecordCompaction(uint64_t num_bytes, uint64_t micros, int num_running);
+  // Estimated compaction throughput in bytes per second, 0 if unknown.
+  uint64_t compaction_throughput() const { return compaction_throughput_; }
+
  private:
   friend class WriteControllerToken;
   friend class StopWriteToken;
@@ -74,6 +88,7 @@ class WriteController {
   uint64_t bytes_left_;
   uint64_t last_refill_time_;
   uint64_t delayed_write_rate_;
+  uint64_t compaction_throughput_;
 };
 
 class WriteControllerToken {
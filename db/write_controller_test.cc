@@ -41,6 +41,41 @@ TEST_F(WriteControllerTest, ChangeDelayRateTest) {
             controller.GetDelay(&env, 20000000u));
 }
 
+TEST_F(WriteControllerTest, AdjustedDelayTokenKeepsSleepDebt) {
+  TimeSetEnv env;
+  WriteController controller(10000000u);
+  auto delay_token_1 = controller.GetAdjustedDelayToken(10000000u);
+  ASSERT_EQ(static_cast<uint64_t>(2000000),
+            controller.GetDelay(&env, 20000000u));
+
+  // Unlike GetDelayToken(), the sleep debt of 2 seconds is kept when the
+  // rate is adjusted
+  auto delay_token_2 = controller.GetAdjustedDelayToken(20000000u);
+  delay_token_1.reset();
+  ASSERT_EQ(20000000u, controller.delayed_write_rate());
+  ASSERT_EQ(static_cast<uint64_t>(3000000),
+            controller.GetDelay(&env, 20000000u));
+
+  delay_token_2.reset();
+  ASSERT_FALSE(controller.NeedsDelay());
+  ASSERT_EQ(static_cast<uint64_t>(0), controller.GetDelay(&env, 20000000u));
+}
+
+TEST_F(WriteControllerTest, CompactionThroughput) {
+  WriteController controller(10000000u);
+  ASSERT_EQ(0u, controller.compaction_throughput());
+  // 1MB in one second
+  controller.RecordCompaction(1000000u, 1000000u, 1);
+  ASSERT_EQ(1000000u, controller.compaction_throughput());
+  // 1MB in one second each, by three concurrent compactions
+  controller.RecordCompaction(1000000u, 1000000u, 3);
+  ASSERT_EQ(1500000u, controller.compaction_throughput());
+  // Empty samples are ignored
+  controller.RecordCompaction(0u, 1000000u, 1);
+  controller.RecordCompaction(1000000u, 0u, 1);
+  ASSERT_EQ(1500000u, controller.compaction_throughput());
+}
+
 TEST_F(WriteControllerTest, SanityTest) {
   WriteController controller(10000000u);
   auto stop_token_1 = controller.GetStopToken();
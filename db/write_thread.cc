@@ -222,8 +222,8 @@ void WriteThread::JoinBatchGroup(Writer* w) {
   TEST_SYNC_POINT_CALLBACK("WriteThread::JoinBatchGroup:Wait", w);
 
   if (!linked_as_leader) {
-    AwaitState(w,
-               STATE_GROUP_LEADER | STATE_PARALLEL_FOLLOWER | STATE_COMPLETED,
+    AwaitState(w, STATE_GROUP_LEADER | STATE_PARALLEL_FOLLOWER |
+                      STATE_UNORDERED_WRITER | STATE_COMPLETED,
                &ctx);
     TEST_SYNC_POINT_CALLBACK("WriteThread::JoinBatchGroup:DoneWaiting", w);
   }
@@ -372,6 +372,29 @@ void WriteThread::EarlyExitParallelGroup(Writer* w) {
 
 void WriteThread::ExitAsBatchGroupLeader(Writer* leader, Writer* last_writer,
                                          Status status) {
+  ExitGroup(leader, last_writer, status, STATE_COMPLETED);
+}
+
+void WriteThread::ExitAsUnorderedGroupLeader(Writer* leader,
+                                             Writer* last_writer,
+                                             SequenceNumber sequence) {
+  // EnterAsBatchGroupLeader already created the links from leader to
+  // newer writers in the group
+  Writer* w = leader;
+  w->sequence = sequence;
+  while (w != last_writer) {
+    // Writers that won't write don't get sequence allotment
+    if (!w->CallbackFailed()) {
+      sequence += WriteBatchInternal::Count(w->batch);
+    }
+    w = w->link_newer;
+    w->sequence = sequence;
+  }
+  ExitGroup(leader, last_writer, Status::OK(), STATE_UNORDERED_WRITER);
+}
+
+void WriteThread::ExitGroup(Writer* leader, Writer* last_writer, Status status,
+                            uint8_t follower_state) {
   assert(leader->link_older == nullptr);
 
   Writer* head = newest_writer_.load(std::memory_order_acquire);
@@ -412,7 +435,7 @@ void WriteThread::ExitAsBatchGroupLeader(Writer* leader, Writer* last_writer,
     // as it is marked committed the other thread's Await may return and
     // deallocate the Writer.
     auto next = last_writer->link_older;
-    SetState(last_writer, STATE_COMPLETED);
+    SetState(last_writer, follower_state);
 
     last_writer = next;
   }
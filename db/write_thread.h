@@ -32,7 +32,9 @@ class WriteThread {
     // non-parallel informs a follower that its writes have been committed
     // (-> STATE_COMPLETED), or when a leader that has chosen to perform
     // updates in parallel and needs this Writer to apply its batch (->
-    // STATE_PARALLEL_FOLLOWER).
+    // STATE_PARALLEL_FOLLOWER), or when a leader in unordered write mode
+    // hands the memtable insert of this Writer back to it (->
+    // STATE_UNORDERED_WRITER).
     STATE_INIT = 1,
 
     // The state used to inform a waiting Writer that it has become the
@@ -60,6 +62,13 @@ class WriteThread {
     // A state indicating that the thread may be waiting using StateMutex()
     // and StateCondVar()
     STATE_LOCKED_WAITING = 16,
+
+    // A follower whose batch has been written to the WAL by a leader in
+    // unordered write mode.  The leader has already released the write
+    // queue, so the Writer is no longer linked and should apply its batch
+    // to the memtable on its own, starting at Writer::sequence.  This is a
+    // terminal state.
+    STATE_UNORDERED_WRITER = 32,
   };
 
   struct Writer;
@@ -181,7 +190,9 @@ class WriteThread {
   // STATE_GROUP_LEADER.  If w has been made part of a sequential batch
   // group and the leader has performed the write, returns STATE_DONE.
   // If w has been made part of a parallel batch group and is reponsible
-  // for updating the memtable, returns STATE_PARALLEL_FOLLOWER.
+  // for updating the memtable, returns STATE_PARALLEL_FOLLOWER.  If the
+  // leader has written w's batch to the WAL in unordered write mode and w
+  // should update the memtable on its own, returns STATE_UNORDERED_WRITER.
   //
   // The db mutex SHOULD NOT be held when calling this function, because
   // it will block.
@@ -229,6 +240,18 @@ class WriteThread {
   void ExitAsBatchGroupLeader(Writer* leader, Writer* last_writer,
                               Status status);
 
+  // Assigns each Writer of the group its starting sequence number, then
+  // unlinks the group like ExitAsBatchGroupLeader, except that the
+  // non-leaders are moved to STATE_UNORDERED_WRITER instead of
+  // STATE_COMPLETED.  The next leader may start as soon as this returns,
+  // while the members of this group are still updating the memtable.
+  //
+  // Writer* leader:          From EnterAsBatchGroupLeader
+  // Writer* last_writer:     Value of out-param of EnterAsBatchGroupLeader
+  // SequenceNumber sequence: Starting sequence number to assign to Writer-s
+  void ExitAsUnorderedGroupLeader(Writer* leader, Writer* last_writer,
+                                  SequenceNumber sequence);
+
   // Waits for all preceding writers (unlocking mu while waiting), then
   // registers w as the currently proceeding writer.
   //
@@ -276,6 +299,11 @@ class WriteThread {
   // Computes any missing link_newer links.  Should not be called
   // concurrently with itself.
   void CreateMissingNewerLinks(Writer* head);
+
+  // Unlinks the Writer-s in a batch group, hands leadership to the next
+  // writer (if any), and moves the non-leaders to follower_state.
+  void ExitGroup(Writer* leader, Writer* last_writer, Status status,
+                 uint8_t follower_state);
 };
 
 }  // namespace rocksdb
@@ -32,6 +32,7 @@ namespace rocksdb {
 using std::shared_ptr;
 
 class Cache;
+class MemoryAllocator;
 
 // Create a new cache with a fixed size capacity. The cache is sharded
 // to 2^num_shard_bits shards, by hash of the key. The total capacity
@@ -39,10 +40,16 @@ class Cache;
 //
 // The parameter num_shard_bits defaults to 4, and strict_capacity_limit
 // defaults to false.
+//
+// If memory_allocator is not null, block based tables that use the cache as
+// their block cache allocate the data blocks they read from it.
 extern shared_ptr<Cache> NewLRUCache(size_t capacity);
 extern shared_ptr<Cache> NewLRUCache(size_t capacity, int num_shard_bits);
 extern shared_ptr<Cache> NewLRUCache(size_t capacity, int num_shard_bits,
                                      bool strict_capacity_limit);
+extern shared_ptr<Cache> NewLRUCache(
+    size_t capacity, int num_shard_bits, bool strict_capacity_limit,
+    shared_ptr<MemoryAllocator> memory_allocator);
 
 class Cache {
  public:
@@ -150,6 +157,10 @@ class Cache {
   // Prerequisit: no entry is referenced.
   virtual void EraseUnRefEntries() = 0;
 
+  // Returns the allocator of the memory of the values that are inserted into
+  // the cache, or nullptr if they are allocated with new[].
+  virtual MemoryAllocator* memory_allocator() const { return nullptr; }
+
  private:
   void LRU_Remove(Handle* e);
   void LRU_Append(Handle* e);
@@ -9,6 +9,7 @@
 #ifndef STORAGE_ROCKSDB_INCLUDE_COMPACTION_FILTER_H_
 #define STORAGE_ROCKSDB_INCLUDE_COMPACTION_FILTER_H_
 
+#include <cassert>
 #include <memory>
 #include <string>
 #include <vector>
@@ -32,6 +33,20 @@ struct CompactionFilterContext {
 
 class CompactionFilter {
  public:
+  // The type of the entry passed to FilterV2()
+  enum class ValueType {
+    kValue,
+    kMergeOperand,
+  };
+
+  // The decision of FilterV2() about an entry
+  enum class Decision {
+    kKeep,
+    kRemove,
+    kChangeValue,
+    kRemoveAndSkipUntil,
+  };
+
   // Context information of a compaction run
   struct Context {
     // Does this compaction run include all data files
@@ -88,7 +103,9 @@ class CompactionFilter {
                       const Slice& key,
                       const Slice& existing_value,
                       std::string* new_value,
-                      bool* value_changed) const = 0;
+                      bool* value_changed) const {
+    return false;
+  }
 
   // The compaction process invokes this method on every merge operand. If this
   // method returns true, the merge operand will be ignored and not written out
@@ -104,6 +121,53 @@ class CompactionFilter {
     return false;
   }
 
+  // An extended version of Filter() and FilterMergeOperand(), which by
+  // default calls them. It is called for values, the first occurrence of a
+  // key, and merge operands, under the same conditions and with the same
+  // thread-safety requirements as those. value_type tells which one
+  // existing_value is.
+  //
+  // The returned decision is one of:
+  // kKeep - keep the entry unchanged.
+  // kRemove - remove the entry. A value is replaced by a deletion marker,
+  //   a merge operand is dropped.
+  // kChangeValue - keep the entry with the value or operand set to
+  //   *new_value.
+  // kRemoveAndSkipUntil - remove the entry and all entries of the following
+  //   keys, up to but not including *skip_until, without passing them to
+  //   the filter. The compaction seeks past them, so the data blocks that
+  //   only hold skipped keys are not even read. *skip_until must be greater
+  //   than key, otherwise the entry is kept. Unlike kRemove, this leaves no
+  //   deletion markers behind, so it is meant for ranges of keys that are
+  //   all known to be dead, e.g. all keys of an expired prefix. Caveats:
+  //   - The skipped entries are removed even if a snapshot can still see
+  //     them, as if IgnoreSnapshots() returned true.
+  //   - Older versions of the skipped keys that are in levels not part of
+  //     this compaction reappear, as there are no deletion markers to hide
+  //     them.
+  //   - Doesn't work with PlainTableFactory in prefix mode, which can't
+  //     seek across prefixes.
+  virtual Decision FilterV2(int level, const Slice& key, ValueType value_type,
+                            const Slice& existing_value, std::string* new_value,
+                            std::string* skip_until) const {
+    switch (value_type) {
+      case ValueType::kValue: {
+        bool value_changed = false;
+        bool rv = Filter(level, key, existing_value, new_value, &value_changed);
+        if (rv) {
+          return Decision::kRemove;
+        }
+        return value_changed ? Decision::kChangeValue : Decision::kKeep;
+      }
+      case ValueType::kMergeOperand: {
+        bool rv = FilterMergeOperand(level, key, existing_value);
+        return rv ? Decision::kRemove : Decision::kKeep;
+      }
+    }
+    assert(false);
+    return Decision::kKeep;
+  }
+
   // By default, compaction will only call Filter() on keys written after the
   // most recent call to GetSnapshot(). However, if the compaction filter
   // overrides IgnoreSnapshots to make it return false, the compaction filter
@@ -0,0 +1,41 @@
+//  Copyright (c) 2011-present, Facebook, Inc.  All rights reserved.
+//  This source code is licensed under the BSD-style license found in the
+//  LICENSE file in the root directory of this source tree. An additional grant
+//  of patent rights can be found in the PATENTS file in the same directory.
+
+#pragma once
+
+#include <string>
+
+#include "rocksdb/status.h"
+
+namespace rocksdb {
+
+// CompactionService allows the key/value processing of compactions to be
+// offloaded from the DB process, e.g. to another process on the same host or
+// to a pool of workers. When DBOptions::compaction_service is set, every
+// (sub)compaction is serialized into an opaque string and handed to Run().
+// The executor is expected to pass that string to DB::OpenAndCompact() on a
+// host that can read the DB directory, and return the serialized result it
+// produces. The DB then moves the output files into place and installs them
+// like the outputs of a local compaction.
+//
+// If Run() returns a non-OK status, or the result can't be installed, the DB
+// runs the compaction locally instead.
+//
+// Run() may be called concurrently from different compaction threads.
+class CompactionService {
+ public:
+  virtual ~CompactionService() {}
+
+  // The name of the service, used in the info log.
+  virtual const char* Name() const = 0;
+
+  // Executes the compaction described by `input` against the DB at `db_name`.
+  // `job_id` is the id of the compaction job in the info log of the DB, and
+  // is shared by the subcompactions of a job.
+  virtual Status Run(const std::string& db_name, int job_id,
+                     const std::string& input, std::string* result) = 0;
+};
+
+}  // namespace rocksdb
@@ -135,6 +135,20 @@ class DB {
       std::vector<ColumnFamilyHandle*>* handles, DB** dbptr,
       bool error_if_log_file_exist = false);
 
+  // Run a compaction on behalf of the DB named `name`, which is opened read
+  // only for that purpose. `input` is a compaction serialized by the DB for
+  // its CompactionService. The output files are written to the directory
+  // `output_directory`, and a description of them is stored in *result, to
+  // be returned by CompactionService::Run(). The column family of the
+  // compaction is opened with `options`, which must be compatible with the
+  // options of the DB, e.g. use the same comparator and merge operator.
+  //
+  // Not supported in ROCKSDB_LITE, in which case the function will
+  // return Status::NotSupported.
+  static Status OpenAndCompact(const Options& options, const std::string& name,
+                               const std::string& output_directory,
+                               const std::string& input, std::string* result);
+
   // Open DB with column families.
   // db_options specify database specific options
   // column_families is the vector of all column families in the database,
@@ -219,6 +233,27 @@ class DB {
     return SingleDelete(options, DefaultColumnFamily(), key);
   }
 
+  // Removes the database entries in the range ["begin_key", "end_key"), i.e.,
+  // including "begin_key" and excluding "end_key". Returns OK on success, and
+  // a non-OK status on error. It is not an error if no keys exist in the range
+  // ["begin_key", "end_key").
+  //
+  // The range is kept as a single tombstone until compactions drop the keys
+  // it covers, and a compaction drops the files that it covers entirely
+  // without reading them. Reads check the keys they find against the
+  // tombstones, so a large number of them slows reads down.
+  //
+  // Only supported with block based tables.
+  //
+  // Note: consider setting options.sync = true.
+  virtual Status DeleteRange(const WriteOptions& options,
+                             ColumnFamilyHandle* column_family,
+                             const Slice& begin_key, const Slice& end_key);
+  virtual Status DeleteRange(const WriteOptions& options,
+                             const Slice& begin_key, const Slice& end_key) {
+    return DeleteRange(options, DefaultColumnFamily(), begin_key, end_key);
+  }
+
   // Merge the database entry for "key" with "value".  Returns OK on success,
   // and a non-OK status on error. The semantics of this operation is
   // determined by the user provided merge_operator when opening DB.
@@ -469,6 +504,20 @@ class DB {
     //      based.
     static const std::string kEstimatePendingCompactionBytes;
 
+    //  "rocksdb.actual-delayed-write-rate" - returns the current rate in bytes
+    //      per second that writes are delayed to, or 0 if they are not
+    //      delayed.
+    static const std::string kActualDelayedWriteRate;
+
+    //  "rocksdb.is-write-stopped" - returns 1 if writes are stopped,
+    //      otherwise 0.
+    static const std::string kIsWriteStopped;
+
+    //  "rocksdb.estimate-compaction-throughput" - returns the estimated
+    //      compaction throughput in bytes per second used by
+    //      adaptive_delayed_write_rate, or 0 if unknown.
+    static const std::string kEstimateCompactionThroughput;
+
     //  "rocksdb.aggregated-table-properties" - returns a string representation
     //      of the aggregated table properties of the target column family.
     static const std::string kAggregatedTableProperties;
@@ -517,6 +566,9 @@ class DB {
   //  "rocksdb.estimate-pending-compaction-bytes"
   //  "rocksdb.num-running-compactions"
   //  "rocksdb.num-running-flushes"
+  //  "rocksdb.actual-delayed-write-rate"
+  //  "rocksdb.is-write-stopped"
+  //  "rocksdb.estimate-compaction-throughput"
   virtual bool GetIntProperty(ColumnFamilyHandle* column_family,
                               const Slice& property, uint64_t* value) = 0;
   virtual bool GetIntProperty(const Slice& property, uint64_t* value) {
@@ -243,8 +243,10 @@ class Env {
   // REQUIRES: lock has not already been unlocked.
   virtual Status UnlockFile(FileLock* lock) = 0;
 
-  // Priority for scheduling job in thread pool
-  enum Priority { LOW, HIGH, TOTAL };
+  // Priority for scheduling job in thread pool. The BOTTOM pool runs the
+  // compactions into the bottommost level, if it has any threads, so that
+  // they don't hold the threads of the LOW pool for hours.
+  enum Priority { BOTTOM, LOW, HIGH, TOTAL };
 
   // Priority for requesting bytes in rate limiter scheduler
   enum IOPriority {
@@ -321,9 +323,12 @@ class Env {
 
   // The number of background worker threads of a specific thread pool
   // for this environment. 'LOW' is the default pool.
-  // default number: 1
+  // default number: 1, except for the BOTTOM pool, which has none
   virtual void SetBackgroundThreads(int number, Priority pri = LOW) = 0;
 
+  // Get the number of background worker threads of a specific thread pool.
+  virtual int GetBackgroundThreads(Priority pri = LOW) { return 0; }
+
   // Enlarge number of background worker threads of a specific thread pool
   // for this environment if it is smaller than specified. 'LOW' is the default
   // pool.
@@ -886,6 +891,9 @@ class EnvWrapper : public Env {
   void SetBackgroundThreads(int num, Priority pri) override {
     return target_->SetBackgroundThreads(num, pri);
   }
+  int GetBackgroundThreads(Priority pri) override {
+    return target_->GetBackgroundThreads(pri);
+  }
 
   void IncBackgroundThreadsIfNeeded(int num, Priority pri) override {
     return target_->IncBackgroundThreadsIfNeeded(num, pri);
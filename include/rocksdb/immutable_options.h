@@ -52,6 +52,8 @@ struct ImmutableCFOptions {
 
   uint64_t delayed_write_rate;
 
+  bool adaptive_delayed_write_rate;
+
   // Allow the OS to mmap file for reading sst tables. Default: false
   bool allow_mmap_reads;
 
@@ -62,6 +64,10 @@ struct ImmutableCFOptions {
 
   MemTableRepFactory* memtable_factory;
 
+  const SliceTransform* memtable_insert_with_hint_prefix_extractor;
+
+  MemoryAllocator* memtable_memory_allocator;
+
   TableFactory* table_factory;
 
   Options::TablePropertiesCollectorFactories
@@ -58,6 +58,10 @@ enum class CompactionReason {
   kManualCompaction,
   // DB::SuggestCompactRange() marked files for compaction
   kFilesMarkedForCompaction,
+  // [Level] the data of a file is older than periodic_compaction_seconds
+  kPeriodicCompaction,
+  // [FIFO] the data of a file is older than CompactionOptionsFIFO::ttl
+  kFIFOTtl,
 };
 
 #ifndef ROCKSDB_LITE
@@ -0,0 +1,63 @@
+// Copyright (c) 2011-present, Facebook, Inc.  All rights reserved.
+// This source code is licensed under the BSD-style license found in the
+// LICENSE file in the root directory of this source tree. An additional grant
+// of patent rights can be found in the PATENTS file in the same directory.
+
+#pragma once
+
+#include <stddef.h>
+#include <memory>
+
+namespace rocksdb {
+
+// A MemoryAllocator supplies the memory of the memtable arenas and of the
+// data blocks that block based tables read and keep in the block cache. See
+// ColumnFamilyOptions::memtable_memory_allocator and NewLRUCache().
+//
+// An allocator may be shared by many DBs and threads, so it has to be
+// thread-safe.
+class MemoryAllocator {
+ public:
+  virtual ~MemoryAllocator() {}
+
+  // The name of the allocator, which is written to the info log
+  virtual const char* Name() const = 0;
+
+  // Returns size bytes, aligned to at least sizeof(void*), or nullptr if
+  // the memory can't be allocated, in which case the caller falls back to
+  // operator new.
+  virtual void* Allocate(size_t size) = 0;
+
+  // Releases p, which was returned by Allocate(size).
+  virtual void Deallocate(void* p, size_t size) = 0;
+};
+
+// Where the pages of the memory of a NUMA memory allocator are placed
+enum NumaPolicy : char {
+  // The OS default: a page comes from the node of the thread that first
+  // touches it
+  kNumaDefault = 0x0,
+  // The pages are spread round-robin over all the nodes, so that memory
+  // that the threads of all the nodes read, like a block cache, does not
+  // load a single node
+  kNumaInterleave = 0x1,
+  // The pages come from the node of the thread that allocates them
+  kNumaLocal = 0x2,
+};
+
+// Returns an allocator that maps each allocation separately from the OS and
+// places its pages by numa_policy. If transparent_huge_pages is true, it
+// also asks the OS to back the mappings with transparent huge pages, which
+// cuts the TLB misses of lookups that touch memory all over large arenas
+// and caches.
+//
+// Allocations are rounded up to whole pages and cost a system call each, so
+// the allocator suits memtable arenas and block caches with large blocks,
+// not many small allocations.
+//
+// numa_policy is only honored when RocksDB is built with libnuma (-DNUMA).
+// On platforms without mmap(), the allocator falls back to operator new.
+extern std::shared_ptr<MemoryAllocator> NewNumaMemoryAllocator(
+    NumaPolicy numa_policy, bool transparent_huge_pages = false);
+
+}  // namespace rocksdb
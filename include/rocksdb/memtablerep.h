@@ -28,6 +28,9 @@
 // vector is sorted. It is intelligent about sorting; once the MarkReadOnly()
 // has been called, the vector will only be sorted once. It is optimized for
 // random-write-heavy workloads.
+//  - BTreeRep: This is backed by a B+-tree, whose nodes keep many keys next
+//  to each other, so that lookups take fewer cache misses than in a skip
+//  list. It supports concurrent inserts and ordered iteration.
 //
 // The last four implementations are designed for situations in which
 // iteration over the entire collection is rare since doing so requires all the
@@ -83,6 +86,16 @@ class MemTableRep {
   // collection, and no concurrent modifications to the table in progress
   virtual void Insert(KeyHandle handle) = 0;
 
+  // Like Insert(handle), but also passes a hint of where the key goes. If
+  // *hint is nullptr, a new hint is stored in it; otherwise it is updated to
+  // the position of this insert. A hint belongs to this MemTableRep, and is
+  // freed with it. The default implementation ignores the hint.
+  // REQUIRES: nothing that compares equal to key is currently in the
+  // collection, and no concurrent modifications to the table in progress
+  virtual void InsertWithHint(KeyHandle handle, void** hint) {
+    Insert(handle);
+  }
+
   // Like Insert(handle), but may be called concurrent with other calls
   // to InsertConcurrently for other handles
   virtual void InsertConcurrently(KeyHandle handle) {
@@ -240,15 +253,25 @@ class SkipListFactory : public MemTableRepFactory {
 // the vector is sorted. This is useful for workloads where iteration is very
 // rare and writes are generally not issued after reads begin.
 //
+// It supports concurrent memtable writes (allow_concurrent_memtable_write):
+// concurrent writers append to per-core vectors, which are joined when the
+// memtable becomes immutable. This suits bulk loads from many threads.
+//
 // Parameters:
 //   count: Passed to the constructor of the underlying std::vector of each
 //     VectorRep. On initialization, the underlying array will be at least count
 //     bytes reserved for usage.
+//   sort_threads: The number of threads that sort the vector, e.g. when the
+//     memtable is flushed. Each thread sorts a run of the entries, and the
+//     runs are then merged by all the threads. Vectors that are too small
+//     to gain from it are sorted by a single thread.
 class VectorRepFactory : public MemTableRepFactory {
   const size_t count_;
+  const size_t sort_threads_;
 
  public:
-  explicit VectorRepFactory(size_t count = 0) : count_(count) { }
+  explicit VectorRepFactory(size_t count = 0, size_t sort_threads = 1)
+      : count_(count), sort_threads_(sort_threads) {}
   virtual MemTableRep* CreateMemTableRep(const MemTableRep::KeyComparator&,
                                          MemTableAllocator*,
                                          const SliceTransform*,
@@ -256,6 +279,24 @@ class VectorRepFactory : public MemTableRepFactory {
   virtual const char* Name() const override {
     return "VectorRepFactory";
   }
+
+  bool IsInsertConcurrentlySupported() const override { return true; }
+};
+
+// This creates MemTableReps that are backed by a B+-tree. Readers don't take
+// locks, and writers only lock the nodes they change, so it supports
+// concurrent memtable writes (allow_concurrent_memtable_write) like the skip
+// list. Point lookups and seeks take fewer cache misses than in a skip list,
+// and a scan reads the keys of a leaf at a time.
+class BTreeRepFactory : public MemTableRepFactory {
+ public:
+  virtual MemTableRep* CreateMemTableRep(const MemTableRep::KeyComparator&,
+                                         MemTableAllocator*,
+                                         const SliceTransform*,
+                                         Logger* logger) override;
+  virtual const char* Name() const override { return "BTreeRepFactory"; }
+
+  bool IsInsertConcurrentlySupported() const override { return true; }
 };
 
 // This class contains a fixed array of buckets, each
@@ -30,6 +30,7 @@ namespace rocksdb {
 class Cache;
 class CompactionFilter;
 class CompactionFilterFactory;
+class CompactionService;
 class Comparator;
 class Env;
 enum InfoLogLevel : unsigned char;
@@ -40,6 +41,7 @@ class MergeOperator;
 class Snapshot;
 class TableFactory;
 class MemTableRepFactory;
+class MemoryAllocator;
 class TablePropertiesCollectorFactory;
 class RateLimiter;
 class Slice;
@@ -47,6 +49,7 @@ class SliceTransform;
 class Statistics;
 class InternalKeyComparator;
 class WalFilter;
+class WriteBufferManager;
 
 // DB contents are stored in a set of blocks, each of which holds a
 // sequence of key,value pairs.  Each block may be compressed before
@@ -128,7 +131,15 @@ struct CompactionOptionsFIFO {
   // Default: 1GB
   uint64_t max_table_files_size;
 
-  CompactionOptionsFIFO() : max_table_files_size(1 * 1024 * 1024 * 1024) {}
+  // If non-zero, the table files whose data was written more than this many
+  // seconds ago are deleted, whatever the total size. Like the size limit,
+  // it is checked whenever a new version of the column family is installed,
+  // after a flush or a reopen.
+  // Default: 0 (disabled)
+  uint64_t ttl;
+
+  CompactionOptionsFIFO()
+      : max_table_files_size(1 * 1024 * 1024 * 1024), ttl(0) {}
 };
 
 // Compression options for different compression algorithms like Zlib
@@ -136,9 +147,21 @@ struct CompressionOptions {
   int window_bits;
   int level;
   int strategy;
-  CompressionOptions() : window_bits(-14), level(-1), strategy(0) {}
+  // Number of threads used to compress the data blocks of a block-based
+  // table file being written by a flush or a compaction.  With a value
+  // greater than 1, finished data blocks are handed to that many worker
+  // threads, while the thread building the file keeps reading its input,
+  // and the compressed blocks are written to the file in their original
+  // order.  The output is identical to the one of a single thread.
+  // Default: 1 (blocks are compressed by the thread building the file)
+  uint32_t parallel_threads;
+  CompressionOptions()
+      : window_bits(-14), level(-1), strategy(0), parallel_threads(1) {}
   CompressionOptions(int wbits, int _lev, int _strategy)
-      : window_bits(wbits), level(_lev), strategy(_strategy) {}
+      : window_bits(wbits),
+        level(_lev),
+        strategy(_strategy),
+        parallel_threads(1) {}
 };
 
 enum UpdateStatus {    // Return status For inplace update callback
@@ -315,6 +338,24 @@ struct ColumnFamilyOptions {
   // set by the user.  Otherwise, the default is 0.
   int max_write_buffer_number_to_maintain;
 
+  // If true, a memtable that becomes immutable is not queued for flush
+  // right away. A background job of the flush thread pool first merges it
+  // with the other immutable memtables that wait for a flush into a single
+  // memtable, a sorted array of entries that keeps only the versions some
+  // snapshot needs and applies the merge operands it can, like a flush does.
+  // The merged memtable is read by binary search, and is flushed once it
+  // takes min_write_buffer_number_to_merge times write_buffer_size bytes, or
+  // when a flush is requested. Workloads that overwrite the same keys then
+  // flush less often and write less data to L0.
+  //
+  // Memtables merged this way are freed right away, and are not kept for
+  // max_write_buffer_number_to_maintain.
+  //
+  // Not supported in ROCKSDB_LITE mode, where it is ignored.
+  //
+  // Default: false
+  bool in_memory_compaction;
+
   // Compress blocks using the specified compression algorithm.  This
   // parameter can be changed dynamically.
   //
@@ -627,11 +668,65 @@ struct ColumnFamilyOptions {
   // Dynamically changeable through SetOptions() API
   uint64_t max_sequential_skip_in_iterations;
 
+  // If non-zero, an iterator that skips over at least this many deleted
+  // entries (point deletions, single deletions and keys covered by range
+  // deletions) between two keys it returns, reports the key range of that run
+  // to the DB. The DB then schedules a flush of the memtable if it holds
+  // deletions, and marks the files that overlap the range for compaction,
+  // so that the following scans do not have to skip the deletions again.
+  // Only level style compaction compacts the marked files.
+  //
+  // Default: 0 (disabled)
+  //
+  // Dynamically changeable through SetOptions() API
+  uint64_t scan_deletion_compaction_trigger;
+
+  // If non-zero, the files whose data was last written more than this many
+  // seconds ago are rewritten by a compaction, so that the compaction filter
+  // sees their keys again and the space of their deleted and overwritten
+  // entries is reclaimed. A file at the last level is rewritten in place;
+  // any other file is compacted into the next level. The age of a file is
+  // taken from the creation time in its table properties, or from its
+  // modification time for files written by older versions.
+  // The files are picked only when no other compaction is needed, and the
+  // rewrites are rate limited by the DB's rate_limiter like all compactions.
+  // The ages are checked whenever a new version of the column family is
+  // installed, after a flush, a compaction or a reopen.
+  // Only level style compaction supports this option; FIFO compaction has
+  // CompactionOptionsFIFO::ttl.
+  //
+  // Default: 0 (disabled)
+  //
+  // Dynamically changeable through SetOptions() API
+  uint64_t periodic_compaction_seconds;
+
   // This is a factory that provides MemTableRep objects.
   // Default: a factory that provides a skip-list-based implementation of
   // MemTableRep.
   std::shared_ptr<MemTableRepFactory> memtable_factory;
 
+  // If non-nullptr, the memtable keeps a hint, the position of the last
+  // insert, for each prefix of the user keys given by this extractor, and
+  // starts the search for the position of a new key of that prefix from
+  // the hint instead of from the head of the memtable. This saves most of
+  // the key comparisons of inserts when the keys of a prefix are written in
+  // increasing order, e.g. for keys made of an id followed by a timestamp.
+  // Keys outside the domain of the extractor are inserted as usual.
+  //
+  // Only the skip list memtable uses the hints, and they are not used by
+  // concurrent memtable writes (allow_concurrent_memtable_write).
+  //
+  // Default: nullptr (disabled)
+  std::shared_ptr<const SliceTransform>
+      memtable_insert_with_hint_prefix_extractor;
+
+  // If non-nullptr, the arena blocks of the memtables are allocated from it,
+  // e.g. to place them on NUMA nodes or on transparent huge pages. See
+  // NewNumaMemoryAllocator() in rocksdb/memory_allocator.h.
+  //
+  // Default: nullptr (the blocks are allocated with new[])
+  std::shared_ptr<MemoryAllocator> memtable_memory_allocator;
+
   // This is a factory that provides TableFactory objects.
   // Default: a block-based table factory that provides a default
   // implementation of TableBuilder and TableReader with default
@@ -740,6 +835,24 @@ struct ColumnFamilyOptions {
   // Dynamically changeable through SetOptions() API
   size_t memtable_prefix_bloom_huge_page_tlb_size;
 
+  // If not 0, each memtable keeps a hash index with this many slots from its
+  // user keys to their newest entries, next to the memtable rep. A point
+  // lookup of a key whose newest entry is a put or a deletion visible to the
+  // read is then answered from the index, as is a lookup of a key that is
+  // not in the memtable, without a search of the memtable rep. Iterators
+  // still read the memtable rep.
+  //
+  // The slots take 8 bytes each from the memory of the memtable. Keys that
+  // don't fit in the index are looked up in the memtable rep, so it should
+  // have about twice as many slots as a memtable has keys. The index hashes
+  // the user keys, so it can only be used with comparators under which equal
+  // keys are bytewise equal, like BytewiseComparator().
+  //
+  // Default: 0 (disabled)
+  //
+  // Dynamically changeable through SetOptions() API
+  uint32_t memtable_key_index_slots;
+
   // Control locality of bloom filter probes to improve cache miss rate.
   // This option only applies to memtable prefix bloom and plaintable
   // prefix bloom. It essentially limits every bloom checking to one cache line.
@@ -756,6 +869,9 @@ struct ColumnFamilyOptions {
   // ensure that there are never more than max_successive_merges merge
   // operations in the memtable.
   //
+  // Successive merges are not collapsed when the memtable is written
+  // concurrently (allow_concurrent_memtable_write).
+  //
   // Default: 0 (disabled)
   //
   // Dynamically changeable through SetOptions() API
@@ -1030,6 +1146,17 @@ struct DBOptions {
   // Default: 0
   size_t recycle_log_file_num;
 
+  // If not kNoCompression, the records of every new WAL file are compressed
+  // as a single stream, so that each record can refer to the data of the
+  // records written before it in the same file.  Only kZlibCompression is
+  // supported; DB::Open() returns Status::NotSupported for the other types.
+  // Existing uncompressed WAL files remain readable, and the setting can be
+  // changed between DB::Open() calls.  Since a record can only be decoded
+  // after all the records preceding it, a corrupted record also makes the
+  // rest of the file unreadable, even with kSkipAnyCorruptedRecords.
+  // Default: kNoCompression
+  CompressionType wal_compression;
+
   // manifest file is rolled over on reaching this limit.
   // The older manifest file be deleted.
   // The default value is MAX_INT so that roll-over does not take place.
@@ -1120,6 +1247,23 @@ struct DBOptions {
   // Default: 0 (disabled)
   size_t db_write_buffer_size;
 
+  // The memory usage of memtable will report to this object. The same object
+  // can be passed into multiple DBs and it will track the sum of size of all
+  // the DBs. If the total size of all live memtables of all the DBs exceeds
+  // a limit, a flush will be triggered in the next DB to which the next write
+  // is issued.
+  //
+  // If the object is constructed with a block cache, the memory allocated by
+  // memtables is also charged to that cache, so that a single memory budget
+  // covers both the memtables and the cached blocks.
+  //
+  // If the object is only passed to one DB, the behavior is the same as
+  // db_write_buffer_size. When write_buffer_manager is set, the value set will
+  // override db_write_buffer_size.
+  //
+  // Default: null
+  std::shared_ptr<WriteBufferManager> write_buffer_manager;
+
   // Specify the file access pattern once a compaction is started.
   // It will be applied to all input files of a compaction.
   // Default: NORMAL
@@ -1231,10 +1375,24 @@ struct DBOptions {
   // Default: 2MB/s
   uint64_t delayed_write_rate;
 
+  // If true, the rate writes are delayed to is not stepped up and down from
+  // delayed_write_rate based on whether compaction debt grew since the last
+  // check. Instead it follows the measured compaction throughput (capped at
+  // delayed_write_rate), scaled down continuously as the slowdown condition
+  // approaches its stop condition, e.g. as the estimated pending compaction
+  // bytes grow from soft_pending_compaction_bytes_limit to
+  // hard_pending_compaction_bytes_limit. This avoids the oscillation between
+  // stopped and undelayed writes seen under bursty load.
+  //
+  // Default: false
+  bool adaptive_delayed_write_rate;
+
   // If true, allow multi-writers to update mem tables in parallel.
   // Only some memtable_factory-s support concurrent writes; currently it
   // is implemented only for SkipListFactory.  Concurrent memtable writes
-  // are not compatible with inplace_update_support or filter_deletes.
+  // are not compatible with inplace_callback or filter_deletes.  With
+  // inplace_update_support, a write group is only inserted in parallel if
+  // no key is written by more than one of its writers.
   // It is strongly recommended to set enable_write_thread_adaptive_yield
   // if you are going to use this feature.
   //
@@ -1243,6 +1401,24 @@ struct DBOptions {
   // Default: false
   bool allow_concurrent_memtable_write;
 
+  // If true, the memtable inserts of a write group are not serialized with
+  // those of other groups. Once the group leader has written the group to
+  // the WAL it releases the write queue, and every writer then inserts its
+  // own batch into the memtable concurrently with later groups. The last
+  // sequence number visible to readers is only advanced once all earlier
+  // sequence numbers have been applied, so reads and snapshots stay
+  // consistent and a writer can read its own write once Write() returns.
+  //
+  // This increases write throughput when memtable inserts, rather than the
+  // WAL, are the bottleneck, e.g. for ingest-only workloads. If a column
+  // family uses inplace_update_support, write groups are inserted in order,
+  // after all in-flight unordered inserts have finished.
+  //
+  // Requires allow_concurrent_memtable_write.
+  //
+  // Default: false
+  bool unordered_write;
+
   // If true, threads synchronizing with the write batch group leader will
   // wait for up to write_thread_max_yield_usec before blocking on a mutex.
   // This can substantially improve throughput for concurrent workloads,
@@ -1289,6 +1465,14 @@ struct DBOptions {
   // Not supported in ROCKSDB_LITE mode!
   std::shared_ptr<Cache> row_cache;
 
+  // If not nullptr, the key/value processing of compactions is handed to this
+  // service, which may run it outside of the DB process. See
+  // rocksdb/compaction_service.h. Compactions fall back to running locally
+  // if the service fails.
+  // Default: nullptr
+  // Not supported in ROCKSDB_LITE mode!
+  std::shared_ptr<CompactionService> compaction_service;
+
 #ifndef ROCKSDB_LITE
   // A filter object supplied to be invoked while processing write-ahead-logs
   // (WALs) during recovery. The filter provides a way to inspect log
@@ -173,6 +173,16 @@ enum Tickers : uint32_t {
   ROW_CACHE_HIT,
   ROW_CACHE_MISS,
 
+  // Write stall state, updated every time the write stall conditions of a
+  // column family are recalculated.
+  // Current delayed write rate in bytes per second, 0 if not delayed.
+  DELAYED_WRITE_RATE,
+  // Estimated pending compaction bytes of the column family last
+  // recalculated.
+  ESTIMATED_PENDING_COMPACTION_BYTES,
+  // Estimated compaction throughput in bytes per second.
+  ESTIMATED_COMPACTION_THROUGHPUT,
+
   TICKER_ENUM_MAX
 };
 
@@ -255,6 +265,10 @@ const std::vector<std::pair<Tickers, std::string>> TickersNameMap = {
     {FILTER_OPERATION_TOTAL_TIME, "rocksdb.filter.operation.time.nanos"},
     {ROW_CACHE_HIT, "rocksdb.row.cache.hit"},
     {ROW_CACHE_MISS, "rocksdb.row.cache.miss"},
+    {DELAYED_WRITE_RATE, "rocksdb.delayed.write.rate"},
+    {ESTIMATED_PENDING_COMPACTION_BYTES,
+     "rocksdb.estimate.pending.compaction.bytes"},
+    {ESTIMATED_COMPACTION_THROUGHPUT, "rocksdb.estimate.compaction.throughput"},
 };
 
 /**
@@ -294,6 +308,13 @@ enum Histograms : uint32_t {
   BYTES_PER_READ,
   BYTES_PER_WRITE,
   BYTES_PER_MULTIGET,
+  // With CompressionOptions::parallel_threads > 1, the number of data blocks
+  // of a table file being compressed or waiting to be written, sampled every
+  // time a block is queued
+  PARALLEL_COMPRESSION_QUEUE_DEPTH,
+  // With CompressionOptions::parallel_threads > 1, the time the thread
+  // building a table file waited for a data block to be compressed
+  PARALLEL_COMPRESSION_WAIT_MICROS,
   HISTOGRAM_ENUM_MAX,  // TODO(ldemailly): enforce HistogramsNameMap match
 };
 
@@ -324,6 +345,10 @@ const std::vector<std::pair<Histograms, std::string>> HistogramsNameMap = {
     {BYTES_PER_READ, "rocksdb.bytes.per.read"},
     {BYTES_PER_WRITE, "rocksdb.bytes.per.write"},
     {BYTES_PER_MULTIGET, "rocksdb.bytes.per.multiget"},
+    {PARALLEL_COMPRESSION_QUEUE_DEPTH,
+     "rocksdb.parallel.compression.queue.depth"},
+    {PARALLEL_COMPRESSION_WAIT_MICROS,
+     "rocksdb.parallel.compression.wait.micros"},
 };
 
 struct HistogramData {
@@ -36,11 +36,13 @@ struct TablePropertiesNames {
   static const std::string kRawValueSize;
   static const std::string kNumDataBlocks;
   static const std::string kNumEntries;
+  static const std::string kNumRangeDeletions;
   static const std::string kFormatVersion;
   static const std::string kFixedKeyLen;
   static const std::string kFilterPolicy;
   static const std::string kColumnFamilyName;
   static const std::string kColumnFamilyId;
+  static const std::string kCreationTime;
 };
 
 extern const std::string kPropertiesBlock;
@@ -137,10 +139,16 @@ struct TableProperties {
   uint64_t num_data_blocks = 0;
   // the number of entries in this table
   uint64_t num_entries = 0;
+  // the number of range deletions in this table, not counted in num_entries
+  uint64_t num_range_deletions = 0;
   // format version, reserved for backward compatibility
   uint64_t format_version = 0;
   // If 0, key is variable length. Otherwise number of bytes for each key.
   uint64_t fixed_key_len = 0;
+  // The time the table was written, in seconds since the epoch; 0 if unknown.
+  // A compaction output is a new table, so this is the time of the last
+  // rewrite of its data.
+  uint64_t creation_time = 0;
   // ID of column family for this SST file, corresponding to the CF identified
   // by column_family_name.
   uint64_t column_family_id =
@@ -47,6 +47,7 @@ struct ThreadStatus {
     HIGH_PRIORITY = 0,  // RocksDB BG thread in high-pri thread pool
     LOW_PRIORITY,  // RocksDB BG thread in low-pri thread pool
     USER,  // User thread (Non-RocksDB BG thread)
+    BOTTOM_PRIORITY,  // RocksDB BG thread in bottom-pri thread pool
     NUM_THREAD_TYPES
   };
 
@@ -131,7 +132,7 @@ struct ThreadStatus {
   const uint64_t thread_id;
 
   // The type of the thread, it could be HIGH_PRIORITY,
-  // LOW_PRIORITY, and USER
+  // LOW_PRIORITY, BOTTOM_PRIORITY and USER
   const ThreadType thread_type;
 
   // The name of the DB instance where the thread is currently
@@ -0,0 +1,52 @@
+// Copyright (c) 2011-present, Facebook, Inc.  All rights reserved.
+// This source code is licensed under the BSD-style license found in the
+// LICENSE file in the root directory of this source tree. An additional grant
+// of patent rights can be found in the PATENTS file in the same directory.
+//
+// A CompactionService that hands compactions to worker processes through a
+// directory shared with them, such as tools/compaction_service_worker. It
+// needs no network service, so offloaded compactions can be run and tested on
+// a single host.
+//
+// For a compaction with id <id>, the DB writes the request "<id>.request" to
+// the shared directory. A worker claims the request by renaming it to
+// "<id>.running", writes the output files of the compaction to the directory
+// "<id>.output" and then writes "<id>.result", which the DB polls for. Files
+// are always written under a temporary name and renamed into place. The
+// output files are moved into the DB, so the shared directory should be on
+// the same file system as the DB.
+
+#pragma once
+#ifndef ROCKSDB_LITE
+
+#include <stdint.h>
+#include <memory>
+#include <string>
+
+#include "rocksdb/compaction_service.h"
+#include "rocksdb/status.h"
+
+namespace rocksdb {
+
+class Env;
+struct Options;
+
+// Creates a CompactionService that passes compactions through shared_dir. A
+// compaction fails with Status::TimedOut, and is then run locally by the DB,
+// if no worker finished it within timeout_micros.
+extern std::shared_ptr<CompactionService> NewSharedDirCompactionService(
+    Env* env, const std::string& shared_dir,
+    uint64_t timeout_micros = 600000000 /* 10 minutes */,
+    uint64_t poll_interval_micros = 10000);
+
+// Runs one pending request found in shared_dir. The DB of the request is
+// opened with options, which must be compatible with the options of the DB,
+// see DB::OpenAndCompact(). *found is set to false, and OK is returned, if
+// there was no pending request. The status of the compaction is returned
+// to the DB through the result file, not by this function.
+extern Status RunSharedDirCompactionRequest(const Options& options,
+                                            const std::string& shared_dir,
+                                            bool* found);
+
+}  // namespace rocksdb
+#endif  // !ROCKSDB_LITE
@@ -84,6 +84,13 @@ class WriteBatch : public WriteBatchBase {
     SingleDelete(nullptr, key);
   }
 
+  // WriteBatch implementation of DB::DeleteRange().  See db.h.
+  void DeleteRange(ColumnFamilyHandle* column_family, const Slice& begin_key,
+                   const Slice& end_key);
+  void DeleteRange(const Slice& begin_key, const Slice& end_key) {
+    DeleteRange(nullptr, begin_key, end_key);
+  }
+
   using WriteBatchBase::Merge;
   // Merge "value" with the existing value of "key" in the database.
   // "key->merge(existing, value)"
@@ -169,6 +176,14 @@ class WriteBatch : public WriteBatchBase {
     }
     virtual void SingleDelete(const Slice& /*key*/) {}
 
+    // Not implemented by default, so that existing handlers fail on batches
+    // they would otherwise misinterpret.
+    virtual Status DeleteRangeCF(uint32_t /*column_family_id*/,
+                                 const Slice& /*begin_key*/,
+                                 const Slice& /*end_key*/) {
+      return Status::InvalidArgument("DeleteRangeCF not implemented");
+    }
+
     // Merge and LogData are not pure virtual. Otherwise, we would break
     // existing clients of Handler on a source code level. The default
     // implementation of Merge does nothing.
@@ -211,6 +226,9 @@ class WriteBatch : public WriteBatchBase {
   // Returns true if SingleDeleteCF will be called during Iterate
   bool HasSingleDelete() const;
 
+  // Returns true if DeleteRangeCF will be called during Iterate
+  bool HasDeleteRange() const;
+
   // Returns trie if MergeCF will be called during Iterate
   bool HasMerge() const;
 
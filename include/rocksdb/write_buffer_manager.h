@@ -0,0 +1,95 @@
+//  Copyright (c) 2011-present, Facebook, Inc.  All rights reserved.
+//  This source code is licensed under the BSD-style license found in the
+//  LICENSE file in the root directory of this source tree. An additional grant
+//  of patent rights can be found in the PATENTS file in the same directory.
+//
+// Copyright (c) 2011 The LevelDB Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file. See the AUTHORS file for names of contributors.
+//
+// WriteBufferManager is for managing memory allocation for one or more
+// MemTables. It can be shared by multiple DB instances, and it can
+// optionally charge the memory it tracks to a block cache so that a single
+// memory budget covers both memtables and cached blocks.
+
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <vector>
+#include "rocksdb/cache.h"
+
+namespace rocksdb {
+
+class WriteBufferManager {
+ public:
+  // _buffer_size = 0 indicates no limit, in which case ShouldFlush() always
+  // returns false.
+  //
+  // If cache is not nullptr, the memory allocated by memtables is charged to
+  // the cache by inserting dummy entries of kDummyEntrySize bytes each. The
+  // charge is released once the memtables holding the memory are freed. The
+  // cache is charged even if _buffer_size is 0.
+  explicit WriteBufferManager(size_t _buffer_size,
+                              std::shared_ptr<Cache> cache = nullptr);
+
+  ~WriteBufferManager();
+
+  bool enabled() const { return buffer_size_ != 0; }
+
+  // Total memory allocated by all memtables tracked by this manager,
+  // including the immutable ones that are not yet freed.
+  size_t memory_usage() const {
+    return memory_used_.load(std::memory_order_relaxed);
+  }
+  // Memory allocated by memtables that are still accepting writes.
+  size_t mutable_memtable_memory_usage() const {
+    return memory_active_.load(std::memory_order_relaxed);
+  }
+  size_t buffer_size() const { return buffer_size_; }
+
+  // Bytes currently charged to the cache, or 0 if no cache is used.
+  size_t dummy_entries_in_cache_usage() const {
+    return cache_charged_.load(std::memory_order_relaxed);
+  }
+
+  // Should only be called from write thread
+  bool ShouldFlush() const {
+    return enabled() && mutable_memtable_memory_usage() >= buffer_size();
+  }
+
+  // Called when a memtable allocates mem bytes.
+  void ReserveMem(size_t mem);
+  // Called when a memtable becomes immutable. The memory is no longer counted
+  // toward the flush trigger but stays charged until FreeMem().
+  void ScheduleFreeMem(size_t mem);
+  // Called when the memtable owning mem bytes is destroyed.
+  void FreeMem(size_t mem);
+
+  // Size of each dummy entry inserted into the cache.
+  static const size_t kDummyEntrySize = 1 << 20;
+
+ private:
+  void ReserveMemWithCache();
+  void FreeMemWithCache();
+
+  const size_t buffer_size_;
+  std::atomic<size_t> memory_used_;
+  std::atomic<size_t> memory_active_;
+
+  std::shared_ptr<Cache> cache_;
+  // Protects dummy_handles_. The i-th dummy entry is keyed by cache_id_
+  // and i, so entries are always added and removed at the back.
+  std::mutex cache_mutex_;
+  std::vector<Cache::Handle*> dummy_handles_;
+  std::atomic<size_t> cache_charged_;
+  uint64_t cache_id_;
+
+  // No copying allowed
+  WriteBufferManager(const WriteBufferManager&) = delete;
+  WriteBufferManager& operator=(const WriteBufferManager&) = delete;
+};
+
+}  // namespace rocksdb
@@ -17,9 +17,9 @@
 #include "rocksdb/write_batch.h"
 #include "rocksdb/status.h"
 #include "db/write_batch_internal.h"
-#include "db/writebuffer.h"
 #include "rocksdb/env.h"
 #include "rocksdb/memtablerep.h"
+#include "rocksdb/write_buffer_manager.h"
 #include "table/scoped_arena_iterator.h"
 #include "util/logging.h"
 #include "util/testharness.h"
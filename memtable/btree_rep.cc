@@ -0,0 +1,572 @@
+//  Copyright (c) 2011-present, Facebook, Inc.  All rights reserved.
+//  This source code is licensed under the BSD-style license found in the
+//  LICENSE file in the root directory of this source tree. An additional grant
+//  of patent rights can be found in the PATENTS file in the same directory.
+//
+#ifndef ROCKSDB_LITE
+#include <assert.h>
+#include <atomic>
+#include <string>
+
+#include "db/memtable.h"
+#include "port/port.h"
+#include "rocksdb/memtablerep.h"
+#include "util/arena.h"
+
+namespace rocksdb {
+namespace {
+
+// A B+-tree of the entries. A node holds the pointers to up to a few dozen
+// keys next to each other, so that a search takes a cache miss or two per
+// node on a tree a handful of nodes deep, instead of one or two per level of
+// a skip list.
+//
+// Writers and readers synchronize with optimistic lock coupling. Every node
+// has a version, whose low bit is set while a writer holds the node. Readers
+// take no locks: they read the version, read the node, and check that the
+// version did not change, starting over from the root if it did. Writers
+// lock the nodes they change by setting the low bit, and count the change
+// when they unlock. A full node is split on the way down, with its parent
+// locked, so that the parent always has room for the new separator key.
+//
+// Nodes are never freed before the rep, and entries only move to the right
+// on a split, so a reader never follows a pointer into freed memory, and the
+// lowest key of a subtree stays in it.
+//
+// Iterators copy the key pointers of a leaf at a time, and move to the next
+// leaf through the leaf links. Prev() searches again from the root.
+class BTreeRep : public MemTableRep {
+ public:
+  BTreeRep(const MemTableRep::KeyComparator& compare,
+           MemTableAllocator* allocator);
+
+  virtual void Insert(KeyHandle handle) override {
+    InsertConcurrently(handle);
+  }
+
+  virtual void InsertConcurrently(KeyHandle handle) override {
+    const char* key = static_cast<char*>(handle);
+    while (!TryInsert(key)) {
+    }
+  }
+
+  virtual bool Contains(const char* key) const override;
+
+  virtual size_t ApproximateMemoryUsage() override {
+    // All memory is allocated through allocator; nothing to report here
+    return 0;
+  }
+
+  virtual void Get(const LookupKey& k, void* callback_args,
+                   bool (*callback_func)(void* arg,
+                                         const char* entry)) override;
+
+  virtual ~BTreeRep() {}
+
+  virtual MemTableRep::Iterator* GetIterator(Arena* arena = nullptr) override;
+
+ private:
+  enum : int { kLeafCapacity = 32, kInnerCapacity = 32 };
+
+  // The low bit of a version is set while a writer holds the node
+  static const uint64_t kLocked = 1;
+
+  struct Node {
+    explicit Node(bool leaf) : version(0), count(0), is_leaf(leaf) {}
+
+    std::atomic<uint64_t> version;
+    std::atomic<int> count;
+    const bool is_leaf;
+  };
+
+  struct LeafNode : public Node {
+    LeafNode() : Node(true), next(nullptr) {
+      for (int i = 0; i < kLeafCapacity; i++) {
+        keys[i].store(nullptr, std::memory_order_relaxed);
+      }
+    }
+
+    std::atomic<const char*> keys[kLeafCapacity];
+    std::atomic<LeafNode*> next;
+  };
+
+  // children[i] holds the keys in [keys[i - 1], keys[i])
+  struct InnerNode : public Node {
+    InnerNode() : Node(false) {
+      for (int i = 0; i < kInnerCapacity; i++) {
+        keys[i].store(nullptr, std::memory_order_relaxed);
+      }
+      for (int i = 0; i <= kInnerCapacity; i++) {
+        children[i].store(nullptr, std::memory_order_relaxed);
+      }
+    }
+
+    std::atomic<const char*> keys[kInnerCapacity];
+    std::atomic<Node*> children[kInnerCapacity + 1];
+  };
+
+  // The keys of a leaf, as a reader saw them at one point in time
+  struct LeafSnapshot {
+    const char* keys[kLeafCapacity];
+    int count;
+    LeafNode* next;
+  };
+
+  class Iterator : public MemTableRep::Iterator {
+   public:
+    explicit Iterator(const BTreeRep* rep) : rep_(rep), pos_(0) {
+      leaf_.count = 0;
+      leaf_.next = nullptr;
+    }
+
+    virtual ~Iterator() {}
+
+    // Returns true iff the iterator is positioned at a valid node.
+    virtual bool Valid() const override { return pos_ < leaf_.count; }
+
+    // Returns the key at the current position.
+    // REQUIRES: Valid()
+    virtual const char* key() const override {
+      assert(Valid());
+      return leaf_.keys[pos_];
+    }
+
+    // Advances to the next position.
+    // REQUIRES: Valid()
+    virtual void Next() override {
+      assert(Valid());
+      pos_++;
+      SkipToNextLeaf();
+    }
+
+    // Advances to the previous position.
+    // REQUIRES: Valid()
+    virtual void Prev() override {
+      assert(Valid());
+      if (pos_ > 0) {
+        pos_--;
+        return;
+      }
+      const char* target = leaf_.keys[0];
+      rep_->FindLeaf(target, true /* before_key */, &leaf_);
+      pos_ = rep_->LowerBound(leaf_, target) - 1;
+      if (pos_ < 0) {
+        // No key before target
+        leaf_.count = 0;
+        pos_ = 0;
+      }
+    }
+
+    // Advance to the first entry with a key >= target
+    virtual void Seek(const Slice& internal_key,
+                      const char* memtable_key) override {
+      const char* encoded_key = (memtable_key != nullptr)
+                                    ? memtable_key
+                                    : EncodeKey(&tmp_, internal_key);
+      rep_->FindLeaf(encoded_key, false /* before_key */, &leaf_);
+      pos_ = rep_->LowerBound(leaf_, encoded_key);
+      SkipToNextLeaf();
+    }
+
+    // Position at the first entry in collection.
+    // Final state of iterator is Valid() iff collection is not empty.
+    virtual void SeekToFirst() override {
+      rep_->FindLeaf(nullptr, false /* before_key */, &leaf_);
+      pos_ = 0;
+      SkipToNextLeaf();
+    }
+
+    // Position at the last entry in collection.
+    // Final state of iterator is Valid() iff collection is not empty.
+    virtual void SeekToLast() override {
+      rep_->FindLeaf(nullptr, true /* before_key */, &leaf_);
+      pos_ = leaf_.count > 0 ? leaf_.count - 1 : 0;
+    }
+
+   private:
+    // If the position is past the keys of the leaf, moves to the first key
+    // of the next leaf that has one
+    void SkipToNextLeaf() {
+      while (pos_ == leaf_.count && leaf_.next != nullptr) {
+        rep_->ReadLeaf(leaf_.next, &leaf_);
+        pos_ = 0;
+      }
+    }
+
+    const BTreeRep* rep_;
+    LeafSnapshot leaf_;
+    int pos_;
+    std::string tmp_;  // For passing to EncodeKey
+  };
+
+  static bool ReadLock(const Node* node, uint64_t* version) {
+    *version = node->version.load(std::memory_order_acquire);
+    if ((*version & kLocked) != 0) {
+      port::AsmVolatilePause();
+      return false;
+    }
+    return true;
+  }
+
+  // Returns whether the node is unchanged since ReadLock returned version,
+  // that is, whether what was read from it since is consistent
+  static bool Validate(const Node* node, uint64_t version) {
+    std::atomic_thread_fence(std::memory_order_acquire);
+    return node->version.load(std::memory_order_relaxed) == version;
+  }
+
+  static bool UpgradeToWriteLock(Node* node, uint64_t version) {
+    if (!node->version.compare_exchange_strong(version, version | kLocked,
+                                               std::memory_order_acquire)) {
+      return false;
+    }
+    // Readers that see any of the changes below also see the lock
+    std::atomic_thread_fence(std::memory_order_release);
+    return true;
+  }
+
+  static void WriteUnlock(Node* node) {
+    node->version.fetch_add(1, std::memory_order_release);
+  }
+
+  // Returns the number of the keys[0, count) that are less than key or, if
+  // or_equal, not greater than it. A null key is less than all keys.
+  // Returns -1 if one of the keys was not written yet, which only happens
+  // to a reader whose read will not validate.
+  int Search(const std::atomic<const char*>* keys, int count, const char* key,
+             bool or_equal) const {
+    if (key == nullptr) {
+      return 0;
+    }
+    int lo = 0;
+    int hi = count;
+    while (lo < hi) {
+      int mid = (lo + hi) / 2;
+      const char* mid_key = keys[mid].load(std::memory_order_acquire);
+      if (mid_key == nullptr) {
+        return -1;
+      }
+      int cmp = compare_(mid_key, key);
+      if (cmp < 0 || (cmp == 0 && or_equal)) {
+        lo = mid + 1;
+      } else {
+        hi = mid;
+      }
+    }
+    return lo;
+  }
+
+  // Returns the position of the first key of leaf >= key
+  int LowerBound(const LeafSnapshot& leaf, const char* key) const {
+    int lo = 0;
+    int hi = leaf.count;
+    while (lo < hi) {
+      int mid = (lo + hi) / 2;
+      if (compare_(leaf.keys[mid], key) < 0) {
+        lo = mid + 1;
+      } else {
+        hi = mid;
+      }
+    }
+    return lo;
+  }
+
+  bool TryReadLeaf(const LeafNode* leaf, uint64_t version,
+                   LeafSnapshot* snapshot) const;
+
+  void ReadLeaf(const LeafNode* leaf, LeafSnapshot* snapshot) const;
+
+  // Copies the leaf that holds the first key >= key or, if before_key, the
+  // last key < key. A null key is before all keys, or after them if
+  // before_key.
+  void FindLeaf(const char* key, bool before_key,
+                LeafSnapshot* snapshot) const;
+
+  bool TryFindLeaf(const char* key, bool before_key,
+                   LeafSnapshot* snapshot) const;
+
+  // Returns false if the insert has to start over
+  bool TryInsert(const char* key);
+
+  // Splits the full node, and adds the separator key to parent, or to a new
+  // root if parent is null.
+  // REQUIRES: node and parent are locked
+  void Split(Node* node, InnerNode* parent);
+
+  LeafNode* NewLeaf() {
+    auto mem = allocator_->AllocateAligned(sizeof(LeafNode));
+    return new (mem) LeafNode();
+  }
+
+  InnerNode* NewInner() {
+    auto mem = allocator_->AllocateAligned(sizeof(InnerNode));
+    return new (mem) InnerNode();
+  }
+
+  const MemTableRep::KeyComparator& compare_;
+  std::atomic<Node*> root_;
+};
+
+BTreeRep::BTreeRep(const MemTableRep::KeyComparator& compare,
+                   MemTableAllocator* allocator)
+    : MemTableRep(allocator), compare_(compare) {
+  root_.store(NewLeaf(), std::memory_order_release);
+}
+
+bool BTreeRep::TryReadLeaf(const LeafNode* leaf, uint64_t version,
+                           LeafSnapshot* snapshot) const {
+  int count = leaf->count.load(std::memory_order_relaxed);
+  if (count > kLeafCapacity) {
+    return false;
+  }
+  for (int i = 0; i < count; i++) {
+    snapshot->keys[i] = leaf->keys[i].load(std::memory_order_acquire);
+    if (snapshot->keys[i] == nullptr) {
+      return false;
+    }
+  }
+  snapshot->next = leaf->next.load(std::memory_order_acquire);
+  if (!Validate(leaf, version)) {
+    return false;
+  }
+  snapshot->count = count;
+  return true;
+}
+
+void BTreeRep::ReadLeaf(const LeafNode* leaf, LeafSnapshot* snapshot) const {
+  while (true) {
+    uint64_t version;
+    if (ReadLock(leaf, &version) && TryReadLeaf(leaf, version, snapshot)) {
+      return;
+    }
+  }
+}
+
+void BTreeRep::FindLeaf(const char* key, bool before_key,
+                        LeafSnapshot* snapshot) const {
+  while (!TryFindLeaf(key, before_key, snapshot)) {
+  }
+}
+
+bool BTreeRep::TryFindLeaf(const char* key, bool before_key,
+                           LeafSnapshot* snapshot) const {
+  const Node* node = root_.load(std::memory_order_acquire);
+  uint64_t version;
+  if (!ReadLock(node, &version) ||
+      node != root_.load(std::memory_order_acquire)) {
+    return false;
+  }
+  const Node* parent = nullptr;
+  uint64_t parent_version = 0;
+  while (!node->is_leaf) {
+    auto inner = static_cast<const InnerNode*>(node);
+    int count = inner->count.load(std::memory_order_relaxed);
+    if (count > kInnerCapacity) {
+      return false;
+    }
+    // The keys equal to a separator are in the child to its right
+    int pos = (key == nullptr && before_key)
+                  ? count
+                  : Search(inner->keys, count, key, !before_key);
+    if (pos < 0) {
+      return false;
+    }
+    const Node* child = inner->children[pos].load(std::memory_order_acquire);
+    if (child == nullptr || !Validate(inner, version)) {
+      return false;
+    }
+    // The parent is checked again once the child is read locked, so that a
+    // split of the child since the parent was read is noticed
+    if (parent != nullptr && !Validate(parent, parent_version)) {
+      return false;
+    }
+    parent = inner;
+    parent_version = version;
+    node = child;
+    if (!ReadLock(node, &version)) {
+      return false;
+    }
+  }
+  if (!TryReadLeaf(static_cast<const LeafNode*>(node), version, snapshot)) {
+    return false;
+  }
+  return parent == nullptr || Validate(parent, parent_version);
+}
+
+bool BTreeRep::TryInsert(const char* key) {
+  Node* node = root_.load(std::memory_order_acquire);
+  uint64_t version;
+  if (!ReadLock(node, &version) ||
+      node != root_.load(std::memory_order_acquire)) {
+    return false;
+  }
+  InnerNode* parent = nullptr;
+  uint64_t parent_version = 0;
+  while (true) {
+    int count = node->count.load(std::memory_order_relaxed);
+    if (count == (node->is_leaf ? kLeafCapacity : kInnerCapacity)) {
+      // The node can only be full if nothing changed it since it was read
+      // locked, which the write locks check
+      if (parent != nullptr && !UpgradeToWriteLock(parent, parent_version)) {
+        return false;
+      }
+      if (!UpgradeToWriteLock(node, version)) {
+        if (parent != nullptr) {
+          WriteUnlock(parent);
+        }
+        return false;
+      }
+      Split(node, parent);
+      WriteUnlock(node);
+      if (parent != nullptr) {
+        WriteUnlock(parent);
+      }
+      return false;
+    }
+    if (node->is_leaf) {
+      break;
+    }
+    auto inner = static_cast<InnerNode*>(node);
+    int pos = Search(inner->keys, count, key, true /* or_equal */);
+    if (pos < 0) {
+      return false;
+    }
+    Node* child = inner->children[pos].load(std::memory_order_acquire);
+    if (child == nullptr || !Validate(inner, version)) {
+      return false;
+    }
+    if (parent != nullptr && !Validate(parent, parent_version)) {
+      return false;
+    }
+    parent = inner;
+    parent_version = version;
+    node = child;
+    if (!ReadLock(node, &version)) {
+      return false;
+    }
+  }
+
+  if (!UpgradeToWriteLock(node, version)) {
+    return false;
+  }
+  if (parent != nullptr && !Validate(parent, parent_version)) {
+    WriteUnlock(node);
+    return false;
+  }
+  auto leaf = static_cast<LeafNode*>(node);
+  int count = leaf->count.load(std::memory_order_relaxed);
+  assert(count < kLeafCapacity);
+  int pos = Search(leaf->keys, count, key, false /* or_equal */);
+  assert(pos >= 0);
+  // Our data structure does not allow duplicate insertion
+  assert(pos == count ||
+         compare_(leaf->keys[pos].load(std::memory_order_relaxed), key) != 0);
+  for (int i = count; i > pos; i--) {
+    leaf->keys[i].store(leaf->keys[i - 1].load(std::memory_order_relaxed),
+                        std::memory_order_release);
+  }
+  leaf->keys[pos].store(key, std::memory_order_release);
+  leaf->count.store(count + 1, std::memory_order_relaxed);
+  WriteUnlock(leaf);
+  return true;
+}
+
+void BTreeRep::Split(Node* node, InnerNode* parent) {
+  // The new node is only seen by readers once it is linked with a release
+  // store, so it is filled with relaxed ones
+  const char* separator;
+  Node* right;
+  if (node->is_leaf) {
+    auto leaf = static_cast<LeafNode*>(node);
+    auto new_leaf = NewLeaf();
+    const int mid = kLeafCapacity / 2;
+    for (int i = mid; i < kLeafCapacity; i++) {
+      new_leaf->keys[i - mid].store(
+          leaf->keys[i].load(std::memory_order_relaxed),
+          std::memory_order_relaxed);
+    }
+    new_leaf->count.store(kLeafCapacity - mid, std::memory_order_relaxed);
+    new_leaf->next.store(leaf->next.load(std::memory_order_relaxed),
+                         std::memory_order_relaxed);
+    leaf->next.store(new_leaf, std::memory_order_release);
+    leaf->count.store(mid, std::memory_order_relaxed);
+    separator = new_leaf->keys[0].load(std::memory_order_relaxed);
+    right = new_leaf;
+  } else {
+    auto inner = static_cast<InnerNode*>(node);
+    auto new_inner = NewInner();
+    const int mid = kInnerCapacity / 2;
+    separator = inner->keys[mid].load(std::memory_order_relaxed);
+    for (int i = mid + 1; i < kInnerCapacity; i++) {
+      new_inner->keys[i - mid - 1].store(
+          inner->keys[i].load(std::memory_order_relaxed),
+          std::memory_order_relaxed);
+    }
+    for (int i = mid + 1; i <= kInnerCapacity; i++) {
+      new_inner->children[i - mid - 1].store(
+          inner->children[i].load(std::memory_order_relaxed),
+          std::memory_order_relaxed);
+    }
+    new_inner->count.store(kInnerCapacity - mid - 1,
+                           std::memory_order_relaxed);
+    inner->count.store(mid, std::memory_order_relaxed);
+    right = new_inner;
+  }
+
+  if (parent == nullptr) {
+    auto root = NewInner();
+    root->keys[0].store(separator, std::memory_order_relaxed);
+    root->children[0].store(node, std::memory_order_relaxed);
+    root->children[1].store(right, std::memory_order_relaxed);
+    root->count.store(1, std::memory_order_relaxed);
+    root_.store(root, std::memory_order_release);
+    return;
+  }
+  int count = parent->count.load(std::memory_order_relaxed);
+  assert(count < kInnerCapacity);
+  int pos = Search(parent->keys, count, separator, false /* or_equal */);
+  assert(pos >= 0);
+  for (int i = count; i > pos; i--) {
+    parent->keys[i].store(parent->keys[i - 1].load(std::memory_order_relaxed),
+                          std::memory_order_release);
+    parent->children[i + 1].store(
+        parent->children[i].load(std::memory_order_relaxed),
+        std::memory_order_release);
+  }
+  parent->keys[pos].store(separator, std::memory_order_release);
+  parent->children[pos + 1].store(right, std::memory_order_release);
+  parent->count.store(count + 1, std::memory_order_relaxed);
+}
+
+bool BTreeRep::Contains(const char* key) const {
+  LeafSnapshot leaf;
+  FindLeaf(key, false /* before_key */, &leaf);
+  int pos = LowerBound(leaf, key);
+  return pos < leaf.count && compare_(leaf.keys[pos], key) == 0;
+}
+
+void BTreeRep::Get(const LookupKey& k, void* callback_args,
+                   bool (*callback_func)(void* arg, const char* entry)) {
+  BTreeRep::Iterator iter(this);
+  for (iter.Seek(Slice(), k.memtable_key().data());
+       iter.Valid() && callback_func(callback_args, iter.key());
+       iter.Next()) {
+  }
+}
+
+MemTableRep::Iterator* BTreeRep::GetIterator(Arena* arena) {
+  void* mem = arena ? arena->AllocateAligned(sizeof(BTreeRep::Iterator))
+                    : operator new(sizeof(BTreeRep::Iterator));
+  return new (mem) BTreeRep::Iterator(this);
+}
+
+}  // anon namespace
+
+MemTableRep* BTreeRepFactory::CreateMemTableRep(
+    const MemTableRep::KeyComparator& compare, MemTableAllocator* allocator,
+    const SliceTransform* transform, Logger* logger) {
+  return new BTreeRep(compare, allocator);
+}
+
+}  // namespace rocksdb
+#endif  // ROCKSDB_LITE
@@ -0,0 +1,233 @@
+//  Copyright (c) 2011-present, Facebook, Inc.  All rights reserved.
+//  This source code is licensed under the BSD-style license found in the
+//  LICENSE file in the root directory of this source tree. An additional grant
+//  of patent rights can be found in the PATENTS file in the same directory.
+
+#ifndef ROCKSDB_LITE
+
+#include <atomic>
+#include <memory>
+#include <set>
+#include <thread>
+#include <vector>
+
+#include "db/dbformat.h"
+#include "db/memtable.h"
+#include "rocksdb/comparator.h"
+#include "rocksdb/memtablerep.h"
+#include "rocksdb/write_buffer_manager.h"
+#include "util/coding.h"
+#include "util/concurrent_arena.h"
+#include "util/random.h"
+#include "util/testharness.h"
+
+namespace rocksdb {
+
+class BTreeRepTest : public testing::Test {
+ public:
+  BTreeRepTest()
+      : icmp_(BytewiseComparator()),
+        key_comp_(icmp_),
+        write_buffer_manager_(0),
+        allocator_(&arena_, &write_buffer_manager_) {
+    rep_.reset(BTreeRepFactory().CreateMemTableRep(key_comp_, &allocator_,
+                                                   nullptr, nullptr));
+  }
+
+  // Returns the entry of key, with a big-endian user key so that the
+  // entries sort like the keys
+  KeyHandle NewEntry(uint64_t key) {
+    std::string user_key;
+    for (int shift = 56; shift >= 0; shift -= 8) {
+      user_key.push_back(static_cast<char>(key >> shift));
+    }
+    InternalKey internal_key(user_key, 1, kTypeValue);
+    const Slice encoded = internal_key.Encode();
+    char* buf = nullptr;
+    KeyHandle handle = rep_->Allocate(
+        VarintLength(encoded.size()) + encoded.size(), &buf);
+    char* p = EncodeVarint32(buf, static_cast<uint32_t>(encoded.size()));
+    memcpy(p, encoded.data(), encoded.size());
+    return handle;
+  }
+
+  static uint64_t Decode(const char* entry) {
+    Slice user_key = ExtractUserKey(GetLengthPrefixedSlice(entry));
+    uint64_t key = 0;
+    for (size_t i = 0; i < user_key.size(); i++) {
+      key = (key << 8) | static_cast<unsigned char>(user_key[i]);
+    }
+    return key;
+  }
+
+  InternalKeyComparator icmp_;
+  MemTable::KeyComparator key_comp_;
+  ConcurrentArena arena_;
+  WriteBufferManager write_buffer_manager_;
+  MemTableAllocator allocator_;
+  std::unique_ptr<MemTableRep> rep_;
+};
+
+TEST_F(BTreeRepTest, Empty) {
+  std::unique_ptr<MemTableRep::Iterator> iter(rep_->GetIterator());
+  iter->SeekToFirst();
+  ASSERT_TRUE(!iter->Valid());
+  iter->SeekToLast();
+  ASSERT_TRUE(!iter->Valid());
+  const char* entry = static_cast<const char*>(NewEntry(100));
+  iter->Seek(Slice(), entry);
+  ASSERT_TRUE(!iter->Valid());
+  ASSERT_TRUE(!rep_->Contains(entry));
+}
+
+TEST_F(BTreeRepTest, InsertAndLookup) {
+  const int N = 20000;
+  const uint64_t R = 50000;
+  Random rnd(301);
+  std::set<uint64_t> keys;
+  for (int i = 0; i < N; i++) {
+    uint64_t key = rnd.Next() % R;
+    if (keys.insert(key).second) {
+      rep_->Insert(NewEntry(key));
+    }
+  }
+
+  for (uint64_t i = 0; i < R; i += 7) {
+    ASSERT_EQ(keys.count(i) == 1,
+              rep_->Contains(static_cast<const char*>(NewEntry(i))));
+  }
+
+  std::unique_ptr<MemTableRep::Iterator> iter(rep_->GetIterator());
+  iter->SeekToFirst();
+  for (uint64_t key : keys) {
+    ASSERT_TRUE(iter->Valid());
+    ASSERT_EQ(key, Decode(iter->key()));
+    iter->Next();
+  }
+  ASSERT_TRUE(!iter->Valid());
+
+  iter->SeekToLast();
+  for (auto it = keys.rbegin(); it != keys.rend(); ++it) {
+    ASSERT_TRUE(iter->Valid());
+    ASSERT_EQ(*it, Decode(iter->key()));
+    iter->Prev();
+  }
+  ASSERT_TRUE(!iter->Valid());
+
+  for (uint64_t i = 0; i < R + 10; i += 13) {
+    iter->Seek(Slice(), static_cast<const char*>(NewEntry(i)));
+    auto model = keys.lower_bound(i);
+    if (model == keys.end()) {
+      ASSERT_TRUE(!iter->Valid());
+      continue;
+    }
+    ASSERT_TRUE(iter->Valid());
+    ASSERT_EQ(*model, Decode(iter->key()));
+    // Moves across leaves both ways
+    for (int j = 0; j < 40 && iter->Valid(); j++) {
+      iter->Next();
+      ++model;
+      ASSERT_EQ(model != keys.end(), iter->Valid());
+      if (iter->Valid()) {
+        ASSERT_EQ(*model, Decode(iter->key()));
+      }
+    }
+    iter->Seek(Slice(), static_cast<const char*>(NewEntry(i)));
+    model = keys.lower_bound(i);
+    for (int j = 0; j < 40; j++) {
+      iter->Prev();
+      if (model == keys.begin()) {
+        ASSERT_TRUE(!iter->Valid());
+        break;
+      }
+      --model;
+      ASSERT_TRUE(iter->Valid());
+      ASSERT_EQ(*model, Decode(iter->key()));
+    }
+  }
+}
+
+TEST_F(BTreeRepTest, Get) {
+  for (uint64_t i = 0; i < 1000; i += 2) {
+    rep_->Insert(NewEntry(i));
+  }
+  struct Args {
+    std::vector<uint64_t> seen;
+  } args;
+  auto callback = [](void* arg, const char* entry) {
+    auto a = static_cast<Args*>(arg);
+    a->seen.push_back(Decode(entry));
+    return a->seen.size() < 3;
+  };
+  std::string user_key(7, '\0');
+  user_key.push_back(static_cast<char>(101));
+  LookupKey lookup_key(user_key, kMaxSequenceNumber);
+  rep_->Get(lookup_key, &args, callback);
+  ASSERT_EQ(std::vector<uint64_t>({102, 104, 106}), args.seen);
+}
+
+TEST_F(BTreeRepTest, ConcurrentInsert) {
+  const int kNumThreads = 4;
+  const uint64_t kNumKeys = 20000;
+  std::atomic<bool> done(false);
+
+  // A reader checks the order of what it sees while the writers run
+  std::thread reader([&]() {
+    while (!done.load()) {
+      std::unique_ptr<MemTableRep::Iterator> iter(rep_->GetIterator());
+      uint64_t last = 0;
+      bool first = true;
+      for (iter->SeekToFirst(); iter->Valid(); iter->Next()) {
+        uint64_t key = Decode(iter->key());
+        ASSERT_TRUE(first || last < key);
+        last = key;
+        first = false;
+      }
+    }
+  });
+
+  std::vector<std::thread> writers;
+  for (int t = 0; t < kNumThreads; t++) {
+    writers.emplace_back([&, t]() {
+      Random rnd(t + 1);
+      // Each writer inserts the keys k with k % kNumThreads == t, in random
+      // order, so that the writers share the leaves
+      std::vector<uint64_t> keys;
+      for (uint64_t k = t; k < kNumKeys; k += kNumThreads) {
+        keys.push_back(k);
+      }
+      for (size_t i = keys.size(); i > 1; i--) {
+        std::swap(keys[i - 1], keys[rnd.Uniform(static_cast<int>(i))]);
+      }
+      for (uint64_t k : keys) {
+        rep_->InsertConcurrently(NewEntry(k));
+      }
+    });
+  }
+  for (auto& writer : writers) {
+    writer.join();
+  }
+  done = true;
+  reader.join();
+
+  std::unique_ptr<MemTableRep::Iterator> iter(rep_->GetIterator());
+  uint64_t expected = 0;
+  for (iter->SeekToFirst(); iter->Valid(); iter->Next()) {
+    ASSERT_EQ(expected, Decode(iter->key()));
+    expected++;
+  }
+  ASSERT_EQ(kNumKeys, expected);
+}
+
+}  // namespace rocksdb
+
+#endif  // !ROCKSDB_LITE
+
+int main(int argc, char** argv) {
+#ifndef ROCKSDB_LITE
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+#else
+  return 0;
+#endif
+}
@@ -16,6 +16,7 @@
 #include "port/port.h"
 #include "util/histogram.h"
 #include "util/murmurhash.h"
+#include "util/mutexlock.h"
 #include "db/memtable.h"
 #include "db/skiplist.h"
 
@@ -172,6 +173,8 @@ class HashLinkListRep : public MemTableRep {
 
   virtual void Insert(KeyHandle handle) override;
 
+  virtual void InsertConcurrently(KeyHandle handle) override;
+
   virtual bool Contains(const char* key) const override;
 
   virtual size_t ApproximateMemoryUsage() override;
@@ -207,6 +210,19 @@ class HashLinkListRep : public MemTableRep {
   int bucket_entries_logging_threshold_;
   bool if_log_bucket_dist_when_flash_;
 
+  // A bucket changes shape as it grows, from a single node to a linked list
+  // and then to a skip list built from a copy of the list, which concurrent
+  // inserts into the same bucket would race with. InsertConcurrently takes
+  // the lock of the bucket's stripe around the same steps as Insert, so
+  // that inserts into buckets of different stripes still run in parallel.
+  // Readers never take the locks.
+  static const size_t kNumInsertLocks = 64;
+  struct InsertLock {
+    SpinMutex mutex;
+    char padding[CACHE_LINE_SIZE - sizeof(SpinMutex)];
+  };
+  InsertLock insert_locks_[kNumInsertLocks];
+
   bool LinkListContains(Node* head, const Slice& key) const;
 
   SkipListBucketHeader* GetSkipListBucketHeader(Pointer* first_next_pointer)
@@ -667,6 +683,14 @@ void HashLinkListRep::Insert(KeyHandle handle) {
   }
 }
 
+void HashLinkListRep::InsertConcurrently(KeyHandle handle) {
+  Node* x = static_cast<Node*>(handle);
+  auto transformed = GetPrefix(GetLengthPrefixedSlice(x->key));
+  std::lock_guard<SpinMutex> lock(
+      insert_locks_[GetHash(transformed) % kNumInsertLocks].mutex);
+  Insert(handle);
+}
+
 bool HashLinkListRep::Contains(const char* key) const {
   Slice internal_key = GetLengthPrefixedSlice(key);
 
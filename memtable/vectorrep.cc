@@ -10,23 +10,138 @@
 #include <set>
 #include <memory>
 #include <algorithm>
+#include <functional>
+#include <thread>
 #include <type_traits>
 
 #include "util/arena.h"
 #include "db/memtable.h"
 #include "memtable/stl_wrappers.h"
+#include "port/likely.h"
 #include "port/port.h"
 #include "util/mutexlock.h"
+#include "util/random.h"
 
 namespace rocksdb {
 namespace {
 
 using namespace stl_wrappers;
 
+typedef std::vector<const char*> Bucket;
+
+// Below this many entries per thread, sorting in parallel does not pay for
+// starting the threads
+const size_t kMinEntriesPerSortThread = 4096;
+
+// Runs the tasks, all but the last one in new threads, and waits for them
+void RunInParallel(const std::vector<std::function<void()>>& tasks) {
+  std::vector<std::thread> threads;
+  for (size_t i = 0; i + 1 < tasks.size(); i++) {
+    threads.emplace_back(tasks[i]);
+  }
+  if (!tasks.empty()) {
+    tasks.back()();
+  }
+  for (auto& thread : threads) {
+    thread.join();
+  }
+}
+
+// Adds the tasks that merge the sorted ranges [a, a_end) and [b, b_end) into
+// out. The larger range is cut into num_pieces pieces, the smaller one at the
+// matching keys, and each pair of pieces is merged by its own task.
+void AddMergeTasks(const char** a, const char** a_end, const char** b,
+                   const char** b_end, const char** out, size_t num_pieces,
+                   const Compare& cmp,
+                   std::vector<std::function<void()>>* tasks) {
+  const bool split_a = a_end - a >= b_end - b;
+  const size_t split_size = static_cast<size_t>(split_a ? a_end - a
+                                                        : b_end - b);
+  const char** a_begin = a;
+  const char** b_begin = b;
+  for (size_t i = 1; i <= num_pieces; i++) {
+    const char** a_next = a_end;
+    const char** b_next = b_end;
+    if (i < num_pieces) {
+      // The entries of a go before the equal entries of b
+      if (split_a) {
+        a_next = a + split_size * i / num_pieces;
+        b_next = a_next == a_end ? b_end
+                                 : std::lower_bound(b, b_end, *a_next, cmp);
+      } else {
+        b_next = b + split_size * i / num_pieces;
+        a_next = b_next == b_end ? a_end
+                                 : std::upper_bound(a, a_end, *b_next, cmp);
+      }
+    }
+    const char** dest = out + (a_begin - a) + (b_begin - b);
+    tasks->emplace_back([=]() {
+      std::merge(a_begin, a_next, b_begin, b_next, dest, cmp);
+    });
+    a_begin = a_next;
+    b_begin = b_next;
+  }
+}
+
+// Sorts bucket with up to sort_threads threads: each thread sorts a run of
+// the entries, and then the runs are merged pairwise, every round of merges
+// again split over all the threads.
+void SortBucket(Bucket* bucket, const MemTableRep::KeyComparator& compare,
+                size_t sort_threads) {
+  Compare cmp(compare);
+  const size_t n = bucket->size();
+  const size_t num_runs = std::min(sort_threads, n / kMinEntriesPerSortThread);
+  if (num_runs <= 1) {
+    std::sort(bucket->begin(), bucket->end(), cmp);
+    return;
+  }
+
+  std::vector<size_t> bounds;
+  for (size_t i = 0; i <= num_runs; i++) {
+    bounds.push_back(n * i / num_runs);
+  }
+  std::vector<std::function<void()>> tasks;
+  const char** src = bucket->data();
+  for (size_t i = 0; i < num_runs; i++) {
+    const char** begin = src + bounds[i];
+    const char** end = src + bounds[i + 1];
+    tasks.emplace_back([=]() { std::sort(begin, end, cmp); });
+  }
+  RunInParallel(tasks);
+
+  Bucket merged(n);
+  const char** dest = merged.data();
+  while (bounds.size() > 2) {
+    tasks.clear();
+    std::vector<size_t> merged_bounds = {0};
+    const size_t runs = bounds.size() - 1;
+    const size_t pieces = std::max<size_t>(1, sort_threads / (runs / 2));
+    for (size_t i = 0; i + 1 < runs; i += 2) {
+      AddMergeTasks(src + bounds[i], src + bounds[i + 1], src + bounds[i + 1],
+                    src + bounds[i + 2], dest + bounds[i], pieces, cmp,
+                    &tasks);
+      merged_bounds.push_back(bounds[i + 2]);
+    }
+    if (runs % 2 == 1) {
+      const char** begin = src + bounds[runs - 1];
+      const char** end = src + bounds[runs];
+      const char** out = dest + bounds[runs - 1];
+      tasks.emplace_back([=]() { std::copy(begin, end, out); });
+      merged_bounds.push_back(bounds[runs]);
+    }
+    RunInParallel(tasks);
+    std::swap(src, dest);
+    bounds.swap(merged_bounds);
+  }
+  if (src != bucket->data()) {
+    bucket->swap(merged);
+  }
+}
+
 class VectorRep : public MemTableRep {
  public:
   VectorRep(const KeyComparator& compare, MemTableAllocator* allocator,
-            size_t count);
+            size_t count, size_t sort_threads);
 
   // Insert key into the collection. (The caller will pack key and value into a
   // single buffer and pass that in as the parameter to Insert)
@@ -34,6 +149,9 @@ class VectorRep : public MemTableRep {
   // collection.
   virtual void Insert(KeyHandle handle) override;
 
+  // Appends key to the shard of the current core, without taking rwlock_
+  virtual void InsertConcurrently(KeyHandle handle) override;
+
   // Returns true iff an entry that compares equal to key is in the collection.
   virtual bool Contains(const char* key) const override;
 
@@ -54,11 +172,12 @@ class VectorRep : public MemTableRep {
     const KeyComparator& compare_;
     std::string tmp_;       // For passing to EncodeKey
     bool mutable sorted_;
+    const size_t sort_threads_;
     void DoSort() const;
    public:
     explicit Iterator(class VectorRep* vrep,
       std::shared_ptr<std::vector<const char*>> bucket,
-      const KeyComparator& compare);
+      const KeyComparator& compare, size_t sort_threads);
 
     // Initialize an iterator over the specified collection.
     // The returned iterator is not valid.
@@ -97,12 +216,32 @@ class VectorRep : public MemTableRep {
 
  private:
   friend class Iterator;
-  typedef std::vector<const char*> Bucket;
+
+  // The entries of concurrent writers are appended to the shard of their
+  // core, so that the writers of different cores don't contend.
+  // MarkReadOnly() moves them to bucket_.
+  struct Shard {
+    char padding[CACHE_LINE_SIZE];
+    SpinMutex mutex;
+    Bucket bucket;
+    std::atomic<size_t> num_entries;
+
+    Shard() : num_entries(0) {}
+  };
+
+  // Returns a copy of all the entries
+  // REQUIRES: rwlock_ held
+  Bucket* CopyEntries() const;
+
   std::shared_ptr<Bucket> bucket_;
   mutable port::RWMutex rwlock_;
   bool immutable_;
   bool sorted_;
   const KeyComparator& compare_;
+  const size_t sort_threads_;
+  // shards_[i & shard_mask_] is valid
+  size_t shard_mask_;
+  std::unique_ptr<Shard[]> shards_;
 };
 
 void VectorRep::Insert(KeyHandle handle) {
@@ -112,56 +251,113 @@ void VectorRep::Insert(KeyHandle handle) {
   bucket_->push_back(key);
 }
 
+void VectorRep::InsertConcurrently(KeyHandle handle) {
+  auto* key = static_cast<char*>(handle);
+  int cpuid = port::PhysicalCoreID();
+  if (UNLIKELY(cpuid < 0)) {
+    cpuid = Random::GetTLSInstance()->Uniform(static_cast<int>(shard_mask_) +
+                                              1);
+  }
+  Shard* shard = &shards_[cpuid & shard_mask_];
+  std::lock_guard<SpinMutex> lock(shard->mutex);
+  shard->bucket.push_back(key);
+  shard->num_entries.store(shard->bucket.size(), std::memory_order_relaxed);
+}
+
 // Returns true iff an entry that compares equal to key is in the collection.
 bool VectorRep::Contains(const char* key) const {
   ReadLock l(&rwlock_);
-  return std::find(bucket_->begin(), bucket_->end(), key) != bucket_->end();
+  if (std::find(bucket_->begin(), bucket_->end(), key) != bucket_->end()) {
+    return true;
+  }
+  for (size_t i = 0; i <= shard_mask_; i++) {
+    std::lock_guard<SpinMutex> lock(shards_[i].mutex);
+    const Bucket& bucket = shards_[i].bucket;
+    if (std::find(bucket.begin(), bucket.end(), key) != bucket.end()) {
+      return true;
+    }
+  }
+  return false;
 }
 
 void VectorRep::MarkReadOnly() {
   WriteLock l(&rwlock_);
+  for (size_t i = 0; i <= shard_mask_; i++) {
+    Shard* shard = &shards_[i];
+    std::lock_guard<SpinMutex> lock(shard->mutex);
+    bucket_->insert(bucket_->end(), shard->bucket.begin(),
+                    shard->bucket.end());
+    Bucket().swap(shard->bucket);
+    shard->num_entries.store(0, std::memory_order_relaxed);
+  }
   immutable_ = true;
 }
 
 size_t VectorRep::ApproximateMemoryUsage() {
+  size_t num_entries = bucket_->size();
+  for (size_t i = 0; i <= shard_mask_; i++) {
+    num_entries += shards_[i].num_entries.load(std::memory_order_relaxed);
+  }
   return
     sizeof(bucket_) + sizeof(*bucket_) +
-    bucket_->size() *
+    (shard_mask_ + 1) * sizeof(Shard) +
+    num_entries *
     sizeof(
       std::remove_reference<decltype(*bucket_)>::type::value_type
     );
 }
 
+Bucket* VectorRep::CopyEntries() const {
+  Bucket* copy = new Bucket(*bucket_);
+  for (size_t i = 0; i <= shard_mask_; i++) {
+    std::lock_guard<SpinMutex> lock(shards_[i].mutex);
+    copy->insert(copy->end(), shards_[i].bucket.begin(),
+                 shards_[i].bucket.end());
+  }
+  return copy;
+}
+
 VectorRep::VectorRep(const KeyComparator& compare, MemTableAllocator* allocator,
-                     size_t count)
+                     size_t count, size_t sort_threads)
   : MemTableRep(allocator),
     bucket_(new Bucket()),
     immutable_(false),
     sorted_(false),
-    compare_(compare) { bucket_.get()->reserve(count); }
+    compare_(compare),
+    sort_threads_(std::max<size_t>(sort_threads, 1)) {
+  bucket_.get()->reserve(count);
+  // find a power of two >= num_cpus
+  auto num_cpus = std::thread::hardware_concurrency();
+  shard_mask_ = 0;
+  while (shard_mask_ + 1 < num_cpus) {
+    shard_mask_ = shard_mask_ * 2 + 1;
+  }
+  shards_.reset(new Shard[shard_mask_ + 1]);
+}
 
 VectorRep::Iterator::Iterator(class VectorRep* vrep,
                    std::shared_ptr<std::vector<const char*>> bucket,
-                   const KeyComparator& compare)
+                   const KeyComparator& compare, size_t sort_threads)
 : vrep_(vrep),
   bucket_(bucket),
   cit_(bucket_->end()),
   compare_(compare),
-  sorted_(false) { }
+  sorted_(false),
+  sort_threads_(sort_threads) { }
 
 void VectorRep::Iterator::DoSort() const {
   // vrep is non-null means that we are working on an immutable memtable
   if (!sorted_ && vrep_ != nullptr) {
     WriteLock l(&vrep_->rwlock_);
     if (!vrep_->sorted_) {
-      std::sort(bucket_->begin(), bucket_->end(), Compare(compare_));
+      SortBucket(bucket_.get(), compare_, sort_threads_);
       cit_ = bucket_->begin();
       vrep_->sorted_ = true;
     }
     sorted_ = true;
   }
   if (!sorted_) {
-    std::sort(bucket_->begin(), bucket_->end(), Compare(compare_));
+    SortBucket(bucket_.get(), compare_, sort_threads_);
     cit_ = bucket_->begin();
     sorted_ = true;
   }
@@ -247,9 +443,10 @@ void VectorRep::Get(const LookupKey& k, void* callback_args,
     vector_rep = this;
   } else {
     vector_rep = nullptr;
-    bucket.reset(new Bucket(*bucket_));  // make a copy
+    bucket.reset(CopyEntries());  // make a copy
   }
-  VectorRep::Iterator iter(vector_rep, immutable_ ? bucket_ : bucket, compare_);
+  VectorRep::Iterator iter(vector_rep, immutable_ ? bucket_ : bucket, compare_,
+                           sort_threads_);
   rwlock_.ReadUnlock();
 
   for (iter.Seek(k.user_key(), k.memtable_key().data());
@@ -267,17 +464,17 @@ MemTableRep::Iterator* VectorRep::GetIterator(Arena* arena) {
   // a Seek is performed on the iterator.
   if (immutable_) {
     if (arena == nullptr) {
-      return new Iterator(this, bucket_, compare_);
+      return new Iterator(this, bucket_, compare_, sort_threads_);
     } else {
-      return new (mem) Iterator(this, bucket_, compare_);
+      return new (mem) Iterator(this, bucket_, compare_, sort_threads_);
     }
   } else {
     std::shared_ptr<Bucket> tmp;
-    tmp.reset(new Bucket(*bucket_)); // make a copy
+    tmp.reset(CopyEntries()); // make a copy
     if (arena == nullptr) {
-      return new Iterator(nullptr, tmp, compare_);
+      return new Iterator(nullptr, tmp, compare_, sort_threads_);
     } else {
-      return new (mem) Iterator(nullptr, tmp, compare_);
+      return new (mem) Iterator(nullptr, tmp, compare_, sort_threads_);
     }
   }
 }
@@ -286,7 +483,7 @@ MemTableRep::Iterator* VectorRep::GetIterator(Arena* arena) {
 MemTableRep* VectorRepFactory::CreateMemTableRep(
     const MemTableRep::KeyComparator& compare, MemTableAllocator* allocator,
     const SliceTransform*, Logger* logger) {
-  return new VectorRep(compare, allocator, count_);
+  return new VectorRep(compare, allocator, count_, sort_threads_);
 }
 } // namespace rocksdb
 #endif  // ROCKSDB_LITE
@@ -0,0 +1,161 @@
+//  Copyright (c) 2011-present, Facebook, Inc.  All rights reserved.
+//  This source code is licensed under the BSD-style license found in the
+//  LICENSE file in the root directory of this source tree. An additional grant
+//  of patent rights can be found in the PATENTS file in the same directory.
+
+#ifndef ROCKSDB_LITE
+
+#include <memory>
+#include <set>
+#include <thread>
+#include <vector>
+
+#include "db/dbformat.h"
+#include "db/memtable.h"
+#include "rocksdb/comparator.h"
+#include "rocksdb/memtablerep.h"
+#include "rocksdb/write_buffer_manager.h"
+#include "util/coding.h"
+#include "util/concurrent_arena.h"
+#include "util/random.h"
+#include "util/testharness.h"
+
+namespace rocksdb {
+
+class VectorRepTest : public testing::Test {
+ public:
+  VectorRepTest()
+      : icmp_(BytewiseComparator()),
+        key_comp_(icmp_),
+        write_buffer_manager_(0),
+        allocator_(&arena_, &write_buffer_manager_) {}
+
+  void NewRep(size_t sort_threads) {
+    rep_.reset(VectorRepFactory(0, sort_threads)
+                   .CreateMemTableRep(key_comp_, &allocator_, nullptr,
+                                      nullptr));
+  }
+
+  // Returns the entry of key, with a big-endian user key so that the
+  // entries sort like the keys
+  KeyHandle NewEntry(uint64_t key) {
+    std::string user_key;
+    for (int shift = 56; shift >= 0; shift -= 8) {
+      user_key.push_back(static_cast<char>(key >> shift));
+    }
+    InternalKey internal_key(user_key, 1, kTypeValue);
+    const Slice encoded = internal_key.Encode();
+    char* buf = nullptr;
+    KeyHandle handle = rep_->Allocate(
+        VarintLength(encoded.size()) + encoded.size(), &buf);
+    char* p = EncodeVarint32(buf, static_cast<uint32_t>(encoded.size()));
+    memcpy(p, encoded.data(), encoded.size());
+    return handle;
+  }
+
+  static uint64_t Decode(const char* entry) {
+    Slice user_key = ExtractUserKey(GetLengthPrefixedSlice(entry));
+    uint64_t key = 0;
+    for (size_t i = 0; i < user_key.size(); i++) {
+      key = (key << 8) | static_cast<unsigned char>(user_key[i]);
+    }
+    return key;
+  }
+
+  // Checks that the rep holds exactly keys, in order
+  void Verify(const std::set<uint64_t>& keys) {
+    std::unique_ptr<MemTableRep::Iterator> iter(rep_->GetIterator());
+    iter->SeekToFirst();
+    for (uint64_t key : keys) {
+      ASSERT_TRUE(iter->Valid());
+      ASSERT_EQ(key, Decode(iter->key()));
+      iter->Next();
+    }
+    ASSERT_TRUE(!iter->Valid());
+
+    for (uint64_t i = 0; i < 1000; i++) {
+      uint64_t target = *keys.begin() + i * 97;
+      iter->Seek(Slice(), static_cast<const char*>(NewEntry(target)));
+      auto model = keys.lower_bound(target);
+      ASSERT_EQ(model != keys.end(), iter->Valid());
+      if (iter->Valid()) {
+        ASSERT_EQ(*model, Decode(iter->key()));
+      }
+    }
+  }
+
+  InternalKeyComparator icmp_;
+  MemTable::KeyComparator key_comp_;
+  ConcurrentArena arena_;
+  WriteBufferManager write_buffer_manager_;
+  MemTableAllocator allocator_;
+  std::unique_ptr<MemTableRep> rep_;
+};
+
+TEST_F(VectorRepTest, ParallelSort) {
+  // Enough entries for the sort to use all the threads, and run counts that
+  // leave an odd run out of some merge rounds
+  for (size_t sort_threads : {1, 2, 3, 4, 7}) {
+    NewRep(sort_threads);
+    Random rnd(301);
+    std::set<uint64_t> keys;
+    for (int i = 0; i < 60000; i++) {
+      uint64_t key = rnd.Next() % 1000000;
+      if (keys.insert(key).second) {
+        rep_->Insert(NewEntry(key));
+      }
+    }
+    // A copy is sorted while the rep is mutable
+    Verify(keys);
+    rep_->MarkReadOnly();
+    Verify(keys);
+  }
+}
+
+TEST_F(VectorRepTest, ConcurrentInsert) {
+  const int kNumThreads = 4;
+  const uint64_t kNumKeys = 40000;
+  NewRep(kNumThreads);
+
+  std::vector<std::thread> writers;
+  for (int t = 0; t < kNumThreads; t++) {
+    writers.emplace_back([&, t]() {
+      Random rnd(t + 1);
+      std::vector<uint64_t> keys;
+      for (uint64_t k = t; k < kNumKeys; k += kNumThreads) {
+        keys.push_back(k);
+      }
+      for (size_t i = keys.size(); i > 1; i--) {
+        std::swap(keys[i - 1], keys[rnd.Uniform(static_cast<int>(i))]);
+      }
+      for (uint64_t k : keys) {
+        rep_->InsertConcurrently(NewEntry(k));
+      }
+    });
+  }
+  for (auto& writer : writers) {
+    writer.join();
+  }
+
+  std::set<uint64_t> keys;
+  for (uint64_t k = 0; k < kNumKeys; k++) {
+    keys.insert(k);
+  }
+  ASSERT_GE(rep_->ApproximateMemoryUsage(), kNumKeys * sizeof(const char*));
+  Verify(keys);
+  rep_->MarkReadOnly();
+  Verify(keys);
+}
+
+}  // namespace rocksdb
+
+#endif  // !ROCKSDB_LITE
+
+int main(int argc, char** argv) {
+#ifndef ROCKSDB_LITE
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+#else
+  return 0;
+#endif
+}
@@ -0,0 +1,116 @@
+//  Copyright (c) 2011-present, Facebook, Inc.  All rights reserved.
+//  This source code is licensed under the BSD-style license found in the
+//  LICENSE file in the root directory of this source tree. An additional grant
+//  of patent rights can be found in the PATENTS file in the same directory.
+//
+// Copyright (c) 2011 The LevelDB Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file. See the AUTHORS file for names of contributors.
+
+#include "rocksdb/write_buffer_manager.h"
+
+#include <assert.h>
+#include "util/coding.h"
+
+namespace rocksdb {
+
+namespace {
+const size_t kDummyKeySize = 16;
+
+void DeleteDummyEntry(const Slice& key, void* value) {}
+
+void EncodeDummyKey(char* buf, uint64_t cache_id, uint64_t index) {
+  EncodeFixed64(buf, cache_id);
+  EncodeFixed64(buf + 8, index);
+}
+}  // namespace
+
+WriteBufferManager::WriteBufferManager(size_t _buffer_size,
+                                       std::shared_ptr<Cache> cache)
+    : buffer_size_(_buffer_size),
+      memory_used_(0),
+      memory_active_(0),
+      cache_(cache),
+      cache_charged_(0),
+      cache_id_(0) {
+  if (cache_ != nullptr) {
+    cache_id_ = cache_->NewId();
+  }
+}
+
+WriteBufferManager::~WriteBufferManager() {
+  if (cache_ != nullptr) {
+    std::lock_guard<std::mutex> lock(cache_mutex_);
+    char key[kDummyKeySize];
+    while (!dummy_handles_.empty()) {
+      EncodeDummyKey(key, cache_id_, dummy_handles_.size() - 1);
+      cache_->Erase(Slice(key, kDummyKeySize));
+      cache_->Release(dummy_handles_.back());
+      dummy_handles_.pop_back();
+    }
+  }
+}
+
+void WriteBufferManager::ReserveMem(size_t mem) {
+  memory_used_.fetch_add(mem, std::memory_order_relaxed);
+  memory_active_.fetch_add(mem, std::memory_order_relaxed);
+  if (cache_ != nullptr) {
+    ReserveMemWithCache();
+  }
+}
+
+void WriteBufferManager::ScheduleFreeMem(size_t mem) {
+  memory_active_.fetch_sub(mem, std::memory_order_relaxed);
+}
+
+void WriteBufferManager::FreeMem(size_t mem) {
+  memory_used_.fetch_sub(mem, std::memory_order_relaxed);
+  if (cache_ != nullptr) {
+    FreeMemWithCache();
+  }
+}
+
+void WriteBufferManager::ReserveMemWithCache() {
+  // Fast path: the current charge already covers the usage.
+  if (memory_usage() < cache_charged_.load(std::memory_order_relaxed)) {
+    return;
+  }
+  std::lock_guard<std::mutex> lock(cache_mutex_);
+  char key[kDummyKeySize];
+  while (memory_usage() >= cache_charged_.load(std::memory_order_relaxed)) {
+    EncodeDummyKey(key, cache_id_, dummy_handles_.size());
+    Cache::Handle* handle = nullptr;
+    Status s = cache_->Insert(Slice(key, kDummyKeySize), nullptr,
+                              kDummyEntrySize, &DeleteDummyEntry, &handle);
+    if (!s.ok()) {
+      // The cache is full and has a strict capacity limit. Memtable
+      // allocation is not failed because of it; the charge simply stays
+      // below the actual usage until more space becomes available.
+      break;
+    }
+    dummy_handles_.push_back(handle);
+    cache_charged_.fetch_add(kDummyEntrySize, std::memory_order_relaxed);
+  }
+}
+
+void WriteBufferManager::FreeMemWithCache() {
+  // Keep some slack so that a memtable being allocated and freed around a
+  // dummy entry boundary does not keep inserting and erasing the same entry.
+  // Release one entry only once usage drops below 3/4 of the charge.
+  std::lock_guard<std::mutex> lock(cache_mutex_);
+  char key[kDummyKeySize];
+  while (!dummy_handles_.empty()) {
+    size_t charged = cache_charged_.load(std::memory_order_relaxed);
+    if (memory_usage() >= charged / 4 * 3 ||
+        charged - kDummyEntrySize < memory_usage()) {
+      break;
+    }
+    EncodeDummyKey(key, cache_id_, dummy_handles_.size() - 1);
+    cache_->Erase(Slice(key, kDummyKeySize));
+    cache_->Release(dummy_handles_.back());
+    dummy_handles_.pop_back();
+    cache_charged_.fetch_sub(kDummyEntrySize, std::memory_order_relaxed);
+  }
+}
+
+}  // namespace rocksdb
@@ -0,0 +1,96 @@
+//  Copyright (c) 2011-present, Facebook, Inc.  All rights reserved.
+//  This source code is licensed under the BSD-style license found in the
+//  LICENSE file in the root directory of this source tree. An additional grant
+//  of patent rights can be found in the PATENTS file in the same directory.
+//
+// Copyright (c) 2011 The LevelDB Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file. See the AUTHORS file for names of contributors.
+
+#include "rocksdb/write_buffer_manager.h"
+
+#include "util/testharness.h"
+
+namespace rocksdb {
+
+class WriteBufferManagerTest : public testing::Test {};
+
+TEST_F(WriteBufferManagerTest, ShouldFlush) {
+  const size_t kMB = 1024 * 1024;
+  WriteBufferManager wbf(10 * kMB);
+  ASSERT_TRUE(wbf.enabled());
+
+  wbf.ReserveMem(8 * kMB);
+  ASSERT_FALSE(wbf.ShouldFlush());
+  wbf.ReserveMem(3 * kMB);
+  ASSERT_TRUE(wbf.ShouldFlush());
+  ASSERT_EQ(11 * kMB, wbf.memory_usage());
+
+  // Memory of a memtable that became immutable no longer triggers flushes
+  // but is still accounted for until it is freed.
+  wbf.ScheduleFreeMem(3 * kMB);
+  ASSERT_FALSE(wbf.ShouldFlush());
+  ASSERT_EQ(8 * kMB, wbf.mutable_memtable_memory_usage());
+  ASSERT_EQ(11 * kMB, wbf.memory_usage());
+
+  wbf.FreeMem(3 * kMB);
+  ASSERT_EQ(8 * kMB, wbf.memory_usage());
+
+  WriteBufferManager disabled(0);
+  ASSERT_FALSE(disabled.enabled());
+  disabled.ReserveMem(1024 * kMB);
+  ASSERT_FALSE(disabled.ShouldFlush());
+}
+
+TEST_F(WriteBufferManagerTest, CacheCharge) {
+  const size_t kMB = 1024 * 1024;
+  std::shared_ptr<Cache> cache = NewLRUCache(100 * kMB, 4);
+  {
+    WriteBufferManager wbf(50 * kMB, cache);
+
+    wbf.ReserveMem(333 * 1024);
+    ASSERT_GE(cache->GetPinnedUsage(), 1 * kMB);
+    ASSERT_LT(cache->GetPinnedUsage(), 2 * kMB);
+
+    wbf.ReserveMem(10 * kMB);
+    ASSERT_GE(cache->GetPinnedUsage(), 11 * kMB);
+    ASSERT_LT(cache->GetPinnedUsage(), 12 * kMB);
+    ASSERT_EQ(cache->GetPinnedUsage(), wbf.dummy_entries_in_cache_usage());
+
+    // A small free keeps the charge to avoid thrashing dummy entries.
+    wbf.ScheduleFreeMem(kMB);
+    wbf.FreeMem(kMB);
+    ASSERT_GE(cache->GetPinnedUsage(), 11 * kMB);
+
+    // Freeing most of the memory releases the charge down to the usage.
+    wbf.ScheduleFreeMem(9 * kMB);
+    wbf.FreeMem(9 * kMB);
+    ASSERT_GE(cache->GetPinnedUsage(), wbf.memory_usage());
+    ASSERT_LT(cache->GetPinnedUsage(), 3 * kMB);
+  }
+  // Destroying the manager releases all the dummy entries.
+  ASSERT_EQ(0U, cache->GetPinnedUsage());
+  ASSERT_LT(cache->GetUsage(), kMB);
+}
+
+TEST_F(WriteBufferManagerTest, CacheChargeWithoutLimit) {
+  const size_t kMB = 1024 * 1024;
+  std::shared_ptr<Cache> cache = NewLRUCache(100 * kMB, 4);
+  WriteBufferManager wbf(0, cache);
+  ASSERT_FALSE(wbf.enabled());
+
+  wbf.ReserveMem(5 * kMB);
+  ASSERT_GE(cache->GetPinnedUsage(), 5 * kMB);
+  ASSERT_FALSE(wbf.ShouldFlush());
+
+  wbf.ScheduleFreeMem(5 * kMB);
+  wbf.FreeMem(5 * kMB);
+  ASSERT_EQ(0U, cache->GetPinnedUsage());
+}
+
+}  // namespace rocksdb
+
+int main(int argc, char** argv) {
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
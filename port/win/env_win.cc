@@ -1779,12 +1779,17 @@ class WinEnv : public Env {
 
   // Allow increasing the number of worker threads.
   virtual void SetBackgroundThreads(int num, Priority pri) override {
-    assert(pri >= Priority::LOW && pri <= Priority::HIGH);
+    assert(pri >= Priority::BOTTOM && pri <= Priority::HIGH);
     thread_pools_[pri].SetBackgroundThreads(num);
   }
 
+  virtual int GetBackgroundThreads(Priority pri) override {
+    assert(pri >= Priority::BOTTOM && pri <= Priority::HIGH);
+    return thread_pools_[pri].GetBackgroundThreads();
+  }
+
   virtual void IncBackgroundThreadsIfNeeded(int num, Priority pri) override {
-    assert(pri >= Priority::LOW && pri <= Priority::HIGH);
+    assert(pri >= Priority::BOTTOM && pri <= Priority::HIGH);
     thread_pools_[pri].IncBackgroundThreadsIfNeeded(num);
   }
 
@@ -1859,6 +1864,7 @@ class WinEnv : public Env {
           queue_len_(0U),
           exit_all_threads_(false),
           low_io_priority_(false),
+          priority_(Env::Priority::LOW),
           env_(nullptr) {}
 
     ~ThreadPool() { assert(bgthreads_.size() == 0U); }
@@ -1972,10 +1978,13 @@ class WinEnv : public Env {
 
 #if ROCKSDB_USING_THREAD_STATUS
       // for thread-status
-      ThreadStatusUtil::RegisterThread(
-          tp->env_, (tp->GetThreadPriority() == Env::Priority::HIGH
-                         ? ThreadStatus::HIGH_PRIORITY
-                         : ThreadStatus::LOW_PRIORITY));
+      ThreadStatus::ThreadType thread_type = ThreadStatus::LOW_PRIORITY;
+      if (tp->GetThreadPriority() == Env::Priority::HIGH) {
+        thread_type = ThreadStatus::HIGH_PRIORITY;
+      } else if (tp->GetThreadPriority() == Env::Priority::BOTTOM) {
+        thread_type = ThreadStatus::BOTTOM_PRIORITY;
+      }
+      ThreadStatusUtil::RegisterThread(tp->env_, thread_type);
 #endif
       tp->BGThread(thread_id);
 #if ROCKSDB_USING_THREAD_STATUS
@@ -1995,11 +2004,13 @@ class WinEnv : public Env {
 
       if (num > total_threads_limit_ ||
           (num < total_threads_limit_ && allow_reduce)) {
-        total_threads_limit_ = std::max(size_t(1), num);
+        // Only the BOTTOM pool may be empty, the others always run their
+        // jobs
+        total_threads_limit_ = std::max(
+            size_t(priority_ == Env::Priority::BOTTOM ? 0 : 1), num);
         WakeUpAllThreads();
         StartBGThreads();
       }
-      assert(total_threads_limit_ > 0);
     }
 
     void IncBackgroundThreadsIfNeeded(int num) {
@@ -2010,6 +2021,11 @@ class WinEnv : public Env {
       SetBackgroundThreadsInternal(num, true);
     }
 
+    int GetBackgroundThreads() {
+      std::lock_guard<std::mutex> lg(mu_);
+      return static_cast<int>(total_threads_limit_);
+    }
+
     void StartBGThreads() {
       // Start background thread if necessary
       while (bgthreads_.size() < total_threads_limit_) {
@@ -2146,6 +2162,8 @@ WinEnv::WinEnv()
     // This allows later initializing the thread-local-env of each thread.
     thread_pools_[pool_id].SetHostEnv(this);
   }
+  // Bottommost compactions stay in the LOW pool unless asked otherwise
+  thread_pools_[Priority::BOTTOM].SetBackgroundThreads(0);
 
   // Protected member of the base class
   thread_status_updater_ = CreateThreadStatusUpdater();
@@ -2153,7 +2171,7 @@ WinEnv::WinEnv()
 
 void WinEnv::Schedule(void (*function)(void*), void* arg, Priority pri,
                       void* tag, void (*unschedFunction)(void* arg)) {
-  assert(pri >= Priority::LOW && pri <= Priority::HIGH);
+  assert(pri >= Priority::BOTTOM && pri <= Priority::HIGH);
   thread_pools_[pri].Schedule(function, arg, tag, unschedFunction);
 }
 
@@ -2162,7 +2180,7 @@ int WinEnv::UnSchedule(void* arg, Priority pri) {
 }
 
 unsigned int WinEnv::GetThreadPoolQueueLen(Priority pri) const {
-  assert(pri >= Priority::LOW && pri <= Priority::HIGH);
+  assert(pri >= Priority::BOTTOM && pri <= Priority::HIGH);
   return thread_pools_[pri].GetQueueLen();
 }
 
@@ -9,6 +9,7 @@ LIB_SOURCES =                                                   \
   db/compaction_iterator.cc                                     \
   db/compaction_job.cc                                          \
   db/compaction_picker.cc                                       \
+  db/compaction_service.cc                                      \
   db/convenience.cc                                             \
   db/db_filesnapshot.cc                                         \
   db/dbformat.cc                                                \
@@ -25,21 +26,25 @@ LIB_SOURCES =                                                   \
   db/flush_job.cc                                               \
   db/flush_scheduler.cc                                         \
   db/forward_iterator.cc                                        \
+  db/in_memory_compaction_job.cc                                \
   db/internal_stats.cc                                          \
   db/log_reader.cc                                              \
   db/log_writer.cc                                              \
   db/managed_iterator.cc                                        \
   db/memtable_allocator.cc                                      \
   db/memtable.cc                                                \
+  db/memtable_key_index.cc                                      \
   db/memtable_list.cc                                           \
   db/merge_helper.cc                                            \
   db/merge_operator.cc                                          \
+  db/range_del_aggregator.cc                                    \
   db/repair.cc                                                  \
   db/slice.cc                                                   \
   db/snapshot_impl.cc                                           \
   db/table_cache.cc                                             \
   db/table_properties_collector.cc                              \
   db/transaction_log_impl.cc                                    \
+  db/unordered_write_tracker.cc                                 \
   db/version_builder.cc                                         \
   db/version_edit.cc                                            \
   db/version_set.cc                                             \
@@ -52,8 +57,10 @@ LIB_SOURCES =                                                   \
   memtable/hash_cuckoo_rep.cc                                   \
   memtable/hash_linklist_rep.cc                                 \
   memtable/hash_skiplist_rep.cc                                 \
+  memtable/btree_rep.cc                                         \
   memtable/skiplistrep.cc                                       \
   memtable/vectorrep.cc                                         \
+  memtable/write_buffer_manager.cc                              \
   port/stack_trace.cc                                           \
   port/port_posix.cc                                            \
   table/adaptive_table_factory.cc                               \
@@ -91,6 +98,7 @@ LIB_SOURCES =                                                   \
   util/cache.cc                                                 \
   util/coding.cc                                                \
   util/comparator.cc                                            \
+  util/compression.cc                                           \
   util/compaction_job_stats_impl.cc                             \
   util/concurrent_arena.cc                                      \
   util/crc32c.cc                                                \
@@ -115,6 +123,7 @@ LIB_SOURCES =                                                   \
   utilities/convenience/info_log_finder.cc                      \
   utilities/checkpoint/checkpoint.cc                            \
   utilities/compaction_filters/remove_emptyvalue_compactionfilter.cc    \
+  utilities/compaction_service/shared_dir_compaction_service.cc \
   utilities/document/document_db.cc                             \
   utilities/document/json_document_builder.cc                   \
   utilities/document/json_document.cc                           \
@@ -146,6 +155,7 @@ LIB_SOURCES =                                                   \
   util/log_buffer.cc                                            \
   util/logging.cc                                               \
   util/memenv.cc                                                \
+  util/memory_allocator.cc                                      \
   util/murmurhash.cc                                            \
   util/mutable_cf_options.cc                                    \
   util/options.cc                                               \
@@ -191,6 +201,7 @@ TEST_BENCH_SOURCES =                                                    \
   db/compaction_job_test.cc                                             \
   db/compaction_job_stats_test.cc                                       \
   db/compaction_picker_test.cc                                          \
+  db/compaction_service_test.cc                                         \
   db/comparator_db_test.cc                                              \
   db/corruption_test.cc                                                 \
   db/cuckoo_table_db_test.cc                                            \
@@ -203,6 +214,7 @@ TEST_BENCH_SOURCES =                                                    \
   db/db_dynamic_level_test.cc                                           \
   db/db_inplace_update_test.cc                                          \
   db/db_log_iter_test.cc                                                \
+  db/db_range_del_test.cc                                               \
   db/db_universal_compaction_test.cc                                    \
   db/db_tailing_iter_test.cc                                            \
   db/db_wal_test.cc                                                     \
@@ -216,6 +228,7 @@ TEST_BENCH_SOURCES =                                                    \
   db/listener_test.cc                                                   \
   db/log_test.cc                                                        \
   db/manual_compaction_test.cc                                          \
+  db/memtable_key_index_test.cc                                         \
   db/memtablerep_bench.cc                                               \
   db/merge_test.cc                                                      \
   db/options_file_test.cc                                               \
@@ -232,6 +245,9 @@ TEST_BENCH_SOURCES =                                                    \
   db/write_batch_test.cc                                                \
   db/write_controller_test.cc                                           \
   db/write_callback_test.cc                                             \
+  memtable/btree_rep_test.cc                                            \
+  memtable/vectorrep_test.cc                                            \
+  memtable/write_buffer_manager_test.cc                                 \
   table/block_based_filter_block_test.cc                                \
   table/block_hash_index_test.cc                                        \
   table/block_test.cc                                                   \
@@ -43,7 +43,9 @@ class Block {
   bool cachable() const { return contents_.cachable; }
   size_t usable_size() const {
 #ifdef ROCKSDB_MALLOC_USABLE_SIZE
-    if (contents_.allocation.get() != nullptr) {
+    // Only new[] allocations come from malloc
+    if (contents_.allocation.get() != nullptr &&
+        contents_.allocation.get_deleter().allocator == nullptr) {
       return malloc_usable_size(contents_.allocation.get());
     }
 #endif  // ROCKSDB_MALLOC_USABLE_SIZE
@@ -13,9 +13,13 @@
 #include <inttypes.h>
 #include <stdio.h>
 
+#include <condition_variable>
+#include <deque>
 #include <map>
 #include <memory>
+#include <mutex>
 #include <string>
+#include <thread>
 #include <unordered_map>
 #include <utility>
 
@@ -446,6 +450,145 @@ class BlockBasedTableBuilder::BlockBasedTablePropertiesCollector
   bool prefix_filtering_;
 };
 
+// State of the parallel compression of data blocks.  The thread building
+// the table queues every finished data block, together with the keys it
+// needs to replay into the filter and index builders, and writes the blocks
+// in order once they have been compressed by the worker threads.
+struct BlockBasedTableBuilder::ParallelCompressionRep {
+  struct BlockRep {
+    // Raw contents, replaced by the compressed contents once compressed
+    std::string contents;
+    CompressionType type;
+    size_t raw_size;
+    // Keys of the block, length prefixed
+    std::string keys;
+    std::string last_key;
+    // First key of the next block, if has_next_key
+    std::string next_key;
+    bool has_next_key;
+    // Guarded by mu
+    bool compressed;
+  };
+
+  ParallelCompressionRep(uint32_t num_threads,
+                         CompressionType _compression_type,
+                         const CompressionOptions& _compression_opts,
+                         uint32_t _format_version)
+      : compression_type(_compression_type),
+        compression_opts(_compression_opts),
+        format_version(_format_version),
+        max_queued_blocks(2 * num_threads),
+        queued_raw_bytes(0),
+        raw_bytes_written(0),
+        bytes_written(0),
+        shutdown(false) {
+    for (uint32_t i = 0; i < num_threads; i++) {
+      workers.emplace_back(&ParallelCompressionRep::BGWorkCompression, this);
+    }
+  }
+
+  ~ParallelCompressionRep() { Shutdown(); }
+
+  // Hands block over to the workers, unless it is already compressed
+  void Queue(BlockRep* block) {
+    queue.emplace_back(block);
+    queued_raw_bytes += block->raw_size;
+    if (!block->compressed) {
+      {
+        std::lock_guard<std::mutex> lock(mu);
+        compress_queue.push_back(block);
+      }
+      work_cv.notify_one();
+    }
+  }
+
+  bool IsCompressed(BlockRep* block) {
+    std::lock_guard<std::mutex> lock(mu);
+    return block->compressed;
+  }
+
+  void WaitCompressed(BlockRep* block) {
+    std::unique_lock<std::mutex> lock(mu);
+    done_cv.wait(lock, [block] { return block->compressed; });
+  }
+
+  // Waits for the workers to compress the blocks queued so far and stops
+  // them.
+  void Shutdown() {
+    {
+      std::lock_guard<std::mutex> lock(mu);
+      shutdown = true;
+    }
+    work_cv.notify_all();
+    for (auto& worker : workers) {
+      worker.join();
+    }
+    workers.clear();
+  }
+
+  // Estimated size of the queued blocks once compressed, based on the
+  // compression ratio of the blocks written so far
+  uint64_t EstimatedQueuedBytes() const {
+    if (raw_bytes_written == 0) {
+      return queued_raw_bytes;
+    }
+    return static_cast<uint64_t>(static_cast<double>(queued_raw_bytes) *
+                                 bytes_written / raw_bytes_written);
+  }
+
+  void BGWorkCompression() {
+    std::string compressed_output;
+    while (true) {
+      BlockRep* block;
+      {
+        std::unique_lock<std::mutex> lock(mu);
+        work_cv.wait(lock,
+                     [this] { return shutdown || !compress_queue.empty(); });
+        if (compress_queue.empty()) {
+          return;
+        }
+        block = compress_queue.front();
+        compress_queue.pop_front();
+      }
+
+      CompressionType type = compression_type;
+      CompressBlock(block->contents, compression_opts, &type, format_version,
+                    &compressed_output);
+      if (type != kNoCompression) {
+        block->contents.swap(compressed_output);
+      }
+      block->type = type;
+      compressed_output.clear();
+
+      {
+        std::lock_guard<std::mutex> lock(mu);
+        block->compressed = true;
+      }
+      done_cv.notify_all();
+    }
+  }
+
+  const CompressionType compression_type;
+  const CompressionOptions compression_opts;
+  const uint32_t format_version;
+  // Beyond it, the builder waits for the oldest block to be written
+  const size_t max_queued_blocks;
+
+  // Only accessed by the thread building the table
+  std::deque<std::unique_ptr<BlockRep>> queue;
+  std::string current_block_keys;
+  uint64_t queued_raw_bytes;
+  uint64_t raw_bytes_written;
+  uint64_t bytes_written;
+
+  std::mutex mu;
+  std::condition_variable work_cv;
+  std::condition_variable done_cv;
+  std::deque<BlockRep*> compress_queue;  // Guarded by mu
+  bool shutdown;                         // Guarded by mu
+  std::vector<std::thread> workers;
+};
+
 struct BlockBasedTableBuilder::Rep {
   const ImmutableCFOptions ioptions;
   const BlockBasedTableOptions table_options;
@@ -454,6 +597,8 @@ struct BlockBasedTableBuilder::Rep {
   uint64_t offset = 0;
   Status status;
   BlockBuilder data_block;
+  // Range deletions are kept out of the data blocks, see Add()
+  BlockBuilder range_del_block;
 
   InternalKeySliceTransform internal_prefix_transform;
   std::unique_ptr<IndexBuilder> index_builder;
@@ -477,6 +622,9 @@ struct BlockBasedTableBuilder::Rep {
 
   std::vector<std::unique_ptr<IntTblPropCollector>> table_properties_collectors;
 
+  // Set if the data blocks are compressed by worker threads
+  std::unique_ptr<ParallelCompressionRep> pc_rep;
+
   Rep(const ImmutableCFOptions& _ioptions,
       const BlockBasedTableOptions& table_opt,
       const InternalKeyComparator& icomparator,
@@ -492,6 +640,7 @@ struct BlockBasedTableBuilder::Rep {
         file(f),
         data_block(table_options.block_restart_interval,
                    table_options.use_delta_encoding),
+        range_del_block(1 /* block_restart_interval */),
         internal_prefix_transform(_ioptions.prefix_extractor),
         index_builder(
             CreateIndexBuilder(table_options.index_type, &internal_comparator,
@@ -514,6 +663,12 @@ struct BlockBasedTableBuilder::Rep {
         new BlockBasedTablePropertiesCollector(
             table_options.index_type, table_options.whole_key_filtering,
             _ioptions.prefix_extractor != nullptr));
+    if (compression_opts.parallel_threads > 1 &&
+        compression_type != kNoCompression) {
+      pc_rep.reset(new ParallelCompressionRep(
+          compression_opts.parallel_threads, compression_type,
+          compression_opts, table_options.format_version));
+    }
   }
 };
 
@@ -563,12 +718,24 @@ void BlockBasedTableBuilder::Add(const Slice& key, const Slice& value) {
   Rep* r = rep_;
   assert(!r->closed);
   if (!ok()) return;
+  if (key.size() >= 8 && ExtractValueType(key) == kTypeRangeDeletion) {
+    // Range deletions are not ordered with the other entries, and are read
+    // all at once, so they go into a meta block of their own. Some tests
+    // build tables of keys that are not internal keys, hence the size check
+    r->range_del_block.Add(key, value);
+    ++r->props.num_range_deletions;
+    return;
+  }
   if (r->props.num_entries > 0) {
     assert(r->internal_comparator.Compare(key, Slice(r->last_key)) > 0);
   }
 
   auto should_flush = r->flush_block_policy->Update(key, value);
-  if (should_flush) {
+  if (should_flush && r->pc_rep) {
+    assert(!r->data_block.empty());
+    // The index entry is added once the block has been written
+    QueueDataBlock(&key);
+  } else if (should_flush) {
     assert(!r->data_block.empty());
     Flush();
 
@@ -585,7 +752,10 @@ void BlockBasedTableBuilder::Add(const Slice& key, const Slice& value) {
     }
   }
 
-  if (r->filter_block != nullptr) {
+  if (r->pc_rep) {
+    // Replayed into the filter and index builders when the block is written
+    PutLengthPrefixedSlice(&r->pc_rep->current_block_keys, key);
+  } else if (r->filter_block != nullptr) {
     r->filter_block->Add(ExtractUserKey(key));
   }
 
@@ -595,8 +765,10 @@ void BlockBasedTableBuilder::Add(const Slice& key, const Slice& value) {
   r->props.raw_key_size += key.size();
   r->props.raw_value_size += value.size();
 
-  r->index_builder->OnKeyAdded(key);
-  NotifyCollectTableCollectorsOnAdd(key, value, r->offset,
+  if (!r->pc_rep) {
+    r->index_builder->OnKeyAdded(key);
+  }
+  NotifyCollectTableCollectorsOnAdd(key, value, FileSize(),
                                     r->table_properties_collectors,
                                     r->ioptions.info_log);
 }
@@ -606,6 +778,10 @@ void BlockBasedTableBuilder::Flush() {
   assert(!r->closed);
   if (!ok()) return;
   if (r->data_block.empty()) return;
+  if (r->pc_rep) {
+    QueueDataBlock(nullptr);
+    return;
+  }
   WriteBlock(&r->data_block, &r->pending_handle);
   if (ok() && !r->table_options.skip_table_builder_flush) {
     r->status = r->file->Flush();
@@ -617,6 +793,87 @@ void BlockBasedTableBuilder::Flush() {
   ++r->props.num_data_blocks;
 }
 
+void BlockBasedTableBuilder::QueueDataBlock(const Slice* next_key) {
+  Rep* r = rep_;
+  ParallelCompressionRep* pc_rep = r->pc_rep.get();
+  assert(pc_rep != nullptr);
+  if (!ok()) return;
+
+  std::unique_ptr<ParallelCompressionRep::BlockRep> block(
+      new ParallelCompressionRep::BlockRep());
+  Slice raw_block_contents = r->data_block.Finish();
+  block->contents.assign(raw_block_contents.data(),
+                         raw_block_contents.size());
+  block->raw_size = raw_block_contents.size();
+  r->data_block.Reset();
+  block->keys.swap(pc_rep->current_block_keys);
+  block->last_key = r->last_key;
+  block->has_next_key = next_key != nullptr;
+  if (next_key != nullptr) {
+    block->next_key.assign(next_key->data(), next_key->size());
+  }
+  block->type = r->compression_type;
+  block->compressed = false;
+  if (block->raw_size >= kCompressionSizeLimit) {
+    RecordTick(r->ioptions.statistics, NUMBER_BLOCK_NOT_COMPRESSED);
+    block->type = kNoCompression;
+    block->compressed = true;
+  }
+  pc_rep->Queue(block.release());
+  MeasureTime(r->ioptions.statistics, PARALLEL_COMPRESSION_QUEUE_DEPTH,
+              pc_rep->queue.size());
+
+  WriteQueuedDataBlocks(false /* wait */);
+}
+
+void BlockBasedTableBuilder::WriteQueuedDataBlocks(bool wait) {
+  Rep* r = rep_;
+  ParallelCompressionRep* pc_rep = r->pc_rep.get();
+  assert(pc_rep != nullptr);
+
+  while (ok() && !pc_rep->queue.empty()) {
+    ParallelCompressionRep::BlockRep* block = pc_rep->queue.front().get();
+    if (!pc_rep->IsCompressed(block)) {
+      if (!wait && pc_rep->queue.size() <= pc_rep->max_queued_blocks) {
+        break;
+      }
+      StopWatch sw(r->ioptions.env, r->ioptions.statistics,
+                   PARALLEL_COMPRESSION_WAIT_MICROS);
+      pc_rep->WaitCompressed(block);
+    }
+
+    // Same as Add() and Flush() do for a block written right away
+    Slice keys(block->keys);
+    Slice key;
+    while (GetLengthPrefixedSlice(&keys, &key)) {
+      if (r->filter_block != nullptr) {
+        r->filter_block->Add(ExtractUserKey(key));
+      }
+      r->index_builder->OnKeyAdded(key);
+    }
+    WriteRawBlock(block->contents, block->type, &r->pending_handle);
+    if (ok() && !r->table_options.skip_table_builder_flush) {
+      r->status = r->file->Flush();
+    }
+    if (r->filter_block != nullptr) {
+      r->filter_block->StartBlock(r->offset);
+    }
+    r->props.data_size = r->offset;
+    ++r->props.num_data_blocks;
+    if (ok()) {
+      Slice next_key(block->next_key);
+      r->index_builder->AddIndexEntry(
+          &block->last_key, block->has_next_key ? &next_key : nullptr,
+          r->pending_handle);
+    }
+
+    pc_rep->queued_raw_bytes -= block->raw_size;
+    pc_rep->raw_bytes_written += block->raw_size;
+    pc_rep->bytes_written += block->contents.size() + kBlockTrailerSize;
+    pc_rep->queue.pop_front();
+  }
+}
+
 void BlockBasedTableBuilder::WriteBlock(BlockBuilder* block,
                                         BlockHandle* handle) {
   WriteBlock(block->Finish(), handle);
@@ -712,7 +969,7 @@ Status BlockBasedTableBuilder::InsertBlockInCache(const Slice& block_contents,
 
     size_t size = block_contents.size();
 
-    std::unique_ptr<char[]> ubuf(new char[size + 1]);
+    CacheAllocationPtr ubuf(new char[size + 1]);
     memcpy(ubuf.get(), block_contents.data(), size);
     ubuf[size] = type;
 
@@ -744,6 +1001,10 @@ Status BlockBasedTableBuilder::Finish() {
   Flush();
   assert(!r->closed);
   r->closed = true;
+  if (r->pc_rep) {
+    WriteQueuedDataBlocks(true /* wait */);
+    r->pc_rep->Shutdown();
+  }
 
   BlockHandle filter_block_handle, metaindex_block_handle, index_block_handle;
   // Write filter block
@@ -756,7 +1017,9 @@ Status BlockBasedTableBuilder::Finish() {
   // To make sure properties block is able to keep the accurate size of index
   // block, we will finish writing all index entries here and flush them
   // to storage after metaindex block is written.
-  if (ok() && !empty_data_block) {
+  // With parallel compression, the index entry of the last data block has
+  // been added when it was written.
+  if (ok() && !empty_data_block && !r->pc_rep) {
     r->index_builder->AddIndexEntry(
         &r->last_key, nullptr /* no next data block */, r->pending_handle);
   }
@@ -780,6 +1043,14 @@ Status BlockBasedTableBuilder::Finish() {
     meta_index_builder.Add(item.first, block_handle);
   }
 
+  if (ok() && !r->range_del_block.empty()) {
+    BlockHandle range_del_block_handle;
+    WriteRawBlock(r->range_del_block.Finish(), kNoCompression,
+                  &range_del_block_handle);
+    meta_index_builder.Add(BlockBasedTable::kRangeDelBlock,
+                           range_del_block_handle);
+  }
+
   if (ok()) {
     if (r->filter_block != nullptr) {
       // Add mapping from "<filter_block_prefix>.Name" to location
@@ -803,6 +1074,10 @@ Status BlockBasedTableBuilder::Finish() {
           r->table_options.filter_policy->Name() : "";
       r->props.index_size =
           r->index_builder->EstimatedSize() + kBlockTrailerSize;
+      int64_t now = 0;
+      if (r->ioptions.env->GetCurrentTime(&now).ok() && now > 0) {
+        r->props.creation_time = static_cast<uint64_t>(now);
+      }
 
       // Add basic properties
       property_block_builder.AddTableProperty(r->props);
@@ -865,13 +1140,21 @@ void BlockBasedTableBuilder::Abandon() {
   Rep* r = rep_;
   assert(!r->closed);
   r->closed = true;
+  if (r->pc_rep) {
+    r->pc_rep->Shutdown();
+  }
 }
 
 uint64_t BlockBasedTableBuilder::NumEntries() const {
-  return rep_->props.num_entries;
+  return rep_->props.num_entries + rep_->props.num_range_deletions;
 }
 
 uint64_t BlockBasedTableBuilder::FileSize() const {
+  if (rep_->pc_rep) {
+    // Include the data blocks that have not been written yet, so that the
+    // callers cutting files by size are not misled
+    return rep_->offset + rep_->pc_rep->EstimatedQueuedBytes();
+  }
   return rep_->offset;
 }
 
@@ -897,4 +1180,5 @@ TableProperties BlockBasedTableBuilder::GetTableProperties() const {
 
 const std::string BlockBasedTable::kFilterBlockPrefix = "filter.";
 const std::string BlockBasedTable::kFullFilterBlockPrefix = "fullfilter.";
+const std::string BlockBasedTable::kRangeDelBlock = "rocksdb.range_del";
 }  // namespace rocksdb
@@ -92,6 +92,7 @@ class BlockBasedTableBuilder : public TableBuilder {
                             const CompressionType type,
                             const BlockHandle* handle);
   struct Rep;
+  struct ParallelCompressionRep;
   class BlockBasedTablePropertiesCollectorFactory;
   class BlockBasedTablePropertiesCollector;
   Rep* rep_;
@@ -102,6 +103,15 @@ class BlockBasedTableBuilder : public TableBuilder {
   // REQUIRES: Finish(), Abandon() have not been called
   void Flush();
 
+  // With parallel compression, hands the data block over to the compression
+  // workers instead of writing it.  next_key is the first key of the next
+  // data block, nullptr if there is none.
+  void QueueDataBlock(const Slice* next_key);
+  // With parallel compression, writes the queued data blocks whose
+  // compression has completed, in order.  If wait is true, waits until all
+  // the queued blocks have been written.
+  void WriteQueuedDataBlocks(bool wait);
+
   // Some compression libraries fail when the raw size is bigger than int. If
   // uncompressed size is bigger than kCompressionSizeLimit, don't compress it
   const uint64_t kCompressionSizeLimit = std::numeric_limits<int>::max();
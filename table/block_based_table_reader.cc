@@ -67,10 +67,11 @@ const size_t kMaxCacheKeyPrefixSize __attribute__((unused)) =
 Status ReadBlockFromFile(RandomAccessFileReader* file, const Footer& footer,
                          const ReadOptions& options, const BlockHandle& handle,
                          std::unique_ptr<Block>* result, Env* env,
-                         bool do_uncompress = true) {
+                         bool do_uncompress = true,
+                         MemoryAllocator* memory_allocator = nullptr) {
   BlockContents contents;
   Status s = ReadBlockContents(file, footer, options, handle, &contents, env,
-                               do_uncompress);
+                               do_uncompress, memory_allocator);
   if (s.ok()) {
     result->reset(new Block(std::move(contents)));
   }
@@ -78,6 +79,11 @@ Status ReadBlockFromFile(RandomAccessFileReader* file, const Footer& footer,
   return s;
 }
 
+// Returns the allocator of the data blocks that are read for block_cache
+MemoryAllocator* GetMemoryAllocator(Cache* block_cache) {
+  return block_cache != nullptr ? block_cache->memory_allocator() : nullptr;
+}
+
 // Delete the resource that is held by the iterator.
 template <class ResourceType>
 void DeleteHeldResource(void* arg, void* ignored) {
@@ -406,6 +412,9 @@ struct BlockBasedTable::Rep {
   FilterType filter_type;
   BlockHandle filter_handle;
 
+  // The range deletions of the table, if there are any
+  unique_ptr<Block> range_del_block;
+
   std::shared_ptr<const TableProperties> table_properties;
   BlockBasedTableOptions::IndexType index_type;
   bool hash_index_allow_collision;
@@ -556,6 +565,18 @@ Status BlockBasedTable::Open(const ImmutableCFOptions& ioptions,
     }
   }
 
+  // Read the range deletions. There are usually few of them, and every read
+  // that goes through the table needs all of them.
+  BlockHandle range_del_handle;
+  if (FindMetaBlock(meta_iter.get(), kRangeDelBlock, &range_del_handle).ok()) {
+    s = ReadBlockFromFile(rep->file.get(), rep->footer, ReadOptions(),
+                          range_del_handle, &rep->range_del_block,
+                          rep->ioptions.env);
+    if (!s.ok()) {
+      return s;
+    }
+  }
+
   // Read the properties
   bool found_properties_block = true;
   s = SeekToPropertiesBlock(meta_iter.get(), &found_properties_block);
@@ -690,9 +711,20 @@ size_t BlockBasedTable::ApproximateMemoryUsage() const {
   if (rep_->index_reader) {
     usage += rep_->index_reader->ApproximateMemoryUsage();
   }
+  if (rep_->range_del_block) {
+    usage += rep_->range_del_block->ApproximateMemoryUsage();
+  }
   return usage;
 }
 
+InternalIterator* BlockBasedTable::NewRangeTombstoneIterator(
+    const ReadOptions& read_options) {
+  if (rep_->range_del_block == nullptr) {
+    return nullptr;
+  }
+  return rep_->range_del_block->NewIterator(&rep_->internal_comparator);
+}
+
 // Load the meta-block from the file. On success, return the loaded meta block
 // and its iterator.
 Status BlockBasedTable::ReadMetaBlock(Rep* rep,
@@ -771,7 +803,7 @@ Status BlockBasedTable::GetDataBlockFromCache(
   BlockContents contents;
   s = UncompressBlockContents(compressed_block->data(),
                               compressed_block->size(), &contents,
-                              format_version);
+                              format_version, GetMemoryAllocator(block_cache));
 
   // Insert uncompressed block into block cache
   if (s.ok()) {
@@ -810,7 +842,7 @@ Status BlockBasedTable::PutDataBlockToCache(
   BlockContents contents;
   if (raw_block->compression_type() != kNoCompression) {
     s = UncompressBlockContents(raw_block->data(), raw_block->size(), &contents,
-                                format_version);
+                                format_version, GetMemoryAllocator(block_cache));
   }
   if (!s.ok()) {
     delete raw_block;
@@ -1108,7 +1140,8 @@ InternalIterator* BlockBasedTable::NewDataBlockIterator(
         StopWatch sw(rep->ioptions.env, statistics, READ_BLOCK_GET_MICROS);
         s = ReadBlockFromFile(rep->file.get(), rep->footer, ro, handle,
                               &raw_block, rep->ioptions.env,
-                              block_cache_compressed == nullptr);
+                              block_cache_compressed == nullptr,
+                              GetMemoryAllocator(block_cache));
       }
 
       if (s.ok()) {
@@ -1132,7 +1165,9 @@ InternalIterator* BlockBasedTable::NewDataBlockIterator(
     }
     std::unique_ptr<Block> block_value;
     s = ReadBlockFromFile(rep->file.get(), rep->footer, ro, handle,
-                          &block_value, rep->ioptions.env);
+                          &block_value, rep->ioptions.env,
+                          true /* do_uncompress */,
+                          GetMemoryAllocator(block_cache));
     if (s.ok()) {
       block.value = block_value.release();
     }
@@ -1571,6 +1606,48 @@ uint64_t BlockBasedTable::ApproximateOffsetOf(const Slice& key) {
   return result;
 }
 
+const size_t BlockBasedTable::kMaxNumAnchors;
+
+Status BlockBasedTable::ApproximateKeyAnchors(const ReadOptions& read_options,
+                                              std::vector<Anchor>* anchors) {
+  anchors->clear();
+  unique_ptr<InternalIterator> index_iter(NewIndexIterator(read_options));
+
+  // Every index entry points to one data block. Count them first, so that
+  // consecutive blocks can be merged into evenly sized anchors.
+  size_t num_blocks = 0;
+  for (index_iter->SeekToFirst(); index_iter->Valid(); index_iter->Next()) {
+    num_blocks++;
+  }
+  if (!index_iter->status().ok()) {
+    return index_iter->status();
+  }
+  const size_t blocks_per_anchor =
+      (num_blocks + kMaxNumAnchors - 1) / kMaxNumAnchors;
+
+  uint64_t range_size = 0;
+  size_t blocks_in_range = 0;
+  size_t block = 0;
+  for (index_iter->SeekToFirst(); index_iter->Valid(); index_iter->Next()) {
+    BlockHandle handle;
+    Slice input = index_iter->value();
+    Status s = handle.DecodeFrom(&input);
+    if (!s.ok()) {
+      return s;
+    }
+    range_size += handle.size() + kBlockTrailerSize;
+    blocks_in_range++;
+    block++;
+    // The index key of a block is at or after the last key of the block
+    if (blocks_in_range == blocks_per_anchor || block == num_blocks) {
+      anchors->emplace_back(ExtractUserKey(index_iter->key()), range_size);
+      range_size = 0;
+      blocks_in_range = 0;
+    }
+  }
+  return index_iter->status();
+}
+
 bool BlockBasedTable::TEST_filter_block_preloaded() const {
   return rep_->filter != nullptr;
 }
@@ -54,6 +54,8 @@ class BlockBasedTable : public TableReader {
  public:
   static const std::string kFilterBlockPrefix;
   static const std::string kFullFilterBlockPrefix;
+  // The name of the meta block of the range deletions
+  static const std::string kRangeDelBlock;
 
   // Attempt to open the table that is stored in bytes [0..file_size)
   // of "file", and read the metadata entries necessary to allow
@@ -87,6 +89,10 @@ class BlockBasedTable : public TableReader {
   InternalIterator* NewIterator(const ReadOptions&, Arena* arena = nullptr,
                                 bool skip_filters = false) override;
 
+  // The range deletions are read when the table is opened
+  InternalIterator* NewRangeTombstoneIterator(
+      const ReadOptions& read_options) override;
+
   // @param skip_filters Disables loading/accessing the filter block
   Status Get(const ReadOptions& readOptions, const Slice& key,
              GetContext* get_context, bool skip_filters = false) override;
@@ -104,6 +110,13 @@ class BlockBasedTable : public TableReader {
   // be close to the file length.
   uint64_t ApproximateOffsetOf(const Slice& key) override;
 
+  // Uses the keys of the index block, merging consecutive data blocks so
+  // that at most kMaxNumAnchors anchors are returned.
+  Status ApproximateKeyAnchors(const ReadOptions& read_options,
+                               std::vector<Anchor>* anchors) override;
+
+  static const size_t kMaxNumAnchors = 128;
+
   // Returns true if the block for the specified key is in cache.
   // REQUIRES: key is in this table && block cache enabled
   bool TEST_KeyInCache(const ReadOptions& options, const Slice& key);
@@ -14,6 +14,7 @@
 #include "rocksdb/status.h"
 #include "rocksdb/options.h"
 #include "rocksdb/table.h"
+#include "util/memory_allocator.h"
 
 namespace rocksdb {
 
@@ -177,7 +178,7 @@ struct BlockContents {
   Slice data;           // Actual contents of data
   bool cachable;        // True iff data can be cached
   CompressionType compression_type;
-  std::unique_ptr<char[]> allocation;
+  CacheAllocationPtr allocation;
 
   BlockContents() : cachable(false), compression_type(kNoCompression) {}
 
@@ -185,7 +186,7 @@ struct BlockContents {
                 CompressionType _compression_type)
       : data(_data), cachable(_cachable), compression_type(_compression_type) {}
 
-  BlockContents(std::unique_ptr<char[]>&& _data, size_t _size, bool _cachable,
+  BlockContents(CacheAllocationPtr&& _data, size_t _size, bool _cachable,
                 CompressionType _compression_type)
       : data(_data.get(), _size),
         cachable(_cachable),
@@ -205,23 +206,27 @@ struct BlockContents {
 
 // Read the block identified by "handle" from "file".  On failure
 // return non-OK.  On success fill *result and return OK.
+// The buffers of the contents are allocated from memory_allocator, or with
+// new[] if it is null.
 extern Status ReadBlockContents(RandomAccessFileReader* file,
                                 const Footer& footer,
                                 const ReadOptions& options,
                                 const BlockHandle& handle,
                                 BlockContents* contents, Env* env,
-                                bool do_uncompress);
+                                bool do_uncompress,
+                                MemoryAllocator* memory_allocator = nullptr);
 
 // The 'data' points to the raw block contents read in from file.
-// This method allocates a new heap buffer and the raw block
-// contents are uncompresed into this buffer. This buffer is
-// returned via 'result' and it is upto the caller to
+// This method allocates a new heap buffer, from memory_allocator if it is
+// not null, and the raw block contents are uncompresed into this buffer.
+// This buffer is returned via 'result' and it is upto the caller to
 // free this buffer.
 // For description of compress_format_version and possible values, see
 // util/compression.h
-extern Status UncompressBlockContents(const char* data, size_t n,
-                                      BlockContents* contents,
-                                      uint32_t compress_format_version);
+extern Status UncompressBlockContents(
+    const char* data, size_t n, BlockContents* contents,
+    uint32_t compress_format_version,
+    MemoryAllocator* memory_allocator = nullptr);
 
 // Implementation details follow.  Clients should ignore,
 
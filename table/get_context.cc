@@ -4,6 +4,7 @@
 //  of patent rights can be found in the PATENTS file in the same directory.
 
 #include "table/get_context.h"
+#include "db/range_del_aggregator.h"
 #include "rocksdb/env.h"
 #include "rocksdb/merge_operator.h"
 #include "rocksdb/statistics.h"
@@ -35,7 +36,7 @@ GetContext::GetContext(const Comparator* ucmp,
                        Statistics* statistics, GetState init_state,
                        const Slice& user_key, std::string* ret_value,
                        bool* value_found, MergeContext* merge_context, Env* env,
-                       SequenceNumber* seq)
+                       SequenceNumber* seq, RangeDelAggregator* range_del_agg)
     : ucmp_(ucmp),
       merge_operator_(merge_operator),
       logger_(logger),
@@ -47,7 +48,8 @@ GetContext::GetContext(const Comparator* ucmp,
       merge_context_(merge_context),
       env_(env),
       seq_(seq),
-      replay_log_(nullptr) {
+      replay_log_(nullptr),
+      range_del_agg_(range_del_agg) {
   if (seq_) {
     *seq_ = kMaxSequenceNumber;
   }
@@ -80,7 +82,12 @@ bool GetContext::SaveValue(const ParsedInternalKey& parsed_key,
   assert((state_ != kMerge && parsed_key.type != kTypeMerge) ||
          merge_context_ != nullptr);
   if (ucmp_->Equal(parsed_key.user_key, user_key_)) {
-    appendToReplayLog(replay_log_, parsed_key.type, value);
+    ValueType type = parsed_key.type;
+    if ((type == kTypeValue || type == kTypeMerge) &&
+        range_del_agg_ != nullptr && range_del_agg_->ShouldDelete(parsed_key)) {
+      type = kTypeRangeDeletion;
+    }
+    appendToReplayLog(replay_log_, type, value);
 
     if (seq_ != nullptr) {
       // Set the sequence number if it is uninitialized
@@ -90,7 +97,7 @@ bool GetContext::SaveValue(const ParsedInternalKey& parsed_key,
     }
 
     // Key matches. Process it
-    switch (parsed_key.type) {
+    switch (type) {
       case kTypeValue:
         assert(state_ == kNotFound || state_ == kMerge);
         if (kNotFound == state_) {
@@ -122,6 +129,7 @@ bool GetContext::SaveValue(const ParsedInternalKey& parsed_key,
 
       case kTypeDeletion:
       case kTypeSingleDeletion:
+      case kTypeRangeDeletion:
         // TODO(noetzli): Verify correctness once merge of single-deletes
         // is supported
         assert(state_ == kNotFound || state_ == kMerge);
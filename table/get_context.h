@@ -11,6 +11,7 @@
 
 namespace rocksdb {
 class MergeContext;
+class RangeDelAggregator;
 
 class GetContext {
  public:
@@ -26,7 +27,8 @@ class GetContext {
              Logger* logger, Statistics* statistics, GetState init_state,
              const Slice& user_key, std::string* ret_value, bool* value_found,
              MergeContext* merge_context, Env* env,
-             SequenceNumber* seq = nullptr);
+             SequenceNumber* seq = nullptr,
+             RangeDelAggregator* range_del_agg = nullptr);
 
   void MarkKeyMayExist();
 
@@ -51,6 +53,10 @@ class GetContext {
   // Do we need to fetch the SequenceNumber for this key?
   bool NeedToReadSequence() const { return (seq_ != nullptr); }
 
+  // The range deletions of the files the key is looked up in are added to
+  // it, and the entries it deletes are treated as deletions. May be null.
+  RangeDelAggregator* range_del_agg() { return range_del_agg_; }
+
  private:
   const Comparator* ucmp_;
   const MergeOperator* merge_operator_;
@@ -68,6 +74,7 @@ class GetContext {
   // write to the key or kMaxSequenceNumber if unknown
   SequenceNumber* seq_;
   std::string* replay_log_;
+  RangeDelAggregator* range_del_agg_;
 };
 
 void replayGetContextLog(const Slice& replay_log, const Slice& user_key,
@@ -97,6 +97,10 @@ PlainTableBuilder::PlainTableBuilder(
   properties_.format_version = (encoding_type == kPlain) ? 0 : 1;
   properties_.column_family_id = column_family_id;
   properties_.column_family_name = column_family_name;
+  int64_t now = 0;
+  if (ioptions.env->GetCurrentTime(&now).ok() && now > 0) {
+    properties_.creation_time = static_cast<uint64_t>(now);
+  }
 
   if (ioptions_.prefix_extractor) {
     properties_.user_collected_properties
@@ -52,6 +52,8 @@ std::string TableProperties::ToString(
   AppendProperty(result, "# data blocks", num_data_blocks, prop_delim,
                  kv_delim);
   AppendProperty(result, "# entries", num_entries, prop_delim, kv_delim);
+  AppendProperty(result, "# range deletions", num_range_deletions, prop_delim,
+                 kv_delim);
 
   AppendProperty(result, "raw key size", raw_key_size, prop_delim, kv_delim);
   AppendProperty(result, "raw average key size",
@@ -85,6 +87,7 @@ std::string TableProperties::ToString(
       result, "column family name",
       column_family_name.empty() ? std::string("N/A") : column_family_name,
       prop_delim, kv_delim);
+  AppendProperty(result, "creation time", creation_time, prop_delim, kv_delim);
 
   return result;
 }
@@ -97,6 +100,7 @@ void TableProperties::Add(const TableProperties& tp) {
   raw_value_size += tp.raw_value_size;
   num_data_blocks += tp.num_data_blocks;
   num_entries += tp.num_entries;
+  num_range_deletions += tp.num_range_deletions;
 }
 
 const std::string TablePropertiesNames::kDataSize  =
@@ -113,6 +117,8 @@ const std::string TablePropertiesNames::kNumDataBlocks =
     "rocksdb.num.data.blocks";
 const std::string TablePropertiesNames::kNumEntries =
     "rocksdb.num.entries";
+const std::string TablePropertiesNames::kNumRangeDeletions =
+    "rocksdb.num.range-deletions";
 const std::string TablePropertiesNames::kFilterPolicy =
     "rocksdb.filter.policy";
 const std::string TablePropertiesNames::kFormatVersion =
@@ -123,6 +129,8 @@ const std::string TablePropertiesNames::kColumnFamilyId =
     "rocksdb.column.family.id";
 const std::string TablePropertiesNames::kColumnFamilyName =
     "rocksdb.column.family.name";
+const std::string TablePropertiesNames::kCreationTime =
+    "rocksdb.creation.time";
 
 extern const std::string kPropertiesBlock = "rocksdb.properties";
 // Old property block name for backward compatibility
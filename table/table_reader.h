@@ -9,12 +9,16 @@
 
 #pragma once
 #include <memory>
+#include <string>
+#include <vector>
+
+#include "rocksdb/slice.h"
+#include "rocksdb/status.h"
 
 namespace rocksdb {
 
 class Iterator;
 struct ParsedInternalKey;
-class Slice;
 class Arena;
 struct ReadOptions;
 struct TableProperties;
@@ -41,6 +45,15 @@ class TableReader {
                                         Arena* arena = nullptr,
                                         bool skip_filters = false) = 0;
 
+  // Returns a new iterator over the range deletions of the table, whose keys
+  // are the internal keys of the start keys and whose values are the end
+  // keys, or nullptr if the table has none. Table formats that don't
+  // support range deletions never have any.
+  virtual InternalIterator* NewRangeTombstoneIterator(
+      const ReadOptions& read_options) {
+    return nullptr;
+  }
+
   // Given a key, return an approximate byte offset in the file where
   // the data for that key begins (or would begin if the key were
   // present in the file).  The returned value is in terms of file
@@ -49,6 +62,24 @@ class TableReader {
   // be close to the file length.
   virtual uint64_t ApproximateOffsetOf(const Slice& key) = 0;
 
+  // A user key sampled from the table, with the approximate number of bytes
+  // of the table between the previous anchor (or the start of the table) and
+  // the end of the data covered by this key.
+  struct Anchor {
+    Anchor(const Slice& _user_key, uint64_t _range_size)
+        : user_key(_user_key.ToString()), range_size(_range_size) {}
+    std::string user_key;
+    uint64_t range_size;
+  };
+
+  // Samples keys that split the table into ranges of similar size, in key
+  // order and with the last anchor at or after the largest key of the table.
+  // Used to divide a compaction into subcompactions of similar size.
+  virtual Status ApproximateKeyAnchors(const ReadOptions& read_options,
+                                       std::vector<Anchor>* anchors) {
+    return Status::NotSupported("ApproximateKeyAnchors() not supported");
+  }
+
   // Set up the table for Compaction. Might change some parameters with
   // posix_fadvise
   virtual void SetupForCompaction() = 0;
@@ -20,7 +20,6 @@
 #include "db/dbformat.h"
 #include "db/memtable.h"
 #include "db/write_batch_internal.h"
-#include "db/writebuffer.h"
 #include "memtable/stl_wrappers.h"
 #include "rocksdb/cache.h"
 #include "rocksdb/db.h"
@@ -30,6 +29,7 @@
 #include "rocksdb/perf_context.h"
 #include "rocksdb/slice_transform.h"
 #include "rocksdb/statistics.h"
+#include "rocksdb/write_buffer_manager.h"
 #include "table/block.h"
 #include "table/block_based_table_builder.h"
 #include "table/block_based_table_factory.h"
@@ -364,7 +364,7 @@ uint64_t TableConstructor::cur_uniq_id_ = 1;
 
 class MemTableConstructor: public Constructor {
  public:
-  explicit MemTableConstructor(const Comparator* cmp, WriteBuffer* wb)
+  explicit MemTableConstructor(const Comparator* cmp, WriteBufferManager* wb)
       : Constructor(cmp),
         internal_comparator_(cmp),
         write_buffer_(wb),
@@ -409,7 +409,7 @@ class MemTableConstructor: public Constructor {
   mutable Arena arena_;
   InternalKeyComparator internal_comparator_;
   Options options_;
-  WriteBuffer* write_buffer_;
+  WriteBufferManager* write_buffer_;
   MemTable* memtable_;
   std::shared_ptr<SkipListFactory> table_factory_;
 };
@@ -901,7 +901,7 @@ class HarnessTest : public testing::Test {
   ImmutableCFOptions ioptions_;
   BlockBasedTableOptions table_options_ = BlockBasedTableOptions();
   Constructor* constructor_;
-  WriteBuffer write_buffer_;
+  WriteBufferManager write_buffer_;
   bool support_prev_;
   bool only_support_prefix_seek_;
   shared_ptr<InternalKeyComparator> internal_comparator_;
@@ -1926,6 +1926,140 @@ TEST_F(BlockBasedTableTest, BlockCacheLeak) {
   c.ResetTableReader();
 }
 
+namespace {
+// Returns the contents of a block-based table file holding the key/values
+// of kvs, as internal keys
+std::string BuildBlockBasedTable(const Options& options,
+                                 const CompressionOptions& compression_opts,
+                                 const stl_wrappers::KVMap& kvs) {
+  unique_ptr<WritableFileWriter> file_writer(
+      test::GetWritableFileWriter(new test::StringSink()));
+  const ImmutableCFOptions ioptions(options);
+  InternalKeyComparator ikc(options.comparator);
+  std::vector<std::unique_ptr<IntTblPropCollectorFactory>>
+      int_tbl_prop_collector_factories;
+  std::string column_family_name;
+  std::unique_ptr<TableBuilder> builder(options.table_factory->NewTableBuilder(
+      TableBuilderOptions(ioptions, ikc, &int_tbl_prop_collector_factories,
+                          options.compression, compression_opts,
+                          false /* skip_filters */, column_family_name),
+      TablePropertiesCollectorFactory::Context::kUnknownColumnFamily,
+      file_writer.get()));
+  for (const auto& kv : kvs) {
+    builder->Add(InternalKey(kv.first, 1, kTypeValue).Encode(), kv.second);
+  }
+  EXPECT_OK(builder->Finish());
+  file_writer->Flush();
+
+  test::StringSink* ss =
+      static_cast<test::StringSink*>(file_writer->writable_file());
+  EXPECT_EQ(ss->contents().size(), builder->FileSize());
+  return ss->contents();
+}
+}  // namespace
+
+TEST_F(BlockBasedTableTest, ParallelCompression) {
+  std::vector<CompressionType> compression_types;
+  if (Zlib_Supported()) {
+    compression_types.push_back(kZlibCompression);
+  }
+  if (Snappy_Supported()) {
+    compression_types.push_back(kSnappyCompression);
+  }
+  if (compression_types.empty()) {
+    return;
+  }
+
+  Random rnd(301);
+  stl_wrappers::KVMap kvs;
+  for (int i = 0; i < 5000; i++) {
+    // Half of the values do not compress well
+    std::string value = i % 2 == 0 ? RandomString(&rnd, 100)
+                                   : test::RandomHumanReadableString(&rnd, 100);
+    char key[20];
+    snprintf(key, sizeof(key), "k%07d", i);
+    kvs[key] = value;
+  }
+
+  for (int i = 0; i < 4; i++) {
+    Options options;
+    BlockBasedTableOptions table_options;
+    table_options.block_size = 1024;
+    switch (i) {
+      case 0:
+        break;
+      case 1:
+        table_options.filter_policy.reset(NewBloomFilterPolicy(10, true));
+        break;
+      case 2:
+        table_options.filter_policy.reset(NewBloomFilterPolicy(10, false));
+        break;
+      default:
+        table_options.index_type = BlockBasedTableOptions::kHashSearch;
+        options.prefix_extractor.reset(NewFixedPrefixTransform(4));
+        break;
+    }
+    options.table_factory.reset(new BlockBasedTableFactory(table_options));
+
+    for (auto compression_type : compression_types) {
+      options.compression = compression_type;
+      CompressionOptions compression_opts;
+      std::string expected =
+          BuildBlockBasedTable(options, compression_opts, kvs);
+      for (uint32_t threads : {2, 8}) {
+        compression_opts.parallel_threads = threads;
+        // The output does not depend on the number of threads
+        ASSERT_TRUE(expected ==
+                    BuildBlockBasedTable(options, compression_opts, kvs));
+      }
+    }
+  }
+}
+
+TEST_F(BlockBasedTableTest, ApproximateKeyAnchors) {
+  Random rnd(301);
+  TableConstructor c(BytewiseComparator());
+  for (int i = 0; i < 10000; i++) {
+    char key[20];
+    snprintf(key, sizeof(key), "k%07d", i);
+    c.Add(InternalKey(key, 0, kTypeValue).Encode().ToString(),
+          RandomString(&rnd, 100));
+  }
+  std::vector<std::string> keys;
+  stl_wrappers::KVMap kvmap;
+  Options options;
+  options.compression = kNoCompression;
+  BlockBasedTableOptions table_options;
+  table_options.block_size = 1024;
+  options.table_factory.reset(NewBlockBasedTableFactory(table_options));
+  const ImmutableCFOptions ioptions(options);
+  InternalKeyComparator ikc(options.comparator);
+  c.Finish(options, ioptions, table_options, ikc, &keys, &kvmap);
+
+  // About 1000 data blocks are merged into at most 128 anchors
+  std::vector<TableReader::Anchor> anchors;
+  ASSERT_OK(c.GetTableReader()->ApproximateKeyAnchors(ReadOptions(), &anchors));
+  ASSERT_LE(anchors.size(), BlockBasedTable::kMaxNumAnchors);
+  ASSERT_GT(anchors.size(), BlockBasedTable::kMaxNumAnchors / 2);
+  uint64_t total_size = 0;
+  for (size_t i = 0; i < anchors.size(); i++) {
+    if (i > 0) {
+      ASSERT_LT(anchors[i - 1].user_key, anchors[i].user_key);
+      // The ranges have similar sizes, only the last one may be smaller
+      if (i + 1 < anchors.size()) {
+        ASSERT_TRUE(Between(anchors[i].range_size,
+                            anchors[0].range_size * 9 / 10,
+                            anchors[0].range_size * 11 / 10));
+      }
+    }
+    total_size += anchors[i].range_size;
+  }
+  ASSERT_GE(anchors.back().user_key, ExtractUserKey(keys.back()).ToString());
+  // The anchors cover all data blocks, including their trailers
+  ASSERT_EQ(c.GetTableReader()->GetTableProperties()->data_size, total_size);
+  c.ResetTableReader();
+}
+
 // Plain table is not supported in ROCKSDB_LITE
 #ifndef ROCKSDB_LITE
 TEST_F(PlainTableTest, BasicPlainTableProperties) {
@@ -2133,7 +2267,7 @@ TEST_F(MemTableTest, Simple) {
   Options options;
   options.memtable_factory = table_factory;
   ImmutableCFOptions ioptions(options);
-  WriteBuffer wb(options.db_write_buffer_size);
+  WriteBufferManager wb(options.db_write_buffer_size);
   MemTable* memtable =
       new MemTable(cmp, ioptions, MutableCFOptions(options, ioptions), &wb,
                    kMaxSequenceNumber);
@@ -4,7 +4,7 @@
 if [ $# -ne 1 ]; then
   echo -n "./benchmark.sh [bulkload/fillseq/overwrite/filluniquerandom/"
   echo    "readrandom/readwhilewriting/readwhilemerging/updaterandom/"
-  echo    "mergerandom/randomtransaction/compact]"
+  echo    "mergerandom/randomtransaction/compact/overwrite_bottom_pri]"
   exit 0
 fi
 
@@ -342,6 +342,29 @@ function run_change {
   summarize_result $output_dir/${out_name} ${operation}.t${num_threads}.s${syncval} $operation
 }
 
+# Overwrites with and without a thread pool for the compactions into the last
+# level. Compare the Stall-time and Stall% columns of the two results: with
+# few compaction threads, long compactions into the last level otherwise hold
+# the threads that L0 compactions need.
+function run_overwrite_bottom_pri {
+  for bottom_pri_threads in 0 ${NUM_BOTTOM_PRI_THREADS:-2}; do
+    echo "Do $num_keys random overwrite with $bottom_pri_threads bottom-pri threads"
+    out_name="benchmark_overwrite_bottom_pri${bottom_pri_threads}.t${num_threads}.s${syncval}.log"
+    cmd="./db_bench --benchmarks=overwrite \
+         --use_existing_db=1 \
+         --sync=$syncval \
+         $params_w \
+         --max_background_compactions=${MAX_BACKGROUND_COMPACTIONS:-4} \
+         --num_bottom_pri_threads=$bottom_pri_threads \
+         --threads=$num_threads \
+         --seed=$( date +%s ) \
+         2>&1 | tee -a $output_dir/${out_name}"
+    echo $cmd | tee $output_dir/${out_name}
+    eval $cmd
+    summarize_result $output_dir/${out_name} overwrite.bottom_pri${bottom_pri_threads}.t${num_threads}.s${syncval} overwrite
+  done
+}
+
 function run_filluniquerandom {
   echo "Loading $num_keys unique keys randomly"
   cmd="./db_bench --benchmarks=filluniquerandom \
@@ -464,6 +487,8 @@ for job in ${jobs[@]}; do
     run_fillseq 0
   elif [ $job = overwrite ]; then
     run_change overwrite
+  elif [ $job = overwrite_bottom_pri ]; then
+    run_overwrite_bottom_pri
   elif [ $job = updaterandom ]; then
     run_change updaterandom
   elif [ $job = mergerandom ]; then
@@ -0,0 +1,84 @@
+//  Copyright (c) 2011-present, Facebook, Inc.  All rights reserved.
+//  This source code is licensed under the BSD-style license found in the
+//  LICENSE file in the root directory of this source tree. An additional grant
+//  of patent rights can be found in the PATENTS file in the same directory.
+//
+// Runs the compactions that DBs using NewSharedDirCompactionService() hand to
+// a shared directory. The DBs are opened with default options, so they must
+// not depend on a custom comparator, merge operator or compaction filter.
+#ifndef ROCKSDB_LITE
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <memory>
+#include <string>
+
+#include "rocksdb/env.h"
+#include "rocksdb/options.h"
+#include "rocksdb/utilities/shared_dir_compaction_service.h"
+#include "util/stderr_logger.h"
+
+namespace {
+
+void PrintUsage(const char* name) {
+  fprintf(stderr,
+          "Usage: %s --shared_dir=<dir> [--poll_interval_ms=<ms>] [--once]\n"
+          "  --shared_dir        directory shared with the DBs\n"
+          "  --poll_interval_ms  wait between looking for requests, "
+          "default 100\n"
+          "  --once              exit once there are no pending requests\n",
+          name);
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  std::string shared_dir;
+  int poll_interval_ms = 100;
+  bool once = false;
+  for (int i = 1; i < argc; i++) {
+    if (strncmp(argv[i], "--shared_dir=", 13) == 0) {
+      shared_dir = argv[i] + 13;
+    } else if (strncmp(argv[i], "--poll_interval_ms=", 19) == 0) {
+      poll_interval_ms = atoi(argv[i] + 19);
+    } else if (strcmp(argv[i], "--once") == 0) {
+      once = true;
+    } else {
+      PrintUsage(argv[0]);
+      return 1;
+    }
+  }
+  if (shared_dir.empty()) {
+    PrintUsage(argv[0]);
+    return 1;
+  }
+
+  rocksdb::Options options;
+  // Don't replace the info log of the DBs
+  options.info_log =
+      std::make_shared<rocksdb::StderrLogger>(rocksdb::InfoLogLevel::WARN_LEVEL);
+  rocksdb::Env* env = rocksdb::Env::Default();
+  while (true) {
+    bool found = false;
+    rocksdb::Status s =
+        rocksdb::RunSharedDirCompactionRequest(options, shared_dir, &found);
+    if (!s.ok()) {
+      fprintf(stderr, "%s\n", s.ToString().c_str());
+    }
+    if (!found) {
+      if (once) {
+        break;
+      }
+      env->SleepForMicroseconds(poll_interval_ms * 1000);
+    }
+  }
+  return 0;
+}
+#else
+#include <stdio.h>
+int main(int argc, char** argv) {
+  fprintf(stderr, "Not supported in lite mode.\n");
+  return 1;
+}
+#endif  // ROCKSDB_LITE
@@ -43,6 +43,7 @@
 #include "rocksdb/db.h"
 #include "rocksdb/env.h"
 #include "rocksdb/filter_policy.h"
+#include "rocksdb/memory_allocator.h"
 #include "rocksdb/memtablerep.h"
 #include "rocksdb/options.h"
 #include "rocksdb/perf_context.h"
@@ -253,6 +254,16 @@ DEFINE_bool(enable_numa, false,
             "CPU and memory of same node. Use \"$numactl --hardware\" command "
             "to see NUMA memory architecture.");
 
+DEFINE_string(memory_allocator, "",
+              "If \"numa_default\", \"numa_interleave\" or \"numa_local\", "
+              "the memtable arenas and the data blocks of the block caches "
+              "are allocated by NewNumaMemoryAllocator() with that NUMA "
+              "policy");
+
+DEFINE_bool(memory_allocator_transparent_huge_pages, false,
+            "Ask the OS to back the memory of --memory_allocator with "
+            "transparent huge pages");
+
 DEFINE_int64(db_write_buffer_size, rocksdb::Options().db_write_buffer_size,
              "Number of bytes to buffer in all memtables before compacting");
 
@@ -294,6 +305,12 @@ DEFINE_int32(max_background_compactions,
              "The maximum number of concurrent background compactions"
              " that can occur in parallel.");
 
+DEFINE_int32(num_bottom_pri_threads, 0,
+             "The number of threads in the bottom-priority thread pool, which "
+             "runs the compactions into the last level, so that they don't "
+             "hold the threads of max_background_compactions. 0 runs them "
+             "with the other compactions.");
+
 DEFINE_uint64(subcompactions, 1,
               "Maximum number of subcompactions to divide L0-L1 compactions "
               "into.");
@@ -385,6 +402,8 @@ DEFINE_int32(bloom_bits, -1, "Bloom filter bits per key. Negative means"
              " use default settings.");
 DEFINE_int32(memtable_bloom_bits, 0, "Bloom filter bits per key for memtable. "
              "Negative means no bloom filter.");
+DEFINE_int32(memtable_key_index_slots, 0, "Number of slots of the hash index "
+             "of the memtable keys for point lookups. 0 means no index.");
 
 DEFINE_bool(use_existing_db, false, "If true, do not destroy the existing"
             " database.  If you set this flag and also specify a benchmark that"
@@ -556,10 +575,19 @@ DEFINE_string(compression_type, "snappy",
 static enum rocksdb::CompressionType FLAGS_compression_type_e =
     rocksdb::kSnappyCompression;
 
+DEFINE_string(wal_compression, "none",
+              "Algorithm to use to compress the WAL. Only zlib is supported");
+static enum rocksdb::CompressionType FLAGS_wal_compression_e =
+    rocksdb::kNoCompression;
+
 DEFINE_int32(compression_level, -1,
              "Compression level. For zlib this should be -1 for the "
              "default level, or between 0 and 9.");
 
+DEFINE_uint64(compression_parallel_threads, 1,
+              "Number of threads used to compress the data blocks of a table "
+              "file being written by a flush or a compaction.");
+
 static bool ValidateCompressionLevel(const char* flagname, int32_t value) {
   if (value < -1 || value > 9) {
     fprintf(stderr, "Invalid value for --%s: %d, must be between -1 and 9\n",
@@ -638,9 +666,18 @@ DEFINE_uint64(delayed_write_rate, 8388608u,
               "Limited bytes allowed to DB when soft_rate_limit or "
               "level0_slowdown_writes_trigger triggers");
 
+DEFINE_bool(adaptive_delayed_write_rate, false,
+            "Derive the delayed write rate from the measured compaction "
+            "throughput and the remaining headroom before writes stop.");
+
 DEFINE_bool(allow_concurrent_memtable_write, false,
             "Allow multi-writers to update mem tables in parallel.");
 
+DEFINE_bool(unordered_write, false,
+            "Let each writer insert into the memtable without waiting for "
+            "earlier write groups. Requires "
+            "--allow_concurrent_memtable_write.");
+
 DEFINE_bool(enable_write_thread_adaptive_yield, false,
             "Use a yielding spin loop for brief writer thread waits.");
 
@@ -781,6 +818,9 @@ enum RepFactory StringToRepFactory(const char* ctype) {
 static enum RepFactory FLAGS_rep_factory;
 DEFINE_string(memtablerep, "skip_list", "");
 DEFINE_int64(hash_bucket_count, 1024 * 1024, "hash bucket count");
+DEFINE_int32(vector_sort_threads, 1, "The number of threads that sort a "
+             "vector memtable (--memtablerep=vector) when it is read or "
+             "flushed");
 DEFINE_bool(use_plain_table, false, "if use plain table "
             "instead of block-based table format");
 DEFINE_bool(use_cuckoo_table, false, "if use cuckoo table format");
@@ -1752,20 +1792,43 @@ class Benchmark {
 #endif
   }
 
+  // Returns the allocator selected by --memory_allocator, or nullptr
+  static std::shared_ptr<MemoryAllocator> GetMemoryAllocator() {
+    static std::shared_ptr<MemoryAllocator> memory_allocator;
+    if (memory_allocator == nullptr && !FLAGS_memory_allocator.empty()) {
+      NumaPolicy policy;
+      if (FLAGS_memory_allocator == "numa_default") {
+        policy = kNumaDefault;
+      } else if (FLAGS_memory_allocator == "numa_interleave") {
+        policy = kNumaInterleave;
+      } else if (FLAGS_memory_allocator == "numa_local") {
+        policy = kNumaLocal;
+      } else {
+        fprintf(stderr, "Unknown memory allocator %s\n",
+                FLAGS_memory_allocator.c_str());
+        exit(1);
+      }
+      memory_allocator = NewNumaMemoryAllocator(
+          policy, FLAGS_memory_allocator_transparent_huge_pages);
+    }
+    return memory_allocator;
+  }
+
+  static std::shared_ptr<Cache> NewCache(int64_t capacity) {
+    if (capacity < 0) {
+      return nullptr;
+    }
+    // 6 is the default number of shard bits of NewLRUCache()
+    return NewLRUCache(
+        static_cast<size_t>(capacity),
+        FLAGS_cache_numshardbits >= 1 ? FLAGS_cache_numshardbits : 6,
+        false /* strict_capacity_limit */, GetMemoryAllocator());
+  }
+
  public:
   Benchmark()
-      : cache_(
-            FLAGS_cache_size >= 0
-                ? (FLAGS_cache_numshardbits >= 1
-                       ? NewLRUCache(FLAGS_cache_size, FLAGS_cache_numshardbits)
-                       : NewLRUCache(FLAGS_cache_size))
-                : nullptr),
-        compressed_cache_(FLAGS_compressed_cache_size >= 0
-                              ? (FLAGS_cache_numshardbits >= 1
-                                     ? NewLRUCache(FLAGS_compressed_cache_size,
-                                                   FLAGS_cache_numshardbits)
-                                     : NewLRUCache(FLAGS_compressed_cache_size))
-                              : nullptr),
+      : cache_(NewCache(FLAGS_cache_size)),
+        compressed_cache_(NewCache(FLAGS_compressed_cache_size)),
         filter_policy_(FLAGS_bloom_bits >= 0
                            ? NewBloomFilterPolicy(FLAGS_bloom_bits,
                                                   FLAGS_use_block_based_filter)
@@ -2284,7 +2347,7 @@ class Benchmark {
     int64_t bytes = 0;
     int decompress_size;
     while (ok && bytes < 1024 * 1048576) {
-      char *uncompressed = nullptr;
+      CacheAllocationPtr uncompressed;
       switch (FLAGS_compression_type_e) {
         case rocksdb::kSnappyCompression: {
           // get size and allocate here to make comparison fair
@@ -2294,9 +2357,9 @@ class Benchmark {
             ok = false;
             break;
           }
-          uncompressed = new char[ulength];
+          uncompressed = AllocateBlock(ulength, nullptr);
           ok = Snappy_Uncompress(compressed.data(), compressed.size(),
-                                 uncompressed);
+                                 uncompressed.get());
           break;
         }
       case rocksdb::kZlibCompression:
@@ -2327,7 +2390,6 @@ class Benchmark {
       default:
         ok = false;
       }
-      delete[] uncompressed;
       bytes += input.size();
       thread->stats.FinishedOps(nullptr, nullptr, 1, kUncompress);
     }
@@ -2370,6 +2432,8 @@ class Benchmark {
       }
     }
     options.memtable_prefix_bloom_bits = FLAGS_memtable_bloom_bits;
+    options.memtable_key_index_slots = FLAGS_memtable_key_index_slots;
+    options.memtable_memory_allocator = GetMemoryAllocator();
     options.bloom_locality = FLAGS_bloom_locality;
     options.max_open_files = FLAGS_open_files;
     options.max_file_opening_threads = FLAGS_file_opening_threads;
@@ -2404,6 +2468,7 @@ class Benchmark {
     options.disableDataSync = FLAGS_disable_data_sync;
     options.use_fsync = FLAGS_use_fsync;
     options.wal_dir = FLAGS_wal_dir;
+    options.wal_compression = FLAGS_wal_compression_e;
     options.num_levels = FLAGS_num_levels;
     options.target_file_size_base = FLAGS_target_file_size_base;
     options.target_file_size_multiplier = FLAGS_target_file_size_multiplier;
@@ -2443,8 +2508,7 @@ class Benchmark {
         break;
       case kVectorRep:
         options.memtable_factory.reset(
-          new VectorRepFactory
-        );
+            new VectorRepFactory(0, FLAGS_vector_sort_threads));
         break;
       case kCuckoo:
         options.memtable_factory.reset(NewHashCuckooRepFactory(
@@ -2544,6 +2608,8 @@ class Benchmark {
       FLAGS_level0_slowdown_writes_trigger;
     options.compression = FLAGS_compression_type_e;
     options.compression_opts.level = FLAGS_compression_level;
+    options.compression_opts.parallel_threads =
+        static_cast<uint32_t>(FLAGS_compression_parallel_threads);
     options.WAL_ttl_seconds = FLAGS_wal_ttl_seconds;
     options.WAL_size_limit_MB = FLAGS_wal_size_limit_MB;
     options.max_total_wal_size = FLAGS_max_total_wal_size;
@@ -2566,8 +2632,10 @@ class Benchmark {
     options.hard_pending_compaction_bytes_limit =
         FLAGS_hard_pending_compaction_bytes_limit;
     options.delayed_write_rate = FLAGS_delayed_write_rate;
+    options.adaptive_delayed_write_rate = FLAGS_adaptive_delayed_write_rate;
     options.allow_concurrent_memtable_write =
         FLAGS_allow_concurrent_memtable_write;
+    options.unordered_write = FLAGS_unordered_write;
     options.enable_write_thread_adaptive_yield =
         FLAGS_enable_write_thread_adaptive_yield;
     options.write_thread_max_yield_usec = FLAGS_write_thread_max_yield_usec;
@@ -3963,6 +4031,8 @@ int db_bench_tool(int argc, char** argv) {
 
   FLAGS_compression_type_e =
     StringToCompressionType(FLAGS_compression_type.c_str());
+  FLAGS_wal_compression_e =
+    StringToCompressionType(FLAGS_wal_compression.c_str());
 
   if (!FLAGS_hdfs.empty()) {
     FLAGS_env  = new rocksdb::HdfsEnv(FLAGS_hdfs);
@@ -3988,6 +4058,8 @@ int db_bench_tool(int argc, char** argv) {
   FLAGS_env->SetBackgroundThreads(FLAGS_max_background_compactions);
   FLAGS_env->SetBackgroundThreads(FLAGS_max_background_flushes,
                                   rocksdb::Env::Priority::HIGH);
+  FLAGS_env->SetBackgroundThreads(FLAGS_num_bottom_pri_threads,
+                                  rocksdb::Env::Priority::BOTTOM);
 
   // Choose a location for the test database if none given with --db=<path>
   if (FLAGS_db.empty()) {
@@ -17,6 +17,7 @@
 #include "port/port.h"
 #include <algorithm>
 #include "rocksdb/env.h"
+#include "rocksdb/memory_allocator.h"
 
 namespace rocksdb {
 
@@ -42,8 +43,10 @@ size_t OptimizeBlockSize(size_t block_size) {
   return block_size;
 }
 
-Arena::Arena(size_t block_size, size_t huge_page_size)
-    : kBlockSize(OptimizeBlockSize(block_size)) {
+Arena::Arena(size_t block_size, size_t huge_page_size,
+             MemoryAllocator* memory_allocator)
+    : kBlockSize(OptimizeBlockSize(block_size)),
+      memory_allocator_(memory_allocator) {
   assert(kBlockSize >= kMinBlockSize && kBlockSize <= kMaxBlockSize &&
          kBlockSize % kAlignUnit == 0);
   alloc_bytes_remaining_ = sizeof(inline_block_);
@@ -62,6 +65,9 @@ Arena::~Arena() {
   for (const auto& block : blocks_) {
     delete[] block;
   }
+  for (const auto& block : allocator_blocks_) {
+    memory_allocator_->Deallocate(block.addr_, block.length_);
+  }
 
 #ifdef MAP_HUGETLB
   for (const auto& mmap_info : huge_blocks_) {
@@ -181,6 +187,17 @@ char* Arena::AllocateNewBlock(size_t block_bytes) {
   // we won't leak either
   blocks_.reserve(blocks_.size() + 1);
 
+  if (memory_allocator_ != nullptr) {
+    allocator_blocks_.reserve(allocator_blocks_.size() + 1);
+    void* addr = memory_allocator_->Allocate(block_bytes);
+    if (addr != nullptr) {
+      allocator_blocks_.emplace_back(MmapInfo(addr, block_bytes));
+      blocks_memory_ += block_bytes;
+      return reinterpret_cast<char*>(addr);
+    }
+    // fall back to new[]
+  }
+
   char* block = new char[block_bytes];
 
 #ifdef ROCKSDB_MALLOC_USABLE_SIZE
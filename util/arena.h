@@ -25,6 +25,8 @@
 
 namespace rocksdb {
 
+class MemoryAllocator;
+
 class Arena : public Allocator {
  public:
   // No copying allowed
@@ -38,7 +40,10 @@ class Arena : public Allocator {
   // huge_page_size: if 0, don't use huge page TLB. If > 0 (should set to the
   // supported hugepage size of the system), block allocation will try huge
   // page TLB first. If allocation fails, will fall back to normal case.
-  explicit Arena(size_t block_size = kMinBlockSize, size_t huge_page_size = 0);
+  // memory_allocator: if not null, the blocks are allocated from it rather
+  // than with new[]. It has to outlive the arena.
+  explicit Arena(size_t block_size = kMinBlockSize, size_t huge_page_size = 0,
+                 MemoryAllocator* memory_allocator = nullptr);
   ~Arena();
 
   char* Allocate(size_t bytes) override;
@@ -93,6 +98,10 @@ class Arena : public Allocator {
   std::vector<MmapInfo> huge_blocks_;
   size_t irregular_block_num = 0;
 
+  MemoryAllocator* const memory_allocator_;
+  // Blocks allocated from memory_allocator_
+  std::vector<MmapInfo> allocator_blocks_;
+
   // Stats for current active block.
   // For each block, we allocate aligned memory chucks from one end and
   // allocate unaligned memory chucks from the other end. Otherwise the
@@ -8,6 +8,7 @@
 // found in the LICENSE file. See the AUTHORS file for names of contributors.
 
 #include "util/arena.h"
+#include "rocksdb/memory_allocator.h"
 #include "util/random.h"
 #include "util/testharness.h"
 
@@ -127,9 +128,10 @@ static void ApproximateMemoryUsageTest(size_t huge_page_size) {
   }
 }
 
-static void SimpleTest(size_t huge_page_size) {
+static void SimpleTest(size_t huge_page_size,
+                       MemoryAllocator* memory_allocator = nullptr) {
   std::vector<std::pair<size_t, char*>> allocated;
-  Arena arena(Arena::kMinBlockSize, huge_page_size);
+  Arena arena(Arena::kMinBlockSize, huge_page_size, memory_allocator);
   const int N = 100000;
   size_t bytes = 0;
   Random rnd(301);
@@ -173,6 +175,33 @@ static void SimpleTest(size_t huge_page_size) {
     }
   }
 }
+
+// Counts the bytes that are allocated from a NUMA memory allocator
+class CountingMemoryAllocator : public MemoryAllocator {
+ public:
+  CountingMemoryAllocator()
+      : target_(NewNumaMemoryAllocator(kNumaInterleave,
+                                       true /* transparent_huge_pages */)),
+        allocated_(0) {}
+
+  const char* Name() const override { return "CountingMemoryAllocator"; }
+
+  void* Allocate(size_t size) override {
+    allocated_ += size;
+    return target_->Allocate(size);
+  }
+
+  void Deallocate(void* p, size_t size) override {
+    allocated_ -= size;
+    target_->Deallocate(p, size);
+  }
+
+  size_t allocated() const { return allocated_; }
+
+ private:
+  std::shared_ptr<MemoryAllocator> target_;
+  size_t allocated_;
+};
 }  // namespace
 
 TEST_F(ArenaTest, MemoryAllocatedBytes) {
@@ -189,6 +218,27 @@ TEST_F(ArenaTest, Simple) {
   SimpleTest(0);
   SimpleTest(kHugePageSize);
 }
+
+TEST_F(ArenaTest, MemoryAllocator) {
+  CountingMemoryAllocator memory_allocator;
+  SimpleTest(0, &memory_allocator);
+  ASSERT_EQ(0, memory_allocator.allocated());
+
+  {
+    Arena arena(Arena::kMinBlockSize, 0, &memory_allocator);
+    // The inline block is used first
+    arena.Allocate(Arena::kInlineSize);
+    ASSERT_EQ(0, memory_allocator.allocated());
+    arena.Allocate(100);
+    ASSERT_EQ(Arena::kMinBlockSize, memory_allocator.allocated());
+    // An allocation of more than a quarter of a block gets its own block
+    arena.AllocateAligned(Arena::kMinBlockSize);
+    ASSERT_EQ(2 * Arena::kMinBlockSize, memory_allocator.allocated());
+    ASSERT_EQ(Arena::kInlineSize + 2 * Arena::kMinBlockSize,
+              arena.MemoryAllocatedBytes());
+  }
+  ASSERT_EQ(0, memory_allocator.allocated());
+}
 }  // namespace rocksdb
 
 int main(int argc, char** argv) {
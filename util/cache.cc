@@ -12,6 +12,7 @@
 #include <stdlib.h>
 
 #include "rocksdb/cache.h"
+#include "rocksdb/memory_allocator.h"
 #include "port/port.h"
 #include "util/autovector.h"
 #include "util/hash.h"
@@ -531,6 +532,7 @@ class ShardedLRUCache : public Cache {
   int num_shard_bits_;
   size_t capacity_;
   bool strict_capacity_limit_;
+  std::shared_ptr<MemoryAllocator> memory_allocator_;
 
   static inline uint32_t HashSlice(const Slice& s) {
     return Hash(s.data(), s.size(), 0);
@@ -543,11 +545,13 @@ class ShardedLRUCache : public Cache {
 
  public:
   ShardedLRUCache(size_t capacity, int num_shard_bits,
-                  bool strict_capacity_limit)
+                  bool strict_capacity_limit,
+                  std::shared_ptr<MemoryAllocator> memory_allocator)
       : last_id_(0),
         num_shard_bits_(num_shard_bits),
         capacity_(capacity),
-        strict_capacity_limit_(strict_capacity_limit) {
+        strict_capacity_limit_(strict_capacity_limit),
+        memory_allocator_(std::move(memory_allocator)) {
     int num_shards = 1 << num_shard_bits_;
     shards_ = new LRUCache[num_shards];
     const size_t per_shard = (capacity + (num_shards - 1)) / num_shards;
@@ -647,6 +651,10 @@ class ShardedLRUCache : public Cache {
       shards_[s].EraseUnRefEntries();
     }
   }
+
+  virtual MemoryAllocator* memory_allocator() const override {
+    return memory_allocator_.get();
+  }
 };
 
 }  // end anonymous namespace
@@ -661,11 +669,18 @@ shared_ptr<Cache> NewLRUCache(size_t capacity, int num_shard_bits) {
 
 shared_ptr<Cache> NewLRUCache(size_t capacity, int num_shard_bits,
                               bool strict_capacity_limit) {
+  return NewLRUCache(capacity, num_shard_bits, strict_capacity_limit, nullptr);
+}
+
+shared_ptr<Cache> NewLRUCache(size_t capacity, int num_shard_bits,
+                              bool strict_capacity_limit,
+                              shared_ptr<MemoryAllocator> memory_allocator) {
   if (num_shard_bits >= 20) {
     return nullptr;  // the cache cannot be sharded into too many fine pieces
   }
   return std::make_shared<ShardedLRUCache>(capacity, num_shard_bits,
-                                           strict_capacity_limit);
+                                           strict_capacity_limit,
+                                           std::move(memory_allocator));
 }
 
 }  // namespace rocksdb
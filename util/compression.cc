@@ -0,0 +1,148 @@
+//  Copyright (c) 2011-present, Facebook, Inc.  All rights reserved.
+//  This source code is licensed under the BSD-style license found in the
+//  LICENSE file in the root directory of this source tree. An additional grant
+//  of patent rights can be found in the PATENTS file in the same directory.
+
+#include "util/compression.h"
+
+#include <string.h>
+
+namespace rocksdb {
+
+namespace {
+
+#ifdef ZLIB
+// Size of the chunks the output buffer grows by
+const size_t kZlibStreamingChunkSize = 16 << 10;
+
+class ZlibStreamingCompress : public StreamingCompress {
+ public:
+  ZlibStreamingCompress() : initialized_(false) {
+    memset(&stream_, 0, sizeof(z_stream));
+  }
+
+  ~ZlibStreamingCompress() {
+    if (initialized_) {
+      deflateEnd(&stream_);
+    }
+  }
+
+  bool Init(const CompressionOptions& opts) {
+    // See Zlib_Compress() for the meaning of memLevel
+    static const int memLevel = 8;
+    initialized_ = deflateInit2(&stream_, opts.level, Z_DEFLATED,
+                                opts.window_bits, memLevel,
+                                opts.strategy) == Z_OK;
+    return initialized_;
+  }
+
+  virtual bool Compress(const Slice& input, std::string* output) override {
+    stream_.next_in =
+        reinterpret_cast<Bytef*>(const_cast<char*>(input.data()));
+    stream_.avail_in = static_cast<unsigned int>(input.size());
+    // Z_SYNC_FLUSH ends the output on a byte boundary with all the input
+    // processed, without resetting the history shared by the records.
+    do {
+      size_t old_size = output->size();
+      size_t chunk_size = std::max(
+          kZlibStreamingChunkSize,
+          static_cast<size_t>(deflateBound(&stream_, stream_.avail_in)));
+      output->resize(old_size + chunk_size);
+      stream_.next_out = reinterpret_cast<Bytef*>(&(*output)[old_size]);
+      stream_.avail_out = static_cast<unsigned int>(chunk_size);
+      int st = deflate(&stream_, Z_SYNC_FLUSH);
+      output->resize(old_size + chunk_size - stream_.avail_out);
+      if (st != Z_OK && st != Z_BUF_ERROR) {
+        return false;
+      }
+    } while (stream_.avail_out == 0);
+    return stream_.avail_in == 0;
+  }
+
+ private:
+  z_stream stream_;
+  bool initialized_;
+};
+
+class ZlibStreamingUncompress : public StreamingUncompress {
+ public:
+  ZlibStreamingUncompress() : initialized_(false) {
+    memset(&stream_, 0, sizeof(z_stream));
+  }
+
+  ~ZlibStreamingUncompress() {
+    if (initialized_) {
+      inflateEnd(&stream_);
+    }
+  }
+
+  bool Init() {
+    // Raw stream with the largest window, which can read the output of any
+    // raw deflate window size.
+    initialized_ = inflateInit2(&stream_, -15) == Z_OK;
+    return initialized_;
+  }
+
+  virtual bool Uncompress(const Slice& input, std::string* output) override {
+    stream_.next_in =
+        reinterpret_cast<Bytef*>(const_cast<char*>(input.data()));
+    stream_.avail_in = static_cast<unsigned int>(input.size());
+    do {
+      size_t old_size = output->size();
+      size_t chunk_size = std::max(kZlibStreamingChunkSize, input.size() * 4);
+      output->resize(old_size + chunk_size);
+      stream_.next_out = reinterpret_cast<Bytef*>(&(*output)[old_size]);
+      stream_.avail_out = static_cast<unsigned int>(chunk_size);
+      int st = inflate(&stream_, Z_SYNC_FLUSH);
+      output->resize(old_size + chunk_size - stream_.avail_out);
+      if (st != Z_OK && st != Z_BUF_ERROR) {
+        // The writer never ends the stream, so Z_STREAM_END is an error too
+        return false;
+      }
+    } while (stream_.avail_out == 0);
+    return stream_.avail_in == 0;
+  }
+
+ private:
+  z_stream stream_;
+  bool initialized_;
+};
+#endif  // ZLIB
+
+}  // namespace
+
+StreamingCompress* StreamingCompress::Create(CompressionType compression_type,
+                                             const CompressionOptions& opts) {
+  if (!StreamingCompressionTypeSupported(compression_type)) {
+    return nullptr;
+  }
+#ifdef ZLIB
+  ZlibStreamingCompress* compress = new ZlibStreamingCompress();
+  if (!compress->Init(opts)) {
+    delete compress;
+    return nullptr;
+  }
+  return compress;
+#else
+  return nullptr;
+#endif  // ZLIB
+}
+
+StreamingUncompress* StreamingUncompress::Create(
+    CompressionType compression_type) {
+  if (!StreamingCompressionTypeSupported(compression_type)) {
+    return nullptr;
+  }
+#ifdef ZLIB
+  ZlibStreamingUncompress* uncompress = new ZlibStreamingUncompress();
+  if (!uncompress->Init()) {
+    delete uncompress;
+    return nullptr;
+  }
+  return uncompress;
+#else
+  return nullptr;
+#endif  // ZLIB
+}
+
+}  // namespace rocksdb
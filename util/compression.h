@@ -15,6 +15,7 @@
 
 #include "rocksdb/options.h"
 #include "util/coding.h"
+#include "util/memory_allocator.h"
 
 #ifdef SNAPPY
 #include <snappy.h>
@@ -251,10 +252,12 @@ inline bool Zlib_Compress(const CompressionOptions& opts,
 // block header
 // compress_format_version == 2 -- decompressed size is included in the block
 // header in varint32 format
-inline char* Zlib_Uncompress(const char* input_data, size_t input_length,
-                             int* decompress_size,
-                             uint32_t compress_format_version,
-                             int windowBits = -14) {
+//
+// The output is allocated from allocator, or with new[] if it is null.
+inline CacheAllocationPtr Zlib_Uncompress(
+    const char* input_data, size_t input_length, int* decompress_size,
+    uint32_t compress_format_version, int windowBits = -14,
+    MemoryAllocator* allocator = nullptr) {
 #ifdef ZLIB
   uint32_t output_len = 0;
   if (compress_format_version == 2) {
@@ -286,9 +289,9 @@ inline char* Zlib_Uncompress(const char* input_data, size_t input_length,
   _stream.next_in = (Bytef *)input_data;
   _stream.avail_in = static_cast<unsigned int>(input_length);
 
-  char* output = new char[output_len];
+  CacheAllocationPtr output = AllocateBlock(output_len, allocator);
 
-  _stream.next_out = (Bytef *)output;
+  _stream.next_out = (Bytef *)output.get();
   _stream.avail_out = static_cast<unsigned int>(output_len);
 
   bool done = false;
@@ -306,19 +309,17 @@ inline char* Zlib_Uncompress(const char* input_data, size_t input_length,
         size_t old_sz = output_len;
         uint32_t output_len_delta = output_len/5;
         output_len += output_len_delta < 10 ? 10 : output_len_delta;
-        char* tmp = new char[output_len];
-        memcpy(tmp, output, old_sz);
-        delete[] output;
-        output = tmp;
+        CacheAllocationPtr tmp = AllocateBlock(output_len, allocator);
+        memcpy(tmp.get(), output.get(), old_sz);
+        output = std::move(tmp);
 
         // Set more output.
-        _stream.next_out = (Bytef *)(output + old_sz);
+        _stream.next_out = (Bytef *)(output.get() + old_sz);
         _stream.avail_out = static_cast<unsigned int>(output_len - old_sz);
         break;
       }
       case Z_BUF_ERROR:
       default:
-        delete[] output;
         inflateEnd(&_stream);
         return nullptr;
     }
@@ -403,9 +404,11 @@ inline bool BZip2_Compress(const CompressionOptions& opts,
 // block header
 // compress_format_version == 2 -- decompressed size is included in the block
 // header in varint32 format
-inline char* BZip2_Uncompress(const char* input_data, size_t input_length,
-                              int* decompress_size,
-                              uint32_t compress_format_version) {
+//
+// The output is allocated from allocator, or with new[] if it is null.
+inline CacheAllocationPtr BZip2_Uncompress(
+    const char* input_data, size_t input_length, int* decompress_size,
+    uint32_t compress_format_version, MemoryAllocator* allocator = nullptr) {
 #ifdef BZIP2
   uint32_t output_len = 0;
   if (compress_format_version == 2) {
@@ -433,9 +436,9 @@ inline char* BZip2_Uncompress(const char* input_data, size_t input_length,
   _stream.next_in = (char *)input_data;
   _stream.avail_in = static_cast<unsigned int>(input_length);
 
-  char* output = new char[output_len];
+  CacheAllocationPtr output = AllocateBlock(output_len, allocator);
 
-  _stream.next_out = (char *)output;
+  _stream.next_out = (char *)output.get();
   _stream.avail_out = static_cast<unsigned int>(output_len);
 
   bool done = false;
@@ -452,18 +455,16 @@ inline char* BZip2_Uncompress(const char* input_data, size_t input_length,
         assert(compress_format_version != 2);
         uint32_t old_sz = output_len;
         output_len = output_len * 1.2;
-        char* tmp = new char[output_len];
-        memcpy(tmp, output, old_sz);
-        delete[] output;
-        output = tmp;
+        CacheAllocationPtr tmp = AllocateBlock(output_len, allocator);
+        memcpy(tmp.get(), output.get(), old_sz);
+        output = std::move(tmp);
 
         // Set more output.
-        _stream.next_out = (char *)(output + old_sz);
+        _stream.next_out = (char *)(output.get() + old_sz);
         _stream.avail_out = static_cast<unsigned int>(output_len - old_sz);
         break;
       }
       default:
-        delete[] output;
         BZ2_bzDecompressEnd(&_stream);
         return nullptr;
     }
@@ -523,9 +524,11 @@ inline bool LZ4_Compress(const CompressionOptions& opts,
 // block header using memcpy, which makes database non-portable)
 // compress_format_version == 2 -- decompressed size is included in the block
 // header in varint32 format
-inline char* LZ4_Uncompress(const char* input_data, size_t input_length,
-                            int* decompress_size,
-                            uint32_t compress_format_version) {
+//
+// The output is allocated from allocator, or with new[] if it is null.
+inline CacheAllocationPtr LZ4_Uncompress(
+    const char* input_data, size_t input_length, int* decompress_size,
+    uint32_t compress_format_version, MemoryAllocator* allocator = nullptr) {
 #ifdef LZ4
   uint32_t output_len = 0;
   if (compress_format_version == 2) {
@@ -544,12 +547,11 @@ inline char* LZ4_Uncompress(const char* input_data, size_t input_length,
     input_length -= 8;
     input_data += 8;
   }
-  char* output = new char[output_len];
-  *decompress_size =
-      LZ4_decompress_safe(input_data, output, static_cast<int>(input_length),
-                          static_cast<int>(output_len));
+  CacheAllocationPtr output = AllocateBlock(output_len, allocator);
+  *decompress_size = LZ4_decompress_safe(input_data, output.get(),
+                                         static_cast<int>(input_length),
+                                         static_cast<int>(output_len));
   if (*decompress_size < 0) {
-    delete[] output;
     return nullptr;
   }
   assert(*decompress_size == static_cast<int>(output_len));
@@ -630,8 +632,10 @@ inline bool ZSTD_Compress(const CompressionOptions& opts, const char* input,
   return false;
 }
 
-inline char* ZSTD_Uncompress(const char* input_data, size_t input_length,
-                             int* decompress_size) {
+// The output is allocated from allocator, or with new[] if it is null.
+inline CacheAllocationPtr ZSTD_Uncompress(
+    const char* input_data, size_t input_length, int* decompress_size,
+    MemoryAllocator* allocator = nullptr) {
 #ifdef ZSTD
   uint32_t output_len = 0;
   if (!compression::GetDecompressedSizeInfo(&input_data, &input_length,
@@ -639,9 +643,9 @@ inline char* ZSTD_Uncompress(const char* input_data, size_t input_length,
     return nullptr;
   }
 
-  char* output = new char[output_len];
+  CacheAllocationPtr output = AllocateBlock(output_len, allocator);
   size_t actual_output_length =
-      ZSTD_decompress(output, output_len, input_data, input_length);
+      ZSTD_decompress(output.get(), output_len, input_data, input_length);
   assert(actual_output_length == output_len);
   *decompress_size = static_cast<int>(actual_output_length);
   return output;
@@ -649,4 +653,42 @@ inline char* ZSTD_Uncompress(const char* input_data, size_t input_length,
   return nullptr;
 }
 
+// Returns true if records can be compressed with compression_type by
+// StreamingCompress.
+inline bool StreamingCompressionTypeSupported(
+    CompressionType compression_type) {
+  return compression_type == kZlibCompression && Zlib_Supported();
+}
+
+// Compresses a sequence of records as a single stream, so that a record can
+// refer to the data of the records compressed before it.  The output of every
+// Compress() call is flushed, so it can be decompressed by the matching
+// StreamingUncompress as soon as it is complete.
+class StreamingCompress {
+ public:
+  // Returns nullptr if compression_type is not supported.
+  static StreamingCompress* Create(CompressionType compression_type,
+                                   const CompressionOptions& opts);
+
+  virtual ~StreamingCompress() {}
+
+  // Appends the compressed form of input to *output.  Returns false on
+  // failure, after which the stream can not be used anymore.
+  virtual bool Compress(const Slice& input, std::string* output) = 0;
+};
+
+// Decompresses the records written by StreamingCompress, in the same order.
+class StreamingUncompress {
+ public:
+  // Returns nullptr if compression_type is not supported.
+  static StreamingUncompress* Create(CompressionType compression_type);
+
+  virtual ~StreamingUncompress() {}
+
+  // Appends the decompressed form of input, the output of a single
+  // StreamingCompress::Compress() call, to *output.  Returns false if the
+  // input is corrupted, after which the stream can not be used anymore.
+  virtual bool Uncompress(const Slice& input, std::string* output) = 0;
+};
+
 }  // namespace rocksdb
@@ -13,6 +13,8 @@
 #include <stddef.h>
 #include <stdint.h>
 
+#include "rocksdb/slice.h"
+
 namespace rocksdb {
 
 extern uint32_t Hash(const char* data, size_t n, uint32_t seed);
@@ -25,4 +27,9 @@ inline uint32_t GetSliceHash(const Slice& s) {
   return Hash(s.data(), s.size(), 397);
 }
 
+// std::hash compatible interface.
+struct SliceHasher {
+  uint32_t operator()(const Slice& s) const { return GetSliceHash(s); }
+};
+
 }  // namespace rocksdb
@@ -0,0 +1,97 @@
+//  Copyright (c) 2011-present, Facebook, Inc.  All rights reserved.
+//  This source code is licensed under the BSD-style license found in the
+//  LICENSE file in the root directory of this source tree. An additional grant
+//  of patent rights can be found in the PATENTS file in the same directory.
+
+#include "util/memory_allocator.h"
+
+#ifndef OS_WIN
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+#ifdef NUMA
+#include <numa.h>
+#endif
+
+namespace rocksdb {
+
+namespace {
+
+class NumaMemoryAllocator : public MemoryAllocator {
+ public:
+  NumaMemoryAllocator(NumaPolicy numa_policy, bool transparent_huge_pages)
+      : numa_policy_(numa_policy),
+        transparent_huge_pages_(transparent_huge_pages),
+        page_size_(4096) {
+#ifdef NUMA
+    if (numa_available() < 0) {
+      numa_policy_ = kNumaDefault;
+    }
+#endif
+#ifndef OS_WIN
+    page_size_ = static_cast<size_t>(getpagesize());
+#endif
+  }
+
+  virtual const char* Name() const override { return "NumaMemoryAllocator"; }
+
+  virtual void* Allocate(size_t size) override {
+#ifndef OS_WIN
+    const size_t length = MappedLength(size);
+    void* p = mmap(nullptr, length, PROT_READ | PROT_WRITE,
+                   MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (p == MAP_FAILED) {
+      return nullptr;
+    }
+    // The pages are only backed by memory on first touch, so the hints below
+    // apply to all of them. They are best effort, and their errors ignored.
+#ifdef MADV_HUGEPAGE
+    if (transparent_huge_pages_) {
+      madvise(p, length, MADV_HUGEPAGE);
+    }
+#endif
+#ifdef NUMA
+    switch (numa_policy_) {
+      case kNumaInterleave:
+        numa_interleave_memory(p, length, numa_all_nodes_ptr);
+        break;
+      case kNumaLocal:
+        numa_setlocal_memory(p, length);
+        break;
+      default:
+        break;
+    }
+#endif
+    return p;
+#else
+    return new char[size];
+#endif
+  }
+
+  virtual void Deallocate(void* p, size_t size) override {
+#ifndef OS_WIN
+    munmap(p, MappedLength(size));
+#else
+    delete[] static_cast<char*>(p);
+#endif
+  }
+
+ private:
+  size_t MappedLength(size_t size) const {
+    return (size + page_size_ - 1) / page_size_ * page_size_;
+  }
+
+  NumaPolicy numa_policy_;
+  const bool transparent_huge_pages_;
+  size_t page_size_;
+};
+
+}  // namespace
+
+std::shared_ptr<MemoryAllocator> NewNumaMemoryAllocator(
+    NumaPolicy numa_policy, bool transparent_huge_pages) {
+  return std::make_shared<NumaMemoryAllocator>(numa_policy,
+                                               transparent_huge_pages);
+}
+
+}  // namespace rocksdb
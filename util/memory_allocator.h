@@ -0,0 +1,49 @@
+//  Copyright (c) 2011-present, Facebook, Inc.  All rights reserved.
+//  This source code is licensed under the BSD-style license found in the
+//  LICENSE file in the root directory of this source tree. An additional grant
+//  of patent rights can be found in the PATENTS file in the same directory.
+
+#pragma once
+
+#include <memory>
+
+#include "rocksdb/memory_allocator.h"
+
+namespace rocksdb {
+
+// Releases a buffer of size bytes to the allocator it came from, or with
+// delete[] if allocator is null
+struct CustomDeleter {
+  explicit CustomDeleter(MemoryAllocator* a = nullptr, size_t s = 0)
+      : allocator(a), size(s) {}
+
+  void operator()(char* ptr) const {
+    if (allocator != nullptr) {
+      allocator->Deallocate(ptr, size);
+    } else {
+      delete[] ptr;
+    }
+  }
+
+  MemoryAllocator* allocator;
+  size_t size;
+};
+
+// A buffer that may come from a MemoryAllocator, like the contents of the
+// blocks kept in the block cache
+typedef std::unique_ptr<char[], CustomDeleter> CacheAllocationPtr;
+
+// Returns a buffer of size bytes from allocator, or from new[] if allocator
+// is null or out of memory
+inline CacheAllocationPtr AllocateBlock(size_t size,
+                                        MemoryAllocator* allocator) {
+  if (allocator != nullptr) {
+    char* block = static_cast<char*>(allocator->Allocate(size));
+    if (block != nullptr) {
+      return CacheAllocationPtr(block, CustomDeleter(allocator, size));
+    }
+  }
+  return CacheAllocationPtr(new char[size]);
+}
+
+}  // namespace rocksdb
@@ -76,6 +76,8 @@ void MutableCFOptions::Dump(Logger* log) const {
       memtable_prefix_bloom_probes);
   Log(log, " memtable_prefix_bloom_huge_page_tlb_size: %" ROCKSDB_PRIszt,
       memtable_prefix_bloom_huge_page_tlb_size);
+  Log(log, "                 memtable_key_index_slots: %" PRIu32,
+      memtable_key_index_slots);
   Log(log, "                    max_successive_merges: %" ROCKSDB_PRIszt,
       max_successive_merges);
   Log(log, "                           filter_deletes: %d",
@@ -118,6 +120,10 @@ void MutableCFOptions::Dump(Logger* log) const {
       verify_checksums_in_compaction);
   Log(log, "        max_sequential_skip_in_iterations: %" PRIu64,
       max_sequential_skip_in_iterations);
+  Log(log, "         scan_deletion_compaction_trigger: %" PRIu64,
+      scan_deletion_compaction_trigger);
+  Log(log, "              periodic_compaction_seconds: %" PRIu64,
+      periodic_compaction_seconds);
 }
 
 }  // namespace rocksdb
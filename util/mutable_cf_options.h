@@ -20,6 +20,7 @@ struct MutableCFOptions {
         memtable_prefix_bloom_probes(options.memtable_prefix_bloom_probes),
         memtable_prefix_bloom_huge_page_tlb_size(
             options.memtable_prefix_bloom_huge_page_tlb_size),
+        memtable_key_index_slots(options.memtable_key_index_slots),
         max_successive_merges(options.max_successive_merges),
         filter_deletes(options.filter_deletes),
         inplace_update_num_locks(options.inplace_update_num_locks),
@@ -46,6 +47,9 @@ struct MutableCFOptions {
         max_subcompactions(options.max_subcompactions),
         max_sequential_skip_in_iterations(
             options.max_sequential_skip_in_iterations),
+        scan_deletion_compaction_trigger(
+            options.scan_deletion_compaction_trigger),
+        periodic_compaction_seconds(options.periodic_compaction_seconds),
         paranoid_file_checks(options.paranoid_file_checks),
         report_bg_io_stats(options.report_bg_io_stats)
 
@@ -59,6 +63,7 @@ struct MutableCFOptions {
         memtable_prefix_bloom_bits(0),
         memtable_prefix_bloom_probes(0),
         memtable_prefix_bloom_huge_page_tlb_size(0),
+        memtable_key_index_slots(0),
         max_successive_merges(0),
         filter_deletes(false),
         inplace_update_num_locks(0),
@@ -79,6 +84,8 @@ struct MutableCFOptions {
         verify_checksums_in_compaction(false),
         max_subcompactions(1),
         max_sequential_skip_in_iterations(0),
+        scan_deletion_compaction_trigger(0),
+        periodic_compaction_seconds(0),
         paranoid_file_checks(false),
         report_bg_io_stats(false) {}
 
@@ -109,6 +116,7 @@ struct MutableCFOptions {
   uint32_t memtable_prefix_bloom_bits;
   uint32_t memtable_prefix_bloom_probes;
   size_t memtable_prefix_bloom_huge_page_tlb_size;
+  uint32_t memtable_key_index_slots;
   size_t max_successive_merges;
   bool filter_deletes;
   size_t inplace_update_num_locks;
@@ -134,6 +142,8 @@ struct MutableCFOptions {
 
   // Misc options
   uint64_t max_sequential_skip_in_iterations;
+  uint64_t scan_deletion_compaction_trigger;
+  uint64_t periodic_compaction_seconds;
   bool paranoid_file_checks;
   bool report_bg_io_stats;
 
@@ -19,8 +19,10 @@
 
 #include "rocksdb/cache.h"
 #include "rocksdb/compaction_filter.h"
+#include "rocksdb/compaction_service.h"
 #include "rocksdb/comparator.h"
 #include "rocksdb/env.h"
+#include "rocksdb/memory_allocator.h"
 #include "rocksdb/sst_file_manager.h"
 #include "rocksdb/memtablerep.h"
 #include "rocksdb/merge_operator.h"
@@ -29,6 +31,7 @@
 #include "rocksdb/table.h"
 #include "rocksdb/table_properties.h"
 #include "rocksdb/wal_filter.h"
+#include "rocksdb/write_buffer_manager.h"
 #include "table/block_based_table_factory.h"
 #include "util/compression.h"
 #include "util/statistics.h"
@@ -51,10 +54,14 @@ ImmutableCFOptions::ImmutableCFOptions(const Options& options)
       statistics(options.statistics.get()),
       env(options.env),
       delayed_write_rate(options.delayed_write_rate),
+      adaptive_delayed_write_rate(options.adaptive_delayed_write_rate),
       allow_mmap_reads(options.allow_mmap_reads),
       allow_mmap_writes(options.allow_mmap_writes),
       db_paths(options.db_paths),
       memtable_factory(options.memtable_factory.get()),
+      memtable_insert_with_hint_prefix_extractor(
+          options.memtable_insert_with_hint_prefix_extractor.get()),
+      memtable_memory_allocator(options.memtable_memory_allocator.get()),
       table_factory(options.table_factory.get()),
       table_properties_collector_factories(
           options.table_properties_collector_factories),
@@ -87,6 +94,7 @@ ColumnFamilyOptions::ColumnFamilyOptions()
       max_write_buffer_number(2),
       min_write_buffer_number_to_merge(1),
       max_write_buffer_number_to_maintain(0),
+      in_memory_compaction(false),
       compression(Snappy_Supported() ? kSnappyCompression : kNoCompression),
       prefix_extractor(nullptr),
       num_levels(7),
@@ -115,6 +123,8 @@ ColumnFamilyOptions::ColumnFamilyOptions()
       verify_checksums_in_compaction(true),
       filter_deletes(false),
       max_sequential_skip_in_iterations(8),
+      scan_deletion_compaction_trigger(0),
+      periodic_compaction_seconds(0),
       memtable_factory(std::shared_ptr<SkipListFactory>(new SkipListFactory)),
       table_factory(
           std::shared_ptr<TableFactory>(new BlockBasedTableFactory())),
@@ -124,6 +134,7 @@ ColumnFamilyOptions::ColumnFamilyOptions()
       memtable_prefix_bloom_bits(0),
       memtable_prefix_bloom_probes(6),
       memtable_prefix_bloom_huge_page_tlb_size(0),
+      memtable_key_index_slots(0),
       bloom_locality(0),
       max_successive_merges(0),
       min_partial_merge_operands(2),
@@ -144,6 +155,7 @@ ColumnFamilyOptions::ColumnFamilyOptions(const Options& options)
           options.min_write_buffer_number_to_merge),
       max_write_buffer_number_to_maintain(
           options.max_write_buffer_number_to_maintain),
+      in_memory_compaction(options.in_memory_compaction),
       compression(options.compression),
       compression_per_level(options.compression_per_level),
       compression_opts(options.compression_opts),
@@ -182,7 +194,13 @@ ColumnFamilyOptions::ColumnFamilyOptions(const Options& options)
       filter_deletes(options.filter_deletes),
       max_sequential_skip_in_iterations(
           options.max_sequential_skip_in_iterations),
+      scan_deletion_compaction_trigger(
+          options.scan_deletion_compaction_trigger),
+      periodic_compaction_seconds(options.periodic_compaction_seconds),
       memtable_factory(options.memtable_factory),
+      memtable_insert_with_hint_prefix_extractor(
+          options.memtable_insert_with_hint_prefix_extractor),
+      memtable_memory_allocator(options.memtable_memory_allocator),
       table_factory(options.table_factory),
       table_properties_collector_factories(
           options.table_properties_collector_factories),
@@ -193,6 +211,7 @@ ColumnFamilyOptions::ColumnFamilyOptions(const Options& options)
       memtable_prefix_bloom_probes(options.memtable_prefix_bloom_probes),
       memtable_prefix_bloom_huge_page_tlb_size(
           options.memtable_prefix_bloom_huge_page_tlb_size),
+      memtable_key_index_slots(options.memtable_key_index_slots),
       bloom_locality(options.bloom_locality),
       max_successive_merges(options.max_successive_merges),
       min_partial_merge_operands(options.min_partial_merge_operands),
@@ -237,6 +256,7 @@ DBOptions::DBOptions()
       log_file_time_to_roll(0),
       keep_log_file_num(1000),
       recycle_log_file_num(0),
+      wal_compression(kNoCompression),
       max_manifest_file_size(std::numeric_limits<uint64_t>::max()),
       table_cache_numshardbits(6),
       WAL_ttl_seconds(0),
@@ -251,6 +271,7 @@ DBOptions::DBOptions()
       stats_dump_period_sec(600),
       advise_random_on_open(true),
       db_write_buffer_size(0),
+      write_buffer_manager(nullptr),
       access_hint_on_compaction_start(NORMAL),
       new_table_reader_for_compaction_inputs(false),
       compaction_readahead_size(0),
@@ -262,13 +283,16 @@ DBOptions::DBOptions()
       listeners(),
       enable_thread_tracking(false),
       delayed_write_rate(2 * 1024U * 1024U),
+      adaptive_delayed_write_rate(false),
       allow_concurrent_memtable_write(false),
+      unordered_write(false),
       enable_write_thread_adaptive_yield(false),
       write_thread_max_yield_usec(100),
       write_thread_slow_yield_usec(3),
       skip_stats_update_on_db_open(false),
       wal_recovery_mode(WALRecoveryMode::kTolerateCorruptedTailRecords),
       row_cache(nullptr),
+      compaction_service(nullptr),
 #ifndef ROCKSDB_LITE
       wal_filter(nullptr),
 #endif  // ROCKSDB_LITE
@@ -304,6 +328,7 @@ DBOptions::DBOptions(const Options& options)
       log_file_time_to_roll(options.log_file_time_to_roll),
       keep_log_file_num(options.keep_log_file_num),
       recycle_log_file_num(options.recycle_log_file_num),
+      wal_compression(options.wal_compression),
       max_manifest_file_size(options.max_manifest_file_size),
       table_cache_numshardbits(options.table_cache_numshardbits),
       WAL_ttl_seconds(options.WAL_ttl_seconds),
@@ -318,6 +343,7 @@ DBOptions::DBOptions(const Options& options)
       stats_dump_period_sec(options.stats_dump_period_sec),
       advise_random_on_open(options.advise_random_on_open),
       db_write_buffer_size(options.db_write_buffer_size),
+      write_buffer_manager(options.write_buffer_manager),
       access_hint_on_compaction_start(options.access_hint_on_compaction_start),
       new_table_reader_for_compaction_inputs(
           options.new_table_reader_for_compaction_inputs),
@@ -330,7 +356,9 @@ DBOptions::DBOptions(const Options& options)
       listeners(options.listeners),
       enable_thread_tracking(options.enable_thread_tracking),
       delayed_write_rate(options.delayed_write_rate),
+      adaptive_delayed_write_rate(options.adaptive_delayed_write_rate),
       allow_concurrent_memtable_write(options.allow_concurrent_memtable_write),
+      unordered_write(options.unordered_write),
       enable_write_thread_adaptive_yield(
           options.enable_write_thread_adaptive_yield),
       write_thread_max_yield_usec(options.write_thread_max_yield_usec),
@@ -338,6 +366,7 @@ DBOptions::DBOptions(const Options& options)
       skip_stats_update_on_db_open(options.skip_stats_update_on_db_open),
       wal_recovery_mode(options.wal_recovery_mode),
       row_cache(options.row_cache),
+      compaction_service(options.compaction_service),
 #ifndef ROCKSDB_LITE
       wal_filter(options.wal_filter),
 #endif  // ROCKSDB_LITE
@@ -371,6 +400,8 @@ void DBOptions::Dump(Logger* log) const {
          keep_log_file_num);
     Header(log, "  Options.recycle_log_file_num: %" ROCKSDB_PRIszt,
            recycle_log_file_num);
+    Header(log, "       Options.wal_compression: %s",
+           CompressionTypeToString(wal_compression).c_str());
     Header(log, "       Options.allow_os_buffer: %d", allow_os_buffer);
     Header(log, "      Options.allow_mmap_reads: %d", allow_mmap_reads);
     Header(log, "      Options.allow_fallocate: %d", allow_fallocate);
@@ -416,6 +447,10 @@ void DBOptions::Dump(Logger* log) const {
          "                    Options.db_write_buffer_size: %" ROCKSDB_PRIszt
          "d",
          db_write_buffer_size);
+    Header(log,
+           "        Options.write_buffer_manager.buffer_size: %" ROCKSDB_PRIszt
+           "d",
+           write_buffer_manager ? write_buffer_manager->buffer_size() : 0);
     Header(log, "         Options.access_hint_on_compaction_start: %s",
         access_hints[access_hint_on_compaction_start]);
     Header(log, "  Options.new_table_reader_for_compaction_inputs: %d",
@@ -450,6 +485,10 @@ void DBOptions::Dump(Logger* log) const {
         enable_thread_tracking);
     Header(log, "         Options.allow_concurrent_memtable_write: %d",
            allow_concurrent_memtable_write);
+    Header(log, "                         Options.unordered_write: %d",
+           unordered_write);
+    Header(log, "             Options.adaptive_delayed_write_rate: %d",
+           adaptive_delayed_write_rate);
     Header(log, "      Options.enable_write_thread_adaptive_yield: %d",
            enable_write_thread_adaptive_yield);
     Header(log, "             Options.write_thread_max_yield_usec: %" PRIu64,
@@ -462,6 +501,8 @@ void DBOptions::Dump(Logger* log) const {
     } else {
       Header(log, "                               Options.row_cache: None");
     }
+    Header(log, "                      Options.compaction_service: %s",
+           compaction_service ? compaction_service->Name() : "None");
 #ifndef ROCKSDB_LITE
     Header(log, "       Options.wal_filter: %s",
            wal_filter ? wal_filter->Name() : "None");
@@ -477,6 +518,14 @@ void ColumnFamilyOptions::Dump(Logger* log) const {
   Header(log, "       Options.compaction_filter_factory: %s",
       compaction_filter_factory ? compaction_filter_factory->Name() : "None");
   Header(log, "        Options.memtable_factory: %s", memtable_factory->Name());
+  Header(log, "        Options.memtable_insert_with_hint_prefix_extractor: %s",
+      memtable_insert_with_hint_prefix_extractor == nullptr
+          ? "nullptr"
+          : memtable_insert_with_hint_prefix_extractor->Name());
+  Header(log, "        Options.memtable_memory_allocator: %s",
+      memtable_memory_allocator == nullptr
+          ? "nullptr"
+          : memtable_memory_allocator->Name());
   Header(log, "           Options.table_factory: %s", table_factory->Name());
   Header(log, "           table_factory options: %s",
       table_factory->GetPrintableTableOptions().c_str());
@@ -499,12 +548,16 @@ void ColumnFamilyOptions::Dump(Logger* log) const {
         min_write_buffer_number_to_merge);
     Header(log, "    Options.max_write_buffer_number_to_maintain: %d",
          max_write_buffer_number_to_maintain);
+    Header(log, "                   Options.in_memory_compaction: %d",
+        in_memory_compaction);
     Header(log, "           Options.compression_opts.window_bits: %d",
         compression_opts.window_bits);
     Header(log, "                 Options.compression_opts.level: %d",
         compression_opts.level);
     Header(log, "              Options.compression_opts.strategy: %d",
         compression_opts.strategy);
+    Header(log, "      Options.compression_opts.parallel_threads: %" PRIu32,
+        compression_opts.parallel_threads);
     Header(log, "     Options.level0_file_num_compaction_trigger: %d",
         level0_file_num_compaction_trigger);
     Header(log, "         Options.level0_slowdown_writes_trigger: %d",
@@ -530,6 +583,10 @@ void ColumnFamilyOptions::Dump(Logger* log) const {
     }
     Header(log, "      Options.max_sequential_skip_in_iterations: %" PRIu64,
         max_sequential_skip_in_iterations);
+    Header(log, "       Options.scan_deletion_compaction_trigger: %" PRIu64,
+        scan_deletion_compaction_trigger);
+    Header(log, "            Options.periodic_compaction_seconds: %" PRIu64,
+        periodic_compaction_seconds);
     Header(log, "             Options.expanded_compaction_factor: %d",
         expanded_compaction_factor);
     Header(log, "               Options.source_compaction_factor: %d",
@@ -571,6 +628,8 @@ void ColumnFamilyOptions::Dump(Logger* log) const {
     Header(log,
         "Options.compaction_options_fifo.max_table_files_size: %" PRIu64,
         compaction_options_fifo.max_table_files_size);
+    Header(log, "Options.compaction_options_fifo.ttl: %" PRIu64,
+        compaction_options_fifo.ttl);
     std::string collector_names;
     for (const auto& collector_factory : table_properties_collector_factories) {
       collector_names.append(collector_factory->Name());
@@ -594,6 +653,8 @@ void ColumnFamilyOptions::Dump(Logger* log) const {
     Header(log,
          "  Options.memtable_prefix_bloom_huge_page_tlb_size: %" ROCKSDB_PRIszt,
          memtable_prefix_bloom_huge_page_tlb_size);
+    Header(log, "                Options.memtable_key_index_slots: %" PRIu32,
+        memtable_key_index_slots);
     Header(log, "                          Options.bloom_locality: %d",
         bloom_locality);
 
@@ -543,6 +543,8 @@ bool ParseMemtableOptions(const std::string& name, const std::string& value,
   } else if (name == "memtable_prefix_bloom_huge_page_tlb_size") {
     new_options->memtable_prefix_bloom_huge_page_tlb_size =
       ParseSizeT(value);
+  } else if (name == "memtable_key_index_slots") {
+    new_options->memtable_key_index_slots = ParseUint32(value);
   } else if (name == "max_successive_merges") {
     new_options->max_successive_merges = ParseSizeT(value);
   } else if (name == "filter_deletes") {
@@ -620,6 +622,10 @@ bool ParseMiscOptions(const std::string& name, const std::string& value,
                       OptionsType* new_options) {
   if (name == "max_sequential_skip_in_iterations") {
     new_options->max_sequential_skip_in_iterations = ParseUint64(value);
+  } else if (name == "scan_deletion_compaction_trigger") {
+    new_options->scan_deletion_compaction_trigger = ParseUint64(value);
+  } else if (name == "periodic_compaction_seconds") {
+    new_options->periodic_compaction_seconds = ParseUint64(value);
   } else if (name == "paranoid_file_checks") {
     new_options->paranoid_file_checks = ParseBoolean(name, value);
   } else {
@@ -810,11 +816,33 @@ Status ParseColumnFamilyOption(const std::string& name,
         return Status::InvalidArgument(
             "unable to parse the specified CF option " + name);
       }
+      end = value.find(':', start);
       new_options->compression_opts.strategy =
-          ParseInt(value.substr(start, value.size() - start));
+          ParseInt(value.substr(start, end - start));
+      // parallel_threads is optional
+      if (end != std::string::npos) {
+        start = end + 1;
+        if (start >= value.size()) {
+          return Status::InvalidArgument(
+              "unable to parse the specified CF option " + name);
+        }
+        new_options->compression_opts.parallel_threads =
+            ParseUint32(value.substr(start, value.size() - start));
+      }
     } else if (name == "compaction_options_fifo") {
+      // "max_table_files_size[:ttl]"
+      size_t end = value.find(':');
       new_options->compaction_options_fifo.max_table_files_size =
-          ParseUint64(value);
+          ParseUint64(value.substr(0, end));
+      if (end != std::string::npos) {
+        size_t start = end + 1;
+        if (start >= value.size()) {
+          return Status::InvalidArgument(
+              "unable to parse the specified CF option " + name);
+        }
+        new_options->compaction_options_fifo.ttl =
+            ParseUint64(value.substr(start));
+      }
     } else {
       auto iter = cf_options_type_info.find(name);
       if (iter == cf_options_type_info.end()) {
@@ -1220,6 +1248,15 @@ Status GetMemTableRepFactoryFromString(const std::string& opts_str,
     } else if (1 == len) {
       mem_factory = new VectorRepFactory();
     }
+  } else if (opts_list[0] == "btree") {
+    // Expecting format
+    // btree
+    if (1 == len) {
+      mem_factory = new BTreeRepFactory();
+    } else {
+      return Status::InvalidArgument("Can't parse memtable_factory option ",
+                                     opts_str);
+    }
   } else if (opts_list[0] == "cuckoo") {
     // Expecting format
     // cuckoo:<write_buffer_size>
@@ -1411,6 +1448,8 @@ ColumnFamilyOptions BuildColumnFamilyOptions(
       mutable_cf_options.memtable_prefix_bloom_probes;
   cf_opts.memtable_prefix_bloom_huge_page_tlb_size =
       mutable_cf_options.memtable_prefix_bloom_huge_page_tlb_size;
+  cf_opts.memtable_key_index_slots =
+      mutable_cf_options.memtable_key_index_slots;
   cf_opts.max_successive_merges = mutable_cf_options.max_successive_merges;
   cf_opts.filter_deletes = mutable_cf_options.filter_deletes;
   cf_opts.inplace_update_num_locks =
@@ -1451,6 +1490,10 @@ ColumnFamilyOptions BuildColumnFamilyOptions(
   // Misc options
   cf_opts.max_sequential_skip_in_iterations =
       mutable_cf_options.max_sequential_skip_in_iterations;
+  cf_opts.scan_deletion_compaction_trigger =
+      mutable_cf_options.scan_deletion_compaction_trigger;
+  cf_opts.periodic_compaction_seconds =
+      mutable_cf_options.periodic_compaction_seconds;
   cf_opts.paranoid_file_checks = mutable_cf_options.paranoid_file_checks;
   cf_opts.report_bg_io_stats = mutable_cf_options.report_bg_io_stats;
 
@@ -245,6 +245,9 @@ static std::unordered_map<std::string, OptionTypeInfo> db_options_type_info = {
     {"recycle_log_file_num",
      {offsetof(struct DBOptions, recycle_log_file_num), OptionType::kSizeT,
       OptionVerificationType::kNormal}},
+    {"wal_compression",
+     {offsetof(struct DBOptions, wal_compression),
+      OptionType::kCompressionType, OptionVerificationType::kNormal}},
     {"log_file_time_to_roll",
      {offsetof(struct DBOptions, log_file_time_to_roll), OptionType::kSizeT,
       OptionVerificationType::kNormal}},
@@ -275,6 +278,9 @@ static std::unordered_map<std::string, OptionTypeInfo> db_options_type_info = {
     {"delayed_write_rate",
      {offsetof(struct DBOptions, delayed_write_rate), OptionType::kUInt64T,
       OptionVerificationType::kNormal}},
+    {"adaptive_delayed_write_rate",
+     {offsetof(struct DBOptions, adaptive_delayed_write_rate),
+      OptionType::kBoolean, OptionVerificationType::kNormal}},
     {"delete_obsolete_files_period_micros",
      {offsetof(struct DBOptions, delete_obsolete_files_period_micros),
       OptionType::kUInt64T, OptionVerificationType::kNormal}},
@@ -296,6 +302,9 @@ static std::unordered_map<std::string, OptionTypeInfo> db_options_type_info = {
     {"allow_concurrent_memtable_write",
      {offsetof(struct DBOptions, allow_concurrent_memtable_write),
       OptionType::kBoolean, OptionVerificationType::kNormal}},
+    {"unordered_write",
+     {offsetof(struct DBOptions, unordered_write), OptionType::kBoolean,
+      OptionVerificationType::kNormal}},
     {"wal_recovery_mode",
      {offsetof(struct DBOptions, wal_recovery_mode),
       OptionType::kWALRecoveryMode, OptionVerificationType::kNormal}},
@@ -399,6 +408,9 @@ static std::unordered_map<std::string, OptionTypeInfo> cf_options_type_info = {
     {"max_write_buffer_number_to_maintain",
      {offsetof(struct ColumnFamilyOptions, max_write_buffer_number_to_maintain),
       OptionType::kInt, OptionVerificationType::kNormal}},
+    {"in_memory_compaction",
+     {offsetof(struct ColumnFamilyOptions, in_memory_compaction),
+      OptionType::kBoolean, OptionVerificationType::kNormal}},
     {"min_write_buffer_number_to_merge",
      {offsetof(struct ColumnFamilyOptions, min_write_buffer_number_to_merge),
       OptionType::kInt, OptionVerificationType::kNormal}},
@@ -436,6 +448,9 @@ static std::unordered_map<std::string, OptionTypeInfo> cf_options_type_info = {
     {"memtable_prefix_bloom_probes",
      {offsetof(struct ColumnFamilyOptions, memtable_prefix_bloom_probes),
       OptionType::kUInt32T, OptionVerificationType::kNormal}},
+    {"memtable_key_index_slots",
+     {offsetof(struct ColumnFamilyOptions, memtable_key_index_slots),
+      OptionType::kUInt32T, OptionVerificationType::kNormal}},
     {"min_partial_merge_operands",
      {offsetof(struct ColumnFamilyOptions, min_partial_merge_operands),
       OptionType::kUInt32T, OptionVerificationType::kNormal}},
@@ -445,6 +460,12 @@ static std::unordered_map<std::string, OptionTypeInfo> cf_options_type_info = {
     {"max_sequential_skip_in_iterations",
      {offsetof(struct ColumnFamilyOptions, max_sequential_skip_in_iterations),
       OptionType::kUInt64T, OptionVerificationType::kNormal}},
+    {"scan_deletion_compaction_trigger",
+     {offsetof(struct ColumnFamilyOptions, scan_deletion_compaction_trigger),
+      OptionType::kUInt64T, OptionVerificationType::kNormal}},
+    {"periodic_compaction_seconds",
+     {offsetof(struct ColumnFamilyOptions, periodic_compaction_seconds),
+      OptionType::kUInt64T, OptionVerificationType::kNormal}},
     {"target_file_size_base",
      {offsetof(struct ColumnFamilyOptions, target_file_size_base),
       OptionType::kUInt64T, OptionVerificationType::kNormal}},
@@ -466,6 +487,10 @@ static std::unordered_map<std::string, OptionTypeInfo> cf_options_type_info = {
     {"memtable_factory",
      {offsetof(struct ColumnFamilyOptions, memtable_factory),
       OptionType::kMemTableRepFactory, OptionVerificationType::kByName}},
+    {"memtable_insert_with_hint_prefix_extractor",
+     {offsetof(struct ColumnFamilyOptions,
+               memtable_insert_with_hint_prefix_extractor),
+      OptionType::kSliceTransform, OptionVerificationType::kByNameAllowNull}},
     {"table_factory",
      {offsetof(struct ColumnFamilyOptions, table_factory),
       OptionType::kTableFactory, OptionVerificationType::kByName}},
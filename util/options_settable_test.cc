@@ -20,6 +20,7 @@
 #include "rocksdb/convenience.h"
 #include "rocksdb/memtablerep.h"
 #include "rocksdb/utilities/leveldb_options.h"
+#include "rocksdb/write_buffer_manager.h"
 #include "util/options_helper.h"
 #include "util/options_parser.h"
 #include "util/options_sanity_check.h"
@@ -194,9 +195,13 @@ TEST_F(OptionsSettableTest, DBOptionsAllFieldsSettable) {
       {offsetof(struct DBOptions, db_paths), sizeof(std::vector<DbPath>)},
       {offsetof(struct DBOptions, db_log_dir), sizeof(std::string)},
       {offsetof(struct DBOptions, wal_dir), sizeof(std::string)},
+      {offsetof(struct DBOptions, write_buffer_manager),
+       sizeof(std::shared_ptr<WriteBufferManager>)},
       {offsetof(struct DBOptions, listeners),
        sizeof(std::vector<std::shared_ptr<EventListener>>)},
       {offsetof(struct DBOptions, row_cache), sizeof(std::shared_ptr<Cache>)},
+      {offsetof(struct DBOptions, compaction_service),
+       sizeof(std::shared_ptr<CompactionService>)},
       {offsetof(struct DBOptions, wal_filter), sizeof(const WalFilter*)},
   };
 
@@ -255,6 +260,7 @@ TEST_F(OptionsSettableTest, DBOptionsAllFieldsSettable) {
                              "enable_thread_tracking=false;"
                              "disable_data_sync=false;"
                              "recycle_log_file_num=0;"
+                             "wal_compression=kZlibCompression;"
                              "disableDataSync=false;"
                              "create_missing_column_families=true;"
                              "log_file_time_to_roll=3097;"
@@ -263,6 +269,7 @@ TEST_F(OptionsSettableTest, DBOptionsAllFieldsSettable) {
                              "error_if_exists=true;"
                              "allow_os_buffer=false;"
                              "delayed_write_rate=4294976214;"
+                             "adaptive_delayed_write_rate=false;"
                              "manifest_preallocation_size=1222;"
                              "allow_mmap_writes=false;"
                              "stats_dump_period_sec=70127;"
@@ -275,6 +282,7 @@ TEST_F(OptionsSettableTest, DBOptionsAllFieldsSettable) {
                              "allow_concurrent_memtable_write=true;"
                              "wal_recovery_mode=kPointInTimeRecovery;"
                              "enable_write_thread_adaptive_yield=true;"
+                             "unordered_write=false;"
                              "write_thread_slow_yield_usec=5;"
                              "write_thread_max_yield_usec=1000;"
                              "access_hint_on_compaction_start=NONE;"
@@ -318,6 +326,11 @@ TEST_F(OptionsSettableTest, ColumnFamilyOptionsAllFieldsSettable) {
        sizeof(std::vector<int>)},
       {offsetof(struct ColumnFamilyOptions, memtable_factory),
        sizeof(std::shared_ptr<MemTableRepFactory>)},
+      {offsetof(struct ColumnFamilyOptions,
+                memtable_insert_with_hint_prefix_extractor),
+       sizeof(std::shared_ptr<const SliceTransform>)},
+      {offsetof(struct ColumnFamilyOptions, memtable_memory_allocator),
+       sizeof(std::shared_ptr<MemoryAllocator>)},
       {offsetof(struct ColumnFamilyOptions, table_factory),
        sizeof(std::shared_ptr<TableFactory>)},
       {offsetof(struct ColumnFamilyOptions,
@@ -386,6 +399,8 @@ TEST_F(OptionsSettableTest, ColumnFamilyOptionsAllFieldsSettable) {
       "memtable_prefix_bloom_huge_page_tlb_size=2557;"
       "max_successive_merges=5497;"
       "max_sequential_skip_in_iterations=4294971408;"
+      "scan_deletion_compaction_trigger=4294971409;"
+      "periodic_compaction_seconds=4294971410;"
       "arena_block_size=1893;"
       "target_file_size_multiplier=35;"
       "source_compaction_factor=54;"
@@ -412,10 +427,12 @@ TEST_F(OptionsSettableTest, ColumnFamilyOptionsAllFieldsSettable) {
       "paranoid_file_checks=true;"
       "inplace_update_num_locks=7429;"
       "optimize_filters_for_hits=false;"
+      "in_memory_compaction=true;"
       "level_compaction_dynamic_level_bytes=false;"
       "inplace_update_support=false;"
       "compaction_style=kCompactionStyleFIFO;"
       "memtable_prefix_bloom_probes=2511;"
+      "memtable_key_index_slots=2512;"
       "purge_redundant_kvs_while_flush=true;"
       "filter_deletes=false;"
       "hard_pending_compaction_bytes_limit=0;"
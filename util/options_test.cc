@@ -123,7 +123,7 @@ TEST_F(OptionsTest, GetOptionsFromMapTest) {
       {"disable_auto_compactions", "true"},
       {"compaction_style", "kCompactionStyleLevel"},
       {"verify_checksums_in_compaction", "false"},
-      {"compaction_options_fifo", "23"},
+      {"compaction_options_fifo", "23:3600"},
       {"filter_deletes", "0"},
       {"max_sequential_skip_in_iterations", "24"},
       {"inplace_update_support", "true"},
@@ -133,11 +133,13 @@ TEST_F(OptionsTest, GetOptionsFromMapTest) {
       {"memtable_prefix_bloom_bits", "26"},
       {"memtable_prefix_bloom_probes", "27"},
       {"memtable_prefix_bloom_huge_page_tlb_size", "28"},
+      {"memtable_key_index_slots", "32"},
       {"bloom_locality", "29"},
       {"max_successive_merges", "30"},
       {"min_partial_merge_operands", "31"},
       {"prefix_extractor", "fixed:31"},
       {"optimize_filters_for_hits", "true"},
+      {"in_memory_compaction", "true"},
   };
 
   std::unordered_map<std::string, std::string> db_options_map = {
@@ -223,6 +225,7 @@ TEST_F(OptionsTest, GetOptionsFromMapTest) {
   ASSERT_EQ(new_cf_opt.verify_checksums_in_compaction, false);
   ASSERT_EQ(new_cf_opt.compaction_options_fifo.max_table_files_size,
             static_cast<uint64_t>(23));
+  ASSERT_EQ(new_cf_opt.compaction_options_fifo.ttl, 3600U);
   ASSERT_EQ(new_cf_opt.filter_deletes, false);
   ASSERT_EQ(new_cf_opt.max_sequential_skip_in_iterations,
             static_cast<uint64_t>(24));
@@ -231,11 +234,13 @@ TEST_F(OptionsTest, GetOptionsFromMapTest) {
   ASSERT_EQ(new_cf_opt.memtable_prefix_bloom_bits, 26U);
   ASSERT_EQ(new_cf_opt.memtable_prefix_bloom_probes, 27U);
   ASSERT_EQ(new_cf_opt.memtable_prefix_bloom_huge_page_tlb_size, 28U);
+  ASSERT_EQ(new_cf_opt.memtable_key_index_slots, 32U);
   ASSERT_EQ(new_cf_opt.bloom_locality, 29U);
   ASSERT_EQ(new_cf_opt.max_successive_merges, 30U);
   ASSERT_EQ(new_cf_opt.min_partial_merge_operands, 31U);
   ASSERT_TRUE(new_cf_opt.prefix_extractor != nullptr);
   ASSERT_EQ(new_cf_opt.optimize_filters_for_hits, true);
+  ASSERT_EQ(new_cf_opt.in_memory_compaction, true);
   ASSERT_EQ(std::string(new_cf_opt.prefix_extractor->Name()),
             "rocksdb.FixedPrefix.31");
 
@@ -321,6 +326,13 @@ TEST_F(OptionsTest, GetColumnFamilyOptionsFromStringTest) {
             &new_cf_opt));
   ASSERT_EQ(new_cf_opt.write_buffer_size, 11U);
   ASSERT_EQ(new_cf_opt.max_write_buffer_number, 12);
+  // Optional parallel_threads of compression_opts
+  ASSERT_OK(GetColumnFamilyOptionsFromString(
+      base_cf_opt, "compression_opts=4:5:6:7", &new_cf_opt));
+  ASSERT_EQ(new_cf_opt.compression_opts.strategy, 6);
+  ASSERT_EQ(new_cf_opt.compression_opts.parallel_threads, 7U);
+  ASSERT_NOK(GetColumnFamilyOptionsFromString(
+      base_cf_opt, "compression_opts=4:5:6:", &new_cf_opt));
   // Wrong name "max_write_buffer_number_"
   ASSERT_NOK(GetColumnFamilyOptionsFromString(base_cf_opt,
              "write_buffer_size=13;max_write_buffer_number_=14;",
@@ -576,6 +588,10 @@ TEST_F(OptionsTest, GetMemTableRepFactoryFromString) {
   ASSERT_NOK(GetMemTableRepFactoryFromString("vector:1024:invalid_opt",
                                              &new_mem_factory));
 
+  ASSERT_OK(GetMemTableRepFactoryFromString("btree", &new_mem_factory));
+  ASSERT_EQ(std::string(new_mem_factory->Name()), "BTreeRepFactory");
+  ASSERT_NOK(GetMemTableRepFactoryFromString("btree:1024", &new_mem_factory));
+
   ASSERT_NOK(GetMemTableRepFactoryFromString("cuckoo", &new_mem_factory));
   ASSERT_OK(GetMemTableRepFactoryFromString("cuckoo:1024", &new_mem_factory));
   ASSERT_EQ(std::string(new_mem_factory->Name()), "HashCuckooRepFactory");
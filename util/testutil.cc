@@ -298,6 +298,7 @@ void RandomInitCFOptions(ColumnFamilyOptions* cf_opt, Random* rnd) {
   cf_opt->disable_auto_compactions = rnd->Uniform(2);
   cf_opt->filter_deletes = rnd->Uniform(2);
   cf_opt->inplace_update_support = rnd->Uniform(2);
+  cf_opt->in_memory_compaction = rnd->Uniform(2);
   cf_opt->level_compaction_dynamic_level_bytes = rnd->Uniform(2);
   cf_opt->optimize_filters_for_hits = rnd->Uniform(2);
   cf_opt->paranoid_file_checks = rnd->Uniform(2);
@@ -334,12 +335,15 @@ void RandomInitCFOptions(ColumnFamilyOptions* cf_opt, Random* rnd) {
   cf_opt->bloom_locality = rnd->Uniform(10000);
   cf_opt->memtable_prefix_bloom_bits = rnd->Uniform(10000);
   cf_opt->memtable_prefix_bloom_probes = rnd->Uniform(10000);
+  cf_opt->memtable_key_index_slots = rnd->Uniform(10000);
   cf_opt->min_partial_merge_operands = rnd->Uniform(10000);
   cf_opt->max_bytes_for_level_base = rnd->Uniform(10000);
 
   // uint64_t options
   static const uint64_t uint_max = static_cast<uint64_t>(UINT_MAX);
   cf_opt->max_sequential_skip_in_iterations = uint_max + rnd->Uniform(10000);
+  cf_opt->scan_deletion_compaction_trigger = uint_max + rnd->Uniform(10000);
+  cf_opt->periodic_compaction_seconds = uint_max + rnd->Uniform(10000);
   cf_opt->target_file_size_base = uint_max + rnd->Uniform(10000);
 
   // unsigned int options
@@ -347,6 +351,8 @@ void RandomInitCFOptions(ColumnFamilyOptions* cf_opt, Random* rnd) {
 
   // pointer typed options
   cf_opt->prefix_extractor.reset(RandomSliceTransform(rnd));
+  cf_opt->memtable_insert_with_hint_prefix_extractor.reset(
+      RandomSliceTransform(rnd));
   cf_opt->table_factory.reset(RandomTableFactory(rnd));
   cf_opt->merge_operator.reset(RandomMergeOperator(rnd));
   if (cf_opt->compaction_filter) {
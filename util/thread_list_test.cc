@@ -122,10 +122,14 @@ TEST_F(ThreadListTest, SimpleColumnFamilyInfoTest) {
   Env* env = Env::Default();
   const int kHighPriorityThreads = 3;
   const int kLowPriorityThreads = 5;
+  const int kBottomPriorityThreads = 2;
   const int kSimulatedHighPriThreads = kHighPriorityThreads - 1;
   const int kSimulatedLowPriThreads = kLowPriorityThreads / 3;
+  const int kSimulatedBottomPriThreads = kBottomPriorityThreads - 1;
   env->SetBackgroundThreads(kHighPriorityThreads, Env::HIGH);
   env->SetBackgroundThreads(kLowPriorityThreads, Env::LOW);
+  env->SetBackgroundThreads(kBottomPriorityThreads, Env::BOTTOM);
+  ASSERT_EQ(kBottomPriorityThreads, env->GetBackgroundThreads(Env::BOTTOM));
 
   SimulatedBackgroundTask running_task(
       reinterpret_cast<void*>(1234), "running",
@@ -139,8 +143,14 @@ TEST_F(ThreadListTest, SimpleColumnFamilyInfoTest) {
     env->Schedule(&SimulatedBackgroundTask::DoSimulatedTask,
         &running_task, Env::Priority::LOW);
   }
+  for (int test = 0; test < kSimulatedBottomPriThreads; ++test) {
+    env->Schedule(&SimulatedBackgroundTask::DoSimulatedTask,
+        &running_task, Env::Priority::BOTTOM);
+  }
   running_task.WaitUntilScheduled(
-      kSimulatedHighPriThreads + kSimulatedLowPriThreads, env);
+      kSimulatedHighPriThreads + kSimulatedLowPriThreads +
+          kSimulatedBottomPriThreads,
+      env);
 
   std::vector<ThreadStatus> thread_list;
 
@@ -159,6 +169,9 @@ TEST_F(ThreadListTest, SimpleColumnFamilyInfoTest) {
   ASSERT_EQ(
       running_count[ThreadStatus::LOW_PRIORITY],
       kSimulatedLowPriThreads);
+  ASSERT_EQ(
+      running_count[ThreadStatus::BOTTOM_PRIORITY],
+      kSimulatedBottomPriThreads);
   ASSERT_EQ(
       running_count[ThreadStatus::USER], 0);
 
@@ -182,8 +195,12 @@ TEST_F(ThreadListTest, SimpleColumnFamilyInfoTest) {
       running_count[ThreadStatus::HIGH_PRIORITY], 0);
   ASSERT_EQ(
       running_count[ThreadStatus::LOW_PRIORITY], 0);
+  ASSERT_EQ(
+      running_count[ThreadStatus::BOTTOM_PRIORITY], 0);
   ASSERT_EQ(
       running_count[ThreadStatus::USER], 0);
+
+  env->SetBackgroundThreads(0, Env::BOTTOM);
 }
 
 namespace {
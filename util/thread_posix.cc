@@ -30,6 +30,7 @@ ThreadPool::ThreadPool()
       queue_len_(0),
       exit_all_threads_(false),
       low_io_priority_(false),
+      priority_(Env::Priority::LOW),
       env_(nullptr) {
   PthreadCall("mutex_init", pthread_mutex_init(&mu_, nullptr));
   PthreadCall("cvar_init", pthread_cond_init(&bgsignal_, nullptr));
@@ -134,10 +135,13 @@ static void* BGThreadWrapper(void* arg) {
   ThreadPool* tp = meta->thread_pool_;
 #if ROCKSDB_USING_THREAD_STATUS
   // for thread-status
-  ThreadStatusUtil::RegisterThread(
-      tp->GetHostEnv(), (tp->GetThreadPriority() == Env::Priority::HIGH
-                             ? ThreadStatus::HIGH_PRIORITY
-                             : ThreadStatus::LOW_PRIORITY));
+  ThreadStatus::ThreadType thread_type = ThreadStatus::LOW_PRIORITY;
+  if (tp->GetThreadPriority() == Env::Priority::HIGH) {
+    thread_type = ThreadStatus::HIGH_PRIORITY;
+  } else if (tp->GetThreadPriority() == Env::Priority::BOTTOM) {
+    thread_type = ThreadStatus::BOTTOM_PRIORITY;
+  }
+  ThreadStatusUtil::RegisterThread(tp->GetHostEnv(), thread_type);
 #endif
   delete meta;
   tp->BGThread(thread_id);
@@ -159,7 +163,9 @@ void ThreadPool::SetBackgroundThreadsInternal(int num, bool allow_reduce) {
   }
   if (num > total_threads_limit_ ||
       (num < total_threads_limit_ && allow_reduce)) {
-    total_threads_limit_ = std::max(1, num);
+    // Only the BOTTOM pool may be empty, the others always run their jobs
+    total_threads_limit_ =
+        std::max(priority_ == Env::Priority::BOTTOM ? 0 : 1, num);
     WakeUpAllThreads();
     StartBGThreads();
   }
@@ -174,6 +180,13 @@ void ThreadPool::SetBackgroundThreads(int num) {
   SetBackgroundThreadsInternal(num, true);
 }
 
+int ThreadPool::GetBackgroundThreads() {
+  PthreadCall("lock", pthread_mutex_lock(&mu_));
+  int num = total_threads_limit_;
+  PthreadCall("unlock", pthread_mutex_unlock(&mu_));
+  return num;
+}
+
 void ThreadPool::StartBGThreads() {
   // Start background thread if necessary
   while ((int)bgthreads_.size() < total_threads_limit_) {
@@ -23,6 +23,7 @@ class ThreadPool {
   void WakeUpAllThreads();
   void IncBackgroundThreadsIfNeeded(int num);
   void SetBackgroundThreads(int num);
+  int GetBackgroundThreads();
   void StartBGThreads();
   void Schedule(void (*function)(void* arg1), void* arg, void* tag,
                 void (*unschedFunction)(void* arg));
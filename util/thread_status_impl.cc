@@ -17,7 +17,7 @@ namespace rocksdb {
 const std::string& ThreadStatus::GetThreadTypeName(
     ThreadStatus::ThreadType thread_type) {
   static std::string thread_type_names[NUM_THREAD_TYPES + 1] = {
-      "High Pri", "Low Pri", "User", "Unknown"};
+      "High Pri", "Low Pri", "User", "Bottom Pri", "Unknown"};
   if (thread_type < 0 || thread_type >= NUM_THREAD_TYPES) {
     return thread_type_names[NUM_THREAD_TYPES];  // "Unknown"
   }
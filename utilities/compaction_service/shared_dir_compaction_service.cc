@@ -0,0 +1,197 @@
+//  Copyright (c) 2011-present, Facebook, Inc.  All rights reserved.
+//  This source code is licensed under the BSD-style license found in the
+//  LICENSE file in the root directory of this source tree. An additional grant
+//  of patent rights can be found in the PATENTS file in the same directory.
+
+#ifndef ROCKSDB_LITE
+
+#include "rocksdb/utilities/shared_dir_compaction_service.h"
+
+#include <atomic>
+#include <string>
+#include <vector>
+
+#include "db/compaction_service.h"
+#include "rocksdb/db.h"
+#include "rocksdb/env.h"
+#include "rocksdb/options.h"
+#include "util/string_util.h"
+
+namespace rocksdb {
+
+namespace {
+
+const std::string kRequestSuffix = ".request";
+const std::string kRunningSuffix = ".running";
+const std::string kOutputSuffix = ".output";
+const std::string kResultSuffix = ".result";
+const std::string kTempSuffix = ".tmp";
+
+bool EndsWith(const std::string& name, const std::string& suffix) {
+  return name.size() > suffix.size() &&
+         name.compare(name.size() - suffix.size(), suffix.size(), suffix) == 0;
+}
+
+// Writes the file under a temporary name first, so that it is never seen
+// partially written
+Status WriteFileAtomically(Env* env, const Slice& data,
+                           const std::string& fname) {
+  const std::string temp = fname + kTempSuffix;
+  Status s = WriteStringToFile(env, data, temp, true /* should_sync */);
+  if (s.ok()) {
+    s = env->RenameFile(temp, fname);
+  }
+  if (!s.ok()) {
+    env->DeleteFile(temp);
+  }
+  return s;
+}
+
+class SharedDirCompactionService : public CompactionService {
+ public:
+  SharedDirCompactionService(Env* env, const std::string& shared_dir,
+                             uint64_t timeout_micros,
+                             uint64_t poll_interval_micros)
+      : env_(env),
+        shared_dir_(shared_dir),
+        timeout_micros_(timeout_micros),
+        poll_interval_micros_(poll_interval_micros),
+        next_id_(0) {}
+
+  virtual const char* Name() const override {
+    return "SharedDirCompactionService";
+  }
+
+  virtual Status Run(const std::string& db_name, int job_id,
+                     const std::string& input, std::string* result) override {
+    Status s = env_->CreateDirIfMissing(shared_dir_);
+    if (!s.ok()) {
+      return s;
+    }
+    RemoveEmptyOutputDirs();
+
+    const std::string prefix =
+        shared_dir_ + "/" + ToString(job_id) + "-" +
+        ToString(env_->NowMicros()) + "-" + ToString(next_id_.fetch_add(1));
+    const std::string request = prefix + kRequestSuffix;
+    s = WriteFileAtomically(env_, Slice(db_name).ToString(true) + "\n" + input,
+                            request);
+    if (!s.ok()) {
+      return s;
+    }
+
+    const std::string result_file = prefix + kResultSuffix;
+    const uint64_t deadline = env_->NowMicros() + timeout_micros_;
+    while (!env_->FileExists(result_file).ok()) {
+      if (env_->NowMicros() >= deadline) {
+        // Withdraw the request if no worker has claimed it yet. The result
+        // of a worker that is still running it is ignored.
+        if (env_->DeleteFile(request).ok()) {
+          return Status::TimedOut("No compaction worker claimed", request);
+        }
+        return Status::TimedOut("Compaction worker did not finish", request);
+      }
+      env_->SleepForMicroseconds(static_cast<int>(poll_interval_micros_));
+    }
+    s = ReadFileToString(env_, result_file, result);
+    env_->DeleteFile(result_file);
+    return s;
+  }
+
+ private:
+  // The output directories of finished compactions are left behind once the
+  // DB moved the files out of them
+  void RemoveEmptyOutputDirs() {
+    std::vector<std::string> children;
+    if (!env_->GetChildren(shared_dir_, &children).ok()) {
+      return;
+    }
+    for (const auto& child : children) {
+      if (EndsWith(child, kOutputSuffix)) {
+        const std::string prefix =
+            child.substr(0, child.size() - kOutputSuffix.size());
+        if (!env_->FileExists(shared_dir_ + "/" + prefix + kRunningSuffix)
+                 .ok() &&
+            !env_->FileExists(shared_dir_ + "/" + prefix + kResultSuffix)
+                 .ok()) {
+          // Fails, as it should, if there are files left in the directory
+          env_->DeleteDir(shared_dir_ + "/" + child);
+        }
+      }
+    }
+  }
+
+  Env* env_;
+  const std::string shared_dir_;
+  const uint64_t timeout_micros_;
+  const uint64_t poll_interval_micros_;
+  std::atomic<uint64_t> next_id_;
+};
+
+}  // namespace
+
+std::shared_ptr<CompactionService> NewSharedDirCompactionService(
+    Env* env, const std::string& shared_dir, uint64_t timeout_micros,
+    uint64_t poll_interval_micros) {
+  return std::make_shared<SharedDirCompactionService>(
+      env, shared_dir, timeout_micros, poll_interval_micros);
+}
+
+Status RunSharedDirCompactionRequest(const Options& options,
+                                     const std::string& shared_dir,
+                                     bool* found) {
+  *found = false;
+  Env* env = options.env;
+  Status s = env->CreateDirIfMissing(shared_dir);
+  std::vector<std::string> children;
+  if (s.ok()) {
+    s = env->GetChildren(shared_dir, &children);
+  }
+  if (!s.ok()) {
+    return s;
+  }
+
+  for (const auto& child : children) {
+    if (!EndsWith(child, kRequestSuffix)) {
+      continue;
+    }
+    const std::string prefix =
+        shared_dir + "/" + child.substr(0, child.size() - kRequestSuffix.size());
+    const std::string running = prefix + kRunningSuffix;
+    // The rename fails if another worker claimed the request first
+    if (!env->RenameFile(shared_dir + "/" + child, running).ok()) {
+      continue;
+    }
+    *found = true;
+
+    std::string request;
+    std::string db_name;
+    std::string result;
+    s = ReadFileToString(env, running, &request);
+    if (s.ok()) {
+      size_t pos = request.find('\n');
+      if (pos == std::string::npos ||
+          !Slice(request.data(), pos).DecodeHex(&db_name)) {
+        s = Status::Corruption("Bad compaction request", running);
+      } else {
+        s = DB::OpenAndCompact(options, db_name, prefix + kOutputSuffix,
+                               request.substr(pos + 1), &result);
+      }
+    }
+    if (result.empty()) {
+      // The compaction did not get to run, tell the DB why
+      CompactionServiceResult compaction_result;
+      compaction_result.status =
+          s.ok() ? Status::Corruption("Empty compaction result") : s;
+      compaction_result.EncodeTo(&result);
+    }
+    s = WriteFileAtomically(env, result, prefix + kResultSuffix);
+    env->DeleteFile(running);
+    return s;
+  }
+  return Status::OK();
+}
+
+}  // namespace rocksdb
+
+#endif  // !ROCKSDB_LITE